@@ -73,6 +73,7 @@ static void boot_jump_linux(bootm_headers_t *images, int flag)
 	       "(fake run for tracing)" : "");
 	bootstage_mark_name(BOOTSTAGE_ID_BOOTM_HANDOFF, "start_kernel");
 
+	serial_flush();
 	cleanup_before_linux();
 
 	if (IMAGE_ENABLE_OF_LIBFDT && images->ft_len) {
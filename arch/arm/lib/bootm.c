@@ -93,6 +93,7 @@ static void announce_and_cleanup(int fake)
 #ifdef CONFIG_USB_DEVICE
 	udc_disconnect();
 #endif
+	serial_flush();
 	cleanup_before_linux();
 }
 
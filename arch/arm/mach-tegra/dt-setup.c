@@ -7,7 +7,7 @@
 #include <common.h>
 #include <asm/arch-tegra/gpu.h>
 #include <asm/arch-tegra/board.h>
-#include "dt-edit.h"
+#include <fdt_edit.h>
 
 /*
  * This function is called right before the kernel is booted. "blob" is the
@@ -29,10 +29,7 @@ int ft_system_setup(void *blob, bd_t *bd)
 			return ret;
 	}
 
-	fdt_del_env_nodelist(blob);
-	fdt_del_env_proplist(blob);
-	fdt_copy_env_nodelist(blob);
-	fdt_copy_env_proplist(blob);
+	fdt_edit_env_all(blob);
 
 	return 0;
 }
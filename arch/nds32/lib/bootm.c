@@ -102,6 +102,7 @@ int do_bootm_linux(int flag, int argc, char *argv[], bootm_headers_t *images)
 	}
 #endif
 
+	serial_flush();
 	cleanup_before_linux();
 
 	theKernel(0, machid, bd->bi_boot_params);
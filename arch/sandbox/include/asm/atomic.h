@@ -0,0 +1,74 @@
+/*
+ * Atomic operations for sandbox. U-Boot runs single-threaded, so plain
+ * arithmetic is enough.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __SANDBOX_ASM_ATOMIC_H
+#define __SANDBOX_ASM_ATOMIC_H
+
+typedef struct { volatile int counter; } atomic_t;
+typedef struct { volatile long counter; } atomic64_t;
+
+#define ATOMIC_INIT(i)		{ (i) }
+#define ATOMIC64_INIT(i)	{ (i) }
+
+#define atomic_read(v)		((v)->counter)
+#define atomic_set(v, i)	(((v)->counter) = (i))
+#define atomic_add(i, v)	((void)((v)->counter += (i)))
+#define atomic_sub(i, v)	((void)((v)->counter -= (i)))
+#define atomic_inc(v)		atomic_add(1, v)
+#define atomic_dec(v)		atomic_sub(1, v)
+#define atomic_dec_and_test(v)	(--(v)->counter == 0)
+
+#define atomic64_read(v)	((v)->counter)
+#define atomic64_set(v, i)	(((v)->counter) = (i))
+
+static inline long atomic64_add_return(long i, atomic64_t *v)
+{
+	return v->counter += i;
+}
+
+static inline long atomic64_xchg(atomic64_t *v, long new)
+{
+	long old = v->counter;
+
+	v->counter = new;
+
+	return old;
+}
+
+static inline long atomic64_cmpxchg(atomic64_t *v, long old, long new)
+{
+	long val = v->counter;
+
+	if (val == old)
+		v->counter = new;
+
+	return val;
+}
+
+static inline int atomic64_add_unless(atomic64_t *v, long a, long u)
+{
+	if (v->counter == u)
+		return 0;
+	v->counter += a;
+
+	return 1;
+}
+
+#define atomic64_sub_return(i, v)	atomic64_add_return(-(long)(i), v)
+#define atomic64_inc_return(v)		atomic64_add_return(1, v)
+#define atomic64_dec_return(v)		atomic64_add_return(-1, v)
+#define atomic64_add(i, v)		((void)atomic64_add_return(i, v))
+#define atomic64_sub(i, v)		((void)atomic64_sub_return(i, v))
+#define atomic64_inc(v)			atomic64_add(1, v)
+#define atomic64_dec(v)			atomic64_sub(1, v)
+#define atomic64_add_negative(i, v)	(atomic64_add_return(i, v) < 0)
+#define atomic64_sub_and_test(i, v)	(atomic64_sub_return(i, v) == 0)
+#define atomic64_inc_and_test(v)	(atomic64_inc_return(v) == 0)
+#define atomic64_dec_and_test(v)	(atomic64_dec_return(v) == 0)
+#define atomic64_inc_not_zero(v)	atomic64_add_unless(v, 1, 0)
+
+#endif
@@ -0,0 +1,19 @@
+/*
+ * Copyright (c) 2016 Google, Inc
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __asm_spl_h
+#define __asm_spl_h
+
+/*
+ * Sandbox has no SPL of its own. The FIT loader from common/spl is built
+ * into U-Boot so that it can be tested.
+ */
+enum {
+	BOOT_DEVICE_BOARD,
+	BOOT_DEVICE_NONE
+};
+
+#endif
@@ -48,6 +48,84 @@ void sandbox_i2c_eeprom_set_test_mode(struct udevice *dev,
 
 void sandbox_i2c_eeprom_set_offset_len(struct udevice *dev, int offset_len);
 
+/**
+ * struct sandbox_sf_stats - Transfer counters of the SPI flash emulator
+ *
+ * @xfers:		Number of xfer() calls
+ * @bulk_reads:		Number of bulk reads
+ * @bulk_bytes:		Total number of bytes read by bulk reads
+ * @bulk_opcode:	Read command used by the last bulk read
+ */
+struct sandbox_sf_stats {
+	uint xfers;
+	uint bulk_reads;
+	ulong bulk_bytes;
+	u8 bulk_opcode;
+};
+
+/**
+ * sandbox_sf_get_stats() - read the transfer counters of a SPI flash emulator
+ *
+ * @dev:	SPI flash emulator device
+ * @stats:	Returns the counters
+ */
+void sandbox_sf_get_stats(struct udevice *dev, struct sandbox_sf_stats *stats);
+
+/**
+ * struct sandbox_mtd_platdata - Geometry of a sandbox NAND device
+ *
+ * @size:		Total size in bytes
+ * @erasesize:		Eraseblock size in bytes
+ * @writesize:		Page size in bytes
+ * @subpage_sft:	log2 of the number of sub-pages in a page
+ */
+struct sandbox_mtd_platdata {
+	u64 size;
+	u32 erasesize;
+	u32 writesize;
+	int subpage_sft;
+};
+
+/**
+ * struct sandbox_mtd_stats - Access counters of a sandbox NAND device
+ *
+ * @reads:		Number of read calls
+ * @read_bytes:		Total number of bytes read
+ * @writes:		Number of write calls
+ * @erases:		Number of eraseblocks erased
+ */
+struct sandbox_mtd_stats {
+	uint reads;
+	u64 read_bytes;
+	uint writes;
+	uint erases;
+};
+
+/**
+ * sandbox_mtd_get_stats() - read and reset the counters of a NAND device
+ *
+ * @dev:	Sandbox MTD device
+ * @stats:	Returns the counters accumulated since the last call
+ */
+void sandbox_mtd_get_stats(struct udevice *dev, struct sandbox_mtd_stats *stats);
+
+/**
+ * sandbox_serial_set_tx_space() - emulate a transmit FIFO with limited room
+ *
+ * @dev:	Sandbox serial device
+ * @space:	Number of characters to accept before putc() returns -EAGAIN,
+ *		-1 to accept any number
+ */
+void sandbox_serial_set_tx_space(struct udevice *dev, int space);
+
+/**
+ * sandbox_serial_get_tx_count() - read and reset the output counter
+ *
+ * @dev:	Sandbox serial device
+ * @return number of characters written since the last call
+ */
+uint sandbox_serial_get_tx_count(struct udevice *dev);
+
 /*
  * sandbox_timer_add_offset()
  *
@@ -79,4 +157,35 @@ long sandbox_i2c_rtc_get_set_base_time(struct udevice *dev, long base_time);
 
 int sandbox_usb_keyb_add_string(struct udevice *dev, const char *str);
 
+/**
+ * sandbox_usb_set_max_xfer_size() - set the bulk transfer limit of all buses
+ *
+ * This is picked up by USB storage devices when they are probed.
+ *
+ * @size:	Largest bulk transfer in bytes, 0 for no limit
+ */
+void sandbox_usb_set_max_xfer_size(size_t size);
+
+/**
+ * struct sandbox_flash_stats - counters kept by a USB flash stick emulator
+ *
+ * @cmds:	Number of commands received
+ * @reads:	Number of read commands (READ(10) and READ(16))
+ * @read_blocks: Number of blocks read
+ */
+struct sandbox_flash_stats {
+	uint cmds;
+	uint reads;
+	ulong read_blocks;
+};
+
+/**
+ * sandbox_flash_get_stats() - read the counters of a USB flash stick emulator
+ *
+ * @dev:	USB flash stick emulator device
+ * @stats:	Returns the counters
+ */
+void sandbox_flash_get_stats(struct udevice *dev,
+			     struct sandbox_flash_stats *stats);
+
 #endif
@@ -79,6 +79,13 @@ static int do_dfu(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		if (ctrlc())
 			goto exit;
 
+		/*
+		 * A failed write is reported to the host by the next
+		 * dfu_write() / dfu_flush() call.
+		 */
+		if (dfu_write_deferred())
+			error("Deferred dfu_write() failed!");
+
 		if (dfu_get_defer_flush()) {
 			/*
 			 * Call to usb_gadget_handle_interrupts() is necessary
@@ -0,0 +1,55 @@
+/*
+ * Show the usage of the malloc() heap
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+
+static int do_malloc_stats(void)
+{
+	struct malloc_stats stats;
+	uint frag;
+
+	malloc_get_stats(&stats);
+	frag = stats.free ? 100 - stats.largest_free * 100 / stats.free : 0;
+	printf("total:       %10lu bytes\n", stats.total);
+	printf("in use:      %10lu bytes in %u allocations\n", stats.in_use,
+	       stats.allocs);
+	printf("free:        %10lu bytes in %u blocks\n", stats.free,
+	       stats.free_blocks);
+	printf("largest:     %10lu bytes free, %u%% fragmented\n",
+	       stats.largest_free, frag);
+
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+	{
+		struct malloc_slab_stats slab;
+		int i;
+
+		printf("\nslab   size  pages  objects     free\n");
+		for (i = 0; !malloc_slab_get_stats(i, &slab); i++) {
+			printf("%11u %6u %8u %8u\n", slab.size, slab.pages,
+			       slab.objects, slab.free);
+		}
+	}
+#endif
+
+	return 0;
+}
+
+static int do_malloc(cmd_tbl_t *cmdtp, int flag, int argc,
+		     char * const argv[])
+{
+	if (argc != 2 || strcmp(argv[1], "stats"))
+		return CMD_RET_USAGE;
+
+	return do_malloc_stats();
+}
+
+U_BOOT_CMD(
+	malloc, 2, 1, do_malloc,
+	"malloc() heap information",
+	"stats - show how the heap is used and how fragmented it is"
+);
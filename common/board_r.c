@@ -287,8 +287,12 @@ static int initr_malloc(void)
 	ulong malloc_start;
 
 #ifdef CONFIG_SYS_MALLOC_F_LEN
-	debug("Pre-reloc malloc() used %#lx bytes (%ld KB)\n", gd->malloc_ptr,
-	      gd->malloc_ptr / 1024);
+	debug("Pre-reloc malloc() used %#lx bytes (%ld KB), at most %#lx, in %u blocks\n",
+	      gd->malloc_ptr, gd->malloc_ptr / 1024, gd->malloc_peak,
+	      gd->malloc_count);
+	if (gd->malloc_peak > gd->malloc_limit)
+		printf("Pre-reloc malloc() ran out of space: needed %#lx of %#lx bytes\n",
+		       gd->malloc_peak, gd->malloc_limit);
 #endif
 	/* The malloc area is immediately below the monitor copy in DRAM */
 	malloc_start = gd->relocaddr - TOTAL_MALLOC_LEN;
@@ -324,10 +328,20 @@ static int initr_dm(void)
 	gd->dm_root = NULL;
 #ifdef CONFIG_TIMER
 	gd->timer = NULL;
+#endif
+	/*
+	 * The pre-reloc timer went with its driver model, so only time the
+	 * scan when there is an early timer to take both readings from
+	 */
+#if !defined(CONFIG_TIMER) || defined(CONFIG_TIMER_EARLY)
+	bootstage_start(BOOTSTAGE_ID_ACCUM_DM_R, "dm_r");
 #endif
 	ret = dm_init_and_scan(false);
 	if (ret)
 		return ret;
+#if !defined(CONFIG_TIMER) || defined(CONFIG_TIMER_EARLY)
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_DM_R);
+#endif
 #ifdef CONFIG_TIMER_EARLY
 	ret = dm_timer_init();
 	if (ret)
@@ -797,7 +811,7 @@ init_fnc_t init_sequence_r[] = {
 #ifdef CONFIG_CLOCKS
 	set_cpu_clk_info, /* Setup clock information */
 #endif
-#ifdef CONFIG_EFI_LOADER
+#ifdef CONFIG_EFI_LOADER_MEMORY
 	efi_memory_init,
 #endif
 	stdio_init_tables,
@@ -69,6 +69,9 @@ static inline void boot_start_lmb(bootm_headers_t *images) { }
 static int bootm_start(cmd_tbl_t *cmdtp, int flag, int argc,
 		       char * const argv[])
 {
+#ifdef CONFIG_LMB
+	lmb_release(&images.lmb);
+#endif
 	memset((void *)&images, 0, sizeof(images));
 	images.verify = getenv_yesno("verify");
 
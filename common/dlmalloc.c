@@ -5,6 +5,7 @@
 #endif
 
 #include <malloc.h>
+#include <mapmem.h>
 #include <asm/io.h>
 
 #ifdef DEBUG
@@ -612,6 +613,25 @@ void mem_malloc_init(ulong start, ulong size)
 	malloc_bin_reloc();
 }
 
+#ifdef CONFIG_SYS_MALLOC_F_LEN
+/*
+ * Check whether @mem is a live block from the pre-relocation area. After
+ * relocation that area is left as it was. If it overlaps the heap, its
+ * blocks cannot be told apart from heap blocks, so none are reported.
+ */
+static int malloc_is_early(Void_t *mem)
+{
+	ulong start = map_to_sysmem((void *)mem_malloc_start);
+	ulong end = map_to_sysmem((void *)mem_malloc_end);
+
+	if (gd->malloc_base < end &&
+	    gd->malloc_base + gd->malloc_limit > start)
+		return 0;
+
+	return malloc_simple_usable_size(mem) != 0;
+}
+#endif
+
 /* field-extraction macros */
 
 #define first(b) ((b)->fd)
@@ -1234,9 +1254,9 @@ static void malloc_extend_top(nb) INTERNAL_SIZE_T nb;
 */
 
 #if __STD_C
-Void_t* mALLOc(size_t bytes)
+static Void_t* malloc_from_heap(size_t bytes)
 #else
-Void_t* mALLOc(bytes) size_t bytes;
+static Void_t* malloc_from_heap(bytes) size_t bytes;
 #endif
 {
   mchunkptr victim;                  /* inspected/selected chunk */
@@ -1254,11 +1274,6 @@ Void_t* mALLOc(bytes) size_t bytes;
 
   INTERNAL_SIZE_T nb;
 
-#ifdef CONFIG_SYS_MALLOC_F_LEN
-	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
-		return malloc_simple(bytes);
-#endif
-
   /* check if mem_malloc_init() was run */
   if ((mem_malloc_start == 0) && (mem_malloc_end == 0)) {
     /* not initialized yet */
@@ -1480,6 +1495,24 @@ Void_t* mALLOc(bytes) size_t bytes;
 
 }
 
+Void_t *mALLOc(size_t bytes)
+{
+#ifdef CONFIG_SYS_MALLOC_F_LEN
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return malloc_simple(bytes);
+#endif
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+	if (bytes <= MALLOC_SLAB_MAX) {
+		Void_t *mem = malloc_slab(bytes);
+
+		if (mem)
+			return mem;
+	}
+#endif
+
+	return malloc_from_heap(bytes);
+}
+
 
 
 
@@ -1523,14 +1556,23 @@ void fREe(mem) Void_t* mem;
   int       islr;      /* track whether merging with last_remainder */
 
 #ifdef CONFIG_SYS_MALLOC_F_LEN
-	/* free() is a no-op - all the memory will be freed on relocation */
-	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT)) {
+		free_simple(mem);
+		return;
+	}
+	/* Memory from before relocation is not part of the heap */
+	if (malloc_is_early(mem))
 		return;
 #endif
 
   if (mem == NULL)                              /* free(0) has no effect */
     return;
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+  if (malloc_slab_free(mem))
+    return;
+#endif
+
   p = mem2chunk(mem);
   hd = p->size;
 
@@ -1680,12 +1722,35 @@ Void_t* rEALLOc(oldmem, bytes) Void_t* oldmem; size_t bytes;
   if (oldmem == NULL) return mALLOc(bytes);
 
 #ifdef CONFIG_SYS_MALLOC_F_LEN
-	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT)) {
-		/* This is harder to support and should not be needed */
-		panic("pre-reloc realloc() is not supported");
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return realloc_simple(oldmem, bytes);
+
+	/* Copy memory from before relocation into the heap */
+	if (malloc_is_early(oldmem)) {
+		oldsize = malloc_simple_usable_size(oldmem);
+		newmem = mALLOc(bytes);
+		if (newmem)
+			memcpy(newmem, oldmem, min(oldsize, bytes));
+		return newmem;
 	}
 #endif
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+  /* Slab objects cannot grow, so move them if they need to */
+  oldsize = malloc_slab_size(oldmem);
+  if (oldsize) {
+    if (bytes <= oldsize)
+      return oldmem;
+    newmem = mALLOc(bytes);
+    if (newmem) {
+      /* MALLOC_COPY() only handles the sizes of whole chunks */
+      memcpy(newmem, oldmem, oldsize);
+      fREe(oldmem);
+    }
+    return newmem;
+  }
+#endif
+
   newp    = oldp    = mem2chunk(oldmem);
   newsize = oldsize = chunksize(oldp);
 
@@ -1891,6 +1956,11 @@ Void_t* mEMALIGn(alignment, bytes) size_t alignment; size_t bytes;
 
   if (alignment <= MALLOC_ALIGNMENT) return mALLOc(bytes);
 
+#ifdef CONFIG_SYS_MALLOC_F_LEN
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return memalign_simple(alignment, bytes);
+#endif
+
   /* Otherwise, ensure that it is at least a minimum chunk size */
 
   if (alignment <  MINSIZE) alignment = MINSIZE;
@@ -1898,7 +1968,7 @@ Void_t* mEMALIGn(alignment, bytes) size_t alignment; size_t bytes;
   /* Call malloc with worst case padding to hit alignment. */
 
   nb = request2size(bytes);
-  m  = (char*)(mALLOc(nb + alignment + MINSIZE));
+  m  = (char*)(malloc_from_heap(nb + alignment + MINSIZE));
 
   /*
   * The attempt to over-allocate (with a size large enough to guarantee the
@@ -1914,7 +1984,7 @@ Void_t* mEMALIGn(alignment, bytes) size_t alignment; size_t bytes;
      * Use bytes not nb, since mALLOc internally calls request2size too, and
      * each call increases the size to allocate, to account for the header.
      */
-    m  = (char*)(mALLOc(bytes));
+    m  = (char*)(malloc_from_heap(bytes));
     /* Aligned -> return it */
     if ((((unsigned long)(m)) % alignment) == 0)
       return m;
@@ -1925,7 +1995,7 @@ Void_t* mEMALIGn(alignment, bytes) size_t alignment; size_t bytes;
     fREe(m);
     /* Add in extra bytes to match misalignment of unexpanded allocation */
     extra = alignment - (((unsigned long)(m)) % alignment);
-    m  = (char*)(mALLOc(bytes + extra));
+    m  = (char*)(malloc_from_heap(bytes + extra));
     /*
      * m might not be the same as before. Validate that the previous value of
      * extra still works for the current value of m.
@@ -2076,9 +2146,16 @@ Void_t* cALLOc(n, elem_size) size_t n; size_t elem_size;
   {
 #ifdef CONFIG_SYS_MALLOC_F_LEN
 	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT)) {
-		MALLOC_ZERO(mem, sz);
+		memset(mem, '\0', sz);
 		return mem;
 	}
+#endif
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+    /* MALLOC_ZERO() only handles the sizes of whole chunks */
+    if (malloc_slab_size(mem)) {
+      memset(mem, '\0', sz);
+      return mem;
+    }
 #endif
     p = mem2chunk(mem);
 
@@ -2227,6 +2304,14 @@ size_t malloc_usable_size(mem) Void_t* mem;
   mchunkptr p;
   if (mem == NULL)
     return 0;
+#ifdef CONFIG_SYS_MALLOC_F_LEN
+  else if (malloc_is_early(mem))
+    return malloc_simple_usable_size(mem);
+#endif
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+  else if (malloc_slab_size(mem))
+    return malloc_slab_size(mem);
+#endif
   else
   {
     p = mem2chunk(mem);
@@ -2277,6 +2362,15 @@ static void malloc_update_mallinfo()
 
   current_mallinfo.ordblks = navail;
   current_mallinfo.uordblks = sbrked_mem - avail;
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+  {
+    ulong page_bytes, obj_bytes;
+
+    /* Count the slab objects in use rather than the pages holding them */
+    malloc_slab_usage(&page_bytes, &obj_bytes);
+    current_mallinfo.uordblks -= page_bytes - obj_bytes;
+  }
+#endif
   current_mallinfo.fordblks = avail;
   current_mallinfo.hblks = n_mmaps;
   current_mallinfo.hblkhd = mmapped_mem;
@@ -2319,6 +2413,52 @@ void malloc_stats()
 }
 #endif	/* DEBUG */
 
+void malloc_get_stats(struct malloc_stats *stats)
+{
+  mchunkptr p;
+  INTERNAL_SIZE_T sz;
+  unsigned long misalign;
+
+  memset(stats, '\0', sizeof(*stats));
+  if (sbrk_base == (char *)(-1))
+    return;
+
+  /* The heap is one run of chunks from the base up to the top */
+  p = (mchunkptr)sbrk_base;
+  misalign = (unsigned long)chunk2mem(p) & MALLOC_ALIGN_MASK;
+  if (misalign)
+    p = chunk_at_offset(p, MALLOC_ALIGNMENT - misalign);
+  for (; p < top; p = next_chunk(p)) {
+    sz = chunksize(p);
+    if (inuse(p)) {
+      stats->in_use += sz;
+      stats->allocs++;
+    } else {
+      stats->free += sz;
+      stats->free_blocks++;
+      stats->largest_free = max(stats->largest_free, (ulong)sz);
+    }
+  }
+  sz = chunksize(top);
+  stats->free += sz;
+  stats->free_blocks++;
+  stats->largest_free = max(stats->largest_free, (ulong)sz);
+  stats->total = sbrked_mem;
+
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+  {
+    struct malloc_slab_stats slab;
+    ulong page_bytes, obj_bytes;
+    int i;
+
+    /* Count each slab object as an allocation, not each page */
+    for (i = 0; !malloc_slab_get_stats(i, &slab); i++)
+      stats->allocs -= slab.pages;
+    stats->allocs += malloc_slab_usage(&page_bytes, &obj_bytes);
+  }
+#endif
+}
+
 /*
   mallinfo returns a copy of updated current mallinfo.
 */
@@ -189,7 +189,7 @@ static inline int env_aes_cbc_crypt(env_t *env, const int enc)
  * Check if CRC is valid and (if yes) import the environment.
  * Note that "buf" may or may not be aligned.
  */
-int env_import(const char *buf, int check)
+static int env_do_import(const char *buf, int check, int flag)
 {
 	env_t *ep = (env_t *)buf;
 	int ret;
@@ -213,7 +213,7 @@ int env_import(const char *buf, int check)
 		return ret;
 	}
 
-	if (himport_r(&env_htab, (char *)ep->data, ENV_SIZE, '\0', 0, 0,
+	if (himport_r(&env_htab, (char *)ep->data, ENV_SIZE, '\0', flag, 0,
 			0, NULL)) {
 		gd->flags |= GD_FLG_ENV_READY;
 		return 1;
@@ -226,6 +226,17 @@ int env_import(const char *buf, int check)
 	return 0;
 }
 
+int env_import(const char *buf, int check)
+{
+	return env_do_import(buf, check, 0);
+}
+
+/* As env_import(), but parse the buffer in place instead of copying it */
+int env_import_inplace(char *buf, int check)
+{
+	return env_do_import(buf, check, H_INPLACE);
+}
+
 /* Emport the environment and generate CRC for it. */
 int env_export(env_t *env_out)
 {
@@ -265,7 +276,9 @@ void env_relocate(void)
 		set_default_env("!bad CRC");
 #endif
 	} else {
+		bootstage_start(BOOTSTAGE_ID_ACCUM_ENV, "env_load");
 		env_relocate_spec();
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_ENV);
 	}
 }
 
@@ -208,20 +208,46 @@ static inline int read_env(struct mmc *mmc, unsigned long size,
 }
 
 #ifdef CONFIG_ENV_OFFSET_REDUND
+/* Read just the first block of a copy, to get its serial number */
+static int read_env_flags(struct mmc *mmc, unsigned long offset,
+			  unsigned char *flagsp)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(u8, buf, MMC_MAX_BLOCK_LEN);
+
+	if (read_env(mmc, mmc->read_bl_len, offset, buf))
+		return -1;
+	*flagsp = ((env_t *)buf)->flags;
+
+	return 0;
+}
+
+/* Choose the copy with the newer serial, allowing for it wrapping */
+static int env_newer_copy(unsigned char flags1, unsigned char flags2)
+{
+	if (flags1 == 255 && flags2 == 0)
+		return 1;
+	else if (flags2 == 255 && flags1 == 0)
+		return 0;
+	else if (flags2 > flags1)
+		return 1;
+
+	/* flags are equal - almost impossible */
+	return 0;
+}
+
 void env_relocate_spec(void)
 {
 #if !defined(ENV_IS_EMBEDDED)
 	struct mmc *mmc;
-	u32 offset1, offset2;
-	int read1_fail = 0, read2_fail = 0;
-	int crc1_ok = 0, crc2_ok = 0;
-	env_t *ep;
+	u32 offset[2];
+	unsigned char flags[2];
+	int read_fail[2];
+	int copy, tries;
 	int ret;
 	int dev = mmc_get_env_dev();
 	const char *errmsg = NULL;
 
-	ALLOC_CACHE_ALIGN_BUFFER(env_t, tmp_env1, 1);
-	ALLOC_CACHE_ALIGN_BUFFER(env_t, tmp_env2, 1);
+	ALLOC_CACHE_ALIGN_BUFFER(env_t, tmp_env, 1);
 
 #ifdef CONFIG_SPL_BUILD
 	dev = 0;
@@ -235,57 +261,52 @@ void env_relocate_spec(void)
 		goto err;
 	}
 
-	if (mmc_get_env_addr(mmc, 0, &offset1) ||
-	    mmc_get_env_addr(mmc, 1, &offset2)) {
+	if (mmc_get_env_addr(mmc, 0, &offset[0]) ||
+	    mmc_get_env_addr(mmc, 1, &offset[1])) {
 		ret = 1;
 		goto fini;
 	}
 
-	read1_fail = read_env(mmc, CONFIG_ENV_SIZE, offset1, tmp_env1);
-	read2_fail = read_env(mmc, CONFIG_ENV_SIZE, offset2, tmp_env2);
+	/*
+	 * Read the headers to see which copy is newer, then read and check
+	 * only that one, falling back to the other if it is bad.
+	 */
+	read_fail[0] = read_env_flags(mmc, offset[0], &flags[0]);
+	read_fail[1] = read_env_flags(mmc, offset[1], &flags[1]);
+	if (read_fail[0])
+		copy = 1;
+	else if (read_fail[1])
+		copy = 0;
+	else
+		copy = env_newer_copy(flags[0], flags[1]);
+
+	for (tries = 0; tries < 2; tries++, copy = !copy) {
+		if (read_fail[copy])
+			continue;
+		read_fail[copy] = read_env(mmc, CONFIG_ENV_SIZE, offset[copy],
+					   tmp_env);
+		if (!read_fail[copy] &&
+		    crc32(0, tmp_env->data, ENV_SIZE) == tmp_env->crc)
+			break;
+	}
 
-	if (read1_fail && read2_fail)
+	if (read_fail[0] && read_fail[1])
 		puts("*** Error - No Valid Environment Area found\n");
-	else if (read1_fail || read2_fail)
+	else if (read_fail[0] || read_fail[1])
 		puts("*** Warning - some problems detected "
 		     "reading environment; recovered successfully\n");
 
-	crc1_ok = !read1_fail &&
-		(crc32(0, tmp_env1->data, ENV_SIZE) == tmp_env1->crc);
-	crc2_ok = !read2_fail &&
-		(crc32(0, tmp_env2->data, ENV_SIZE) == tmp_env2->crc);
-
-	if (!crc1_ok && !crc2_ok) {
+	if (tries == 2) {
 		errmsg = "!bad CRC";
 		ret = 1;
 		goto fini;
-	} else if (crc1_ok && !crc2_ok) {
-		gd->env_valid = 1;
-	} else if (!crc1_ok && crc2_ok) {
-		gd->env_valid = 2;
-	} else {
-		/* both ok - check serial */
-		if (tmp_env1->flags == 255 && tmp_env2->flags == 0)
-			gd->env_valid = 2;
-		else if (tmp_env2->flags == 255 && tmp_env1->flags == 0)
-			gd->env_valid = 1;
-		else if (tmp_env1->flags > tmp_env2->flags)
-			gd->env_valid = 1;
-		else if (tmp_env2->flags > tmp_env1->flags)
-			gd->env_valid = 2;
-		else /* flags are equal - almost impossible */
-			gd->env_valid = 1;
 	}
+	gd->env_valid = copy + 1;
 
 	free(env_ptr);
 
-	if (gd->env_valid == 1)
-		ep = tmp_env1;
-	else
-		ep = tmp_env2;
-
-	env_flags = ep->flags;
-	env_import((char *)ep, 0);
+	env_flags = tmp_env->flags;
+	env_import_inplace((char *)tmp_env, 0);
 	ret = 0;
 
 fini:
@@ -329,7 +350,7 @@ void env_relocate_spec(void)
 		goto fini;
 	}
 
-	env_import(buf, 1);
+	env_import_inplace(buf, 1);
 	ret = 0;
 
 fini:
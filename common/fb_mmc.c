@@ -59,6 +59,15 @@ static lbaint_t fb_mmc_sparse_reserve(struct sparse_storage *info,
 	return blkcnt;
 }
 
+static lbaint_t fb_mmc_sparse_erase(struct sparse_storage *info,
+		lbaint_t blk, lbaint_t blkcnt)
+{
+	struct fb_mmc_sparse *sparse = info->priv;
+	struct blk_desc *dev_desc = sparse->dev_desc;
+
+	return blk_derase(dev_desc, blk, blkcnt);
+}
+
 static void write_raw_image(struct blk_desc *dev_desc, disk_partition_t *info,
 		const char *part_name, void *buffer,
 		unsigned int download_bytes)
@@ -130,7 +139,9 @@ void fb_mmc_flash_write(const char *cmd, void *download_buffer,
 	if (is_sparse_image(download_buffer)) {
 		struct fb_mmc_sparse sparse_priv;
 		struct sparse_storage sparse;
+		struct mmc *mmc;
 
+		memset(&sparse, '\0', sizeof(sparse));
 		sparse_priv.dev_desc = dev_desc;
 
 		sparse.blksz = info.blksz;
@@ -138,13 +149,26 @@ void fb_mmc_flash_write(const char *cmd, void *download_buffer,
 		sparse.size = info.size;
 		sparse.write = fb_mmc_sparse_write;
 		sparse.reserve = fb_mmc_sparse_reserve;
+		sparse.mssg = fastboot_fail;
+
+		/* Erase FILL regions which match the erased state */
+		mmc = find_mmc_device(CONFIG_FASTBOOT_FLASH_MMC_DEV);
+		if (mmc && mmc->erase_grp_size) {
+			sparse.erase = fb_mmc_sparse_erase;
+			sparse.erase_grp = mmc->erase_grp_size;
+			sparse.erase_val = mmc->erased_val ? 0xffffffff : 0;
+#ifdef CONFIG_FASTBOOT_FLASH_MMC_DISCARD
+			sparse.discard = true;
+#endif
+		}
 
 		printf("Flashing sparse image at offset " LBAFU "\n",
 		       sparse.start);
 
 		sparse.priv = &sparse_priv;
-		write_sparse_image(&sparse, cmd, download_buffer,
-				   download_bytes);
+		if (!write_sparse_image(&sparse, cmd, download_buffer,
+					download_bytes))
+			fastboot_okay("");
 	} else {
 		write_raw_image(dev_desc, &info, cmd, download_buffer,
 				download_bytes);
@@ -167,6 +167,7 @@ void fb_nand_flash_write(const char *cmd, void *download_buffer,
 		struct fb_nand_sparse sparse_priv;
 		struct sparse_storage sparse;
 
+		memset(&sparse, '\0', sizeof(sparse));
 		sparse_priv.mtd = mtd;
 		sparse_priv.part = part;
 
@@ -175,13 +176,17 @@ void fb_nand_flash_write(const char *cmd, void *download_buffer,
 		sparse.size = part->size / sparse.blksz;
 		sparse.write = fb_nand_sparse_write;
 		sparse.reserve = fb_nand_sparse_reserve;
+		sparse.mssg = fastboot_fail;
 
 		printf("Flashing sparse image at offset " LBAFU "\n",
 		       sparse.start);
 
 		sparse.priv = &sparse_priv;
-		write_sparse_image(&sparse, cmd, download_buffer,
-				   download_bytes);
+		ret = write_sparse_image(&sparse, cmd, download_buffer,
+					 download_bytes);
+		/* Failure has already been reported by write_sparse_image() */
+		if (ret)
+			return;
 	} else {
 		printf("Flashing raw image at offset 0x%llx\n",
 		       part->offset);
@@ -0,0 +1,608 @@
+/*
+ *  Copyright (C) 2010-2019 NVIDIA CORPORATION.
+ *
+ * SPDX-License-Identifier: GPL-2.0
+ */
+
+#include <stdlib.h>
+#include <common.h>
+#include <fdt_support.h>
+#include <fdtdec.h>
+#include <fdt_edit.h>
+
+#define fdt_for_each_property(fdt, prop, parent)		\
+	for (prop = fdt_first_property_offset(fdt, parent);	\
+	     prop >= 0;						\
+	     prop = fdt_next_property_offset(fdt, prop))
+static int fdt_copy_node_content(void *blob_src, int ofs_src, void *blob_dst,
+		int ofs_dst, int indent)
+{
+	int ofs_src_child, ofs_dst_child;
+	int ret;
+
+	/*
+	 * FIXME: This doesn't remove properties or nodes in the destination
+	 * that are not present in the source. For the nodes we care about
+	 * right now, this is not an issue.
+	 */
+
+	fdt_for_each_property(blob_src, ofs_src_child, ofs_src) {
+		const void *prop;
+		const char *name;
+		int len;
+
+		prop = fdt_getprop_by_offset(blob_src, ofs_src_child, &name,
+					     &len);
+		debug("%s: %*scopy prop: %s\n", __func__, indent, "", name);
+add_prop:
+		ret = fdt_setprop(blob_dst, ofs_dst, name, prop, len);
+		if (ret == -FDT_ERR_NOSPACE) {
+			ret = fdt_increase_size(blob_dst, 512);
+			debug("Increased FDT blob size by 512 bytes\n");
+			if (!ret)
+				goto add_prop;		/* retry setprop */
+			else
+				goto err_ret;		/* error out */
+		} else if (ret < 0) {
+			error("Can't copy DT prop %s: %s\n",
+			      name, fdt_strerror(ret));
+			return ret;
+		}
+	}
+
+	fdt_for_each_subnode(blob_src, ofs_src_child, ofs_src) {
+		const char *name;
+
+		name = fdt_get_name(blob_src, ofs_src_child, NULL);
+		debug("%s: %*scopy node: %s\n", __func__, indent, "", name);
+
+		ofs_dst_child = fdt_subnode_offset(blob_dst, ofs_dst, name);
+		if (ofs_dst_child < 0) {
+			debug("%s: %*s(creating it in dst)\n", __func__,
+			      indent, "");
+add_node:
+			ofs_dst_child = fdt_add_subnode(blob_dst, ofs_dst,
+							name);
+			if (ofs_dst_child == -FDT_ERR_NOSPACE) {
+				ret = fdt_increase_size(blob_dst, 512);
+				debug("Increased FDT blob size by 512 bytes\n");
+				if (!ret)
+					goto add_node;	/* retry add_subnode */
+				else
+					goto err_ret;	/* error out */
+			} else if (ofs_dst_child < 0) {
+				error("Can't copy DT node %s: %s\n",
+				      name, fdt_strerror(ofs_dst_child));
+				return ofs_dst_child;
+			}
+		}
+
+		fdt_copy_node_content(blob_src, ofs_src_child, blob_dst,
+				      ofs_dst_child, indent + 2);
+	}
+
+	return 0;
+
+err_ret:
+	printf("Can't increase blob size: %s\n", fdt_strerror(ret));
+	return ret;
+}
+
+__weak void *fdt_copy_get_blob_src_default(void)
+{
+	return NULL;
+}
+
+static void *no_self_copy(void *blob_src, void *blob_dst)
+{
+	if (blob_src == blob_dst)
+		return NULL;
+	return blob_src;
+}
+
+static void *fdt_get_copy_blob_src(void *blob_dst)
+{
+	char *src_addr_s;
+
+	src_addr_s = getenv("fdt_copy_src_addr");
+	if (!src_addr_s)
+		return no_self_copy(fdt_copy_get_blob_src_default(), blob_dst);
+	return no_self_copy((void *)simple_strtoul(src_addr_s, NULL, 16),
+			    blob_dst);
+}
+
+/*
+ * Edits requested through the environment are applied by a small engine
+ * rather than one path at a time:
+ *
+ * - All the lists are parsed first and the source nodes and properties are
+ *   looked up once.
+ * - The destination blob is then grown once, by enough to hold everything
+ *   which will be copied, so that it is not reopened for each property.
+ * - The edits are applied in a single pass. Destination nodes are looked up
+ *   through a cache of path -> offset, which is adjusted as the blob
+ *   changes, so each path is only walked from the root once.
+ */
+enum dt_edit_type {
+	DT_EDIT_DEL_NODE,
+	DT_EDIT_DEL_PROP,
+	DT_EDIT_COPY_NODE,
+	DT_EDIT_COPY_PROP,
+
+	DT_EDIT_COUNT,
+};
+
+/* Environment variable holding the list of paths for each type of edit */
+static const char *const dt_edit_varname[DT_EDIT_COUNT] = {
+	"fdt_del_node_paths",
+	"fdt_del_prop_paths",
+	"fdt_copy_node_paths",
+	"fdt_copy_prop_paths",
+};
+
+/**
+ * struct dt_edit_op - A single edit
+ *
+ * @type:	Type of edit
+ * @path:	Node path (for properties, "" means the root node)
+ * @prop:	Property name, or NULL for node edits
+ * @ofs_src:	Source node offset, for copies
+ * @data:	Source property value, for property copies
+ * @len:	Length of @data
+ * @err:	Error found while looking up the source, if any
+ */
+struct dt_edit_op {
+	enum dt_edit_type type;
+	char *path;
+	char *prop;
+	int ofs_src;
+	const void *data;
+	int len;
+	int err;
+};
+
+/**
+ * struct dt_path_ent - Cached offset of a destination node
+ *
+ * @path:	Path of the node (not nul-terminated)
+ * @len:	Length of @path
+ * @ofs:	Offset of the node in the destination blob
+ */
+struct dt_path_ent {
+	const char *path;
+	int len;
+	int ofs;
+};
+
+/**
+ * struct dt_edit - State of a batch of edits
+ *
+ * @blob_src:	Blob to copy from, or NULL if there is none
+ * @blob_dst:	Blob to edit
+ * @lists:	Copies of the environment variables, which hold the paths
+ * @ops:	Edits to apply, in order
+ * @num_ops:	Number of edits
+ * @cache:	Destination path cache
+ * @num_cache:	Number of entries in @cache
+ */
+struct dt_edit {
+	void *blob_src;
+	void *blob_dst;
+	char *lists[DT_EDIT_COUNT];
+	struct dt_edit_op *ops;
+	int num_ops;
+	struct dt_path_ent *cache;
+	int num_cache;
+};
+
+/* Return the offset just past the end of a node and its subnodes */
+static int dt_node_end(const void *blob, int ofs)
+{
+	int depth = 0;
+
+	do {
+		ofs = fdt_next_node(blob, ofs, &depth);
+	} while (ofs >= 0 && depth > 0);
+
+	return ofs >= 0 ? ofs : fdt_size_dt_struct(blob);
+}
+
+/* Return the space needed to add a property to a blob, at most */
+static int dt_prop_space(const char *name, int len)
+{
+	return sizeof(struct fdt_property) + ALIGN(len, FDT_TAGSIZE) +
+		strlen(name) + 1;
+}
+
+/* Return the space needed to copy the contents of a source node, at most */
+static int dt_node_space(const void *blob, int ofs)
+{
+	int end = dt_node_end(blob, ofs);
+	int depth = 0;
+	int space;
+	int prop;
+
+	/* The structure, plus all the property names in case they are new */
+	space = end - ofs;
+	for (; ofs >= 0 && ofs < end; ofs = fdt_next_node(blob, ofs, &depth)) {
+		fdt_for_each_property(blob, prop, ofs) {
+			const char *name;
+
+			fdt_getprop_by_offset(blob, prop, &name, NULL);
+			space += strlen(name) + 1;
+		}
+	}
+
+	return space;
+}
+
+/* Return the space needed to create all the nodes in a path, at most */
+static int dt_path_space(const char *path)
+{
+	const char *p;
+	int space;
+
+	/* Each node has begin and end tags, and a padded name */
+	space = strlen(path);
+	for (p = path; *p; p++) {
+		if (*p == '/')
+			space += 3 * FDT_TAGSIZE;
+	}
+
+	return space;
+}
+
+/*
+ * Update the path cache after the destination blob has changed at or after
+ * @ofs by @delta bytes. Nodes inside [@ofs, @end) are no longer valid.
+ */
+static void dt_edit_moved(struct dt_edit *ed, int ofs, int end, int delta)
+{
+	int i, j;
+
+	for (i = 0, j = 0; i < ed->num_cache; i++) {
+		struct dt_path_ent *ent = &ed->cache[i];
+
+		if (ent->ofs > ofs && ent->ofs < end)
+			continue;
+		if (ent->ofs > ofs)
+			ent->ofs += delta;
+		ed->cache[j++] = *ent;
+	}
+	ed->num_cache = j;
+}
+
+/* Apply a change to the blob made by a function, keeping the cache valid */
+#define dt_edit_change(ed, ofs, end, call) ({				\
+	int _old = fdt_size_dt_struct((ed)->blob_dst);			\
+	int _ret = (call);						\
+									\
+	dt_edit_moved(ed, ofs, end,					\
+		      fdt_size_dt_struct((ed)->blob_dst) - _old);	\
+	_ret; })
+
+/**
+ * dt_edit_lookup() - Find a destination node by path, using the cache
+ *
+ * @ed:		Edit state
+ * @path:	Path to look up (need not be nul-terminated)
+ * @len:	Length of @path
+ * @create:	true to create any missing nodes
+ * @return node offset, or -ve FDT_ERR_... value
+ */
+static int dt_edit_lookup(struct dt_edit *ed, const char *path, int len,
+			  bool create)
+{
+	struct dt_path_ent *ent;
+	const char *name;
+	int parent, ofs;
+	int i;
+
+	/* Drop any trailing '/' */
+	while (len > 0 && path[len - 1] == '/')
+		len--;
+	if (!len)
+		return 0;
+
+	for (i = 0; i < ed->num_cache; i++) {
+		ent = &ed->cache[i];
+		if (ent->len == len && !memcmp(ent->path, path, len))
+			return ent->ofs;
+	}
+
+	if (*path != '/') {
+		/* An alias, which cannot be created */
+		ofs = fdt_path_offset(ed->blob_dst, path);
+	} else {
+		for (name = path + len; name[-1] != '/'; name--)
+			;
+		parent = dt_edit_lookup(ed, path, name - path, create);
+		if (parent < 0)
+			return parent;
+		ofs = fdt_subnode_offset_namelen(ed->blob_dst, parent, name,
+						 path + len - name);
+		if (ofs == -FDT_ERR_NOTFOUND && create) {
+			debug("%s: creating %.*s\n", __func__, len, path);
+			ofs = dt_edit_change(ed, parent, parent,
+					     fdt_add_subnode_namelen(ed->blob_dst,
+						parent, name, path + len - name));
+		}
+	}
+	if (ofs < 0)
+		return ofs;
+
+	ent = realloc(ed->cache, (ed->num_cache + 1) * sizeof(*ent));
+	if (ent) {
+		ed->cache = ent;
+		ent += ed->num_cache++;
+		ent->path = path;
+		ent->len = len;
+		ent->ofs = ofs;
+	}
+
+	return ofs;
+}
+
+/*
+ * Look up the source of a copy and work out how much it may grow the
+ * destination. Returns the number of bytes, or -ve on error.
+ */
+static int dt_edit_prepare(struct dt_edit *ed, struct dt_edit_op *op)
+{
+	if (op->type == DT_EDIT_COPY_NODE) {
+		op->ofs_src = fdt_path_offset(ed->blob_src, op->path);
+		if (op->ofs_src < 0)
+			return 0;
+		return dt_path_space(op->path) +
+			dt_node_space(ed->blob_src, op->ofs_src);
+	}
+
+	op->ofs_src = 0;
+	if (*op->path) {
+		op->ofs_src = fdt_path_offset(ed->blob_src, op->path);
+		if (op->ofs_src < 0) {
+			error("DT node %s missing in source; can't copy %s\n",
+			      op->path, op->prop);
+			return -1;
+		}
+	}
+	op->data = fdt_getprop(ed->blob_src, op->ofs_src, op->prop, &op->len);
+	if (!op->data) {
+		error("DT property %s/%s missing in source; can't copy\n",
+		      op->path, op->prop);
+		return -1;
+	}
+
+	return dt_prop_space(op->prop, op->len);
+}
+
+static int dt_edit_apply(struct dt_edit *ed, struct dt_edit_op *op)
+{
+	void *blob = ed->blob_dst;
+	int ofs, end, ret;
+
+	switch (op->type) {
+	case DT_EDIT_DEL_NODE:
+		ofs = dt_edit_lookup(ed, op->path, strlen(op->path), false);
+		/* Node doesn't exist -> property can't exist -> it's removed! */
+		if (ofs == -FDT_ERR_NOTFOUND)
+			return 0;
+		if (ofs < 0) {
+			error("DT node %s lookup failure; can't del node\n",
+			      op->path);
+			return ofs;
+		}
+		end = dt_node_end(blob, ofs);
+		return dt_edit_change(ed, ofs - 1, end, fdt_del_node(blob, ofs));
+	case DT_EDIT_DEL_PROP:
+		ofs = dt_edit_lookup(ed, op->path, strlen(op->path), false);
+		/* Node doesn't exist -> property can't exist -> it's removed! */
+		if (ofs == -FDT_ERR_NOTFOUND)
+			return 0;
+		if (ofs < 0) {
+			error("DT node %s lookup failure; can't del prop %s\n",
+			      op->path, op->prop);
+			return ofs;
+		}
+		ret = dt_edit_change(ed, ofs, ofs,
+				     fdt_delprop(blob, ofs, op->prop));
+		/* Property doesn't exist -> it's already removed! */
+		if (ret == -FDT_ERR_NOTFOUND)
+			return 0;
+		return ret;
+	case DT_EDIT_COPY_NODE:
+		ofs = dt_edit_lookup(ed, op->path, strlen(op->path), true);
+		if (ofs < 0) {
+			error("Can't find/create dest DT node %s to copy\n",
+			      op->path);
+			return ofs;
+		}
+		if (!fdtdec_get_is_enabled(blob, ofs)) {
+			debug("%s: DT node %s disabled in dest; skipping copy\n",
+			      __func__, op->path);
+			return 0;
+		}
+		if (op->ofs_src < 0) {
+			error("DT node %s missing in source; can't copy\n",
+			      op->path);
+			return 0;
+		}
+		end = dt_node_end(blob, ofs);
+		return dt_edit_change(ed, ofs, end,
+				      fdt_copy_node_content(ed->blob_src,
+							    op->ofs_src, blob,
+							    ofs, 2));
+	case DT_EDIT_COPY_PROP:
+		ofs = dt_edit_lookup(ed, op->path, strlen(op->path), false);
+		if (ofs < 0) {
+			error("DT node %s missing in dest; can't copy prop %s\n",
+			      op->path, op->prop);
+			return -1;
+		}
+		ret = dt_edit_change(ed, ofs, ofs,
+				     fdt_setprop(blob, ofs, op->prop, op->data,
+						 op->len));
+		if (ret < 0)
+			error("Can't set DT prop %s/%s: %s\n",
+			      op->path, op->prop, fdt_strerror(ret));
+		return ret;
+	default:
+		return -1;
+	}
+}
+
+/* Add the edits listed in an environment variable */
+static int dt_edit_add_list(struct dt_edit *ed, enum dt_edit_type type)
+{
+	struct dt_edit_op *op;
+	char *items, *item;
+
+	items = getenv(dt_edit_varname[type]);
+	if (!items) {
+		debug("%s: No env var %s\n", __func__, dt_edit_varname[type]);
+		return 0;
+	}
+
+	items = strdup(items);
+	if (!items) {
+		error("strdup(%s) failed", dt_edit_varname[type]);
+		return -1;
+	}
+	ed->lists[type] = items;
+
+	while ((item = strsep(&items, ":"))) {
+		debug("%s: item: %s\n", __func__, item);
+		op = realloc(ed->ops, (ed->num_ops + 1) * sizeof(*op));
+		if (!op)
+			return -1;
+		ed->ops = op;
+		op += ed->num_ops++;
+		memset(op, '\0', sizeof(*op));
+		op->type = type;
+		op->path = item;
+
+		if (type == DT_EDIT_COPY_NODE && item[0] != '/') {
+			error("Can't add path %s; missing leading /", item);
+			ed->num_ops--;
+			return -1;
+		}
+		if (type == DT_EDIT_DEL_PROP || type == DT_EDIT_COPY_PROP) {
+			op->prop = strrchr(item, '/');
+			if (!op->prop) {
+				error("Can't edit prop %s; missing /", item);
+				ed->num_ops--;
+				return -1;
+			}
+			*op->prop++ = '\0';
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * fdt_edit_env_lists() - Apply the edits listed in the environment
+ *
+ * The lists are applied in the order of enum dt_edit_type. As before, an
+ * error stops the rest of the list it is in, but not the other lists.
+ *
+ * @blob_dst:	Blob to edit
+ * @types:	Bitmask of the lists to apply, 1 << enum dt_edit_type
+ * @return 0 if OK, -1 if any edit failed
+ */
+static int fdt_edit_env_lists(void *blob_dst, uint types)
+{
+	struct dt_edit ed;
+	uint failed = 0;
+	int space, ret;
+	int type, i;
+
+	memset(&ed, '\0', sizeof(ed));
+	ed.blob_dst = blob_dst;
+	ed.blob_src = fdt_get_copy_blob_src(blob_dst);
+	if (!ed.blob_src) {
+		debug("%s: No source DT\n", __func__);
+		types &= ~(1 << DT_EDIT_COPY_NODE | 1 << DT_EDIT_COPY_PROP);
+	}
+
+	for (type = 0; type < DT_EDIT_COUNT; type++) {
+		if ((types & 1 << type) && dt_edit_add_list(&ed, type))
+			failed |= 1 << type;
+	}
+
+	/* Look up the sources and make room for everything in one go */
+	space = 0;
+	for (i = 0; i < ed.num_ops; i++) {
+		struct dt_edit_op *op = &ed.ops[i];
+
+		if (op->type != DT_EDIT_COPY_NODE &&
+		    op->type != DT_EDIT_COPY_PROP)
+			continue;
+		ret = dt_edit_prepare(&ed, op);
+		if (ret < 0)
+			op->err = ret;
+		else
+			space += ret;
+	}
+	if (space) {
+		ret = fdt_increase_size(blob_dst, space);
+		if (ret) {
+			printf("Can't increase blob size: %s\n",
+			       fdt_strerror(ret));
+			failed |= 1 << DT_EDIT_COPY_NODE | 1 << DT_EDIT_COPY_PROP;
+		}
+		debug("Increased FDT blob size by %d bytes\n", space);
+	}
+
+	for (i = 0; i < ed.num_ops; i++) {
+		struct dt_edit_op *op = &ed.ops[i];
+
+		if (failed & 1 << op->type)
+			continue;
+		ret = op->err ? op->err : dt_edit_apply(&ed, op);
+		if (ret < 0)
+			failed |= 1 << op->type;
+	}
+
+	for (type = 0; type < DT_EDIT_COUNT; type++)
+		free(ed.lists[type]);
+	free(ed.ops);
+	free(ed.cache);
+
+	return failed ? -1 : 0;
+}
+
+int fdt_copy_env_nodelist(void *blob_dst)
+{
+	debug("%s:\n", __func__);
+
+	return fdt_edit_env_lists(blob_dst, 1 << DT_EDIT_COPY_NODE);
+}
+
+int fdt_copy_env_proplist(void *blob_dst)
+{
+	debug("%s:\n", __func__);
+
+	return fdt_edit_env_lists(blob_dst, 1 << DT_EDIT_COPY_PROP);
+}
+
+int fdt_del_env_nodelist(void *blob_dst)
+{
+	debug("%s:\n", __func__);
+
+	return fdt_edit_env_lists(blob_dst, 1 << DT_EDIT_DEL_NODE);
+}
+
+int fdt_del_env_proplist(void *blob_dst)
+{
+	debug("%s:\n", __func__);
+
+	return fdt_edit_env_lists(blob_dst, 1 << DT_EDIT_DEL_PROP);
+}
+
+int fdt_edit_env_all(void *blob_dst)
+{
+	debug("%s:\n", __func__);
+
+	return fdt_edit_env_lists(blob_dst, (1 << DT_EDIT_COUNT) - 1);
+}
@@ -884,8 +884,12 @@ int fit_set_timestamp(void *fit, int noffset, time_t timestamp)
 	int ret;
 
 	t = cpu_to_uimage(timestamp);
-	ret = fdt_setprop(fit, noffset, FIT_TIMESTAMP_PROP, &t,
-				sizeof(uint32_t));
+	/* Avoid moving the rest of the FIT if the property is already there */
+	ret = fdt_setprop_inplace(fit, noffset, FIT_TIMESTAMP_PROP, &t,
+				  sizeof(uint32_t));
+	if (ret)
+		ret = fdt_setprop(fit, noffset, FIT_TIMESTAMP_PROP, &t,
+				  sizeof(uint32_t));
 	if (ret) {
 		debug("Can't set '%s' property for '%s' node (%s)\n",
 		      FIT_TIMESTAMP_PROP, fit_get_name(fit, noffset, NULL),
@@ -940,8 +944,8 @@ int calculate_hash(const void *data, int data_len, const char *algo,
 	return 0;
 }
 
-static int fit_image_check_hash(const void *fit, int noffset, const void *data,
-				size_t size, char **err_msgp)
+int fit_image_check_hash(const void *fit, int noffset, const void *data,
+			 size_t size, char **err_msgp)
 {
 	uint8_t value[FIT_MAX_HASH_LEN];
 	int value_len;
@@ -41,7 +41,7 @@
 #include <malloc.h>
 #include <part.h>
 #include <sparse_format.h>
-#include <fastboot.h>
+#include <errno.h>
 
 #include <linux/math64.h>
 
@@ -49,27 +49,227 @@
 #define CONFIG_FASTBOOT_FLASH_FILLBUF_SIZE (1024 * 512)
 #endif
 
-void write_sparse_image(
+/*
+ * RAW chunks up to this size are moved in memory so that they directly
+ * follow the data of the preceding RAW chunk; the whole run is then
+ * written with a single call. Larger chunks are written from where they
+ * are, since the copy would cost more than the extra write command.
+ */
+#define SPARSE_MERGE_MAX_SIZE	(1024 * 1024)
+
+struct sparse_state {
+	struct sparse_storage *info;
+	lbaint_t blk;			/* next block to write */
+	lbaint_t end;			/* first block past the partition */
+	void *raw_data;			/* pending RAW run */
+	lbaint_t raw_blkcnt;
+	uint32_t *fill_buf;
+	lbaint_t fill_buf_blks;
+	uint32_t fill_buf_val;
+	bool fill_buf_valid;
+};
+
+static int sparse_check_range(struct sparse_state *st, lbaint_t blkcnt)
+{
+	if (st->blk + st->raw_blkcnt + blkcnt > st->end) {
+		printf("%s: Request would exceed partition size!\n", __func__);
+		st->info->mssg("Request would exceed partition size!");
+		return -ENOSPC;
+	}
+
+	return 0;
+}
+
+static int sparse_write(struct sparse_state *st, lbaint_t blkcnt,
+			const void *buf)
+{
+	struct sparse_storage *info = st->info;
+	lbaint_t blks;
+
+	blks = info->write(info, st->blk, blkcnt, buf);
+	/* blks might be > blkcnt (eg. NAND bad-blocks) */
+	if (blks < blkcnt) {
+		printf("%s: %s" LBAFU " [" LBAFU "]\n", __func__,
+		       "Write failed, block #", st->blk, blks);
+		info->mssg("flash write failure");
+		return -EIO;
+	}
+	st->blk += blks;
+
+	return 0;
+}
+
+static int sparse_flush_raw(struct sparse_state *st)
+{
+	int ret;
+
+	if (!st->raw_blkcnt)
+		return 0;
+
+	debug("%s: writing " LBAFU " blocks at " LBAFU "\n", __func__,
+	      st->raw_blkcnt, st->blk);
+	ret = sparse_write(st, st->raw_blkcnt, st->raw_data);
+	st->raw_blkcnt = 0;
+
+	return ret;
+}
+
+static int sparse_add_raw(struct sparse_state *st, void *data,
+			  lbaint_t blkcnt)
+{
+	struct sparse_storage *info = st->info;
+	lbaint_t size = blkcnt * info->blksz;
+	void *run_end;
+	int ret;
+
+	ret = sparse_check_range(st, blkcnt);
+	if (ret)
+		return ret;
+
+	if (st->raw_blkcnt) {
+		if (size > SPARSE_MERGE_MAX_SIZE) {
+			ret = sparse_flush_raw(st);
+			if (ret)
+				return ret;
+		} else {
+			run_end = st->raw_data + st->raw_blkcnt * info->blksz;
+			/* Overwrites the (already parsed) chunk header(s) */
+			if (run_end != data)
+				memmove(run_end, data, size);
+			st->raw_blkcnt += blkcnt;
+			return 0;
+		}
+	}
+	st->raw_data = data;
+	st->raw_blkcnt = blkcnt;
+
+	return 0;
+}
+
+static int sparse_fill(struct sparse_state *st, lbaint_t blkcnt,
+		       uint32_t fill_val)
+{
+	struct sparse_storage *info = st->info;
+	lbaint_t j;
+	int i;
+	int ret;
+
+	if (!blkcnt)
+		return 0;
+
+	if (!st->fill_buf) {
+		st->fill_buf = memalign(ARCH_DMA_MINALIGN,
+					ROUNDUP(info->blksz * st->fill_buf_blks,
+						ARCH_DMA_MINALIGN));
+		if (!st->fill_buf) {
+			info->mssg("Malloc failed for: CHUNK_TYPE_FILL");
+			return -ENOMEM;
+		}
+	}
+
+	/* The buffer is kept across chunks, refill only on a new pattern */
+	if (!st->fill_buf_valid || st->fill_buf_val != fill_val) {
+		for (i = 0;
+		     i < (info->blksz * st->fill_buf_blks / sizeof(fill_val));
+		     i++)
+			st->fill_buf[i] = fill_val;
+		st->fill_buf_val = fill_val;
+		st->fill_buf_valid = true;
+	}
+
+	while (blkcnt) {
+		j = min(blkcnt, st->fill_buf_blks);
+		ret = sparse_write(st, j, st->fill_buf);
+		if (ret)
+			return ret;
+		blkcnt -= j;
+	}
+
+	return 0;
+}
+
+static int sparse_skip(struct sparse_state *st, lbaint_t blkcnt)
+{
+	struct sparse_storage *info = st->info;
+
+	if (blkcnt)
+		st->blk += info->reserve(info, st->blk, blkcnt);
+
+	return 0;
+}
+
+/*
+ * Handle a FILL (or, if @fill is false, a DONT_CARE) range. Where the
+ * storage supports it, the erase-group aligned middle of the range is
+ * erased instead of written; the unaligned head and tail are written
+ * (or skipped) as usual.
+ */
+static int sparse_fill_or_erase(struct sparse_state *st, lbaint_t blkcnt,
+				bool fill, uint32_t fill_val)
+{
+	struct sparse_storage *info = st->info;
+	lbaint_t first, last, head = 0, mid = 0;
+	lbaint_t blks;
+	u32 grp;
+	int ret;
+
+	if (info->erase && info->erase_grp &&
+	    (fill ? fill_val == info->erase_val : info->discard)) {
+		/* The erase group size need not be a power of two */
+		grp = info->erase_grp;
+		first = lldiv(st->blk + grp - 1, grp) * grp;
+		last = lldiv(st->blk + blkcnt, grp) * grp;
+		if (last > first) {
+			head = first - st->blk;
+			mid = last - first;
+		}
+	}
+
+	ret = fill ? sparse_fill(st, mid ? head : blkcnt, fill_val) :
+		     sparse_skip(st, mid ? head : blkcnt);
+	if (ret || !mid)
+		return ret;
+
+	debug("%s: erasing " LBAFU " blocks at " LBAFU "\n", __func__, mid,
+	      st->blk);
+	blks = info->erase(info, st->blk, mid);
+	if (blks != mid) {
+		printf("%s: %s" LBAFU " [" LBAFU "]\n", __func__,
+		       "Erase failed, block #", st->blk, blks);
+		info->mssg("flash erase failure");
+		return -EIO;
+	}
+	st->blk += mid;
+	blkcnt -= head + mid;
+
+	return fill ? sparse_fill(st, blkcnt, fill_val) :
+		      sparse_skip(st, blkcnt);
+}
+
+int write_sparse_image(
 		struct sparse_storage *info, const char *part_name,
 		void *data, unsigned sz)
 {
-	lbaint_t blk;
+	struct sparse_state st;
 	lbaint_t blkcnt;
-	lbaint_t blks;
 	uint32_t bytes_written = 0;
 	unsigned int chunk;
 	unsigned int offset;
 	unsigned int chunk_data_sz;
-	uint32_t *fill_buf = NULL;
 	uint32_t fill_val;
 	sparse_header_t *sparse_header;
 	chunk_header_t *chunk_header;
+	uint16_t chunk_type;
+	uint32_t chunk_sz;
+	uint32_t total_sz;
 	uint32_t total_blocks = 0;
-	int fill_buf_num_blks;
-	int i;
-	int j;
+	int ret = 0;
 
-	fill_buf_num_blks = CONFIG_FASTBOOT_FLASH_FILLBUF_SIZE / info->blksz;
+	memset(&st, '\0', sizeof(st));
+	st.info = info;
+	st.blk = info->start;
+	st.end = info->start + info->size;
+	st.fill_buf_blks = CONFIG_FASTBOOT_FLASH_FILLBUF_SIZE / info->blksz;
 
 	/* Read and skip over sparse image header */
 	sparse_header = (sparse_header_t *)data;
@@ -101,24 +301,34 @@ void write_sparse_image(
 	if (offset) {
 		printf("%s: Sparse image block size issue [%u]\n",
 		       __func__, sparse_header->blk_sz);
-		fastboot_fail("sparse image block size issue");
-		return;
+		info->mssg("sparse image block size issue");
+		return -EINVAL;
 	}
 
 	puts("Flashing Sparse Image\n");
 
 	/* Start processing chunks */
-	blk = info->start;
 	for (chunk = 0; chunk < sparse_header->total_chunks; chunk++) {
-		/* Read and skip over chunk header */
+		/*
+		 * Read and skip over chunk header. The header may be
+		 * overwritten when RAW data is merged, so take a copy.
+		 */
 		chunk_header = (chunk_header_t *)data;
+		chunk_type = chunk_header->chunk_type;
+		chunk_sz = chunk_header->chunk_sz;
+		total_sz = chunk_header->total_sz;
 		data += sizeof(chunk_header_t);
 
-		if (chunk_header->chunk_type != CHUNK_TYPE_RAW) {
+		if (chunk_type != CHUNK_TYPE_RAW) {
 			debug("=== Chunk Header ===\n");
-			debug("chunk_type: 0x%x\n", chunk_header->chunk_type);
-			debug("chunk_data_sz: 0x%x\n", chunk_header->chunk_sz);
-			debug("total_size: 0x%x\n", chunk_header->total_sz);
+			debug("chunk_type: 0x%x\n", chunk_type);
+			debug("chunk_data_sz: 0x%x\n", chunk_sz);
+			debug("total_size: 0x%x\n", total_sz);
+
+			/* Only consecutive RAW chunks are merged */
+			ret = sparse_flush_raw(&st);
+			if (ret)
+				goto out;
 		}
 
 		if (sparse_header->chunk_hdr_sz > sizeof(chunk_header_t)) {
@@ -130,135 +340,95 @@ void write_sparse_image(
 				 sizeof(chunk_header_t));
 		}
 
-		chunk_data_sz = sparse_header->blk_sz * chunk_header->chunk_sz;
+		chunk_data_sz = sparse_header->blk_sz * chunk_sz;
 		blkcnt = chunk_data_sz / info->blksz;
-		switch (chunk_header->chunk_type) {
+		switch (chunk_type) {
 		case CHUNK_TYPE_RAW:
-			if (chunk_header->total_sz !=
+			if (total_sz !=
 			    (sparse_header->chunk_hdr_sz + chunk_data_sz)) {
-				fastboot_fail(
+				info->mssg(
 					"Bogus chunk size for chunk type Raw");
-				return;
+				ret = -EINVAL;
+				goto out;
 			}
 
-			if (blk + blkcnt > info->start + info->size) {
-				printf(
-				    "%s: Request would exceed partition size!\n",
-				    __func__);
-				fastboot_fail(
-				    "Request would exceed partition size!");
-				return;
-			}
-
-			blks = info->write(info, blk, blkcnt, data);
-			/* blks might be > blkcnt (eg. NAND bad-blocks) */
-			if (blks < blkcnt) {
-				printf("%s: %s" LBAFU " [" LBAFU "]\n",
-				       __func__, "Write failed, block #",
-				       blk, blks);
-				fastboot_fail(
-					      "flash write failure");
-				return;
-			}
-			blk += blks;
+			ret = sparse_add_raw(&st, data, blkcnt);
+			if (ret)
+				goto out;
 			bytes_written += blkcnt * info->blksz;
-			total_blocks += chunk_header->chunk_sz;
+			total_blocks += chunk_sz;
 			data += chunk_data_sz;
 			break;
 
 		case CHUNK_TYPE_FILL:
-			if (chunk_header->total_sz !=
+			if (total_sz !=
 			    (sparse_header->chunk_hdr_sz + sizeof(uint32_t))) {
-				fastboot_fail(
+				info->mssg(
 					"Bogus chunk size for chunk type FILL");
-				return;
-			}
-
-			fill_buf = (uint32_t *)
-				   memalign(ARCH_DMA_MINALIGN,
-					    ROUNDUP(
-						info->blksz * fill_buf_num_blks,
-						ARCH_DMA_MINALIGN));
-			if (!fill_buf) {
-				fastboot_fail(
-					"Malloc failed for: CHUNK_TYPE_FILL");
-				return;
+				ret = -EINVAL;
+				goto out;
 			}
 
 			fill_val = *(uint32_t *)data;
 			data = (char *)data + sizeof(uint32_t);
 
-			for (i = 0;
-			     i < (info->blksz * fill_buf_num_blks /
-				  sizeof(fill_val));
-			     i++)
-				fill_buf[i] = fill_val;
-
-			if (blk + blkcnt > info->start + info->size) {
-				printf(
-				    "%s: Request would exceed partition size!\n",
-				    __func__);
-				fastboot_fail(
-				    "Request would exceed partition size!");
-				return;
-			}
+			ret = sparse_check_range(&st, blkcnt);
+			if (ret)
+				goto out;
 
-			for (i = 0; i < blkcnt;) {
-				j = blkcnt - i;
-				if (j > fill_buf_num_blks)
-					j = fill_buf_num_blks;
-				blks = info->write(info, blk, j, fill_buf);
-				/* blks might be > j (eg. NAND bad-blocks) */
-				if (blks < j) {
-					printf("%s: %s " LBAFU " [%d]\n",
-					       __func__,
-					       "Write failed, block #",
-					       blk, j);
-					fastboot_fail(
-						      "flash write failure");
-					free(fill_buf);
-					return;
-				}
-				blk += blks;
-				i += j;
-			}
+			ret = sparse_fill_or_erase(&st, blkcnt, true, fill_val);
+			if (ret)
+				goto out;
 			bytes_written += blkcnt * info->blksz;
 			total_blocks += chunk_data_sz / sparse_header->blk_sz;
-			free(fill_buf);
 			break;
 
 		case CHUNK_TYPE_DONT_CARE:
-			blk += info->reserve(info, blk, blkcnt);
-			total_blocks += chunk_header->chunk_sz;
+			ret = sparse_check_range(&st, blkcnt);
+			if (ret)
+				goto out;
+
+			ret = sparse_fill_or_erase(&st, blkcnt, false, 0);
+			if (ret)
+				goto out;
+			total_blocks += chunk_sz;
 			break;
 
 		case CHUNK_TYPE_CRC32:
-			if (chunk_header->total_sz !=
-			    sparse_header->chunk_hdr_sz) {
-				fastboot_fail(
+			if (total_sz != sparse_header->chunk_hdr_sz) {
+				info->mssg(
 					"Bogus chunk size for chunk type Dont Care");
-				return;
+				ret = -EINVAL;
+				goto out;
 			}
-			total_blocks += chunk_header->chunk_sz;
+			total_blocks += chunk_sz;
 			data += chunk_data_sz;
 			break;
 
 		default:
 			printf("%s: Unknown chunk type: %x\n", __func__,
-			       chunk_header->chunk_type);
-			fastboot_fail("Unknown chunk type");
-			return;
+			       chunk_type);
+			info->mssg("Unknown chunk type");
+			ret = -EINVAL;
+			goto out;
 		}
 	}
 
+	ret = sparse_flush_raw(&st);
+	if (ret)
+		goto out;
+
 	debug("Wrote %d blocks, expected to write %d blocks\n",
 	      total_blocks, sparse_header->total_blks);
 	printf("........ wrote %u bytes to '%s'\n", bytes_written, part_name);
 
-	if (total_blocks != sparse_header->total_blks)
-		fastboot_fail("sparse image write failure");
-	else
-		fastboot_okay("");
+	if (total_blocks != sparse_header->total_blks) {
+		info->mssg("sparse image write failure");
+		ret = -EIO;
+	}
+
+out:
+	free(st.fill_buf);
 
-	return;
+	return ret;
 }
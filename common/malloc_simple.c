@@ -13,38 +13,180 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
-void *malloc_simple(size_t bytes)
+/*
+ * Each block is preceded by a word holding its size. Freed blocks are kept
+ * on a list, linked through their first word, and reused by later
+ * allocations. A freed block at the end of the used space is given back
+ * straight away.
+ */
+#define HDR_SIZE	sizeof(ulong)
+
+/* Smallest block which is worth splitting off the end of a reused block */
+#define MIN_SPLIT	(HDR_SIZE + 2 * sizeof(ulong))
+
+static ulong *block_word(ulong addr)
 {
-	ulong new_ptr;
-	void *ptr;
+	return map_sysmem(addr, sizeof(ulong));
+}
 
-	new_ptr = gd->malloc_ptr + bytes;
-	debug("%s: size=%zx, ptr=%lx, limit=%lx: ", __func__, bytes, new_ptr,
+#define block_size(addr)	(*block_word((addr) - HDR_SIZE))
+#define block_next(addr)	(*block_word(addr))
+
+static void *alloc_top(size_t size, size_t align)
+{
+	ulong addr, new_ptr;
+
+	addr = ALIGN(gd->malloc_base + gd->malloc_ptr + HDR_SIZE, align);
+	new_ptr = addr + size - gd->malloc_base;
+	debug("%s: size=%zx, ptr=%lx, limit=%lx: ", __func__, size, new_ptr,
 	      gd->malloc_limit);
 	if (new_ptr > gd->malloc_limit) {
-		debug("space exhausted\n");
+		debug("space exhausted (%#lx used in %u blocks)\n",
+		      gd->malloc_ptr, gd->malloc_count);
+		/* Reported once, when the area is handed over */
+		gd->malloc_peak = max(gd->malloc_peak, new_ptr);
 		return NULL;
 	}
-	ptr = map_sysmem(gd->malloc_base + gd->malloc_ptr, bytes);
-	gd->malloc_ptr = ALIGN(new_ptr, sizeof(new_ptr));
-	debug("%lx\n", (ulong)ptr);
+	block_size(addr) = size;
+	gd->malloc_ptr = new_ptr;
+	gd->malloc_peak = max(gd->malloc_peak, new_ptr);
+	gd->malloc_count++;
+	debug("%lx\n", addr);
 
-	return ptr;
+	return map_sysmem(addr, size);
 }
 
-void *memalign_simple(size_t align, size_t bytes)
+/* Find the smallest free block which is large enough, and take it */
+static void *alloc_free(size_t size)
 {
-	ulong addr, new_ptr;
-	void *ptr;
+	ulong addr, best = 0, best_prev = 0, prev = 0;
+	ulong rest, best_size = 0;
 
-	addr = ALIGN(gd->malloc_base + gd->malloc_ptr, align);
-	new_ptr = addr + bytes - gd->malloc_base;
-	if (new_ptr > gd->malloc_limit)
+	for (addr = gd->malloc_free_list; addr; addr = block_next(addr)) {
+		if (block_size(addr) >= size &&
+		    (!best || block_size(addr) < best_size)) {
+			best = addr;
+			best_size = block_size(addr);
+			best_prev = prev;
+		}
+		prev = addr;
+	}
+	if (!best)
 		return NULL;
-	ptr = map_sysmem(addr, bytes);
-	gd->malloc_ptr = ALIGN(new_ptr, sizeof(new_ptr));
 
-	return ptr;
+	/* Put any useful space left over back in the list in its place */
+	rest = best + size + HDR_SIZE;
+	if (best_size >= size + MIN_SPLIT) {
+		block_size(rest) = best_size - size - HDR_SIZE;
+		block_next(rest) = block_next(best);
+		block_size(best) = size;
+	} else {
+		rest = block_next(best);
+	}
+	if (best_prev)
+		block_next(best_prev) = rest;
+	else
+		gd->malloc_free_list = rest;
+	gd->malloc_count++;
+
+	return map_sysmem(best, size);
+}
+
+void *malloc_simple(size_t bytes)
+{
+	size_t size = ALIGN(max(bytes, sizeof(ulong)), sizeof(ulong));
+	void *ptr;
+
+	ptr = alloc_free(size);
+	if (ptr)
+		return ptr;
+
+	return alloc_top(size, sizeof(ulong));
+}
+
+void *memalign_simple(size_t align, size_t bytes)
+{
+	size_t size = ALIGN(max(bytes, sizeof(ulong)), sizeof(ulong));
+
+	return alloc_top(size, max(align, sizeof(ulong)));
+}
+
+size_t malloc_simple_usable_size(void *ptr)
+{
+	ulong addr;
+
+	if (!ptr)
+		return 0;
+	addr = map_to_sysmem(ptr);
+	if (addr < gd->malloc_base + HDR_SIZE ||
+	    addr >= gd->malloc_base + gd->malloc_ptr)
+		return 0;
+
+	return block_size(addr);
+}
+
+/* Remove a block from the free list, if it is there */
+static bool unlink_free(ulong block)
+{
+	ulong addr, prev = 0;
+
+	for (addr = gd->malloc_free_list; addr; addr = block_next(addr)) {
+		if (addr == block) {
+			if (prev)
+				block_next(prev) = block_next(addr);
+			else
+				gd->malloc_free_list = block_next(addr);
+			return true;
+		}
+		prev = addr;
+	}
+
+	return false;
+}
+
+void free_simple(void *ptr)
+{
+	ulong addr, end, size;
+
+	size = malloc_simple_usable_size(ptr);
+	if (!size)
+		return;
+	addr = map_to_sysmem(ptr);
+	gd->malloc_count--;
+
+	/* Give back the end of the used space, with any free blocks below */
+	end = gd->malloc_base + gd->malloc_ptr;
+	if (addr + size == end) {
+		do {
+			end = addr - HDR_SIZE;
+			gd->malloc_ptr = end - gd->malloc_base;
+			for (addr = gd->malloc_free_list; addr;
+			     addr = block_next(addr)) {
+				if (addr + block_size(addr) == end)
+					break;
+			}
+		} while (addr && unlink_free(addr));
+		return;
+	}
+
+	block_next(addr) = gd->malloc_free_list;
+	gd->malloc_free_list = addr;
+}
+
+void *realloc_simple(void *ptr, size_t size)
+{
+	size_t old_size = malloc_simple_usable_size(ptr);
+	void *new_ptr;
+
+	if (ptr && size <= old_size)
+		return ptr;
+	new_ptr = malloc_simple(size);
+	if (new_ptr && ptr) {
+		memcpy(new_ptr, ptr, old_size);
+		free_simple(ptr);
+	}
+
+	return new_ptr;
 }
 
 #if CONFIG_IS_ENABLED(SYS_MALLOC_SIMPLE)
@@ -54,7 +196,8 @@ void *calloc(size_t nmemb, size_t elem_size)
 	void *ptr;
 
 	ptr = malloc(size);
-	memset(ptr, '\0', size);
+	if (ptr)
+		memset(ptr, '\0', size);
 
 	return ptr;
 }
@@ -0,0 +1,251 @@
+/*
+ * Slab front end for malloc(), for small allocations
+ *
+ * Small requests are rounded up to one of a few size classes and served
+ * from page-sized slabs taken from the heap, each holding objects of one
+ * class. This avoids searching the dlmalloc bins and the per-allocation
+ * header for the many small buffers that driver model and the commands
+ * allocate.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <malloc.h>
+#include <linux/bitops.h>
+#include <linux/list.h>
+
+#define SLAB_PAGE_SHIFT		12
+#define SLAB_PAGE_SIZE		(1UL << SLAB_PAGE_SHIFT)
+
+/**
+ * struct slab_page - Header at the start of each slab page
+ *
+ * @node: Links the page into its class's list of pages with free objects
+ * @free: First free object, or NULL if the page is full
+ * @inuse: Number of allocated objects
+ * @cls: Size class of the objects
+ * @chunk_size: Heap space taken by the page
+ */
+struct slab_page {
+	struct list_head node;
+	void *free;
+	uint inuse;
+	uint cls;
+	ulong chunk_size;
+};
+
+/* Objects start after the header, with the alignment malloc() gives */
+#define SLAB_HDR_SIZE		ALIGN(sizeof(struct slab_page), 16)
+
+static const ushort slab_sizes[] = { 16, 32, 48, 64, 96, 128, 192, 256 };
+#define SLAB_CLASSES		ARRAY_SIZE(slab_sizes)
+
+/* Size class for each request size, in units of 16 bytes rounded up */
+static const u8 slab_class_of[MALLOC_SLAB_MAX / 16 + 1] = {
+	0, 0, 1, 2, 3, 4, 4, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7,
+};
+
+struct slab_class {
+	struct list_head partial;
+	uint pages;
+	uint objects;
+};
+
+/**
+ * struct slab_state - State of the slab allocator
+ *
+ * @cls: Size classes
+ * @map: One bit for each page frame in the heap, set if it is a slab page
+ * @base: Number of the first page frame in the heap
+ * @frames: Number of page frames in the heap
+ * @page_bytes: Heap space taken by all slab pages
+ * @ready: true once set up
+ * @failed: true if setting up failed, or is in progress
+ */
+static struct slab_state {
+	struct slab_class cls[SLAB_CLASSES];
+	ulong *map;
+	ulong base;
+	ulong frames;
+	ulong page_bytes;
+	bool ready;
+	bool failed;
+} slab;
+
+static int slab_init(void)
+{
+	ulong words;
+	int i;
+
+	if (slab.failed)
+		return -ENOMEM;
+
+	/* Stop the allocation below from coming back here */
+	slab.failed = true;
+	slab.base = mem_malloc_start >> SLAB_PAGE_SHIFT;
+	slab.frames = ((mem_malloc_end - 1) >> SLAB_PAGE_SHIFT) - slab.base + 1;
+	words = DIV_ROUND_UP(slab.frames, BITS_PER_LONG);
+	slab.map = calloc(words, sizeof(ulong));
+	if (!slab.map)
+		return -ENOMEM;
+	for (i = 0; i < SLAB_CLASSES; i++)
+		INIT_LIST_HEAD(&slab.cls[i].partial);
+	slab.failed = false;
+	slab.ready = true;
+
+	return 0;
+}
+
+static ulong slab_frame(const void *mem)
+{
+	ulong frame = (ulong)mem >> SLAB_PAGE_SHIFT;
+
+	if (!slab.ready || frame < slab.base ||
+	    frame - slab.base >= slab.frames)
+		return -1UL;
+
+	return frame - slab.base;
+}
+
+static struct slab_page *slab_page_of(const void *mem)
+{
+	ulong frame = slab_frame(mem);
+
+	if (frame == -1UL || !(slab.map[BIT_WORD(frame)] & BIT_MASK(frame)))
+		return NULL;
+
+	return (struct slab_page *)((ulong)mem & ~(SLAB_PAGE_SIZE - 1));
+}
+
+static struct slab_page *slab_new_page(int cls)
+{
+	uint size = slab_sizes[cls];
+	struct slab_page *page;
+	char *obj, *first, *last;
+	ulong frame;
+
+	page = memalign(SLAB_PAGE_SIZE, SLAB_PAGE_SIZE);
+	if (!page)
+		return NULL;
+
+	/* Read this while the page still looks like any other allocation */
+	page->chunk_size = malloc_usable_size(page) + sizeof(size_t);
+	page->cls = cls;
+	page->inuse = 0;
+	page->free = NULL;
+	first = (char *)page + SLAB_HDR_SIZE;
+	last = first + (SLAB_PAGE_SIZE - SLAB_HDR_SIZE) / size * size - size;
+	for (obj = last; obj >= first; obj -= size) {
+		*(void **)obj = page->free;
+		page->free = obj;
+	}
+
+	frame = slab_frame(page);
+	slab.map[BIT_WORD(frame)] |= BIT_MASK(frame);
+	list_add(&page->node, &slab.cls[cls].partial);
+	slab.cls[cls].pages++;
+	slab.page_bytes += page->chunk_size;
+
+	return page;
+}
+
+void *malloc_slab(size_t bytes)
+{
+	struct slab_class *sc;
+	struct slab_page *page;
+	void *obj;
+	int cls;
+
+	if (bytes > MALLOC_SLAB_MAX || (!slab.ready && slab_init()))
+		return NULL;
+
+	cls = slab_class_of[(bytes + 15) / 16];
+	sc = &slab.cls[cls];
+	if (list_empty(&sc->partial)) {
+		page = slab_new_page(cls);
+		if (!page)
+			return NULL;
+	} else {
+		page = list_first_entry(&sc->partial, struct slab_page, node);
+	}
+
+	obj = page->free;
+	page->free = *(void **)obj;
+	page->inuse++;
+	sc->objects++;
+	if (!page->free)
+		list_del(&page->node);
+
+	return obj;
+}
+
+bool malloc_slab_free(void *mem)
+{
+	struct slab_page *page;
+	struct slab_class *sc;
+	ulong frame;
+
+	page = slab_page_of(mem);
+	if (!page)
+		return false;
+
+	sc = &slab.cls[page->cls];
+	if (!page->free)
+		list_add(&page->node, &sc->partial);
+	*(void **)mem = page->free;
+	page->free = mem;
+	page->inuse--;
+	sc->objects--;
+
+	/* Give empty pages back, so that the heap can use the space */
+	if (!page->inuse) {
+		list_del(&page->node);
+		frame = slab_frame(page);
+		slab.map[BIT_WORD(frame)] &= ~BIT_MASK(frame);
+		sc->pages--;
+		slab.page_bytes -= page->chunk_size;
+		free(page);
+	}
+
+	return true;
+}
+
+size_t malloc_slab_size(void *mem)
+{
+	struct slab_page *page = slab_page_of(mem);
+
+	return page ? slab_sizes[page->cls] : 0;
+}
+
+uint malloc_slab_usage(ulong *page_bytesp, ulong *obj_bytesp)
+{
+	ulong obj_bytes = 0;
+	uint objects = 0;
+	int i;
+
+	for (i = 0; i < SLAB_CLASSES; i++) {
+		obj_bytes += slab.cls[i].objects * slab_sizes[i];
+		objects += slab.cls[i].objects;
+	}
+	*page_bytesp = slab.page_bytes;
+	*obj_bytesp = obj_bytes;
+
+	return objects;
+}
+
+int malloc_slab_get_stats(int index, struct malloc_slab_stats *stats)
+{
+	uint per_page;
+
+	if (index < 0 || index >= SLAB_CLASSES)
+		return -ENOENT;
+	per_page = (SLAB_PAGE_SIZE - SLAB_HDR_SIZE) / slab_sizes[index];
+	stats->size = slab_sizes[index];
+	stats->pages = slab.cls[index].pages;
+	stats->objects = slab.cls[index].objects;
+	stats->free = stats->pages * per_page - stats->objects;
+
+	return 0;
+}
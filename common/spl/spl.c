@@ -439,8 +439,12 @@ void board_init_r(gd_t *dummy1, ulong dummy2)
 		debug("Unsupported OS image.. Jumping nevertheless..\n");
 	}
 #if defined(CONFIG_SYS_MALLOC_F_LEN) && !defined(CONFIG_SYS_SPL_MALLOC_SIZE)
-	debug("SPL malloc() used %#lx bytes (%ld KB)\n", gd->malloc_ptr,
-	      gd->malloc_ptr / 1024);
+	debug("SPL malloc() used %#lx bytes (%ld KB), at most %#lx, in %u blocks\n",
+	      gd->malloc_ptr, gd->malloc_ptr / 1024, gd->malloc_peak,
+	      gd->malloc_count);
+	if (gd->malloc_peak > gd->malloc_limit)
+		printf("SPL malloc() ran out of space: needed %#lx of %#lx bytes\n",
+		       gd->malloc_peak, gd->malloc_limit);
 #endif
 
 	debug("loaded - jumping to U-Boot...");
@@ -498,6 +502,9 @@ ulong spl_relocate_stack_gd(void)
 		gd->malloc_base = ptr;
 		gd->malloc_limit = CONFIG_SPL_STACK_R_MALLOC_SIMPLE_LEN;
 		gd->malloc_ptr = 0;
+		gd->malloc_peak = 0;
+		gd->malloc_free_list = 0;
+		gd->malloc_count = 0;
 	}
 #endif
 	/* Get stack position: use 8-byte alignment for ABI compliance */
@@ -9,6 +9,8 @@
 #include <errno.h>
 #include <image.h>
 #include <libfdt.h>
+#include <malloc.h>
+#include <mapmem.h>
 #include <spl.h>
 
 static ulong fdt_getprop_u32(const void *fdt, int node, const char *prop)
@@ -22,23 +24,26 @@ static ulong fdt_getprop_u32(const void *fdt, int node, const char *prop)
 	return fdt32_to_cpu(*cell);
 }
 
-static int spl_fit_select_fdt(const void *fdt, int images, int *fdt_offsetp)
+/*
+ * Finds the configuration to use. A configuration is selected if
+ * board_fit_config_name_match() accepts its description.
+ */
+static int spl_fit_select_config(const void *fit)
 {
-	const char *name, *fdt_name;
-	int conf, node, fdt_node;
+	const char *name;
+	int conf, node;
 	int len;
 
-	*fdt_offsetp = 0;
-	conf = fdt_path_offset(fdt, FIT_CONFS_PATH);
+	conf = fdt_path_offset(fit, FIT_CONFS_PATH);
 	if (conf < 0) {
 		debug("%s: Cannot find /configurations node: %d\n", __func__,
 		      conf);
 		return -EINVAL;
 	}
-	for (node = fdt_first_subnode(fdt, conf);
+	for (node = fdt_first_subnode(fit, conf);
 	     node >= 0;
-	     node = fdt_next_subnode(fdt, node)) {
-		name = fdt_getprop(fdt, node, "description", &len);
+	     node = fdt_next_subnode(fit, node)) {
+		name = fdt_getprop(fit, node, "description", &len);
 		if (!name) {
 #ifdef CONFIG_SPL_LIBCOMMON_SUPPORT
 			printf("%s: Missing FDT description in DTB\n",
@@ -49,35 +54,17 @@ static int spl_fit_select_fdt(const void *fdt, int images, int *fdt_offsetp)
 		if (board_fit_config_name_match(name))
 			continue;
 
-		debug("Selecting config '%s'", name);
-		fdt_name = fdt_getprop(fdt, node, FIT_FDT_PROP, &len);
-		if (!fdt_name) {
-			debug("%s: Cannot find fdt name property: %d\n",
-			      __func__, len);
-			return -EINVAL;
-		}
-
-		debug(", fdt '%s'\n", fdt_name);
-		fdt_node = fdt_subnode_offset(fdt, images, fdt_name);
-		if (fdt_node < 0) {
-			debug("%s: Cannot find fdt node '%s': %d\n",
-			      __func__, fdt_name, fdt_node);
-			return -EINVAL;
-		}
-
-		*fdt_offsetp = fdt_getprop_u32(fdt, fdt_node, "data-offset");
-		len = fdt_getprop_u32(fdt, fdt_node, "data-size");
 		debug("FIT: Selected '%s'\n", name);
 
-		return len;
+		return node;
 	}
 
 #ifdef CONFIG_SPL_LIBCOMMON_SUPPORT
 	printf("No matching DT out of these options:\n");
-	for (node = fdt_first_subnode(fdt, conf);
+	for (node = fdt_first_subnode(fit, conf);
 	     node >= 0;
-	     node = fdt_next_subnode(fdt, node)) {
-		name = fdt_getprop(fdt, node, "description", &len);
+	     node = fdt_next_subnode(fit, node)) {
+		name = fdt_getprop(fit, node, "description", &len);
 		printf("   %s\n", name);
 	}
 #endif
@@ -85,6 +72,35 @@ static int spl_fit_select_fdt(const void *fdt, int images, int *fdt_offsetp)
 	return -ENOENT;
 }
 
+/*
+ * Returns the image node named by property @prop of configuration @conf.
+ * FITs without a 'firmware' property load the first image as firmware.
+ */
+static int spl_fit_get_image_node(const void *fit, int images, int conf,
+				  const char *prop)
+{
+	const char *name;
+	int node, len;
+
+	name = fdt_getprop(fit, conf, prop, &len);
+	if (!name) {
+		if (!strcmp(prop, FIT_FIRMWARE_PROP))
+			return fdt_first_subnode(fit, images);
+		debug("%s: Cannot find property '%s': %d\n", __func__, prop,
+		      len);
+		return -EINVAL;
+	}
+
+	node = fdt_subnode_offset(fit, images, name);
+	if (node < 0) {
+		debug("%s: Cannot find image node '%s': %d\n", __func__, name,
+		      node);
+		return -EINVAL;
+	}
+
+	return node;
+}
+
 static int get_aligned_image_offset(struct spl_load_info *info, int offset)
 {
 	/*
@@ -115,24 +131,167 @@ static int get_aligned_image_overhead(struct spl_load_info *info, int offset)
 static int get_aligned_image_size(struct spl_load_info *info, int data_size,
 				  int offset)
 {
+	data_size = data_size + get_aligned_image_overhead(info, offset);
+
 	if (info->filename)
-		return data_size + get_aligned_image_overhead(info, offset);
+		return data_size;
 
 	return (data_size + info->bl_len - 1) / info->bl_len;
 }
 
+#if defined(CONFIG_SPL_FIT_IMAGE_HASH) || !defined(CONFIG_SPL_BUILD)
+/* Checks all hashes of an image node against the data just loaded */
+static int spl_fit_check_hashes(const void *fit, int node, const void *data,
+				size_t size)
+{
+	char *err_msg = "";
+	const char *name;
+	int noffset;
+
+	fdt_for_each_subnode(fit, noffset, node) {
+		name = fit_get_name(fit, noffset, NULL);
+		if (strncmp(name, FIT_HASH_NODENAME,
+			    strlen(FIT_HASH_NODENAME)))
+			continue;
+		if (fit_image_check_hash(fit, noffset, data, size, &err_msg)) {
+#ifdef CONFIG_SPL_LIBCOMMON_SUPPORT
+			printf("%s for '%s' hash node in '%s' image node\n",
+			       err_msg, name, fit_get_name(fit, node, NULL));
+#endif
+			return -EPERM;
+		}
+	}
+
+	return 0;
+}
+#else
+static inline int spl_fit_check_hashes(const void *fit, int node,
+				       const void *data, size_t size)
+{
+	return 0;
+}
+#endif
+
+/**
+ * spl_fit_load_image() - Load the data of an image node to its destination
+ *
+ * Data held outside the FIT ('data-offset' relative to the end of the FIT
+ * or 'data-position' relative to its start) is read from the device with
+ * a single read, placed so that the first byte of the data lands at @dst.
+ * Since only whole blocks can be read, up to one block before @dst and the
+ * rest of the last block after the data are overwritten. If that does not
+ * give a buffer aligned for DMA, the read goes to the first aligned address
+ * after @dst instead and the data is moved down. If @keep is set, the bytes
+ * overwritten around the data are saved and restored afterwards. Data held
+ * inside the FIT is copied from the FIT header.
+ *
+ * @info:	Information used to read from the device
+ * @sector:	Sector number where the FIT is located in the device
+ * @fit:	Pointer to the FIT header
+ * @base_offset: Offset of the first byte after the FIT header
+ * @node:	Image node to load
+ * @dst:	Where to place the data
+ * @keep:	true to preserve the memory before and after the data
+ * @return size of the data in bytes, or -ve on error
+ */
+static int spl_fit_load_image(struct spl_load_info *info, ulong sector,
+			      const void *fit, int base_offset, int node,
+			      void *dst, bool keep)
+{
+	int offset, size, overhead, nr_sectors, ret;
+	int head = 0, tail = 0;
+	const void *data;
+	void *read_ptr, *save = NULL;
+	bool bounce;
+	ulong count;
+	int len;
+
+	data = fdt_getprop(fit, node, "data", &len);
+	if (data) {
+		memcpy(dst, data, len);
+		size = len;
+		goto verify;
+	}
+
+	offset = fdt_getprop_u32(fit, node, "data-position");
+	if (offset == -1)
+		offset = fdt_getprop_u32(fit, node, "data-offset") + base_offset;
+	size = fdt_getprop_u32(fit, node, "data-size");
+	if (offset < base_offset || size == -1) {
+		debug("%s: Cannot find data of '%s'\n", __func__,
+		      fit_get_name(fit, node, NULL));
+		return -EINVAL;
+	}
+
+	overhead = get_aligned_image_overhead(info, offset);
+	nr_sectors = get_aligned_image_size(info, size, offset);
+	len = info->filename ? nr_sectors : nr_sectors * info->bl_len;
+	read_ptr = dst - overhead;
+	bounce = (ulong)read_ptr & (ARCH_DMA_MINALIGN - 1);
+	if (bounce)
+		read_ptr = (void *)ALIGN((ulong)dst, ARCH_DMA_MINALIGN);
+	if (keep) {
+		head = bounce ? 0 : overhead;
+		tail = read_ptr + len - (dst + size);
+		save = malloc(head + tail);
+		if (!save)
+			return -ENOMEM;
+		memcpy(save, read_ptr, head);
+		memcpy(save + head, dst + size, tail);
+	}
+
+	count = info->read(info, sector + get_aligned_image_offset(info, offset),
+			   nr_sectors, read_ptr);
+	debug("%s: read dst=%p, offset=%x, size=%x, count=%lx, bounce=%d\n",
+	      __func__, dst, offset, size, count, bounce);
+	if (bounce)
+		memmove(dst, read_ptr + overhead, size);
+	if (keep) {
+		memcpy(read_ptr, save, head);
+		memcpy(dst + size, save + head, tail);
+		free(save);
+	}
+	if (count != nr_sectors)
+		return -EIO;
+
+verify:
+	ret = spl_fit_check_hashes(fit, node, dst, size);
+	if (ret)
+		return ret;
+
+	return size;
+}
+
+/*
+ * So far we only have one block of data from the FIT. The entire FIT
+ * header is read so that it finishes before where we will load the image.
+ *
+ * Note that we will load the image such that its first byte will be
+ * at the load address. Since that byte may be part-way through a
+ * block, we may load the image up to one block before the load
+ * address. So take account of that here by subtracting an addition
+ * block length from the FIT start position.
+ *
+ * In fact the FIT has its own load address, but we assume it cannot
+ * be before CONFIG_SYS_TEXT_BASE.
+ */
+__weak void *board_spl_fit_buffer(ulong fit_size, int bl_len)
+{
+	int align_len = ARCH_DMA_MINALIGN - 1;
+
+	return (void *)((CONFIG_SYS_TEXT_BASE - fit_size - bl_len -
+			 align_len) & ~align_len);
+}
+
 int spl_load_simple_fit(struct spl_load_info *info, ulong sector, void *fit)
 {
 	int sectors;
 	ulong size, load;
 	unsigned long count;
-	int node, images;
+	int node, images, conf;
 	void *load_ptr;
-	int fdt_offset, fdt_len;
-	int data_offset, data_size;
-	int base_offset, align_len = ARCH_DMA_MINALIGN - 1;
-	int src_sector;
-	void *dst;
+	int base_offset;
+	int data_size, fdt_len;
 
 	/*
 	 * Figure out where the external images start. This is the base for the
@@ -142,22 +301,7 @@ int spl_load_simple_fit(struct spl_load_info *info, ulong sector, void *fit)
 	size = (size + 3) & ~3;
 	base_offset = (size + 3) & ~3;
 
-	/*
-	 * So far we only have one block of data from the FIT. Read the entire
-	 * thing, including that first block, placing it so it finishes before
-	 * where we will load the image.
-	 *
-	 * Note that we will load the image such that its first byte will be
-	 * at the load address. Since that byte may be part-way through a
-	 * block, we may load the image up to one block before the load
-	 * address. So take account of that here by subtracting an addition
-	 * block length from the FIT start position.
-	 *
-	 * In fact the FIT has its own load address, but we assume it cannot
-	 * be before CONFIG_SYS_TEXT_BASE.
-	 */
-	fit = (void *)((CONFIG_SYS_TEXT_BASE - size - info->bl_len -
-			align_len) & ~align_len);
+	fit = board_spl_fit_buffer(size, info->bl_len);
 	sectors = get_aligned_image_size(info, size, 0);
 	count = info->read(info, sector, sectors, fit);
 	debug("fit read sector %lx, sectors=%d, dst=%p, count=%lu\n",
@@ -171,73 +315,47 @@ int spl_load_simple_fit(struct spl_load_info *info, ulong sector, void *fit)
 		debug("%s: Cannot find /images node: %d\n", __func__, images);
 		return -1;
 	}
-	node = fdt_first_subnode(fit, images);
+
+	/* Figure out which configuration the board wants to use */
+	conf = spl_fit_select_config(fit);
+	if (conf < 0)
+		return conf;
+
+	node = spl_fit_get_image_node(fit, images, conf, FIT_FIRMWARE_PROP);
 	if (node < 0) {
-		debug("%s: Cannot find first image node: %d\n", __func__, node);
+		debug("%s: Cannot find firmware image node: %d\n", __func__,
+		      node);
 		return -1;
 	}
 
 	/* Get its information and set up the spl_image structure */
-	data_offset = fdt_getprop_u32(fit, node, "data-offset");
-	data_size = fdt_getprop_u32(fit, node, "data-size");
 	load = fdt_getprop_u32(fit, node, "load");
-	debug("data_offset=%x, data_size=%x\n", data_offset, data_size);
 	spl_image.load_addr = load;
 	spl_image.entry_point = load;
 	spl_image.os = IH_OS_U_BOOT;
 
-	/*
-	 * Work out where to place the image. We read it so that the first
-	 * byte will be at 'load'. This may mean we need to load it starting
-	 * before then, since we can only read whole blocks.
-	 */
-	data_offset += base_offset;
-	sectors = get_aligned_image_size(info, data_size, data_offset);
-	load_ptr = (void *)load;
+	/* Read the image so that its first byte is at 'load' */
+	load_ptr = map_sysmem(load, 0);
+	data_size = spl_fit_load_image(info, sector, fit, base_offset, node,
+				       load_ptr, false);
+	if (data_size < 0)
+		return data_size;
 	debug("U-Boot size %x, data %p\n", data_size, load_ptr);
-	dst = load_ptr;
-
-	/* Read the image */
-	src_sector = sector + get_aligned_image_offset(info, data_offset);
-	debug("Aligned image read: dst=%p, src_sector=%x, sectors=%x\n",
-	      dst, src_sector, sectors);
-	count = info->read(info, src_sector, sectors, dst);
-	if (count != sectors)
-		return -EIO;
-	debug("image: dst=%p, data_offset=%x, size=%x\n", dst, data_offset,
-	      data_size);
-	memcpy(dst, dst + get_aligned_image_overhead(info, data_offset),
-	       data_size);
 
-	/* Figure out which device tree the board wants to use */
-	fdt_len = spl_fit_select_fdt(fit, images, &fdt_offset);
-	if (fdt_len < 0)
-		return fdt_len;
+	node = spl_fit_get_image_node(fit, images, conf, FIT_FDT_PROP);
+	if (node < 0)
+		return node;
 
 	/*
-	 * Read the device tree and place it after the image. There may be
-	 * some extra data before it since we can only read entire blocks.
-	 * And also align the destination address to ARCH_DMA_MINALIGN.
+	 * Read the device tree so that it starts immediately after the
+	 * image, keeping the end of the image intact. After this we will
+	 * have the U-Boot image and its device tree ready for us to start.
 	 */
-	dst = (void *)((load + data_size + align_len) & ~align_len);
-	fdt_offset += base_offset;
-	sectors = get_aligned_image_size(info, fdt_len, fdt_offset);
-	src_sector = sector + get_aligned_image_offset(info, fdt_offset);
-	count = info->read(info, src_sector, sectors, dst);
-	debug("Aligned fdt read: dst %p, src_sector = %x, sectors %x\n",
-	      dst, src_sector, sectors);
-	if (count != sectors)
-		return -EIO;
-
-	/*
-	 * Copy the device tree so that it starts immediately after the image.
-	 * After this we will have the U-Boot image and its device tree ready
-	 * for us to start.
-	 */
-	debug("fdt: dst=%p, data_offset=%x, size=%x\n", dst, fdt_offset,
-	      fdt_len);
-	memcpy(load_ptr + data_size,
-	       dst + get_aligned_image_overhead(info, fdt_offset), fdt_len);
+	fdt_len = spl_fit_load_image(info, sector, fit, base_offset, node,
+				     load_ptr + data_size, true);
+	if (fdt_len < 0)
+		return fdt_len;
+	debug("fdt: dst=%p, size=%x\n", load_ptr + data_size, fdt_len);
 
 	return 0;
 }
@@ -59,9 +59,10 @@ static int dev_index;
  */
 int usb_init(void)
 {
+	void *ctrls[CONFIG_USB_MAX_CONTROLLER_COUNT];
 	void *ctrl;
 	struct usb_device *dev;
-	int i, start_index = 0;
+	int i, j, count;
 	int controllers_initialized = 0;
 	int ret;
 
@@ -75,8 +76,16 @@ int usb_init(void)
 		usb_dev[i].devnum = -1;
 	}
 
+	/*
+	 * Root hubs only queue their ports, which are then scanned together
+	 * for all controllers
+	 */
+	usb_hub_defer_scan();
+
 	/* init low_level USB */
 	for (i = 0; i < CONFIG_USB_MAX_CONTROLLER_COUNT; i++) {
+		ctrls[i] = NULL;
+
 		/* init low_level USB */
 		printf("USB%d:   ", i);
 		ret = usb_lowlevel_init(i, USB_INIT_HOST, &ctrl);
@@ -91,32 +100,46 @@ int usb_init(void)
 			continue;
 		}
 		/*
-		 * lowlevel init is OK, now scan the bus for devices
-		 * i.e. search HUBs and configure them
+		 * lowlevel init is OK, now set up the root hub, which
+		 * queues its ports to be scanned below
 		 */
 		controllers_initialized++;
-		start_index = dev_index;
-		printf("scanning bus %d for devices... ", i);
 		ret = usb_alloc_new_device(ctrl, &dev);
-		if (ret)
+		if (ret) {
+			printf("scanning bus %d for devices... ", i);
 			break;
+		}
 
 		/*
 		 * device 0 is always present
 		 * (root hub, so let it analyze)
 		 */
 		ret = usb_new_device(dev);
-		if (ret)
+		if (ret) {
 			usb_free_device(dev->controller);
-
-		if (start_index == dev_index) {
+			printf("scanning bus %d for devices... ", i);
 			puts("No USB Device found\n");
 			continue;
-		} else {
-			printf("%d USB Device(s) found\n",
-				dev_index - start_index);
 		}
+		ctrls[i] = ctrl;
+	}
+
+	/* Scan the ports of all the root hubs, and any hubs found on them */
+	bootstage_mark_name(BOOTSTAGE_ID_USB_CTRL_READY, "usb_ctrl_ready");
+	usb_hub_scan_queued();
+	bootstage_mark_name(BOOTSTAGE_ID_USB_SCAN_DONE, "usb_scan_done");
+
+	for (i = 0; i < CONFIG_USB_MAX_CONTROLLER_COUNT; i++) {
+		if (!ctrls[i])
+			continue;
 
+		count = 0;
+		for (j = 0; j < dev_index; j++) {
+			if (usb_dev[j].controller == ctrls[i])
+				count++;
+		}
+		printf("scanning bus %d for devices... ", i);
+		printf("%d USB Device(s) found\n", count);
 		usb_started = 1;
 	}
 
@@ -285,6 +308,41 @@ int usb_bulk_msg(struct usb_device *dev, unsigned int pipe,
 		return -EIO;
 }
 
+int usb_bulk_msg_queue(struct usb_device *dev, unsigned int pipe,
+		       struct usb_bulk_req *reqs, int count, int timeout)
+{
+	int i, ret;
+
+	for (i = 0; i < count; i++) {
+		if (reqs[i].length < 0)
+			return -EINVAL;
+		reqs[i].act_len = 0;
+		reqs[i].status = USB_ST_NOT_PROC;
+	}
+
+#ifdef CONFIG_DM_USB
+	ret = usb_submit_bulk_queue(dev, pipe, reqs, count);
+	if (ret != -ENOSYS) {
+		for (i = 0; i < count; i++) {
+			if (reqs[i].status)
+				return -EIO;
+		}
+		return ret;
+	}
+#endif
+
+	/* The controller cannot queue them, so send one at a time */
+	for (i = 0; i < count; i++) {
+		ret = usb_bulk_msg(dev, pipe, reqs[i].buffer, reqs[i].length,
+				   &reqs[i].act_len, timeout);
+		reqs[i].status = dev->status;
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
 
 /*-------------------------------------------------------------------
  * Max Packet stuff
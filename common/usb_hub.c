@@ -52,10 +52,21 @@ DECLARE_GLOBAL_DATA_PTR;
 
 #define PORT_OVERCURRENT_MAX_SCAN_COUNT		3
 
+/* What a port on the scanning list is waiting for */
+enum usb_port_scan_state {
+	USB_PORT_SCAN_CONNECT,		/* a connection change */
+	USB_PORT_SCAN_RESET,		/* the end of a port reset */
+};
+
 struct usb_device_scan {
 	struct usb_device *dev;		/* USB hub device to scan */
 	struct usb_hub_device *hub;	/* USB hub struct */
 	int port;			/* USB port to scan */
+	enum usb_port_scan_state state;
+	ulong deadline;			/* don't look at the port before this */
+	int reset_tries;		/* number of resets done so far */
+	unsigned short portstatus;	/* status when the connection came */
+	unsigned short portchange;	/* change bits at that time */
 	struct list_head list;
 };
 
@@ -63,6 +74,8 @@ struct usb_device_scan {
 static struct usb_hub_device hub_dev[USB_MAX_HUB];
 static int usb_hub_index;
 static LIST_HEAD(usb_scan_list);
+static int usb_scan_running;
+static ulong usb_scan_now;	/* time at the start of this pass of the list */
 
 __weak void usb_hub_reset_devices(int port)
 {
@@ -158,8 +171,26 @@ static void usb_hub_power_on(struct usb_hub_device *hub)
 	      max(100, (int)pgood_delay) + 1000);
 }
 
+/* Return the time at which a delay of @ms, starting now, is over */
+static ulong usb_hub_deadline(int ms)
+{
+#ifdef CONFIG_SANDBOX
+	if (state_get_skip_delays())
+		return get_timer(0);
+#endif
+	return get_timer(0) + ms;
+}
+
 void usb_hub_reset(void)
 {
+	struct usb_device_scan *usb_scan, *tmp;
+
+	/* Drop any ports left over from a scan which did not finish */
+	list_for_each_entry_safe(usb_scan, tmp, &usb_scan_list, list) {
+		list_del(&usb_scan->list);
+		free(usb_scan);
+	}
+	usb_scan_running = 0;
 	usb_hub_index = 0;
 
 	/* Zero out global hub_dev in case its re-used again */
@@ -199,12 +230,61 @@ static inline char *portspeed(int portstatus)
 	return speed_str;
 }
 
+/*
+ * Check whether a port is enabled after a reset
+ *
+ * Returns 1 if it is, with its status in @portstat, 0 if the port should be
+ * reset again, or -ve on error.
+ */
+static int usb_hub_port_reset_check(struct usb_device *dev, int port,
+				    unsigned short *portstat)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(struct usb_port_status, portsts, 1);
+	unsigned short portstatus, portchange;
+
+	if (usb_get_port_status(dev, port + 1, portsts) < 0) {
+		debug("get_port_status failed status %lX\n",
+		      dev->status);
+		return -1;
+	}
+	portstatus = le16_to_cpu(portsts->wPortStatus);
+	portchange = le16_to_cpu(portsts->wPortChange);
+
+	debug("portstatus %x, change %x, %s\n", portstatus, portchange,
+						portspeed(portstatus));
+
+	debug("STAT_C_CONNECTION = %d STAT_CONNECTION = %d" \
+	      "  USB_PORT_STAT_ENABLE %d\n",
+	      (portchange & USB_PORT_STAT_C_CONNECTION) ? 1 : 0,
+	      (portstatus & USB_PORT_STAT_CONNECTION) ? 1 : 0,
+	      (portstatus & USB_PORT_STAT_ENABLE) ? 1 : 0);
+
+	/*
+	 * Perhaps we should check for the following here:
+	 * - C_CONNECTION hasn't been set.
+	 * - CONNECTION is still set.
+	 *
+	 * Doing so would ensure that the device is still connected
+	 * to the bus, and hasn't been unplugged or replaced while the
+	 * USB bus reset was going on.
+	 *
+	 * However, if we do that, then (at least) a San Disk Ultra
+	 * USB 3.0 16GB device fails to reset on (at least) an NVIDIA
+	 * Tegra Jetson TK1 board. For some reason, the device appears
+	 * to briefly drop off the bus when this second bus reset is
+	 * executed, yet if we retry this loop, it'll eventually come
+	 * back after another reset or two.
+	 */
+	*portstat = portstatus;
+
+	return portstatus & USB_PORT_STAT_ENABLE ? 1 : 0;
+}
+
 int legacy_hub_port_reset(struct usb_device *dev, int port,
 			unsigned short *portstat)
 {
 	int err, tries;
-	ALLOC_CACHE_ALIGN_BUFFER(struct usb_port_status, portsts, 1);
-	unsigned short portstatus, portchange;
+	unsigned short portstatus;
 	int delay = HUB_SHORT_RESET_TIME; /* start with short reset delay */
 
 #ifdef CONFIG_DM_USB
@@ -220,41 +300,10 @@ int legacy_hub_port_reset(struct usb_device *dev, int port,
 
 		mdelay(delay);
 
-		if (usb_get_port_status(dev, port + 1, portsts) < 0) {
-			debug("get_port_status failed status %lX\n",
-			      dev->status);
-			return -1;
-		}
-		portstatus = le16_to_cpu(portsts->wPortStatus);
-		portchange = le16_to_cpu(portsts->wPortChange);
-
-		debug("portstatus %x, change %x, %s\n", portstatus, portchange,
-							portspeed(portstatus));
-
-		debug("STAT_C_CONNECTION = %d STAT_CONNECTION = %d" \
-		      "  USB_PORT_STAT_ENABLE %d\n",
-		      (portchange & USB_PORT_STAT_C_CONNECTION) ? 1 : 0,
-		      (portstatus & USB_PORT_STAT_CONNECTION) ? 1 : 0,
-		      (portstatus & USB_PORT_STAT_ENABLE) ? 1 : 0);
-
-		/*
-		 * Perhaps we should check for the following here:
-		 * - C_CONNECTION hasn't been set.
-		 * - CONNECTION is still set.
-		 *
-		 * Doing so would ensure that the device is still connected
-		 * to the bus, and hasn't been unplugged or replaced while the
-		 * USB bus reset was going on.
-		 *
-		 * However, if we do that, then (at least) a San Disk Ultra
-		 * USB 3.0 16GB device fails to reset on (at least) an NVIDIA
-		 * Tegra Jetson TK1 board. For some reason, the device appears
-		 * to briefly drop off the bus when this second bus reset is
-		 * executed, yet if we retry this loop, it'll eventually come
-		 * back after another reset or two.
-		 */
-
-		if (portstatus & USB_PORT_STAT_ENABLE)
+		err = usb_hub_port_reset_check(dev, port, &portstatus);
+		if (err < 0)
+			return err;
+		if (err)
 			break;
 
 		/* Switch to long reset delay for the next round */
@@ -282,11 +331,15 @@ int hub_port_reset(struct udevice *dev, int port, unsigned short *portstat)
 }
 #endif
 
-int usb_hub_port_connect_change(struct usb_device *dev, int port)
+/*
+ * Handle a connection change on a port, up to the point where the port
+ * should be reset. Returns -ENOTCONN if nothing is connected.
+ */
+static int usb_hub_port_connect(struct usb_device *dev, int port)
 {
 	ALLOC_CACHE_ALIGN_BUFFER(struct usb_port_status, portsts, 1);
 	unsigned short portstatus;
-	int ret, speed;
+	int ret;
 
 	/* Check status */
 	ret = usb_get_port_status(dev, port + 1, portsts);
@@ -314,13 +367,14 @@ int usb_hub_port_connect_change(struct usb_device *dev, int port)
 			return -ENOTCONN;
 	}
 
-	/* Reset the port */
-	ret = legacy_hub_port_reset(dev, port, &portstatus);
-	if (ret < 0) {
-		if (ret != -ENXIO)
-			printf("cannot reset port %i!?\n", port + 1);
-		return ret;
-	}
+	return 0;
+}
+
+/* Set up the device on a port which has been reset */
+static int usb_hub_port_new_device(struct usb_device *dev, int port,
+				   unsigned short portstatus)
+{
+	int ret, speed;
 
 	switch (portstatus & USB_PORT_STAT_SPEED_MASK) {
 	case USB_PORT_STAT_SUPER_SPEED:
@@ -337,6 +391,7 @@ int usb_hub_port_connect_change(struct usb_device *dev, int port)
 		break;
 	}
 
+	bootstage_start(BOOTSTAGE_ID_ACCUM_USB_ENUM, "usb_enum");
 #ifdef CONFIG_DM_USB
 	struct udevice *child;
 
@@ -347,6 +402,7 @@ int usb_hub_port_connect_change(struct usb_device *dev, int port)
 	ret = usb_alloc_new_device(dev->controller, &usb);
 	if (ret) {
 		printf("cannot create new device: ret=%d", ret);
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_USB_ENUM);
 		return ret;
 	}
 
@@ -362,6 +418,7 @@ int usb_hub_port_connect_change(struct usb_device *dev, int port)
 		dev->children[port] = NULL;
 	}
 #endif
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_USB_ENUM);
 	if (ret < 0) {
 		debug("hub: disabling port %d\n", port + 1);
 		usb_clear_port_feature(dev, port + 1, USB_PORT_FEAT_ENABLE);
@@ -370,66 +427,57 @@ int usb_hub_port_connect_change(struct usb_device *dev, int port)
 	return ret;
 }
 
-static int usb_scan_port(struct usb_device_scan *usb_scan)
+int usb_hub_port_connect_change(struct usb_device *dev, int port)
 {
-	ALLOC_CACHE_ALIGN_BUFFER(struct usb_port_status, portsts, 1);
 	unsigned short portstatus;
-	unsigned short portchange;
-	struct usb_device *dev;
-	struct usb_hub_device *hub;
-	int ret = 0;
-	int i;
-
-	dev = usb_scan->dev;
-	hub = usb_scan->hub;
-	i = usb_scan->port;
+	int ret;
 
-	/*
-	 * Don't talk to the device before the query delay is expired.
-	 * This is needed for voltages to stabalize.
-	 */
-	if (get_timer(0) < hub->query_delay)
-		return 0;
+	ret = usb_hub_port_connect(dev, port);
+	if (ret)
+		return ret;
 
-	ret = usb_get_port_status(dev, i + 1, portsts);
+	/* Reset the port */
+	ret = legacy_hub_port_reset(dev, port, &portstatus);
 	if (ret < 0) {
-		debug("get_port_status failed\n");
-		if (get_timer(0) >= hub->connect_timeout) {
-			debug("devnum=%d port=%d: timeout\n",
-			      dev->devnum, i + 1);
-			/* Remove this device from scanning list */
-			list_del(&usb_scan->list);
-			free(usb_scan);
-			return 0;
-		}
-		return 0;
+		if (ret != -ENXIO)
+			printf("cannot reset port %i!?\n", port + 1);
+		return ret;
 	}
 
-	portstatus = le16_to_cpu(portsts->wPortStatus);
-	portchange = le16_to_cpu(portsts->wPortChange);
-	debug("Port %d Status %X Change %X\n", i + 1, portstatus, portchange);
+	return usb_hub_port_new_device(dev, port, portstatus);
+}
 
-	/* No connection change happened, wait a bit more. */
-	if (!(portchange & USB_PORT_STAT_C_CONNECTION)) {
-		if (get_timer(0) >= hub->connect_timeout) {
-			debug("devnum=%d port=%d: timeout\n",
-			      dev->devnum, i + 1);
-			/* Remove this device from scanning list */
-			list_del(&usb_scan->list);
-			free(usb_scan);
-			return 0;
-		}
-		return 0;
-	}
+/* Start a port reset, to be checked by usb_scan_port_reset() later */
+static int usb_scan_port_reset_start(struct usb_device_scan *usb_scan)
+{
+	int delay;
+	int ret;
 
-	/* Test if the connection came up, and if not exit */
-	if (!(portstatus & USB_PORT_STAT_CONNECTION))
-		return 0;
+	ret = usb_set_port_feature(usb_scan->dev, usb_scan->port + 1,
+				   USB_PORT_FEAT_RESET);
+	if (ret < 0)
+		return ret;
 
-	/* A new USB device is ready at this point */
-	debug("devnum=%d port=%d: USB dev found\n", dev->devnum, i + 1);
+	/* Start with a short reset delay, then switch to a long one */
+	delay = usb_scan->reset_tries++ ? HUB_LONG_RESET_TIME :
+		HUB_SHORT_RESET_TIME;
+	usb_scan->deadline = usb_hub_deadline(delay);
+	usb_scan->state = USB_PORT_SCAN_RESET;
+
+	return 0;
+}
 
-	usb_hub_port_connect_change(dev, i);
+/*
+ * Finish with a port once its device is set up, or it has failed. This
+ * deals with any other changes seen along with the connection.
+ */
+static int usb_scan_port_done(struct usb_device_scan *usb_scan)
+{
+	unsigned short portstatus = usb_scan->portstatus;
+	unsigned short portchange = usb_scan->portchange;
+	struct usb_hub_device *hub = usb_scan->hub;
+	struct usb_device *dev = usb_scan->dev;
+	int i = usb_scan->port;
 
 	if (portchange & USB_PORT_STAT_C_ENABLE) {
 		debug("port %d enable change, status %x\n", i + 1, portstatus);
@@ -472,8 +520,11 @@ static int usb_scan_port(struct usb_device_scan *usb_scan)
 		 * the device from scan-list. This will re-issue a new scan.
 		 */
 		if (hub->overcurrent_count[i] <=
-		    PORT_OVERCURRENT_MAX_SCAN_COUNT)
+		    PORT_OVERCURRENT_MAX_SCAN_COUNT) {
+			usb_scan->state = USB_PORT_SCAN_CONNECT;
+			usb_scan->reset_tries = 0;
 			return 0;
+		}
 
 		/* Otherwise the device will get removed */
 		printf("Port %d over-current occurred %d times\n", i + 1,
@@ -495,24 +546,187 @@ static int usb_scan_port(struct usb_device_scan *usb_scan)
 	return 0;
 }
 
+/* Check a port which is being reset, and set up its device once enabled */
+static int usb_scan_port_reset(struct usb_device_scan *usb_scan)
+{
+	struct usb_device *dev = usb_scan->dev;
+	unsigned short portstatus;
+	int i = usb_scan->port;
+	int ret;
+
+	ret = usb_hub_port_reset_check(dev, i, &portstatus);
+	if (!ret) {
+		if (usb_scan->reset_tries < MAX_TRIES) {
+			ret = usb_scan_port_reset_start(usb_scan);
+			if (!ret)
+				return 0;
+		} else {
+			debug("Cannot enable port %i after %i retries, " \
+			      "disabling port.\n", i + 1, MAX_TRIES);
+			debug("Maybe the USB cable is bad?\n");
+			ret = -1;
+		}
+	}
+
+	if (ret > 0) {
+		usb_clear_port_feature(dev, i + 1, USB_PORT_FEAT_C_RESET);
+		usb_hub_port_new_device(dev, i, portstatus);
+	} else if (ret != -ENXIO) {
+		printf("cannot reset port %i!?\n", i + 1);
+	}
+
+	return usb_scan_port_done(usb_scan);
+}
+
+/*
+ * Check whether another port on the same bus is being reset. Only one port
+ * per bus may be reset at a time, since the device on it answers at address
+ * 0 until it has been set up.
+ */
+static bool usb_scan_bus_busy(struct usb_device_scan *usb_scan)
+{
+	struct usb_device_scan *other;
+
+	list_for_each_entry(other, &usb_scan_list, list) {
+		if (other->state != USB_PORT_SCAN_RESET)
+			continue;
+#ifdef CONFIG_DM_USB
+		if (other->dev->controller_dev == usb_scan->dev->controller_dev)
+			return true;
+#else
+		if (other->dev->controller == usb_scan->dev->controller)
+			return true;
+#endif
+	}
+
+	return false;
+}
+
+/* Check a port which is waiting for a device to be connected */
+static int usb_scan_port_connect(struct usb_device_scan *usb_scan)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(struct usb_port_status, portsts, 1);
+	unsigned short portstatus;
+	unsigned short portchange;
+	struct usb_device *dev;
+	struct usb_hub_device *hub;
+	int ret = 0;
+	int i;
+
+	dev = usb_scan->dev;
+	hub = usb_scan->hub;
+	i = usb_scan->port;
+
+	/*
+	 * Don't talk to the device before the query delay is expired.
+	 * This is needed for voltages to stabalize.
+	 */
+	if (usb_scan_now < hub->query_delay)
+		return 0;
+
+	/* Leave any connection change until the bus is free */
+	if (usb_scan_bus_busy(usb_scan))
+		return 0;
+
+	ret = usb_get_port_status(dev, i + 1, portsts);
+	if (ret < 0) {
+		debug("get_port_status failed\n");
+		if (usb_scan_now >= hub->connect_timeout) {
+			debug("devnum=%d port=%d: timeout\n",
+			      dev->devnum, i + 1);
+			/* Remove this device from scanning list */
+			list_del(&usb_scan->list);
+			free(usb_scan);
+			return 0;
+		}
+		return 0;
+	}
+
+	portstatus = le16_to_cpu(portsts->wPortStatus);
+	portchange = le16_to_cpu(portsts->wPortChange);
+	debug("Port %d Status %X Change %X\n", i + 1, portstatus, portchange);
+
+	/* No connection change happened, wait a bit more. */
+	if (!(portchange & USB_PORT_STAT_C_CONNECTION)) {
+		if (usb_scan_now >= hub->connect_timeout) {
+			debug("devnum=%d port=%d: timeout\n",
+			      dev->devnum, i + 1);
+			/* Remove this device from scanning list */
+			list_del(&usb_scan->list);
+			free(usb_scan);
+			return 0;
+		}
+		return 0;
+	}
+
+	/* Test if the connection came up, and if not exit */
+	if (!(portstatus & USB_PORT_STAT_CONNECTION))
+		return 0;
+
+	/* A new USB device is ready at this point */
+	debug("devnum=%d port=%d: USB dev found\n", dev->devnum, i + 1);
+
+	usb_scan->portstatus = portstatus;
+	usb_scan->portchange = portchange;
+	ret = usb_hub_port_connect(dev, i);
+	if (!ret) {
+		/*
+		 * Reset the port and come back to it when the reset is over,
+		 * so that other ports can be looked at in the meantime
+		 */
+#ifdef CONFIG_DM_USB
+		debug("%s: resetting '%s' port %d...\n", __func__,
+		      dev->dev->name, i + 1);
+#else
+		debug("%s: resetting port %d...\n", __func__, i + 1);
+#endif
+		ret = usb_scan_port_reset_start(usb_scan);
+		if (!ret)
+			return 0;
+		if (ret != -ENXIO)
+			printf("cannot reset port %i!?\n", i + 1);
+	}
+
+	return usb_scan_port_done(usb_scan);
+}
+
+static int usb_scan_port(struct usb_device_scan *usb_scan)
+{
+	if (usb_scan_now < usb_scan->deadline)
+		return 0;
+
+	switch (usb_scan->state) {
+	case USB_PORT_SCAN_CONNECT:
+		return usb_scan_port_connect(usb_scan);
+	case USB_PORT_SCAN_RESET:
+		return usb_scan_port_reset(usb_scan);
+	}
+
+	return 0;
+}
+
 static int usb_device_list_scan(void)
 {
 	struct usb_device_scan *usb_scan;
 	struct usb_device_scan *tmp;
-	static int running;
 	int ret = 0;
 
-	/* Only run this loop once for each controller */
-	if (running)
+	/*
+	 * Only run this loop once, hubs found while it runs (or while it is
+	 * deferred) add their ports to the list
+	 */
+	if (usb_scan_running)
 		return 0;
 
-	running = 1;
+	usb_scan_running = 1;
 
 	while (1) {
 		/* We're done, once the list is empty again */
 		if (list_empty(&usb_scan_list))
 			goto out;
 
+		/* Use the same time for all ports, so they go in list order */
+		usb_scan_now = get_timer(0);
 		list_for_each_entry_safe(usb_scan, tmp, &usb_scan_list, list) {
 			int ret;
 
@@ -525,15 +739,26 @@ static int usb_device_list_scan(void)
 
 out:
 	/*
-	 * This USB controller has finished scanning all its connected
-	 * USB devices. Set "running" back to 0, so that other USB controllers
-	 * will scan their devices too.
+	 * All connected USB devices have been scanned. Set "running" back to
+	 * 0, so that the next scan can run.
 	 */
-	running = 0;
+	usb_scan_running = 0;
 
 	return ret;
 }
 
+void usb_hub_defer_scan(void)
+{
+	usb_scan_running = 1;
+}
+
+int usb_hub_scan_queued(void)
+{
+	usb_scan_running = 0;
+
+	return usb_device_list_scan();
+}
+
 static int usb_hub_configure(struct usb_device *dev)
 {
 	int i, length;
@@ -42,6 +42,7 @@
 #include <memalign.h>
 #include <asm/byteorder.h>
 #include <asm/processor.h>
+#include <asm/unaligned.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
 
@@ -98,15 +99,22 @@ struct us_data {
 	ccb		*srb;			/* current srb */
 	trans_reset	transport_reset;	/* reset routine */
 	trans_cmnd	transport;		/* transport routine */
+	unsigned short	max_xfer_blk;		/* max blocks per transfer */
 };
 
+/*
+ * The SCSI READ(10) and WRITE(10) commands are limited to 65535 blocks. We
+ * use the same limit for READ(16) and WRITE(16) so that a transfer cannot run
+ * into the bulk timeout.
+ */
+#define USB_MAX_XFER_BLK_LIMIT	65535
+
 #ifdef CONFIG_USB_EHCI
 /*
  * The U-Boot EHCI driver can handle any transfer length as long as there is
- * enough free heap space left, but the SCSI READ(10) and WRITE(10) commands are
- * limited to 65535 blocks.
+ * enough free heap space left.
  */
-#define USB_MAX_XFER_BLK	65535
+#define USB_MAX_XFER_BLK	USB_MAX_XFER_BLK_LIMIT
 #else
 #define USB_MAX_XFER_BLK	20
 #endif
@@ -723,6 +731,7 @@ static int usb_stor_BBB_transport(ccb *srb, struct us_data *us)
 	int dir_in;
 	int actlen, data_actlen;
 	unsigned int pipe, pipein, pipeout;
+	struct usb_bulk_req reqs[2];
 	ALLOC_CACHE_ALIGN_BUFFER(struct umass_bbb_csw, csw, 1);
 #ifdef BBB_XPORT_TRACE
 	unsigned char *ptr;
@@ -750,13 +759,30 @@ static int usb_stor_BBB_transport(ccb *srb, struct us_data *us)
 	if (srb->datalen == 0)
 		goto st;
 	debug("DATA phase\n");
-	if (dir_in)
-		pipe = pipein;
-	else
-		pipe = pipeout;
-
-	result = usb_bulk_msg(us->pusb_dev, pipe, srb->pdata, srb->datalen,
-			      &data_actlen, USB_CNTL_TIMEOUT * 5);
+	if (dir_in) {
+		/*
+		 * The status comes in on the same pipe, so queue it behind
+		 * the data and let the controller move straight on to it
+		 */
+		reqs[0].buffer = srb->pdata;
+		reqs[0].length = srb->datalen;
+		reqs[1].buffer = csw;
+		reqs[1].length = UMASS_BBB_CSW_SIZE;
+		result = usb_bulk_msg_queue(us->pusb_dev, pipein, reqs, 2,
+					    USB_CNTL_TIMEOUT * 5);
+		data_actlen = reqs[0].act_len;
+		if (!reqs[0].status) {
+			if (result < 0)
+				us->pusb_dev->status = reqs[1].status;
+			retry = 0;
+			goto st_result;
+		}
+		us->pusb_dev->status = reqs[0].status;
+	} else {
+		result = usb_bulk_msg(us->pusb_dev, pipeout, srb->pdata,
+				      srb->datalen, &data_actlen,
+				      USB_CNTL_TIMEOUT * 5);
+	}
 	/* special handling of STALL in DATA phase */
 	if ((result < 0) && (us->pusb_dev->status & USB_ST_STALLED)) {
 		debug("DATA:stall\n");
@@ -785,7 +811,7 @@ again:
 	debug("STATUS phase\n");
 	result = usb_bulk_msg(us->pusb_dev, pipein, csw, UMASS_BBB_CSW_SIZE,
 				&actlen, USB_CNTL_TIMEOUT*5);
-
+st_result:
 	/* special handling of STALL in STATUS phase */
 	if ((result < 0) && (retry < 1) &&
 	    (us->pusb_dev->status & USB_ST_STALLED)) {
@@ -1046,6 +1072,38 @@ static int usb_read_capacity(ccb *srb, struct us_data *ss)
 	return -1;
 }
 
+#ifdef CONFIG_SYS_64BIT_LBA
+/* Read the capacity of a device too large for READ CAPACITY(10) */
+static int usb_read_capacity_16(ccb *srb, struct us_data *ss,
+				lbaint_t *last_lba, u32 *blksz)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(u8, cap, 32);
+	unsigned char *pdata = srb->pdata;
+	int retry = 3;
+	int ret;
+
+	srb->pdata = cap;
+	do {
+		memset(&srb->cmd[0], 0, 16);
+		memset(cap, 0, 32);
+		srb->cmd[0] = SCSI_RD_CAPAC16;
+		srb->cmd[1] = 0x10;	/* service action: READ CAPACITY(16) */
+		put_unaligned_be32(32, &srb->cmd[10]);
+		srb->datalen = 32;
+		srb->cmdlen = 16;
+		ret = ss->transport(srb, ss);
+	} while (ret != USB_STOR_TRANSPORT_GOOD && retry--);
+	srb->pdata = pdata;
+	if (ret != USB_STOR_TRANSPORT_GOOD)
+		return -1;
+
+	*last_lba = get_unaligned_be64(&cap[0]);
+	*blksz = get_unaligned_be32(&cap[8]);
+
+	return 0;
+}
+#endif
+
 static int usb_read_10(ccb *srb, struct us_data *ss, unsigned long start,
 		       unsigned short blocks)
 {
@@ -1080,6 +1138,42 @@ static int usb_write_10(ccb *srb, struct us_data *ss, unsigned long start,
 	return ss->transport(srb, ss);
 }
 
+/*
+ * Set up a READ(16) or WRITE(16) command, for blocks beyond the 32-bit LBA
+ * range of READ(10) and WRITE(10)
+ */
+static int usb_rw_16(ccb *srb, struct us_data *ss, u8 opcode, u64 start,
+		     unsigned short blocks)
+{
+	memset(&srb->cmd[0], 0, 16);
+	srb->cmd[0] = opcode;
+	srb->cmd[1] = srb->lun << 5;
+	put_unaligned_be64(start, &srb->cmd[2]);
+	put_unaligned_be32(blocks, &srb->cmd[10]);
+	srb->cmdlen = 16;
+	debug("%s16: start %llx blocks %x\n",
+	      opcode == SCSI_READ16 ? "read" : "write", start, blocks);
+	return ss->transport(srb, ss);
+}
+
+static int usb_read(ccb *srb, struct us_data *ss, lbaint_t start,
+		    unsigned short blocks)
+{
+	if ((u64)start + blocks > 0x100000000ULL)
+		return usb_rw_16(srb, ss, SCSI_READ16, start, blocks);
+
+	return usb_read_10(srb, ss, start, blocks);
+}
+
+static int usb_write(ccb *srb, struct us_data *ss, lbaint_t start,
+		     unsigned short blocks)
+{
+	if ((u64)start + blocks > 0x100000000ULL)
+		return usb_rw_16(srb, ss, SCSI_WRITE16, start, blocks);
+
+	return usb_write_10(srb, ss, start, blocks);
+}
+
 
 #ifdef CONFIG_USB_BIN_FIXUP
 /*
@@ -1153,16 +1247,16 @@ static unsigned long usb_stor_read(struct blk_desc *block_dev, lbaint_t blknr,
 		/* XXX need some comment here */
 		retry = 2;
 		srb->pdata = (unsigned char *)buf_addr;
-		if (blks > USB_MAX_XFER_BLK)
-			smallblks = USB_MAX_XFER_BLK;
+		if (blks > ss->max_xfer_blk)
+			smallblks = ss->max_xfer_blk;
 		else
 			smallblks = (unsigned short) blks;
 retry_it:
-		if (smallblks == USB_MAX_XFER_BLK)
+		if (smallblks == ss->max_xfer_blk)
 			usb_show_progress();
 		srb->datalen = block_dev->blksz * smallblks;
 		srb->pdata = (unsigned char *)buf_addr;
-		if (usb_read_10(srb, ss, start, smallblks)) {
+		if (usb_read(srb, ss, start, smallblks)) {
 			debug("Read ERROR\n");
 			usb_request_sense(srb, ss);
 			if (retry--)
@@ -1181,7 +1275,7 @@ retry_it:
 	      start, smallblks, buf_addr);
 
 	usb_disable_asynch(0); /* asynch transfer allowed */
-	if (blkcnt >= USB_MAX_XFER_BLK)
+	if (blkcnt >= ss->max_xfer_blk)
 		debug("\n");
 	return blkcnt;
 }
@@ -1239,16 +1333,16 @@ static unsigned long usb_stor_write(struct blk_desc *block_dev, lbaint_t blknr,
 		 */
 		retry = 2;
 		srb->pdata = (unsigned char *)buf_addr;
-		if (blks > USB_MAX_XFER_BLK)
-			smallblks = USB_MAX_XFER_BLK;
+		if (blks > ss->max_xfer_blk)
+			smallblks = ss->max_xfer_blk;
 		else
 			smallblks = (unsigned short) blks;
 retry_it:
-		if (smallblks == USB_MAX_XFER_BLK)
+		if (smallblks == ss->max_xfer_blk)
 			usb_show_progress();
 		srb->datalen = block_dev->blksz * smallblks;
 		srb->pdata = (unsigned char *)buf_addr;
-		if (usb_write_10(srb, ss, start, smallblks)) {
+		if (usb_write(srb, ss, start, smallblks)) {
 			debug("Write ERROR\n");
 			usb_request_sense(srb, ss);
 			if (retry--)
@@ -1266,12 +1360,36 @@ retry_it:
 	      PRIxPTR "\n", start, smallblks, buf_addr);
 
 	usb_disable_asynch(0); /* asynch transfer allowed */
-	if (blkcnt >= USB_MAX_XFER_BLK)
+	if (blkcnt >= ss->max_xfer_blk)
 		debug("\n");
 	return blkcnt;
 
 }
 
+/*
+ * Work out how many blocks of @blksz bytes to read or write with each
+ * command. This is done again once the block size of the device is known.
+ */
+static void usb_stor_set_max_xfer_blk(struct usb_device *udev,
+				      struct us_data *us, u32 blksz)
+{
+	unsigned short blk = USB_MAX_XFER_BLK;
+#ifdef CONFIG_DM_USB
+	size_t size;
+	int ret;
+
+	ret = usb_get_max_xfer_size(udev, &size);
+	if (!ret && blksz) {
+		size /= blksz;
+		if (size > USB_MAX_XFER_BLK_LIMIT)
+			size = USB_MAX_XFER_BLK_LIMIT;
+		blk = max(size, (size_t)1);
+	}
+#endif
+	debug("%s: %u blocks per transfer\n", __func__, blk);
+	us->max_xfer_blk = blk;
+}
+
 /* Probe to see if a new device is actually a Storage device */
 int usb_storage_probe(struct usb_device *dev, unsigned int ifnum,
 		      struct us_data *ss)
@@ -1387,6 +1505,13 @@ int usb_storage_probe(struct usb_device *dev, unsigned int ifnum,
 		ss->irqmaxp = usb_maxpacket(dev, ss->irqpipe);
 		dev->irq_handle = usb_stor_irq;
 	}
+
+	/*
+	 * Set the maximum transfer size per host controller setting, for
+	 * 512-byte blocks until the block size is known
+	 */
+	usb_stor_set_max_xfer_blk(dev, ss, 512);
+
 	dev->privptr = (void *)ss;
 	return 1;
 }
@@ -1397,7 +1522,8 @@ int usb_stor_get_info(struct usb_device *dev, struct us_data *ss,
 	unsigned char perq, modi;
 	ALLOC_CACHE_ALIGN_BUFFER(u32, cap, 2);
 	ALLOC_CACHE_ALIGN_BUFFER(u8, usb_stor_buf, 36);
-	u32 capacity, blksz;
+	lbaint_t capacity;
+	u32 blksz;
 	ccb *pccb = &usb_ccb;
 
 	pccb->pdata = usb_stor_buf;
@@ -1466,15 +1592,23 @@ int usb_stor_get_info(struct usb_device *dev, struct us_data *ss,
 	cap[1] = cpu_to_be32(cap[1]);
 #endif
 
-	capacity = be32_to_cpu(cap[0]) + 1;
+	capacity = be32_to_cpu(cap[0]);
 	blksz = be32_to_cpu(cap[1]);
+#ifdef CONFIG_SYS_64BIT_LBA
+	/* The device has more blocks than READ CAPACITY(10) can report */
+	if (capacity == 0xffffffff &&
+	    usb_read_capacity_16(pccb, ss, &capacity, &blksz))
+		printf("READ_CAP16 ERROR\n");
+#endif
+	capacity++;
 
-	debug("Capacity = 0x%08x, blocksz = 0x%08x\n", capacity, blksz);
+	debug("Capacity = " LBAFU ", blocksz = 0x%08x\n", capacity, blksz);
 	dev_desc->lba = capacity;
 	dev_desc->blksz = blksz;
 	dev_desc->log2blksz = LOG2(dev_desc->blksz);
 	dev_desc->type = perq;
 	debug(" address %d\n", dev_desc->target);
+	usb_stor_set_max_xfer_blk(dev, ss, blksz);
 
 	return 1;
 }
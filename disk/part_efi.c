@@ -19,6 +19,7 @@
 #include <memalign.h>
 #include <part_efi.h>
 #include <linux/ctype.h>
+#include <linux/list.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -172,17 +173,149 @@ static void prepare_backup_gpt_header(gpt_header *gpt_h)
 }
 
 #ifdef CONFIG_EFI_PARTITION
-/*
- * Public Functions (include/part.h)
+/**
+ * struct gpt_cache - parsed GPT of a block device
+ *
+ * Partitions are looked up one at a time, often by name, so the table is
+ * read and checked once and kept here until the device is written to or
+ * initialised again. The hash tables hold the entry index plus one, with
+ * zero marking an empty slot.
+ *
+ * @list:	Entry in gpt_cache_list
+ * @if_type:	Interface type of the device
+ * @devnum:	Device number
+ * @hwpart:	Hardware partition the table was read from
+ * @lba:	Size of the device in blocks when the table was read
+ * @blksz:	Block size of the device when the table was read
+ * @head:	Valid GPT header, primary or backup
+ * @pte:	Partition table entries
+ * @count:	Number of entries before the first unused one
+ * @mask:	Number of slots in each hash table, minus one
+ * @by_name:	Hash table of entries by name
+ * @by_uuid:	Hash table of entries by unique partition GUID
  */
+struct gpt_cache {
+	struct list_head list;
+	int if_type;
+	int devnum;
+	int hwpart;
+	lbaint_t lba;
+	unsigned long blksz;
+	gpt_header head;
+	gpt_entry *pte;
+	uint count;
+	uint mask;
+	uint *by_name;
+	uint *by_uuid;
+};
 
-void part_print_efi(struct blk_desc *dev_desc)
+static LIST_HEAD(gpt_cache_list);
+
+static uint gpt_hash_name(const char *name)
+{
+	return efi_crc32(name, strlen(name));
+}
+
+static uint gpt_hash_uuid(const efi_guid_t *guid)
+{
+	return efi_crc32(guid->b, sizeof(guid->b));
+}
+
+static void gpt_cache_free(struct gpt_cache *gpt)
+{
+	list_del(&gpt->list);
+	free(gpt->by_name);
+	free(gpt->by_uuid);
+	free(gpt->pte);
+	free(gpt);
+}
+
+void part_efi_invalidate(int if_type, int devnum)
+{
+	struct gpt_cache *gpt, *n;
+
+	list_for_each_entry_safe(gpt, n, &gpt_cache_list, list) {
+		if (gpt->if_type == if_type && gpt->devnum == devnum)
+			gpt_cache_free(gpt);
+	}
+}
+
+/* Add entry @i to a hash table, unless an earlier entry has the same key */
+static void gpt_cache_index(struct gpt_cache *gpt, uint *table, uint i)
+{
+	gpt_entry *pte = &gpt->pte[i];
+	bool by_name = table == gpt->by_name;
+	char name[PARTNAME_SZ + 1];
+	uint slot;
+
+	strcpy(name, print_efiname(pte));
+	slot = by_name ? gpt_hash_name(name) :
+		gpt_hash_uuid(&pte->unique_partition_guid);
+	for (slot &= gpt->mask; table[slot]; slot = (slot + 1) & gpt->mask) {
+		gpt_entry *other = &gpt->pte[table[slot] - 1];
+
+		if (by_name ? !strcmp(print_efiname(other), name) :
+		    !memcmp(&other->unique_partition_guid,
+			    &pte->unique_partition_guid, sizeof(efi_guid_t)))
+			return;
+	}
+	table[slot] = i + 1;
+}
+
+/* Build the name and GUID hash tables for a newly read table */
+static int gpt_cache_build(struct gpt_cache *gpt)
+{
+	uint num = le32_to_cpu(gpt->head.num_partition_entries);
+	uint size = 2;
+	uint i;
+
+	for (i = 0; i < num && is_pte_valid(&gpt->pte[i]); i++)
+		;
+	gpt->count = i;
+
+	/* Keep the tables at most half full */
+	while (size < gpt->count * 2)
+		size <<= 1;
+	gpt->mask = size - 1;
+	gpt->by_name = calloc(size, sizeof(uint));
+	gpt->by_uuid = calloc(size, sizeof(uint));
+	if (!gpt->by_name || !gpt->by_uuid)
+		return -ENOMEM;
+
+	for (i = 0; i < gpt->count; i++) {
+		gpt_cache_index(gpt, gpt->by_name, i);
+		gpt_cache_index(gpt, gpt->by_uuid, i);
+	}
+
+	return 0;
+}
+
+/**
+ * gpt_cache_get() - get the parsed GPT of a device
+ *
+ * The table is read and checked on the first call for a device, falling
+ * back to the backup GPT if the primary one is not valid.
+ *
+ * @dev_desc:	Block device descriptor
+ * @return parsed table, or NULL if there is no valid GPT
+ */
+static struct gpt_cache *gpt_cache_get(struct blk_desc *dev_desc)
 {
 	ALLOC_CACHE_ALIGN_BUFFER_PAD(gpt_header, gpt_head, 1, dev_desc->blksz);
 	gpt_entry *gpt_pte = NULL;
-	int i = 0;
-	char uuid[37];
-	unsigned char *uuid_bin;
+	struct gpt_cache *gpt;
+
+	list_for_each_entry(gpt, &gpt_cache_list, list) {
+		if (gpt->if_type != dev_desc->if_type ||
+		    gpt->devnum != dev_desc->devnum ||
+		    gpt->hwpart != dev_desc->hwpart)
+			continue;
+		if (gpt->lba == dev_desc->lba && gpt->blksz == dev_desc->blksz)
+			return gpt;
+		/* The medium has changed under us */
+		gpt_cache_free(gpt);
+		break;
+	}
 
 	/* This function validates AND fills in the GPT header and PTE */
 	if (is_gpt_valid(dev_desc, GPT_PRIMARY_PARTITION_TABLE_LBA,
@@ -192,7 +325,7 @@ void part_print_efi(struct blk_desc *dev_desc)
 				 gpt_head, &gpt_pte) != 1) {
 			printf("%s: *** ERROR: Invalid Backup GPT ***\n",
 			       __func__);
-			return;
+			return NULL;
 		} else {
 			printf("%s: ***        Using Backup GPT ***\n",
 			       __func__);
@@ -201,16 +334,78 @@ void part_print_efi(struct blk_desc *dev_desc)
 
 	debug("%s: gpt-entry at %p\n", __func__, gpt_pte);
 
+	gpt = calloc(1, sizeof(*gpt));
+	if (!gpt) {
+		free(gpt_pte);
+		return NULL;
+	}
+	gpt->if_type = dev_desc->if_type;
+	gpt->devnum = dev_desc->devnum;
+	gpt->hwpart = dev_desc->hwpart;
+	gpt->lba = dev_desc->lba;
+	gpt->blksz = dev_desc->blksz;
+	memcpy(&gpt->head, gpt_head, sizeof(gpt->head));
+	gpt->pte = gpt_pte;
+	list_add(&gpt->list, &gpt_cache_list);
+	if (gpt_cache_build(gpt)) {
+		printf("%s: ERROR: Can't allocate GPT index\n", __func__);
+		gpt_cache_free(gpt);
+		return NULL;
+	}
+
+	return gpt;
+}
+
+static void gpt_fill_info(struct blk_desc *dev_desc, gpt_entry *pte,
+			  disk_partition_t *info)
+{
+	/* The 'lbaint_t' casting may limit the maximum disk size to 2 TB */
+	info->start = (lbaint_t)le64_to_cpu(pte->starting_lba);
+	/* The ending LBA is inclusive, to calculate size, add 1 to it */
+	info->size = (lbaint_t)le64_to_cpu(pte->ending_lba) + 1
+		     - info->start;
+	info->blksz = dev_desc->blksz;
+
+	sprintf((char *)info->name, "%s", print_efiname(pte));
+	strcpy((char *)info->type, "U-Boot");
+	info->bootable = is_bootable(pte);
+#ifdef CONFIG_PARTITION_UUIDS
+	uuid_bin_to_str(pte->unique_partition_guid.b, info->uuid,
+			UUID_STR_FORMAT_GUID);
+#endif
+#ifdef CONFIG_PARTITION_TYPE_GUID
+	uuid_bin_to_str(pte->partition_type_guid.b, info->type_guid,
+			UUID_STR_FORMAT_GUID);
+#endif
+
+	debug("%s: start 0x" LBAF ", size 0x" LBAF ", name %s\n", __func__,
+	      info->start, info->size, info->name);
+}
+
+/*
+ * Public Functions (include/part.h)
+ */
+
+void part_print_efi(struct blk_desc *dev_desc)
+{
+	struct gpt_cache *gpt;
+	gpt_entry *gpt_pte;
+	int i = 0;
+	char uuid[37];
+	unsigned char *uuid_bin;
+
+	gpt = gpt_cache_get(dev_desc);
+	if (!gpt)
+		return;
+	gpt_pte = gpt->pte;
+
 	printf("Part\tStart LBA\tEnd LBA\t\tName\n");
 	printf("\tAttributes\n");
 	printf("\tType GUID\n");
 	printf("\tPartition GUID\n");
 
-	for (i = 0; i < le32_to_cpu(gpt_head->num_partition_entries); i++) {
-		/* Stop at the first non valid PTE */
-		if (!is_pte_valid(&gpt_pte[i]))
-			break;
-
+	/* Stop at the first non valid PTE */
+	for (i = 0; i < gpt->count; i++) {
 		printf("%3d\t0x%08llx\t0x%08llx\t\"%s\"\n", (i + 1),
 			le64_to_cpu(gpt_pte[i].starting_lba),
 			le64_to_cpu(gpt_pte[i].ending_lba),
@@ -227,17 +422,12 @@ void part_print_efi(struct blk_desc *dev_desc)
 		uuid_bin_to_str(uuid_bin, uuid, UUID_STR_FORMAT_GUID);
 		printf("\tguid:\t%s\n", uuid);
 	}
-
-	/* Remember to free pte */
-	free(gpt_pte);
-	return;
 }
 
 int part_get_info_efi(struct blk_desc *dev_desc, int part,
 		      disk_partition_t *info)
 {
-	ALLOC_CACHE_ALIGN_BUFFER_PAD(gpt_header, gpt_head, 1, dev_desc->blksz);
-	gpt_entry *gpt_pte = NULL;
+	struct gpt_cache *gpt;
 
 	/* "part" argument must be at least 1 */
 	if (part < 1) {
@@ -245,74 +435,70 @@ int part_get_info_efi(struct blk_desc *dev_desc, int part,
 		return -1;
 	}
 
-	/* This function validates AND fills in the GPT header and PTE */
-	if (is_gpt_valid(dev_desc, GPT_PRIMARY_PARTITION_TABLE_LBA,
-			gpt_head, &gpt_pte) != 1) {
-		printf("%s: *** ERROR: Invalid GPT ***\n", __func__);
-		if (is_gpt_valid(dev_desc, (dev_desc->lba - 1),
-				 gpt_head, &gpt_pte) != 1) {
-			printf("%s: *** ERROR: Invalid Backup GPT ***\n",
-			       __func__);
-			return -1;
-		} else {
-			printf("%s: ***        Using Backup GPT ***\n",
-			       __func__);
-		}
-	}
+	gpt = gpt_cache_get(dev_desc);
+	if (!gpt)
+		return -1;
 
-	if (part > le32_to_cpu(gpt_head->num_partition_entries) ||
-	    !is_pte_valid(&gpt_pte[part - 1])) {
+	if (part > le32_to_cpu(gpt->head.num_partition_entries) ||
+	    !is_pte_valid(&gpt->pte[part - 1])) {
 		debug("%s: *** ERROR: Invalid partition number %d ***\n",
 			__func__, part);
-		free(gpt_pte);
 		return -1;
 	}
 
-	/* The 'lbaint_t' casting may limit the maximum disk size to 2 TB */
-	info->start = (lbaint_t)le64_to_cpu(gpt_pte[part - 1].starting_lba);
-	/* The ending LBA is inclusive, to calculate size, add 1 to it */
-	info->size = (lbaint_t)le64_to_cpu(gpt_pte[part - 1].ending_lba) + 1
-		     - info->start;
-	info->blksz = dev_desc->blksz;
+	gpt_fill_info(dev_desc, &gpt->pte[part - 1], info);
 
-	sprintf((char *)info->name, "%s",
-			print_efiname(&gpt_pte[part - 1]));
-	strcpy((char *)info->type, "U-Boot");
-	info->bootable = is_bootable(&gpt_pte[part - 1]);
-#ifdef CONFIG_PARTITION_UUIDS
-	uuid_bin_to_str(gpt_pte[part - 1].unique_partition_guid.b, info->uuid,
-			UUID_STR_FORMAT_GUID);
-#endif
-#ifdef CONFIG_PARTITION_TYPE_GUID
-	uuid_bin_to_str(gpt_pte[part - 1].partition_type_guid.b,
-			info->type_guid, UUID_STR_FORMAT_GUID);
-#endif
-
-	debug("%s: start 0x" LBAF ", size 0x" LBAF ", name %s\n", __func__,
-	      info->start, info->size, info->name);
-
-	/* Remember to free pte */
-	free(gpt_pte);
 	return 0;
 }
 
 int part_get_info_efi_by_name(struct blk_desc *dev_desc,
 	const char *name, disk_partition_t *info)
 {
-	int ret;
-	int i;
-	for (i = 1; i < GPT_ENTRY_NUMBERS; i++) {
-		ret = part_get_info_efi(dev_desc, i, info);
-		if (ret != 0) {
-			/* no more entries in table */
-			return -1;
+	struct gpt_cache *gpt;
+	uint slot, i;
+
+	gpt = gpt_cache_get(dev_desc);
+	if (!gpt)
+		return -1;
+
+	for (slot = gpt_hash_name(name) & gpt->mask; gpt->by_name[slot];
+	     slot = (slot + 1) & gpt->mask) {
+		i = gpt->by_name[slot] - 1;
+		if (!strcmp(print_efiname(&gpt->pte[i]), name)) {
+			gpt_fill_info(dev_desc, &gpt->pte[i], info);
+			return 0;
 		}
-		if (strcmp(name, (const char *)info->name) == 0) {
-			/* matched */
+	}
+
+	/* As before, -2 means that every entry was looked at */
+	return gpt->count < GPT_ENTRY_NUMBERS - 1 ? -1 : -2;
+}
+
+int part_get_info_efi_by_uuid(struct blk_desc *dev_desc, const char *uuid,
+			      disk_partition_t *info)
+{
+	struct gpt_cache *gpt;
+	efi_guid_t guid;
+	uint slot, i;
+
+	if (uuid_str_to_bin((char *)uuid, guid.b, UUID_STR_FORMAT_GUID))
+		return -EINVAL;
+
+	gpt = gpt_cache_get(dev_desc);
+	if (!gpt)
+		return -1;
+
+	for (slot = gpt_hash_uuid(&guid) & gpt->mask; gpt->by_uuid[slot];
+	     slot = (slot + 1) & gpt->mask) {
+		i = gpt->by_uuid[slot] - 1;
+		if (!memcmp(&gpt->pte[i].unique_partition_guid, &guid,
+			    sizeof(guid))) {
+			gpt_fill_info(dev_desc, &gpt->pte[i], info);
 			return 0;
 		}
 	}
-	return -2;
+
+	return -1;
 }
 
 static int part_test_efi(struct blk_desc *dev_desc)
@@ -366,6 +552,8 @@ int write_gpt_table(struct blk_desc *dev_desc,
 					   * sizeof(gpt_entry)), dev_desc);
 	u32 calc_crc32;
 
+	part_efi_invalidate(dev_desc->if_type, dev_desc->devnum);
+
 	debug("max lba: %x\n", (u32) dev_desc->lba);
 	/* Setup the Protective MBR */
 	if (set_protective_mbr(dev_desc) < 0)
@@ -718,6 +906,8 @@ int write_mbr_and_gpt_partitions(struct blk_desc *dev_desc, void *buf)
 	if (is_valid_gpt_buf(dev_desc, buf))
 		return -1;
 
+	part_efi_invalidate(dev_desc->if_type, dev_desc->devnum);
+
 	/* determine start of GPT Header in the buffer */
 	gpt_h = buf + (GPT_PRIMARY_PARTITION_TABLE_LBA *
 		       dev_desc->blksz);
@@ -72,17 +72,13 @@ int blkcache_read(int iftype, int devnum,
 	return 0;
 }
 
-void blkcache_fill(int iftype, int devnum,
-		   lbaint_t start, lbaint_t blkcnt,
-		   unsigned long blksz, void const *buffer)
+static void cache_fill(int iftype, int devnum,
+		       lbaint_t start, lbaint_t blkcnt,
+		       unsigned long blksz, void const *buffer)
 {
 	lbaint_t bytes;
 	struct block_cache_node *node;
 
-	/* don't cache big stuff */
-	if (blkcnt > _stats.max_blocks_per_entry)
-		return;
-
 	if (_stats.max_entries == 0)
 		return;
 
@@ -126,11 +122,31 @@ void blkcache_fill(int iftype, int devnum,
 	_stats.entries++;
 }
 
+void blkcache_fill(int iftype, int devnum,
+		   lbaint_t start, lbaint_t blkcnt,
+		   unsigned long blksz, void const *buffer)
+{
+	/* don't cache big stuff */
+	if (blkcnt > _stats.max_blocks_per_entry)
+		return;
+
+	cache_fill(iftype, devnum, start, blkcnt, blksz, buffer);
+}
+
+void blkcache_fill_readahead(int iftype, int devnum,
+			     lbaint_t start, lbaint_t blkcnt,
+			     unsigned long blksz, void const *buffer)
+{
+	cache_fill(iftype, devnum, start, blkcnt, blksz, buffer);
+}
+
 void blkcache_invalidate(int iftype, int devnum)
 {
 	struct list_head *entry, *n;
 	struct block_cache_node *node;
 
+	part_efi_invalidate(iftype, devnum);
+
 	list_for_each_safe(entry, n, &block_cache) {
 		node = (struct block_cache_node *)entry;
 		if ((node->iftype == iftype) &&
@@ -49,6 +49,7 @@ static unsigned long host_block_read(struct blk_desc *block_dev,
 		return -1;
 #endif
 
+	host_dev->read_count++;
 	if (os_lseek(host_dev->fd, start * block_dev->blksz, OS_SEEK_SET) ==
 			-1) {
 		printf("ERROR: Invalid block %lx\n", start);
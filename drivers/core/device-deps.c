@@ -0,0 +1,159 @@
+/*
+ * Devices which a device depends on, from its device tree node
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <errno.h>
+#include <fdtdec.h>
+#include <malloc.h>
+#include <dm/device-internal.h>
+#include <dm/uclass-internal.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Most devices use only a few clocks, resets, etc. */
+#define DEVICE_MAX_DEPS		16
+
+/*
+ * Properties which refer to devices that must be probed first. The name
+ * matches the whole property or its end after a '-', as in 'cs-gpios'.
+ */
+static const struct device_dep_prop {
+	const char *name;
+	const char *cells_name;
+	enum uclass_id uclass_id;
+} device_dep_props[] = {
+	{ "clocks", "#clock-cells", UCLASS_CLK },
+	{ "resets", "#reset-cells", UCLASS_RESET },
+	{ "power-domains", "#power-domain-cells", UCLASS_POWER_DOMAIN },
+	{ "gpios", "#gpio-cells", UCLASS_GPIO },
+};
+
+static const struct device_dep_prop *device_dep_find_prop(const char *name)
+{
+	int len = strlen(name);
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(device_dep_props); i++) {
+		const char *match = device_dep_props[i].name;
+		int match_len = strlen(match);
+
+		if (len < match_len || strcmp(name + len - match_len, match))
+			continue;
+		if (len == match_len || name[len - match_len - 1] == '-')
+			return &device_dep_props[i];
+	}
+
+	return NULL;
+}
+
+/* Add each node in a phandle list to @deps, returning the new count */
+static int device_dep_add_prop(struct udevice *dev,
+			       const struct device_dep_prop *prop,
+			       const char *name, struct device_dep *deps,
+			       int count)
+{
+	struct fdtdec_phandle_args args;
+	int num, i, j;
+
+	num = fdtdec_parse_phandle_with_args(gd->fdt_blob, dev->of_offset,
+					     name, prop->cells_name, 0, -1,
+					     NULL);
+	for (i = 0; i < num && count < DEVICE_MAX_DEPS; i++) {
+		/* Empty entries give -ENOENT */
+		if (fdtdec_parse_phandle_with_args(gd->fdt_blob,
+						   dev->of_offset, name,
+						   prop->cells_name, 0, i,
+						   &args))
+			continue;
+		if (args.node == dev->of_offset)
+			continue;
+		for (j = 0; j < count; j++) {
+			if (deps[j].of_offset == args.node &&
+			    deps[j].uclass_id == prop->uclass_id)
+				break;
+		}
+		if (j < count)
+			continue;
+		deps[count].uclass_id = prop->uclass_id;
+		deps[count].of_offset = args.node;
+		count++;
+	}
+
+	return count;
+}
+
+int device_bind_deps(struct udevice *dev)
+{
+	const void *blob = gd->fdt_blob;
+	struct device_dep deps[DEVICE_MAX_DEPS];
+	int count = 0;
+	int offset;
+
+	if (dev->of_offset < 0)
+		return 0;
+
+	for (offset = fdt_first_property_offset(blob, dev->of_offset);
+	     offset >= 0;
+	     offset = fdt_next_property_offset(blob, offset)) {
+		const struct device_dep_prop *prop;
+		const char *name;
+
+		if (!fdt_getprop_by_offset(blob, offset, &name, NULL))
+			continue;
+		prop = device_dep_find_prop(name);
+		if (prop)
+			count = device_dep_add_prop(dev, prop, name, deps,
+						    count);
+	}
+	if (!count)
+		return 0;
+
+	dev->deps = malloc(count * sizeof(*deps));
+	if (!dev->deps)
+		return -ENOMEM;
+	memcpy(dev->deps, deps, count * sizeof(*deps));
+	dev->dep_count = count;
+
+	return 0;
+}
+
+int device_get_dep(struct udevice *dev, int index, struct udevice **devp)
+{
+	struct device_dep *dep;
+
+	*devp = NULL;
+	if (index < 0 || index >= dev->dep_count)
+		return -ENOENT;
+	dep = &dev->deps[index];
+	uclass_find_device_by_of_offset(dep->uclass_id, dep->of_offset, devp);
+
+	return 0;
+}
+
+void device_probe_deps(struct udevice *dev)
+{
+	struct udevice *dep;
+	int ret;
+	int i;
+
+	for (i = 0; !device_get_dep(dev, i, &dep); i++) {
+		if (!dep || (dep->flags & DM_FLAG_PROBE_DEPS))
+			continue;
+		ret = device_probe(dep);
+		if (ret) {
+			debug("%s: Cannot probe '%s' used by '%s' (err=%d)\n",
+			      __func__, dep->name, dev->name, ret);
+		}
+	}
+}
+
+void device_free_deps(struct udevice *dev)
+{
+	free(dev->deps);
+	dev->deps = NULL;
+	dev->dep_count = 0;
+}
@@ -92,15 +92,15 @@ int device_unbind(struct udevice *dev)
 		return ret;
 
 	if (dev->flags & DM_FLAG_ALLOC_PDATA) {
-		free(dev->platdata);
+		device_free_area(dev, dev->platdata);
 		dev->platdata = NULL;
 	}
 	if (dev->flags & DM_FLAG_ALLOC_UCLASS_PDATA) {
-		free(dev->uclass_platdata);
+		device_free_area(dev, dev->uclass_platdata);
 		dev->uclass_platdata = NULL;
 	}
 	if (dev->flags & DM_FLAG_ALLOC_PARENT_PDATA) {
-		free(dev->parent_platdata);
+		device_free_area(dev, dev->parent_platdata);
 		dev->parent_platdata = NULL;
 	}
 	ret = uclass_unbind_device(dev);
@@ -110,6 +110,8 @@ int device_unbind(struct udevice *dev)
 	if (dev->parent)
 		list_del(&dev->sibling_node);
 
+	device_free_arena(dev);
+	device_free_deps(dev);
 	devres_release_all(dev);
 
 	if (dev->flags & DM_NAME_ALLOCED)
@@ -128,12 +130,12 @@ void device_free(struct udevice *dev)
 	int size;
 
 	if (dev->driver->priv_auto_alloc_size) {
-		free(dev->priv);
+		device_free_area(dev, dev->priv);
 		dev->priv = NULL;
 	}
 	size = dev->uclass->uc_drv->per_device_auto_alloc_size;
 	if (size) {
-		free(dev->uclass_priv);
+		device_free_area(dev, dev->uclass_priv);
 		dev->uclass_priv = NULL;
 	}
 	if (dev->parent) {
@@ -143,7 +145,7 @@ void device_free(struct udevice *dev)
 					per_child_auto_alloc_size;
 		}
 		if (size) {
-			free(dev->parent_priv);
+			device_free_area(dev, dev->parent_priv);
 			dev->parent_priv = NULL;
 		}
 	}
@@ -189,7 +191,7 @@ int device_remove(struct udevice *dev)
 
 	device_free(dev);
 
-	dev->seq = -1;
+	uclass_set_device_seq(dev, -1);
 	dev->flags &= ~DM_FLAG_ACTIVATED;
 
 	return ret;
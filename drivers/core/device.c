@@ -26,6 +26,160 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+static void *alloc_priv(int size, uint flags)
+{
+	void *priv;
+
+	if (flags & DM_FLAG_ALLOC_PRIV_DMA) {
+		priv = memalign(ARCH_DMA_MINALIGN, size);
+		if (priv)
+			memset(priv, '\0', size);
+	} else {
+		priv = calloc(1, size);
+	}
+
+	return priv;
+}
+
+#if CONFIG_IS_ENABLED(DM_DEVICE_ARENA)
+/* The data which is allocated automatically for a device, in arena order */
+enum device_area {
+	DEVICE_AREA_PRIV,
+	DEVICE_AREA_UCLASS_PRIV,
+	DEVICE_AREA_PARENT_PRIV,
+	DEVICE_AREA_UCLASS_PDATA,
+	DEVICE_AREA_PARENT_PDATA,
+	DEVICE_AREA_PDATA,
+
+	DEVICE_AREA_COUNT,
+};
+
+#define DEVICE_AREA_ALIGN	(2 * sizeof(long))
+
+static int device_area_size(struct udevice *dev, enum device_area area)
+{
+	const struct driver *drv = dev->driver;
+	struct udevice *parent = dev->parent;
+	int size = 0;
+
+	switch (area) {
+	case DEVICE_AREA_PRIV:
+		size = drv->priv_auto_alloc_size;
+		break;
+	case DEVICE_AREA_UCLASS_PRIV:
+		return dev->uclass->uc_drv->per_device_auto_alloc_size;
+	case DEVICE_AREA_PARENT_PRIV:
+		if (!parent)
+			return 0;
+		size = parent->driver->per_child_auto_alloc_size;
+		if (!size) {
+			size = parent->uclass->uc_drv->
+					per_child_auto_alloc_size;
+		}
+		break;
+	case DEVICE_AREA_UCLASS_PDATA:
+		return dev->uclass->uc_drv->per_device_platdata_auto_alloc_size;
+	case DEVICE_AREA_PARENT_PDATA:
+		if (!parent)
+			return 0;
+		size = parent->driver->per_child_platdata_auto_alloc_size;
+		if (!size) {
+			size = parent->uclass->uc_drv->
+					per_child_platdata_auto_alloc_size;
+		}
+		return size;
+	case DEVICE_AREA_PDATA:
+		if (!(dev->flags & DM_FLAG_ALLOC_PDATA))
+			return 0;
+		return drv->platdata_auto_alloc_size;
+	default:
+		return 0;
+	}
+
+	/* Data which must be aligned for DMA is allocated separately */
+	if (drv->flags & DM_FLAG_ALLOC_PRIV_DMA)
+		return 0;
+
+	return size;
+}
+
+/* Find the arena space for an area, or NULL if it is not in the arena */
+static void *device_area(struct udevice *dev, enum device_area area)
+{
+	int size = device_area_size(dev, area);
+	int offset = 0;
+	int i;
+
+	if (!dev->arena || !size)
+		return NULL;
+	for (i = 0; i < area; i++)
+		offset += ALIGN(device_area_size(dev, i), DEVICE_AREA_ALIGN);
+
+	/* The sizes may have changed since the device was bound */
+	if (offset + size > dev->arena_size)
+		return NULL;
+
+	return dev->arena + offset;
+}
+
+static void *device_alloc_area(struct udevice *dev, enum device_area area,
+			       int size, uint flags)
+{
+	void *ptr = device_area(dev, area);
+
+	if (!ptr)
+		return alloc_priv(size, flags);
+	memset(ptr, '\0', size);
+
+	return ptr;
+}
+
+static int device_alloc_arena(struct udevice *dev)
+{
+	int size = 0;
+	int i;
+
+	for (i = 0; i < DEVICE_AREA_COUNT; i++)
+		size += ALIGN(device_area_size(dev, i), DEVICE_AREA_ALIGN);
+	if (!size)
+		return 0;
+	dev->arena = calloc(1, size);
+	if (!dev->arena)
+		return -ENOMEM;
+	dev->arena_size = size;
+
+	return 0;
+}
+
+void device_free_area(struct udevice *dev, void *ptr)
+{
+	char *arena = dev->arena;
+
+	if ((char *)ptr >= arena && (char *)ptr < arena + dev->arena_size)
+		return;
+	free(ptr);
+}
+
+void device_free_arena(struct udevice *dev)
+{
+	free(dev->arena);
+	dev->arena = NULL;
+	dev->arena_size = 0;
+}
+#else
+#define device_alloc_area(dev, area, size, flags)	alloc_priv(size, flags)
+
+static inline int device_alloc_arena(struct udevice *dev)
+{
+	return 0;
+}
+
+void device_free_area(struct udevice *dev, void *ptr)
+{
+	free(ptr);
+}
+#endif
+
 static int device_bind_common(struct udevice *parent, const struct driver *drv,
 			      const char *name, void *platdata,
 			      ulong driver_data, int of_offset,
@@ -83,9 +237,20 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 		}
 	}
 
-	if (!dev->platdata && drv->platdata_auto_alloc_size) {
+	ret = device_bind_deps(dev);
+	if (ret)
+		goto fail_alloc1;
+
+	if (!dev->platdata && drv->platdata_auto_alloc_size)
 		dev->flags |= DM_FLAG_ALLOC_PDATA;
-		dev->platdata = calloc(1, drv->platdata_auto_alloc_size);
+	ret = device_alloc_arena(dev);
+	if (ret)
+		goto fail_alloc1;
+
+	if (dev->flags & DM_FLAG_ALLOC_PDATA) {
+		dev->platdata = device_alloc_area(dev, DEVICE_AREA_PDATA,
+						  drv->platdata_auto_alloc_size,
+						  0);
 		if (!dev->platdata) {
 			ret = -ENOMEM;
 			goto fail_alloc1;
@@ -95,7 +260,8 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 	size = uc->uc_drv->per_device_platdata_auto_alloc_size;
 	if (size) {
 		dev->flags |= DM_FLAG_ALLOC_UCLASS_PDATA;
-		dev->uclass_platdata = calloc(1, size);
+		dev->uclass_platdata = device_alloc_area(dev,
+					DEVICE_AREA_UCLASS_PDATA, size, 0);
 		if (!dev->uclass_platdata) {
 			ret = -ENOMEM;
 			goto fail_alloc2;
@@ -110,7 +276,8 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 		}
 		if (size) {
 			dev->flags |= DM_FLAG_ALLOC_PARENT_PDATA;
-			dev->parent_platdata = calloc(1, size);
+			dev->parent_platdata = device_alloc_area(dev,
+					DEVICE_AREA_PARENT_PDATA, size, 0);
 			if (!dev->parent_platdata) {
 				ret = -ENOMEM;
 				goto fail_alloc3;
@@ -148,6 +315,7 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 	if (devp)
 		*devp = dev;
 
+	uclass_index_device(dev);
 	dev->flags |= DM_FLAG_BOUND;
 
 	return 0;
@@ -173,21 +341,23 @@ fail_uclass_bind:
 	if (CONFIG_IS_ENABLED(DM_DEVICE_REMOVE)) {
 		list_del(&dev->sibling_node);
 		if (dev->flags & DM_FLAG_ALLOC_PARENT_PDATA) {
-			free(dev->parent_platdata);
+			device_free_area(dev, dev->parent_platdata);
 			dev->parent_platdata = NULL;
 		}
 	}
 fail_alloc3:
 	if (dev->flags & DM_FLAG_ALLOC_UCLASS_PDATA) {
-		free(dev->uclass_platdata);
+		device_free_area(dev, dev->uclass_platdata);
 		dev->uclass_platdata = NULL;
 	}
 fail_alloc2:
 	if (dev->flags & DM_FLAG_ALLOC_PDATA) {
-		free(dev->platdata);
+		device_free_area(dev, dev->platdata);
 		dev->platdata = NULL;
 	}
 fail_alloc1:
+	device_free_arena(dev);
+	device_free_deps(dev);
 	devres_release_all(dev);
 
 	free(dev);
@@ -227,20 +397,17 @@ int device_bind_by_name(struct udevice *parent, bool pre_reloc_only,
 			   -1, devp);
 }
 
-static void *alloc_priv(int size, uint flags)
+#if CONFIG_IS_ENABLED(DM_PROBE_TIME)
+static ulong device_probe_time_us(void)
 {
-	void *priv;
-
-	if (flags & DM_FLAG_ALLOC_PRIV_DMA) {
-		priv = memalign(ARCH_DMA_MINALIGN, size);
-		if (priv)
-			memset(priv, '\0', size);
-	} else {
-		priv = calloc(1, size);
-	}
-
-	return priv;
+#ifdef CONFIG_TIMER
+	/* Reading the timer now would probe it in the middle of this probe */
+	if (!gd->timer)
+		return 0;
+#endif
+	return timer_get_us();
 }
+#endif
 
 int device_probe(struct udevice *dev)
 {
@@ -248,6 +415,9 @@ int device_probe(struct udevice *dev)
 	int size = 0;
 	int ret;
 	int seq;
+#if CONFIG_IS_ENABLED(DM_PROBE_TIME)
+	ulong start;
+#endif
 
 	if (!dev)
 		return -EINVAL;
@@ -260,7 +430,9 @@ int device_probe(struct udevice *dev)
 
 	/* Allocate private data if requested and not reentered */
 	if (drv->priv_auto_alloc_size && !dev->priv) {
-		dev->priv = alloc_priv(drv->priv_auto_alloc_size, drv->flags);
+		dev->priv = device_alloc_area(dev, DEVICE_AREA_PRIV,
+					      drv->priv_auto_alloc_size,
+					      drv->flags);
 		if (!dev->priv) {
 			ret = -ENOMEM;
 			goto fail;
@@ -269,7 +441,9 @@ int device_probe(struct udevice *dev)
 	/* Allocate private data if requested and not reentered */
 	size = dev->uclass->uc_drv->per_device_auto_alloc_size;
 	if (size && !dev->uclass_priv) {
-		dev->uclass_priv = calloc(1, size);
+		dev->uclass_priv = device_alloc_area(dev,
+						     DEVICE_AREA_UCLASS_PRIV,
+						     size, 0);
 		if (!dev->uclass_priv) {
 			ret = -ENOMEM;
 			goto fail;
@@ -284,7 +458,9 @@ int device_probe(struct udevice *dev)
 					per_child_auto_alloc_size;
 		}
 		if (size && !dev->parent_priv) {
-			dev->parent_priv = alloc_priv(size, drv->flags);
+			dev->parent_priv = device_alloc_area(dev,
+						DEVICE_AREA_PARENT_PRIV, size,
+						drv->flags);
 			if (!dev->parent_priv) {
 				ret = -ENOMEM;
 				goto fail;
@@ -305,12 +481,27 @@ int device_probe(struct udevice *dev)
 			return 0;
 	}
 
+	/* And the devices providing its clocks, resets, etc. */
+	if (CONFIG_IS_ENABLED(DM_PROBE_DEPS) &&
+	    !(dev->flags & DM_FLAG_PROBE_DEPS)) {
+		dev->flags |= DM_FLAG_PROBE_DEPS;
+		device_probe_deps(dev);
+		dev->flags &= ~DM_FLAG_PROBE_DEPS;
+
+		/* One of them may have needed this device */
+		if (dev->flags & DM_FLAG_ACTIVATED)
+			return 0;
+	}
+
+#if CONFIG_IS_ENABLED(DM_PROBE_TIME)
+	start = device_probe_time_us();
+#endif
 	seq = uclass_resolve_seq(dev);
 	if (seq < 0) {
 		ret = seq;
 		goto fail;
 	}
-	dev->seq = seq;
+	uclass_set_device_seq(dev, seq);
 
 	dev->flags |= DM_FLAG_ACTIVATED;
 
@@ -354,6 +545,10 @@ int device_probe(struct udevice *dev)
 	if (dev->parent && device_get_uclass_id(dev) == UCLASS_PINCTRL)
 		pinctrl_select_state(dev, "default");
 
+#if CONFIG_IS_ENABLED(DM_PROBE_TIME)
+	dev->probe_time_us = start ? device_probe_time_us() - start : 0;
+#endif
+
 	return 0;
 fail_uclass:
 	if (device_remove(dev)) {
@@ -363,7 +558,7 @@ fail_uclass:
 fail:
 	dev->flags &= ~DM_FLAG_ACTIVATED;
 
-	dev->seq = -1;
+	uclass_set_device_seq(dev, -1);
 	device_free(dev);
 
 	return ret;
@@ -737,6 +932,7 @@ int device_set_name(struct udevice *dev, const char *name)
 		return -ENOMEM;
 	dev->name = name;
 	device_set_name_alloced(dev);
+	uclass_index_device(dev);
 
 	return 0;
 }
@@ -94,3 +94,78 @@ void dm_dump_uclass(void)
 		puts("\n");
 	}
 }
+
+#if CONFIG_IS_ENABLED(DM_PROBE_TIME)
+/*
+ * Work out how many devices must be probed one after the other before this
+ * one. Devices at the same level do not depend on each other.
+ *
+ * The level is kept in the device, so that devices shared by many others
+ * are only visited once. A device which is still being worked out is part
+ * of a loop in the dependencies and does not count.
+ */
+static int dm_probe_level(struct udevice *dev)
+{
+	struct udevice *dep;
+	int level, i;
+
+	if (!dev->parent)
+		return 0;
+	if (dev->probe_level)
+		return max(dev->probe_level, 0);
+
+	dev->probe_level = -1;
+	level = dm_probe_level(dev->parent);
+	for (i = 0; !device_get_dep(dev, i, &dep); i++) {
+		if (dep)
+			level = max(level, dm_probe_level(dep));
+	}
+	dev->probe_level = level + 1;
+
+	return dev->probe_level;
+}
+
+static void dm_clear_probe_level(struct udevice *dev)
+{
+	struct udevice *child;
+
+	dev->probe_level = 0;
+	list_for_each_entry(child, &dev->child_head, sibling_node)
+		dm_clear_probe_level(child);
+}
+
+static ulong show_probe_time(struct udevice *dev)
+{
+	struct udevice *child;
+	char class_name[12];
+	ulong total = 0;
+
+	if (dev->flags & DM_FLAG_ACTIVATED) {
+		strlcpy(class_name, dev->uclass->uc_drv->name,
+			sizeof(class_name));
+		printf("%10lu  %5d  %-11s  %s\n", dev->probe_time_us,
+		       dm_probe_level(dev), class_name, dev->name);
+		total = dev->probe_time_us;
+	}
+
+	list_for_each_entry(child, &dev->child_head, sibling_node)
+		total += show_probe_time(child);
+
+	return total;
+}
+
+void dm_dump_probe_time(void)
+{
+	struct udevice *root;
+	ulong total;
+
+	root = dm_root();
+	if (root) {
+		printf(" Time (us)  Level  Class        Name\n");
+		printf("------------------------------------------------\n");
+		dm_clear_probe_level(root);
+		total = show_probe_time(root);
+		printf("%10lu  total\n", total);
+	}
+}
+#endif
@@ -16,7 +16,11 @@
 #include <dm/uclass.h>
 #include <dm/util.h>
 #include <fdtdec.h>
+#include <malloc.h>
 #include <linux/compiler.h>
+#include <linux/log2.h>
+
+DECLARE_GLOBAL_DATA_PTR;
 
 struct driver *lists_driver_lookup_name(const char *name)
 {
@@ -138,13 +142,190 @@ static int driver_check_compatible(const void *blob, int offset,
 	return -ENOENT;
 }
 
-int lists_bind_fdt(struct udevice *parent, const void *blob, int offset,
-		   struct udevice **devp)
+#if CONFIG_IS_ENABLED(DM_COMPAT_HASH)
+/**
+ * struct compat_entry - A compatible string which a driver supports
+ *
+ * @drv: Driver
+ * @id: Entry in the driver's of_match table
+ * @next: Index of the next entry in the same hash bucket, or -1
+ */
+struct compat_entry {
+	struct driver *drv;
+	const struct udevice_id *id;
+	int next;
+};
+
+static struct compat_table {
+	struct compat_entry *entries;
+	int *buckets;
+	uint mask;
+	bool failed;
+} compat_table;
+
+static uint compat_hash(const char *str)
+{
+	uint hash = 2166136261u;
+
+	while (*str)
+		hash = (hash ^ (u8)*str++) * 16777619;
+
+	return hash ^ (hash >> 16);
+}
+
+/* Index the compatible strings of all drivers, once relocated */
+static struct compat_table *lists_compat_table(void)
 {
 	struct driver *driver = ll_entry_start(struct driver, driver);
 	const int n_ents = ll_entry_count(struct driver, driver);
+	struct compat_table *table = &compat_table;
 	const struct udevice_id *id;
+	struct compat_entry *ent;
+	struct driver *entry;
+	int count = 0, buckets;
+	uint hash;
+
+	/*
+	 * Before relocation there is little memory and only a few nodes.
+	 * Check this first: the table is in BSS, which may not be usable yet.
+	 */
+	if (!(gd->flags & GD_FLG_RELOC))
+		return NULL;
+	if (table->entries)
+		return table;
+	if (table->failed)
+		return NULL;
+
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		for (id = entry->of_match; id && id->compatible; id++)
+			count++;
+	}
+	buckets = roundup_pow_of_two(max(count, 1));
+	ent = malloc(count * sizeof(*ent) + buckets * sizeof(int));
+	if (!ent) {
+		table->failed = true;
+		return NULL;
+	}
+	table->entries = ent;
+	table->buckets = (int *)(ent + count);
+	table->mask = buckets - 1;
+	memset(table->buckets, 0xff, buckets * sizeof(int));
+
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		for (id = entry->of_match; id && id->compatible; id++) {
+			hash = compat_hash(id->compatible) & table->mask;
+			ent->drv = entry;
+			ent->id = id;
+			ent->next = table->buckets[hash];
+			table->buckets[hash] = ent - table->entries;
+			ent++;
+		}
+	}
+
+	return table;
+}
+
+/*
+ * Find the first driver after @after which is compatible with the node,
+ * using the table. This gives the same result as checking each driver in
+ * turn: the first match in the linker list wins, regardless of the order
+ * of the node's compatible strings.
+ */
+static int lists_compat_find(struct compat_table *table, const void *blob,
+			     int offset, struct driver *after,
+			     struct driver **drvp,
+			     const struct udevice_id **idp)
+{
+	struct compat_entry *ent, *best = NULL;
+	const char *compat, *end;
+	int len, i;
+
+	compat = fdt_getprop(blob, offset, "compatible", &len);
+	if (!compat)
+		return len == -FDT_ERR_NOTFOUND ? -ENODEV : -EINVAL;
+
+	for (end = compat + len; compat < end; compat += len + 1) {
+		len = strnlen(compat, end - compat);
+		if (compat + len == end)
+			break;	/* not terminated, so cannot match */
+		i = table->buckets[compat_hash(compat) & table->mask];
+		for (; i != -1; i = ent->next) {
+			ent = &table->entries[i];
+			if (ent->drv <= after || strcmp(ent->id->compatible,
+							compat))
+				continue;
+			if (!best || ent->drv < best->drv ||
+			    (ent->drv == best->drv && ent->id < best->id))
+				best = ent;
+		}
+	}
+	if (!best)
+		return -ENOENT;
+	*drvp = best->drv;
+	*idp = best->id;
+
+	return 0;
+}
+#else
+static inline struct compat_table *lists_compat_table(void)
+{
+	return NULL;
+}
+
+static inline int lists_compat_find(struct compat_table *table,
+				    const void *blob, int offset,
+				    struct driver *after, struct driver **drvp,
+				    const struct udevice_id **idp)
+{
+	return -ENOSYS;
+}
+#endif
+
+/**
+ * lists_find_driver() - Find the next driver compatible with a node
+ *
+ * @blob:	Device tree pointer
+ * @offset:	Offset of node in device tree
+ * @after:	Driver to start after, or NULL to start at the first
+ * @drvp:	Returns the driver
+ * @idp:	Returns the match that was found
+ * @return 0 if found, -ENOENT if there are no more matches, -ENODEV if the
+ * node has no compatible string, other error <0 if there is a device tree
+ * error
+ */
+static int lists_find_driver(const void *blob, int offset,
+			     struct driver *after, struct driver **drvp,
+			     const struct udevice_id **idp)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	struct compat_table *table;
 	struct driver *entry;
+	int ret;
+
+	table = lists_compat_table();
+	if (table)
+		return lists_compat_find(table, blob, offset, after, drvp, idp);
+
+	for (entry = after ? after + 1 : driver; entry != driver + n_ents;
+	     entry++) {
+		ret = driver_check_compatible(blob, offset, entry->of_match,
+					      idp);
+		if (ret == -ENOENT)
+			continue;
+		if (!ret)
+			*drvp = entry;
+		return ret;
+	}
+
+	return -ENOENT;
+}
+
+int lists_bind_fdt(struct udevice *parent, const void *blob, int offset,
+		   struct udevice **devp)
+{
+	const struct udevice_id *id;
+	struct driver *entry = NULL;
 	struct udevice *dev;
 	bool found = false;
 	const char *name;
@@ -154,12 +335,11 @@ int lists_bind_fdt(struct udevice *parent, const void *blob, int offset,
 	dm_dbg("bind node %s\n", fdt_get_name(blob, offset, NULL));
 	if (devp)
 		*devp = NULL;
-	for (entry = driver; entry != driver + n_ents; entry++) {
-		ret = driver_check_compatible(blob, offset, entry->of_match,
-					      &id);
-		name = fdt_get_name(blob, offset, NULL);
+	name = fdt_get_name(blob, offset, NULL);
+	while (1) {
+		ret = lists_find_driver(blob, offset, entry, &entry, &id);
 		if (ret == -ENOENT) {
-			continue;
+			break;
 		} else if (ret == -ENODEV) {
 			dm_dbg("Device '%s' has no compatible string\n", name);
 			break;
@@ -38,6 +38,189 @@ struct uclass *uclass_find(enum uclass_id key)
 	return NULL;
 }
 
+#if CONFIG_IS_ENABLED(DM_UCLASS_HASH)
+/* Uclasses with fewer devices than this are just searched in order */
+#define UCLASS_HASH_MIN_DEVS	8
+#define UCLASS_HASH_MIN_BITS	3
+
+static uint uclass_hash_int(int val)
+{
+	return (uint)val * 0x9e3779b1;
+}
+
+static uint uclass_hash_str(const char *str)
+{
+	uint hash = 2166136261u;
+
+	while (*str)
+		hash = (hash ^ (u8)*str++) * 16777619;
+
+	return hash;
+}
+
+static struct hlist_head *uclass_hash_head(struct uclass *uc,
+					   enum uclass_hash_key key, uint hash)
+{
+	hash = (hash >> 16) ^ hash;
+
+	return &uc->hash[(key << uc->hash_bits) +
+			 (hash & ((1 << uc->hash_bits) - 1))];
+}
+
+static bool uclass_hash_match(struct udevice *dev, enum uclass_hash_key key,
+			      int val, const char *name)
+{
+	switch (key) {
+	case UCLASS_HASH_SEQ:
+		return dev->seq == val;
+	case UCLASS_HASH_REQ_SEQ:
+		return dev->req_seq == val;
+	case UCLASS_HASH_NAME:
+		return !strcmp(dev->name, name);
+	case UCLASS_HASH_OF_OFFSET:
+		return dev->of_offset == val;
+	default:
+		return false;
+	}
+}
+
+/* Index a device under the current value of one of its keys */
+static void uclass_hash_add(struct udevice *dev, enum uclass_hash_key key)
+{
+	struct uclass *uc = dev->uclass;
+	uint hash;
+
+	hlist_del_init(&dev->uclass_hash[key]);
+	if (!uc->hash)
+		return;
+
+	switch (key) {
+	case UCLASS_HASH_SEQ:
+		if (dev->seq == -1)
+			return;
+		hash = uclass_hash_int(dev->seq);
+		break;
+	case UCLASS_HASH_REQ_SEQ:
+		if (dev->req_seq == -1)
+			return;
+		hash = uclass_hash_int(dev->req_seq);
+		break;
+	case UCLASS_HASH_NAME:
+		hash = uclass_hash_str(dev->name);
+		break;
+	case UCLASS_HASH_OF_OFFSET:
+		if (dev->of_offset < 0)
+			return;
+		hash = uclass_hash_int(dev->of_offset);
+		break;
+	default:
+		return;
+	}
+	hlist_add_head(&dev->uclass_hash[key], uclass_hash_head(uc, key, hash));
+}
+
+static void uclass_hash_del(struct udevice *dev)
+{
+	int key;
+
+	for (key = 0; key < UCLASS_HASH_KEYS; key++)
+		hlist_del_init(&dev->uclass_hash[key]);
+}
+
+/* Make the tables large enough for the number of devices in the uclass */
+static void uclass_hash_resize(struct uclass *uc)
+{
+	struct hlist_head *heads;
+	struct udevice *dev;
+	int bits, key;
+
+	if (uc->dev_count < UCLASS_HASH_MIN_DEVS)
+		return;
+	if (uc->hash && uc->dev_count <= 2 << uc->hash_bits)
+		return;
+
+	bits = uc->hash ? uc->hash_bits + 2 : UCLASS_HASH_MIN_BITS;
+	heads = calloc(UCLASS_HASH_KEYS << bits, sizeof(*heads));
+	if (!heads)
+		return;	/* carry on with the current tables, if any */
+
+	free(uc->hash);
+	uc->hash = heads;
+	uc->hash_bits = bits;
+	list_for_each_entry(dev, &uc->dev_head, uclass_node) {
+		for (key = 0; key < UCLASS_HASH_KEYS; key++) {
+			INIT_HLIST_NODE(&dev->uclass_hash[key]);
+			uclass_hash_add(dev, key);
+		}
+	}
+}
+
+/*
+ * Look up a device in the index. Returns 0 if there is exactly one match,
+ * -ENODEV if there is none, -EAGAIN if there are several and -ENOSYS if
+ * the uclass has no index. Apart from the sequence number, keys can be
+ * changed behind our back, so only a match is certain.
+ */
+static int uclass_hash_find(struct uclass *uc, enum uclass_hash_key key,
+			    int val, const char *name, struct udevice **devp)
+{
+	struct hlist_node *node;
+	struct udevice *dev, *found = NULL;
+	uint hash;
+
+	if (!uc->hash)
+		return -ENOSYS;
+
+	hash = name ? uclass_hash_str(name) : uclass_hash_int(val);
+	hlist_for_each_entry(dev, node, uclass_hash_head(uc, key, hash),
+			     uclass_hash[key]) {
+		if (!uclass_hash_match(dev, key, val, name))
+			continue;
+		if (found)
+			return -EAGAIN;
+		found = dev;
+	}
+	if (!found)
+		return -ENODEV;
+	*devp = found;
+
+	return 0;
+}
+
+void uclass_index_device(struct udevice *dev)
+{
+	uclass_hash_add(dev, UCLASS_HASH_REQ_SEQ);
+	uclass_hash_add(dev, UCLASS_HASH_NAME);
+	uclass_hash_add(dev, UCLASS_HASH_OF_OFFSET);
+}
+#else
+static inline void uclass_hash_add(struct udevice *dev,
+				   enum uclass_hash_key key)
+{
+}
+
+static inline void uclass_hash_del(struct udevice *dev)
+{
+}
+
+static inline void uclass_hash_resize(struct uclass *uc)
+{
+}
+
+static inline int uclass_hash_find(struct uclass *uc,
+				   enum uclass_hash_key key, int val,
+				   const char *name, struct udevice **devp)
+{
+	return -ENOSYS;
+}
+#endif
+
+void uclass_set_device_seq(struct udevice *dev, int seq)
+{
+	dev->seq = seq;
+	uclass_hash_add(dev, UCLASS_HASH_SEQ);
+}
+
 /**
  * uclass_add() - Create new uclass in list
  * @id: Id number to create
@@ -130,6 +313,9 @@ int uclass_destroy(struct uclass *uc)
 	list_del(&uc->sibling_node);
 	if (uc_drv->priv_auto_alloc_size)
 		free(uc->priv);
+#if CONFIG_IS_ENABLED(DM_UCLASS_HASH)
+	free(uc->hash);
+#endif
 	free(uc);
 
 	return 0;
@@ -215,6 +401,19 @@ int uclass_find_device_by_name(enum uclass_id id, const char *name,
 	if (ret)
 		return ret;
 
+	if (!uclass_hash_find(uc, UCLASS_HASH_NAME, 0, name, devp))
+		return 0;
+
+	list_for_each_entry(dev, &uc->dev_head, uclass_node) {
+		if (!strcmp(dev->name, name)) {
+			/* The name was changed since the device was indexed */
+			uclass_hash_add(dev, UCLASS_HASH_NAME);
+			*devp = dev;
+			return 0;
+		}
+	}
+
+	/* Failing that, allow an abbreviated name */
 	list_for_each_entry(dev, &uc->dev_head, uclass_node) {
 		if (!strncmp(dev->name, name, strlen(name))) {
 			*devp = dev;
@@ -240,10 +439,20 @@ int uclass_find_device_by_seq(enum uclass_id id, int seq_or_req_seq,
 	if (ret)
 		return ret;
 
+	/* Only the core sets seq, so the index is complete for that */
+	ret = uclass_hash_find(uc, find_req_seq ? UCLASS_HASH_REQ_SEQ :
+			       UCLASS_HASH_SEQ, seq_or_req_seq, NULL, devp);
+	if (!ret || (ret == -ENODEV && !find_req_seq)) {
+		debug("   - %s\n", ret ? "not found" : "found");
+		return ret;
+	}
+
 	list_for_each_entry(dev, &uc->dev_head, uclass_node) {
 		debug("   - %d %d\n", dev->req_seq, dev->seq);
 		if ((find_req_seq ? dev->req_seq : dev->seq) ==
 				seq_or_req_seq) {
+			if (find_req_seq)
+				uclass_hash_add(dev, UCLASS_HASH_REQ_SEQ);
 			*devp = dev;
 			debug("   - found\n");
 			return 0;
@@ -268,8 +477,13 @@ int uclass_find_device_by_of_offset(enum uclass_id id, int node,
 	if (ret)
 		return ret;
 
+	if (!uclass_hash_find(uc, UCLASS_HASH_OF_OFFSET, node, NULL, devp))
+		return 0;
+
 	list_for_each_entry(dev, &uc->dev_head, uclass_node) {
 		if (dev->of_offset == node) {
+			/* Some drivers set of_offset after binding */
+			uclass_hash_add(dev, UCLASS_HASH_OF_OFFSET);
 			*devp = dev;
 			return 0;
 		}
@@ -433,6 +647,11 @@ int uclass_bind_device(struct udevice *dev)
 
 	uc = dev->uclass;
 	list_add_tail(&dev->uclass_node, &uc->dev_head);
+#if CONFIG_IS_ENABLED(DM_UCLASS_HASH)
+	uc->dev_count++;
+	uclass_index_device(dev);
+	uclass_hash_resize(uc);
+#endif
 
 	if (dev->parent) {
 		struct uclass_driver *uc_drv = dev->parent->uclass->uc_drv;
@@ -448,6 +667,10 @@ int uclass_bind_device(struct udevice *dev)
 err:
 	/* There is no need to undo the parent's post_bind call */
 	list_del(&dev->uclass_node);
+#if CONFIG_IS_ENABLED(DM_UCLASS_HASH)
+	uc->dev_count--;
+#endif
+	uclass_hash_del(dev);
 
 	return ret;
 }
@@ -466,6 +689,10 @@ int uclass_unbind_device(struct udevice *dev)
 	}
 
 	list_del(&dev->uclass_node);
+#if CONFIG_IS_ENABLED(DM_UCLASS_HASH)
+	uc->dev_count--;
+#endif
+	uclass_hash_del(dev);
 	return 0;
 }
 #endif
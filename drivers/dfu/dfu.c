@@ -14,6 +14,7 @@
 #include <fat.h>
 #include <dfu.h>
 #include <hash.h>
+#include <div64.h>
 #include <linux/list.h>
 #include <linux/compiler.h>
 
@@ -78,8 +79,27 @@ int dfu_init_env_entities(char *interface, char *devstr)
 static unsigned char *dfu_buf;
 static unsigned long dfu_buf_size;
 
+#ifdef CONFIG_DFU_WRITE_DEFER
+/*
+ * dfu_buf holds two buffers of dfu_buf_size bytes. When the one being
+ * filled by dfu_write() is full it is queued here and dfu_write() carries
+ * on with the other one, leaving the medium write to dfu_write_deferred().
+ */
+static struct dfu_entity *dfu_defer_write;
+static u8 *dfu_defer_buf;
+static long dfu_defer_len;
+static int dfu_defer_err;
+#define DFU_BUF_COUNT	2
+#else
+#define DFU_BUF_COUNT	1
+#endif
+
 unsigned char *dfu_free_buf(void)
 {
+#ifdef CONFIG_DFU_WRITE_DEFER
+	dfu_defer_write = NULL;
+	dfu_defer_err = 0;
+#endif
 	free(dfu_buf);
 	dfu_buf = NULL;
 	return dfu_buf;
@@ -107,10 +127,11 @@ unsigned char *dfu_get_buf(struct dfu_entity *dfu)
 	if (dfu->max_buf_size && dfu_buf_size > dfu->max_buf_size)
 		dfu_buf_size = dfu->max_buf_size;
 
-	dfu_buf = memalign(CONFIG_SYS_CACHELINE_SIZE, dfu_buf_size);
+	dfu_buf = memalign(CONFIG_SYS_CACHELINE_SIZE,
+			   dfu_buf_size * DFU_BUF_COUNT);
 	if (dfu_buf == NULL)
 		printf("%s: Could not memalign 0x%lx bytes\n",
-		       __func__, dfu_buf_size);
+		       __func__, dfu_buf_size * DFU_BUF_COUNT);
 
 	return dfu_buf;
 }
@@ -132,37 +153,129 @@ static char *dfu_get_hash_algo(void)
 	return NULL;
 }
 
+static int dfu_write_medium(struct dfu_entity *dfu, u8 *buf, long w_size)
+{
+	int ret;
+
+	ret = dfu->write_medium(dfu, dfu->offset, buf, &w_size);
+	if (ret)
+		debug("%s: Write error!\n", __func__);
+
+	/* update offset */
+	dfu->offset += w_size;
+
+	puts("#");
+
+	return ret;
+}
+
+int dfu_write_deferred(void)
+{
+#ifdef CONFIG_DFU_WRITE_DEFER
+	struct dfu_entity *dfu = dfu_defer_write;
+	int ret;
+
+	if (!dfu)
+		return 0;
+
+	dfu_defer_write = NULL;
+	ret = dfu_write_medium(dfu, dfu_defer_buf, dfu_defer_len);
+	if (ret)
+		dfu_defer_err = ret;
+
+	return ret;
+#else
+	return 0;
+#endif
+}
+
+/* Take the current error from a deferred write, if any */
+static int dfu_write_deferred_err(void)
+{
+#ifdef CONFIG_DFU_WRITE_DEFER
+	int ret = dfu_defer_err;
+
+	dfu_defer_err = 0;
+
+	return ret;
+#else
+	return 0;
+#endif
+}
+
 static int dfu_write_buffer_drain(struct dfu_entity *dfu)
 {
 	long w_size;
 	int ret;
 
+	/* a queued buffer always goes first */
+	dfu_write_deferred();
+	ret = dfu_write_deferred_err();
+	if (ret)
+		return ret;
+
 	/* flush size? */
 	w_size = dfu->i_buf - dfu->i_buf_start;
 	if (w_size == 0)
 		return 0;
 
-	if (dfu_hash_algo)
-		dfu_hash_algo->hash_update(dfu_hash_algo, &dfu->crc,
-					   dfu->i_buf_start, w_size, 0);
-
-	ret = dfu->write_medium(dfu, dfu->offset, dfu->i_buf_start, &w_size);
-	if (ret)
-		debug("%s: Write error!\n", __func__);
+	ret = dfu_write_medium(dfu, dfu->i_buf_start, w_size);
 
 	/* point back */
 	dfu->i_buf = dfu->i_buf_start;
 
-	/* update offset */
-	dfu->offset += w_size;
+	return ret;
+}
 
-	puts("#");
+/*
+ * Queue the current buffer for dfu_write_deferred() and switch to the
+ * other one. This falls back to a direct write when deferred writing is
+ * not enabled or when the caller passed in a pointer into the DFU
+ * buffers (it then reuses that memory as soon as dfu_write() returns).
+ */
+static int dfu_write_buffer_swap(struct dfu_entity *dfu, void *buf)
+{
+#ifdef CONFIG_DFU_WRITE_DEFER
+	int ret;
 
-	return ret;
+	if ((u8 *)buf >= dfu_buf &&
+	    (u8 *)buf < dfu_buf + dfu_buf_size * DFU_BUF_COUNT)
+		return dfu_write_buffer_drain(dfu);
+
+	/* the other buffer must be written out before it is reused */
+	dfu_write_deferred();
+	ret = dfu_write_deferred_err();
+	if (ret)
+		return ret;
+
+	if (dfu->i_buf == dfu->i_buf_start)
+		return 0;
+
+	dfu_defer_write = dfu;
+	dfu_defer_buf = dfu->i_buf_start;
+	dfu_defer_len = dfu->i_buf - dfu->i_buf_start;
+
+	if (dfu->i_buf_start == dfu_buf)
+		dfu->i_buf_start = dfu_buf + dfu_buf_size;
+	else
+		dfu->i_buf_start = dfu_buf;
+	dfu->i_buf_end = dfu->i_buf_start + dfu_buf_size;
+	dfu->i_buf = dfu->i_buf_start;
+
+	return 0;
+#else
+	return dfu_write_buffer_drain(dfu);
+#endif
 }
 
 void dfu_write_transaction_cleanup(struct dfu_entity *dfu)
 {
+#ifdef CONFIG_DFU_WRITE_DEFER
+	/* anything still queued for this transfer is dropped */
+	if (dfu_defer_write == dfu)
+		dfu_defer_write = NULL;
+	dfu_defer_err = 0;
+#endif
 	/* clear everything */
 	dfu->crc = 0;
 	dfu->offset = 0;
@@ -175,6 +288,7 @@ void dfu_write_transaction_cleanup(struct dfu_entity *dfu)
 
 int dfu_flush(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 {
+	ulong elapsed;
 	int ret = 0;
 
 	ret = dfu_write_buffer_drain(dfu);
@@ -184,8 +298,16 @@ int dfu_flush(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 	if (dfu->flush_medium)
 		ret = dfu->flush_medium(dfu);
 
+	elapsed = get_timer(dfu->start_time);
+	printf("\nDFU complete: %llu bytes in %lu ms", dfu->offset, elapsed);
+	if (elapsed) {
+		puts(", ");
+		print_size(lldiv(dfu->offset * 1000, elapsed), "/s");
+	}
+	puts("\n");
+
 	if (dfu_hash_algo)
-		printf("\nDFU complete %s: 0x%08x\n", dfu_hash_algo->name,
+		printf("DFU complete %s: 0x%08x\n", dfu_hash_algo->name,
 		       dfu->crc);
 
 	dfu_write_transaction_cleanup(dfu);
@@ -212,6 +334,7 @@ int dfu_write(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 			return -ENOMEM;
 		dfu->i_buf_end = dfu_get_buf(dfu) + dfu_buf_size;
 		dfu->i_buf = dfu->i_buf_start;
+		dfu->start_time = get_timer(0);
 
 		dfu->inited = 1;
 	}
@@ -241,7 +364,7 @@ int dfu_write(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 
 	/* flush buffer if overflow */
 	if ((dfu->i_buf + size) > dfu->i_buf_end) {
-		ret = dfu_write_buffer_drain(dfu);
+		ret = dfu_write_buffer_swap(dfu, buf);
 		if (ret) {
 			dfu_write_transaction_cleanup(dfu);
 			return ret;
@@ -257,11 +380,18 @@ int dfu_write(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 	}
 
 	memcpy(dfu->i_buf, buf, size);
+	/* hash the data now, while it is still in the cache */
+	if (dfu_hash_algo && size)
+		dfu_hash_algo->hash_update(dfu_hash_algo, &dfu->crc,
+					   dfu->i_buf, size, 0);
 	dfu->i_buf += size;
 
 	/* if end or if buffer full flush */
 	if (size == 0 || (dfu->i_buf + size) > dfu->i_buf_end) {
-		ret = dfu_write_buffer_drain(dfu);
+		if (size == 0)
+			ret = dfu_write_buffer_drain(dfu);
+		else
+			ret = dfu_write_buffer_swap(dfu, buf);
 		if (ret) {
 			dfu_write_transaction_cleanup(dfu);
 			return ret;
@@ -48,6 +48,8 @@ void sysreset_walk_halt(enum sysreset_t type)
 {
 	int ret;
 
+	/* Anything still buffered would be lost in the reset */
+	serial_flush();
 	ret = sysreset_walk(type);
 
 	/* Wait for the reset to take effect */
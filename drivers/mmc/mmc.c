@@ -928,6 +928,8 @@ retry_scr:
 	if (mmc->scr[0] & SD_DATA_4BIT)
 		mmc->card_caps |= MMC_MODE_4BIT;
 
+	mmc->erased_val = (mmc->scr[0] & SD_DATA_STAT_AFTER_ERASE) ? 0xff : 0;
+
 	/* Version 1.0 doesn't support switching */
 	if (mmc->version == SD_VERSION_1_0)
 		return 0;
@@ -1253,6 +1255,8 @@ static int mmc_startup(struct mmc *mmc)
 
 		mmc->capacity_rpmb = ext_csd[EXT_CSD_RPMB_MULT] << 17;
 
+		mmc->erased_val = ext_csd[EXT_CSD_ERASED_MEM_CONT] ? 0xff : 0;
+
 		for (i = 0; i < 4; i++) {
 			int idx = EXT_CSD_GP_SIZE_MULT + i * 3;
 			uint mult = (ext_csd[idx + 2] << 16) +
@@ -0,0 +1,208 @@
+/*
+ * Sandbox NAND device, kept in memory
+ *
+ * Pages are allocated when they are first written, so that large devices
+ * can be emulated cheaply. Like on real NAND, writing can only clear bits
+ * and an erased page reads as 0xff.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <errno.h>
+#include <mtd.h>
+#include <os.h>
+#include <asm/test.h>
+
+struct sandbox_mtd_priv {
+	u8 **pages;
+	unsigned long *bad;
+	ulong num_pages;
+	struct sandbox_mtd_stats stats;
+};
+
+static struct sandbox_mtd_priv *sandbox_mtd_priv(struct mtd_info *mtd)
+{
+	return dev_get_priv(mtd->dev);
+}
+
+static int sandbox_mtd_read(struct mtd_info *mtd, loff_t from, size_t len,
+			    size_t *retlen, u_char *buf)
+{
+	struct sandbox_mtd_priv *priv = sandbox_mtd_priv(mtd);
+	ulong page = from / mtd->writesize;
+	uint offset = from % mtd->writesize;
+	size_t done;
+
+	priv->stats.reads++;
+	priv->stats.read_bytes += len;
+	for (done = 0; done < len; page++, offset = 0) {
+		size_t count = min_t(size_t, len - done,
+				     mtd->writesize - offset);
+
+		if (priv->pages[page])
+			memcpy(buf + done, priv->pages[page] + offset, count);
+		else
+			memset(buf + done, 0xff, count);
+		done += count;
+	}
+	*retlen = len;
+
+	return 0;
+}
+
+static int sandbox_mtd_write(struct mtd_info *mtd, loff_t to, size_t len,
+			     size_t *retlen, const u_char *buf)
+{
+	struct sandbox_mtd_priv *priv = sandbox_mtd_priv(mtd);
+	uint min_io = mtd->writesize >> mtd->subpage_sft;
+	ulong page = to / mtd->writesize;
+	uint offset = to % mtd->writesize;
+	size_t done;
+	uint i;
+
+	if ((to | len) & (min_io - 1))
+		return -EINVAL;
+	priv->stats.writes++;
+	for (done = 0; done < len; page++, offset = 0) {
+		size_t count = min_t(size_t, len - done,
+				     mtd->writesize - offset);
+		u8 *data = priv->pages[page];
+
+		if (!data) {
+			data = os_malloc(mtd->writesize);
+			if (!data)
+				return -ENOMEM;
+			memset(data, 0xff, mtd->writesize);
+			priv->pages[page] = data;
+		}
+		for (i = 0; i < count; i++)
+			data[offset + i] &= buf[done + i];
+		done += count;
+	}
+	*retlen = len;
+
+	return 0;
+}
+
+static int sandbox_mtd_erase(struct mtd_info *mtd, struct erase_info *instr)
+{
+	struct sandbox_mtd_priv *priv = sandbox_mtd_priv(mtd);
+	uint per_block = mtd->erasesize / mtd->writesize;
+	ulong page, end;
+
+	if ((instr->addr | instr->len) & (mtd->erasesize - 1))
+		return -EINVAL;
+	page = instr->addr / mtd->writesize;
+	end = page + instr->len / mtd->writesize;
+	priv->stats.erases += instr->len / mtd->erasesize;
+	for (; page < end; page++) {
+		if (page % per_block == 0 &&
+		    test_bit(page / per_block, priv->bad)) {
+			instr->fail_addr = (loff_t)page * mtd->writesize;
+			instr->state = MTD_ERASE_FAILED;
+			mtd_erase_callback(instr);
+			return -EIO;
+		}
+		os_free(priv->pages[page]);
+		priv->pages[page] = NULL;
+	}
+	instr->state = MTD_ERASE_DONE;
+	mtd_erase_callback(instr);
+
+	return 0;
+}
+
+static int sandbox_mtd_block_isbad(struct mtd_info *mtd, loff_t ofs)
+{
+	struct sandbox_mtd_priv *priv = sandbox_mtd_priv(mtd);
+
+	return test_bit(ofs / mtd->erasesize, priv->bad);
+}
+
+static int sandbox_mtd_block_markbad(struct mtd_info *mtd, loff_t ofs)
+{
+	struct sandbox_mtd_priv *priv = sandbox_mtd_priv(mtd);
+
+	__set_bit(ofs / mtd->erasesize, priv->bad);
+
+	return 0;
+}
+
+void sandbox_mtd_get_stats(struct udevice *dev, struct sandbox_mtd_stats *stats)
+{
+	struct sandbox_mtd_priv *priv = dev_get_priv(dev);
+
+	*stats = priv->stats;
+	memset(&priv->stats, '\0', sizeof(priv->stats));
+}
+
+static int sandbox_mtd_probe(struct udevice *dev)
+{
+	struct sandbox_mtd_platdata *plat = dev_get_platdata(dev);
+	struct sandbox_mtd_priv *priv = dev_get_priv(dev);
+	struct mtd_info *mtd = dev_get_uclass_priv(dev);
+	size_t bad_size;
+
+	if (!plat->size || !plat->writesize ||
+	    plat->erasesize % plat->writesize || plat->size % plat->erasesize)
+		return -EINVAL;
+	bad_size = DIV_ROUND_UP(plat->size / plat->erasesize, BITS_PER_LONG) *
+		sizeof(long);
+	priv->num_pages = plat->size / plat->writesize;
+	priv->pages = os_malloc(priv->num_pages * sizeof(*priv->pages));
+	priv->bad = os_malloc(bad_size);
+	if (!priv->pages || !priv->bad) {
+		os_free(priv->bad);
+		os_free(priv->pages);
+		return -ENOMEM;
+	}
+	memset(priv->pages, '\0', priv->num_pages * sizeof(*priv->pages));
+	memset(priv->bad, '\0', bad_size);
+
+	mtd->dev = dev;
+	mtd->name = (char *)dev->name;
+	mtd->type = MTD_NANDFLASH;
+	mtd->flags = MTD_CAP_NANDFLASH;
+	mtd->size = plat->size;
+	mtd->erasesize = plat->erasesize;
+	mtd->writesize = plat->writesize;
+	mtd->writebufsize = plat->writesize;
+	mtd->subpage_sft = plat->subpage_sft;
+	mtd->_read = sandbox_mtd_read;
+	mtd->_write = sandbox_mtd_write;
+	mtd->_erase = sandbox_mtd_erase;
+	mtd->_block_isbad = sandbox_mtd_block_isbad;
+	mtd->_block_markbad = sandbox_mtd_block_markbad;
+	if (add_mtd_device(mtd)) {
+		os_free(priv->bad);
+		os_free(priv->pages);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static int sandbox_mtd_remove(struct udevice *dev)
+{
+	struct sandbox_mtd_priv *priv = dev_get_priv(dev);
+	ulong i;
+
+	del_mtd_device(dev_get_uclass_priv(dev));
+	for (i = 0; i < priv->num_pages; i++)
+		os_free(priv->pages[i]);
+	os_free(priv->pages);
+	os_free(priv->bad);
+
+	return 0;
+}
+
+U_BOOT_DRIVER(sandbox_mtd) = {
+	.name	= "sandbox_mtd",
+	.id	= UCLASS_MTD,
+	.probe	= sandbox_mtd_probe,
+	.remove	= sandbox_mtd_remove,
+	.priv_auto_alloc_size = sizeof(struct sandbox_mtd_priv),
+	.platdata_auto_alloc_size = sizeof(struct sandbox_mtd_platdata),
+};
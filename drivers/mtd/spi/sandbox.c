@@ -20,6 +20,7 @@
 #include <asm/getopt.h>
 #include <asm/spi.h>
 #include <asm/state.h>
+#include <asm/test.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
 #include <dm/uclass-internal.h>
@@ -56,7 +57,7 @@ static const char *sandbox_sf_state_name(enum sandbox_sf_state state)
 #define STAT_WIP	(1 << 0)
 #define STAT_WEL	(1 << 1)
 
-/* Assume all SPI flashes have 3 byte addresses since they do atm */
+/* Address length of all commands except the 4-byte read commands */
 #define SF_ADDR_LEN	3
 
 #define IDCODE_LEN 3
@@ -83,14 +84,16 @@ struct sandbox_spi_flash {
 	uint erase_size;
 	/* Current position in the flash; used when reading/writing/etc... */
 	uint off;
-	/* How many address bytes we've consumed */
-	uint addr_bytes, pad_addr_bytes;
+	/* How many address bytes we've consumed, and how many we expect */
+	uint addr_bytes, pad_addr_bytes, addr_len;
 	/* The current flash status (see STAT_XXX defines above) */
 	u16 status;
 	/* Data describing the flash we're emulating */
 	const struct spi_flash_params *data;
 	/* The file on disk to serv up data from */
 	int fd;
+	/* Transfer counters, see sandbox_sf_get_stats() */
+	struct sandbox_sf_stats stats;
 };
 
 struct sandbox_spi_flash_plat_data {
@@ -222,6 +225,7 @@ static void sandbox_sf_cs_activate(struct udevice *dev)
 	sbsf->off = 0;
 	sbsf->addr_bytes = 0;
 	sbsf->pad_addr_bytes = 0;
+	sbsf->addr_len = SF_ADDR_LEN;
 	sbsf->state = SF_CMD;
 	sbsf->cmd = SF_CMD;
 }
@@ -244,25 +248,89 @@ static void sandbox_spi_tristate(u8 *buf, uint len)
 	memset(buf, 0xff, len);
 }
 
+/**
+ * sandbox_sf_read_cmd() - Decode a read command
+ *
+ * @cmd:	Command byte
+ * @fmt:	Returns the address length, dummy length and line widths the
+ *		command uses
+ * @return 0 if OK, -EINVAL if @cmd is not a read command
+ */
+static int sandbox_sf_read_cmd(uint cmd, struct spi_bulk_read *fmt)
+{
+	fmt->addr_len = SF_ADDR_LEN;
+	fmt->dummy_len = 1;
+	fmt->addr_width = 1;
+	fmt->data_width = 1;
+	switch (cmd) {
+	case CMD_READ_ARRAY_SLOW_4B:
+		fmt->addr_len = 4;
+		/* fall through */
+	case CMD_READ_ARRAY_SLOW:
+		fmt->dummy_len = 0;
+		break;
+	case CMD_READ_ARRAY_FAST_4B:
+		fmt->addr_len = 4;
+		/* fall through */
+	case CMD_READ_ARRAY_FAST:
+		break;
+	case CMD_READ_DUAL_OUTPUT_FAST_4B:
+		fmt->addr_len = 4;
+		/* fall through */
+	case CMD_READ_DUAL_OUTPUT_FAST:
+		fmt->data_width = 2;
+		break;
+	case CMD_READ_DUAL_IO_FAST_4B:
+		fmt->addr_len = 4;
+		/* fall through */
+	case CMD_READ_DUAL_IO_FAST:
+		fmt->addr_width = 2;
+		fmt->data_width = 2;
+		break;
+	case CMD_READ_QUAD_OUTPUT_FAST_4B:
+		fmt->addr_len = 4;
+		/* fall through */
+	case CMD_READ_QUAD_OUTPUT_FAST:
+		fmt->data_width = 4;
+		break;
+	case CMD_READ_QUAD_IO_FAST_4B:
+		fmt->addr_len = 4;
+		/* fall through */
+	case CMD_READ_QUAD_IO_FAST:
+		fmt->dummy_len = 2;
+		fmt->addr_width = 4;
+		fmt->data_width = 4;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
 /* Figure out what command this stream is telling us to do */
 static int sandbox_sf_process_cmd(struct sandbox_spi_flash *sbsf, const u8 *rx,
 				  u8 *tx)
 {
 	enum sandbox_sf_state oldstate = sbsf->state;
+	struct spi_bulk_read fmt;
 
 	/* We need to output a byte for the cmd byte we just ate */
 	if (tx)
 		sandbox_spi_tristate(tx, 1);
 
 	sbsf->cmd = rx[0];
+	if (!sandbox_sf_read_cmd(sbsf->cmd, &fmt)) {
+		sbsf->addr_len = fmt.addr_len;
+		sbsf->pad_addr_bytes = fmt.dummy_len;
+		sbsf->state = SF_ADDR;
+		goto done;
+	}
 	switch (sbsf->cmd) {
 	case CMD_READ_ID:
 		sbsf->state = SF_ID;
 		sbsf->cmd = SF_ID;
 		break;
-	case CMD_READ_ARRAY_FAST:
-		sbsf->pad_addr_bytes = 1;
-	case CMD_READ_ARRAY_SLOW:
 	case CMD_PAGE_PROGRAM:
 		sbsf->state = SF_ADDR;
 		break;
@@ -306,6 +374,7 @@ static int sandbox_sf_process_cmd(struct sandbox_spi_flash *sbsf, const u8 *rx,
 	}
 	}
 
+done:
 	if (oldstate != sbsf->state)
 		debug(" cmd: transition to %s state\n",
 		      sandbox_sf_state_name(sbsf->state));
@@ -376,7 +445,7 @@ static int sandbox_sf_xfer(struct udevice *dev, unsigned int bitlen,
 			debug(" addr: bytes:%u rx:%02x ", sbsf->addr_bytes,
 			      rx[pos]);
 
-			if (sbsf->addr_bytes++ < SF_ADDR_LEN)
+			if (sbsf->addr_bytes++ < sbsf->addr_len)
 				sbsf->off = (sbsf->off << 8) | rx[pos];
 			debug("addr:%06x\n", sbsf->off);
 
@@ -386,7 +455,7 @@ static int sandbox_sf_xfer(struct udevice *dev, unsigned int bitlen,
 
 			/* See if we're done processing */
 			if (sbsf->addr_bytes <
-					SF_ADDR_LEN + sbsf->pad_addr_bytes)
+					sbsf->addr_len + sbsf->pad_addr_bytes)
 				break;
 
 			/* Next state! */
@@ -395,8 +464,18 @@ static int sandbox_sf_xfer(struct udevice *dev, unsigned int bitlen,
 				return -EIO;
 			}
 			switch (sbsf->cmd) {
-			case CMD_READ_ARRAY_FAST:
 			case CMD_READ_ARRAY_SLOW:
+			case CMD_READ_ARRAY_FAST:
+			case CMD_READ_DUAL_OUTPUT_FAST:
+			case CMD_READ_DUAL_IO_FAST:
+			case CMD_READ_QUAD_OUTPUT_FAST:
+			case CMD_READ_QUAD_IO_FAST:
+			case CMD_READ_ARRAY_SLOW_4B:
+			case CMD_READ_ARRAY_FAST_4B:
+			case CMD_READ_DUAL_OUTPUT_FAST_4B:
+			case CMD_READ_DUAL_IO_FAST_4B:
+			case CMD_READ_QUAD_OUTPUT_FAST_4B:
+			case CMD_READ_QUAD_IO_FAST_4B:
 				sbsf->state = SF_READ;
 				break;
 			case CMD_PAGE_PROGRAM:
@@ -439,7 +518,11 @@ static int sandbox_sf_xfer(struct udevice *dev, unsigned int bitlen,
 			pos += cnt;
 			break;
 		case SF_WRITE_STATUS:
-			debug(" write status: %#x (ignored)\n", rx[pos]);
+			/* The second byte, if any, is the upper 8 bits */
+			debug(" write status: %#x\n", rx[pos]);
+			sbsf->status = rx[pos] & ~(STAT_WIP | STAT_WEL);
+			if (pos + 1 < bytes)
+				sbsf->status |= rx[pos + 1] << 8;
 			pos = bytes;
 			break;
 		case SF_WRITE:
@@ -511,9 +594,69 @@ static int sandbox_sf_xfer(struct udevice *dev, unsigned int bitlen,
  done:
 	if (flags & SPI_XFER_END)
 		sandbox_sf_cs_deactivate(dev);
+	sbsf->stats.xfers++;
 	return pos == bytes ? 0 : -EIO;
 }
 
+static int sandbox_sf_read_bulk(struct udevice *dev,
+				const struct spi_bulk_read *op, void *buf)
+{
+	struct sandbox_spi_flash *sbsf = dev_get_priv(dev);
+	struct spi_bulk_read fmt;
+	uint size;
+	ssize_t ret;
+
+	debug("sandbox_sf: bulk read cmd:%#x addr:%#x len:%#zx\n", op->opcode,
+	      op->addr, op->len);
+	if (sandbox_sf_read_cmd(op->opcode, &fmt)) {
+		debug(" cmd unknown: %#x\n", op->opcode);
+		return -EIO;
+	}
+
+	/* The controller must drive the lines the way the command needs */
+	if (op->addr_len != fmt.addr_len || op->dummy_len != fmt.dummy_len ||
+	    op->addr_width != fmt.addr_width ||
+	    op->data_width != fmt.data_width) {
+		debug(" bad transfer format for cmd %#x\n", op->opcode);
+		return -EIO;
+	}
+
+	/* Without 4-byte addresses only the lower 16MiB can be reached */
+	size = sbsf->data->sector_size * sbsf->data->nr_sectors;
+	if (op->addr >= size || op->len > size - op->addr ||
+	    (fmt.addr_len == SF_ADDR_LEN && op->addr + op->len > 1 << 24)) {
+		debug(" read past end of device\n");
+		return -EIO;
+	}
+
+	if (os_lseek(sbsf->fd, op->addr, OS_SEEK_SET) < 0) {
+		puts("sandbox_sf: os_lseek() failed");
+		return -EIO;
+	}
+	ret = os_read(sbsf->fd, buf, op->len);
+	if (ret < 0) {
+		puts("sandbox_sf: os_read() failed\n");
+		return -EIO;
+	}
+
+	/* Parts of the file which were never written read as erased */
+	if (ret < op->len)
+		memset(buf + ret, 0xff, op->len - ret);
+
+	sbsf->stats.bulk_reads++;
+	sbsf->stats.bulk_bytes += op->len;
+	sbsf->stats.bulk_opcode = op->opcode;
+
+	return 0;
+}
+
+void sandbox_sf_get_stats(struct udevice *dev, struct sandbox_sf_stats *stats)
+{
+	struct sandbox_spi_flash *sbsf = dev_get_priv(dev);
+
+	*stats = sbsf->stats;
+}
+
 int sandbox_sf_ofdata_to_platdata(struct udevice *dev)
 {
 	struct sandbox_spi_flash_plat_data *pdata = dev_get_platdata(dev);
@@ -533,6 +676,7 @@ int sandbox_sf_ofdata_to_platdata(struct udevice *dev)
 
 static const struct dm_spi_emul_ops sandbox_sf_emul_ops = {
 	.xfer          = sandbox_sf_xfer,
+	.read_bulk     = sandbox_sf_read_bulk,
 };
 
 #ifdef CONFIG_SPI_FLASH
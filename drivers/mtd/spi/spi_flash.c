@@ -469,6 +469,82 @@ void __weak spi_flash_copy_mmap(void *data, void *offset, size_t len)
 	memcpy(data, offset, len);
 }
 
+#ifdef CONFIG_DM_SPI
+/*
+ * Read the whole range with one bulk transfer. Without the bank address
+ * register, flashes larger than 16MiB are addressed with the 4-byte read
+ * commands.
+ */
+static int spi_flash_read_bulk(struct spi_flash *flash, u32 offset,
+			       size_t len, void *data)
+{
+	struct spi_slave *spi = flash->spi;
+	struct spi_bulk_read op;
+	int ret;
+
+	op.opcode = flash->read_cmd;
+	op.addr_len = SPI_FLASH_3B_ADDR_LEN;
+	op.dummy_len = flash->dummy_byte;
+	op.addr_width = 1;
+	op.data_width = 1;
+	op.addr = offset;
+	op.len = len;
+
+	switch (flash->read_cmd) {
+	case CMD_READ_QUAD_IO_FAST:
+		op.addr_width = 4;
+		/* fall through */
+	case CMD_READ_QUAD_OUTPUT_FAST:
+		op.data_width = 4;
+		break;
+	case CMD_READ_DUAL_IO_FAST:
+		op.addr_width = 2;
+		/* fall through */
+	case CMD_READ_DUAL_OUTPUT_FAST:
+		op.data_width = 2;
+		break;
+	}
+
+	if (flash->flags & SNOR_F_4B_READ) {
+		op.addr_len = SPI_FLASH_4B_ADDR_LEN;
+		switch (flash->read_cmd) {
+		case CMD_READ_ARRAY_SLOW:
+			op.opcode = CMD_READ_ARRAY_SLOW_4B;
+			break;
+		case CMD_READ_ARRAY_FAST:
+			op.opcode = CMD_READ_ARRAY_FAST_4B;
+			break;
+		case CMD_READ_DUAL_OUTPUT_FAST:
+			op.opcode = CMD_READ_DUAL_OUTPUT_FAST_4B;
+			break;
+		case CMD_READ_DUAL_IO_FAST:
+			op.opcode = CMD_READ_DUAL_IO_FAST_4B;
+			break;
+		case CMD_READ_QUAD_OUTPUT_FAST:
+			op.opcode = CMD_READ_QUAD_OUTPUT_FAST_4B;
+			break;
+		case CMD_READ_QUAD_IO_FAST:
+			op.opcode = CMD_READ_QUAD_IO_FAST_4B;
+			break;
+		}
+	}
+
+	ret = spi_claim_bus(spi);
+	if (ret) {
+		debug("SF: unable to claim SPI bus\n");
+		return ret;
+	}
+
+	ret = dm_spi_read_bulk(spi->dev, &op, data);
+	if (ret)
+		debug("SF: bulk read failed\n");
+
+	spi_release_bus(spi);
+
+	return ret;
+}
+#endif
+
 int spi_flash_cmd_read_ops(struct spi_flash *flash, u32 offset,
 		size_t len, void *data)
 {
@@ -492,6 +568,11 @@ int spi_flash_cmd_read_ops(struct spi_flash *flash, u32 offset,
 		return 0;
 	}
 
+#ifdef CONFIG_DM_SPI
+	if (flash->flags & SNOR_F_BULK_READ)
+		return spi_flash_read_bulk(flash, offset, len, data);
+#endif
+
 	cmdsz = SPI_FLASH_CMD_LEN + flash->dummy_byte;
 	cmd = calloc(1, cmdsz);
 	if (!cmd) {
@@ -1229,6 +1310,25 @@ int spi_flash_scan(struct spi_flash *flash)
 		flash->flags |= SNOR_F_USE_FSR;
 #endif
 
+	/*
+	 * Read in one go if the controller can send whole read commands.
+	 * Above 16MiB this takes the 4-byte read commands, if the part has
+	 * them. Where the bank address register is used, stay with banked
+	 * reads instead.
+	 */
+#ifdef CONFIG_DM_SPI
+	if (flash->dual_flash == SF_SINGLE_FLASH &&
+	    device_get_uclass_id(spi->dev->parent) == UCLASS_SPI &&
+	    spi_get_ops(spi->dev->parent)->read_bulk) {
+		if (flash->size <= SPI_FLASH_16MB_BOUN)
+			flash->flags |= SNOR_F_BULK_READ;
+#ifndef CONFIG_SPI_FLASH_BAR
+		else if (params->flags & RD_4B)
+			flash->flags |= SNOR_F_BULK_READ | SNOR_F_4B_READ;
+#endif
+	}
+#endif
+
 	/* Configure the BAR - discover bank cmds and read current bank */
 #ifdef CONFIG_SPI_FLASH_BAR
 	ret = spi_flash_read_bar(flash, idcode[0]);
@@ -1259,7 +1359,11 @@ int spi_flash_scan(struct spi_flash *flash)
 	     (flash->size > SPI_FLASH_16MB_BOUN)) ||
 	     ((flash->dual_flash > SF_SINGLE_FLASH) &&
 	     (flash->size > SPI_FLASH_16MB_BOUN << 1))) {
-		puts("SF: Warning - Only lower 16MiB accessible,");
+		/* Reads use 4-byte addresses, only writes are limited */
+		if (flash->flags & SNOR_F_4B_READ)
+			puts("SF: Warning - Only lower 16MiB writable,");
+		else
+			puts("SF: Warning - Only lower 16MiB accessible,");
 		puts(" Full access #define CONFIG_SPI_FLASH_BAR\n");
 	}
 #endif
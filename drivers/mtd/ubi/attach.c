@@ -88,8 +88,80 @@
 static int self_check_ai(struct ubi_device *ubi, struct ubi_attach_info *ai);
 
 /* Temporary variables used during scanning */
+static void *hdrs;
 static struct ubi_ec_hdr *ech;
 static struct ubi_vid_hdr *vidh;
+static bool read_hdrs_at_once;
+
+/**
+ * alloc_hdrs - allocate the header buffer used for scanning.
+ * @ubi: UBI device description object
+ *
+ * Both headers of a PEB are read into one buffer. If the VID header lies in
+ * the same minimal I/O unit as the EC header, or if the flash can be read
+ * byte by byte, they are read with a single flash read. Returns zero in case
+ * of success and %-ENOMEM if there is no memory.
+ */
+static int alloc_hdrs(struct ubi_device *ubi)
+{
+	hdrs = kzalloc(ubi->vid_hdr_aloffset + ubi->vid_hdr_alsize,
+		       GFP_KERNEL);
+	if (!hdrs)
+		return -ENOMEM;
+
+	ech = hdrs;
+	vidh = hdrs + ubi->vid_hdr_offset;
+	read_hdrs_at_once = ubi->vid_hdr_aloffset < ubi->min_io_size ||
+			    ubi->min_io_size == 1;
+
+	return 0;
+}
+
+static void free_hdrs(void)
+{
+	kfree(hdrs);
+	hdrs = NULL;
+	ech = NULL;
+	vidh = NULL;
+}
+
+/**
+ * ubi_alloc_aeb - allocate an aeb element.
+ * @ai: attaching information
+ *
+ * Elements are handed out from an array sized for all PEBs of the device,
+ * which saves an allocation per PEB while attaching. Once the array is used
+ * up they come from the slab cache. Returns %NULL if there is no memory.
+ */
+struct ubi_ainf_peb *ubi_alloc_aeb(struct ubi_attach_info *ai)
+{
+	struct ubi_ainf_peb *aeb;
+
+	if (!list_empty(&ai->aeb_pool_free)) {
+		aeb = list_first_entry(&ai->aeb_pool_free, struct ubi_ainf_peb,
+				       u.list);
+		list_del(&aeb->u.list);
+		return aeb;
+	}
+
+	if (ai->aeb_pool_used < ai->aeb_pool_size)
+		return &ai->aeb_pool[ai->aeb_pool_used++];
+
+	return kmem_cache_alloc(ai->aeb_slab_cache, GFP_KERNEL);
+}
+
+/**
+ * ubi_free_aeb - free an aeb element.
+ * @ai: attaching information
+ * @aeb: the element to free
+ */
+void ubi_free_aeb(struct ubi_attach_info *ai, struct ubi_ainf_peb *aeb)
+{
+	if (aeb >= ai->aeb_pool && aeb < ai->aeb_pool + ai->aeb_pool_size)
+		list_add(&aeb->u.list, &ai->aeb_pool_free);
+	else
+		kmem_cache_free(ai->aeb_slab_cache, aeb);
+}
 
 /**
  * add_to_list - add physical eraseblock to a list.
@@ -127,7 +199,7 @@ static int add_to_list(struct ubi_attach_info *ai, int pnum, int vol_id,
 	} else
 		BUG();
 
-	aeb = kmem_cache_alloc(ai->aeb_slab_cache, GFP_KERNEL);
+	aeb = ubi_alloc_aeb(ai);
 	if (!aeb)
 		return -ENOMEM;
 
@@ -159,7 +231,7 @@ static int add_corrupted(struct ubi_attach_info *ai, int pnum, int ec)
 
 	dbg_bld("add to corrupted: PEB %d, EC %d", pnum, ec);
 
-	aeb = kmem_cache_alloc(ai->aeb_slab_cache, GFP_KERNEL);
+	aeb = ubi_alloc_aeb(ai);
 	if (!aeb)
 		return -ENOMEM;
 
@@ -567,7 +639,7 @@ int ubi_add_to_av(struct ubi_device *ubi, struct ubi_attach_info *ai, int pnum,
 	if (err)
 		return err;
 
-	aeb = kmem_cache_alloc(ai->aeb_slab_cache, GFP_KERNEL);
+	aeb = ubi_alloc_aeb(ai);
 	if (!aeb)
 		return -ENOMEM;
 
@@ -816,7 +888,7 @@ static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
 		    int pnum, int *vid, unsigned long long *sqnum)
 {
 	long long uninitialized_var(ec);
-	int err, bitflips = 0, vol_id = -1, ec_err = 0;
+	int err, bitflips = 0, vol_id = -1, ec_err = 0, vid_err = 0;
 
 	dbg_bld("scan PEB %d", pnum);
 
@@ -829,7 +901,10 @@ static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
 		return 0;
 	}
 
-	err = ubi_io_read_ec_hdr(ubi, pnum, ech, 0);
+	if (read_hdrs_at_once)
+		err = ubi_io_read_hdrs(ubi, pnum, hdrs, &vid_err);
+	else
+		err = ubi_io_read_ec_hdr(ubi, pnum, ech, 0);
 	if (err < 0)
 		return err;
 	switch (err) {
@@ -912,7 +987,10 @@ static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
 
 	/* OK, we've done with the EC header, let's look at the VID header */
 
-	err = ubi_io_read_vid_hdr(ubi, pnum, vidh, 0);
+	if (read_hdrs_at_once)
+		err = vid_err;
+	else
+		err = ubi_io_read_vid_hdr(ubi, pnum, vidh, 0);
 	if (err < 0)
 		return err;
 	switch (err) {
@@ -1150,7 +1228,7 @@ static void destroy_av(struct ubi_attach_info *ai, struct ubi_ainf_volume *av)
 					this->rb_right = NULL;
 			}
 
-			kmem_cache_free(ai->aeb_slab_cache, aeb);
+			ubi_free_aeb(ai, aeb);
 		}
 	}
 	kfree(av);
@@ -1168,19 +1246,19 @@ static void destroy_ai(struct ubi_attach_info *ai)
 
 	list_for_each_entry_safe(aeb, aeb_tmp, &ai->alien, u.list) {
 		list_del(&aeb->u.list);
-		kmem_cache_free(ai->aeb_slab_cache, aeb);
+		ubi_free_aeb(ai, aeb);
 	}
 	list_for_each_entry_safe(aeb, aeb_tmp, &ai->erase, u.list) {
 		list_del(&aeb->u.list);
-		kmem_cache_free(ai->aeb_slab_cache, aeb);
+		ubi_free_aeb(ai, aeb);
 	}
 	list_for_each_entry_safe(aeb, aeb_tmp, &ai->corr, u.list) {
 		list_del(&aeb->u.list);
-		kmem_cache_free(ai->aeb_slab_cache, aeb);
+		ubi_free_aeb(ai, aeb);
 	}
 	list_for_each_entry_safe(aeb, aeb_tmp, &ai->free, u.list) {
 		list_del(&aeb->u.list);
-		kmem_cache_free(ai->aeb_slab_cache, aeb);
+		ubi_free_aeb(ai, aeb);
 	}
 
 	/* Destroy the volume RB-tree */
@@ -1208,6 +1286,7 @@ static void destroy_ai(struct ubi_attach_info *ai)
 	if (ai->aeb_slab_cache)
 		kmem_cache_destroy(ai->aeb_slab_cache);
 
+	kfree(ai->aeb_pool);
 	kfree(ai);
 }
 
@@ -1229,23 +1308,17 @@ static int scan_all(struct ubi_device *ubi, struct ubi_attach_info *ai,
 	struct ubi_ainf_volume *av;
 	struct ubi_ainf_peb *aeb;
 
-	err = -ENOMEM;
-
-	ech = kzalloc(ubi->ec_hdr_alsize, GFP_KERNEL);
-	if (!ech)
+	err = alloc_hdrs(ubi);
+	if (err)
 		return err;
 
-	vidh = ubi_zalloc_vid_hdr(ubi, GFP_KERNEL);
-	if (!vidh)
-		goto out_ech;
-
 	for (pnum = start; pnum < ubi->peb_count; pnum++) {
 		cond_resched();
 
 		dbg_gen("process PEB %d", pnum);
 		err = scan_peb(ubi, ai, pnum, NULL, NULL);
 		if (err < 0)
-			goto out_vidh;
+			goto out_hdrs;
 	}
 
 	ubi_msg(ubi, "scanning is finished");
@@ -1256,7 +1329,7 @@ static int scan_all(struct ubi_device *ubi, struct ubi_attach_info *ai,
 
 	err = late_analysis(ubi, ai);
 	if (err)
-		goto out_vidh;
+		goto out_hdrs;
 
 	/*
 	 * In case of unknown erase counter we use the mean erase counter
@@ -1282,22 +1355,13 @@ static int scan_all(struct ubi_device *ubi, struct ubi_attach_info *ai,
 			aeb->ec = ai->mean_ec;
 
 	err = self_check_ai(ubi, ai);
-	if (err)
-		goto out_vidh;
-
-	ubi_free_vid_hdr(ubi, vidh);
-	kfree(ech);
 
-	return 0;
-
-out_vidh:
-	ubi_free_vid_hdr(ubi, vidh);
-out_ech:
-	kfree(ech);
+out_hdrs:
+	free_hdrs();
 	return err;
 }
 
-static struct ubi_attach_info *alloc_ai(void)
+static struct ubi_attach_info *alloc_ai(struct ubi_device *ubi)
 {
 	struct ubi_attach_info *ai;
 
@@ -1309,11 +1373,19 @@ static struct ubi_attach_info *alloc_ai(void)
 	INIT_LIST_HEAD(&ai->free);
 	INIT_LIST_HEAD(&ai->erase);
 	INIT_LIST_HEAD(&ai->alien);
+	INIT_LIST_HEAD(&ai->aeb_pool_free);
+
+	/* Every PEB needs an aeb, so get them all at once if we can */
+	ai->aeb_pool = kmalloc(ubi->peb_count * sizeof(struct ubi_ainf_peb),
+			       GFP_KERNEL);
+	if (ai->aeb_pool)
+		ai->aeb_pool_size = ubi->peb_count;
 	ai->volumes = RB_ROOT;
 	ai->aeb_slab_cache = kmem_cache_create("ubi_aeb_slab_cache",
 					       sizeof(struct ubi_ainf_peb),
 					       0, 0, NULL);
 	if (!ai->aeb_slab_cache) {
+		kfree(ai->aeb_pool);
 		kfree(ai);
 		ai = NULL;
 	}
@@ -1338,15 +1410,9 @@ static int scan_fast(struct ubi_device *ubi, struct ubi_attach_info **ai)
 	int err, pnum, fm_anchor = -1;
 	unsigned long long max_sqnum = 0;
 
-	err = -ENOMEM;
-
-	ech = kzalloc(ubi->ec_hdr_alsize, GFP_KERNEL);
-	if (!ech)
-		goto out;
-
-	vidh = ubi_zalloc_vid_hdr(ubi, GFP_KERNEL);
-	if (!vidh)
-		goto out_ech;
+	err = alloc_hdrs(ubi);
+	if (err)
+		return err;
 
 	for (pnum = 0; pnum < UBI_FM_MAX_START; pnum++) {
 		int vol_id = -1;
@@ -1355,8 +1421,10 @@ static int scan_fast(struct ubi_device *ubi, struct ubi_attach_info **ai)
 
 		dbg_gen("process PEB %d", pnum);
 		err = scan_peb(ubi, *ai, pnum, &vol_id, &sqnum);
-		if (err < 0)
-			goto out_vidh;
+		if (err < 0) {
+			free_hdrs();
+			return err;
+		}
 
 		if (vol_id == UBI_FM_SB_VOLUME_ID && sqnum > max_sqnum) {
 			max_sqnum = sqnum;
@@ -1364,25 +1432,17 @@ static int scan_fast(struct ubi_device *ubi, struct ubi_attach_info **ai)
 		}
 	}
 
-	ubi_free_vid_hdr(ubi, vidh);
-	kfree(ech);
+	free_hdrs();
 
 	if (fm_anchor < 0)
 		return UBI_NO_FASTMAP;
 
 	destroy_ai(*ai);
-	*ai = alloc_ai();
+	*ai = alloc_ai(ubi);
 	if (!*ai)
 		return -ENOMEM;
 
 	return ubi_scan_fastmap(ubi, *ai, fm_anchor);
-
-out_vidh:
-	ubi_free_vid_hdr(ubi, vidh);
-out_ech:
-	kfree(ech);
-out:
-	return err;
 }
 
 #endif
@@ -1400,7 +1460,7 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 	int err;
 	struct ubi_attach_info *ai;
 
-	ai = alloc_ai();
+	ai = alloc_ai(ubi);
 	if (!ai)
 		return -ENOMEM;
 
@@ -1418,7 +1478,7 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 		if (err > 0 || mtd_is_eccerr(err)) {
 			if (err != UBI_NO_FASTMAP) {
 				destroy_ai(ai);
-				ai = alloc_ai();
+				ai = alloc_ai(ubi);
 				if (!ai)
 					return -ENOMEM;
 
@@ -1457,7 +1517,7 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 	if (ubi->fm && ubi_dbg_chk_fastmap(ubi)) {
 		struct ubi_attach_info *scan_ai;
 
-		scan_ai = alloc_ai();
+		scan_ai = alloc_ai(ubi);
 		if (!scan_ai) {
 			err = -ENOMEM;
 			goto out_wl;
@@ -92,6 +92,10 @@ static int self_check_vid_hdr(const struct ubi_device *ubi, int pnum,
 			      const struct ubi_vid_hdr *vid_hdr);
 static int self_check_write(struct ubi_device *ubi, const void *buf, int pnum,
 			    int offset, int len);
+static int check_ec_hdr(struct ubi_device *ubi, int pnum,
+			struct ubi_ec_hdr *ec_hdr, int read_err, int verbose);
+static int check_vid_hdr(struct ubi_device *ubi, int pnum,
+			 struct ubi_vid_hdr *vid_hdr, int read_err, int verbose);
 
 /**
  * ubi_io_read - read data from a physical eraseblock.
@@ -724,8 +728,7 @@ bad:
 int ubi_io_read_ec_hdr(struct ubi_device *ubi, int pnum,
 		       struct ubi_ec_hdr *ec_hdr, int verbose)
 {
-	int err, read_err;
-	uint32_t crc, magic, hdr_crc;
+	int read_err;
 
 	dbg_io("read EC header from PEB %d", pnum);
 	ubi_assert(pnum >= 0 && pnum < ubi->peb_count);
@@ -746,6 +749,25 @@ int ubi_io_read_ec_hdr(struct ubi_device *ubi, int pnum,
 		 */
 	}
 
+	return check_ec_hdr(ubi, pnum, ec_hdr, read_err, verbose);
+}
+
+/**
+ * check_ec_hdr - check an erase counter header which has been read.
+ * @ubi: UBI device description object
+ * @pnum: physical eraseblock the header was read from
+ * @ec_hdr: the erase counter header
+ * @read_err: what 'ubi_io_read()' returned when reading the header
+ * @verbose: be verbose if the header is corrupted or was not found
+ *
+ * Returns the same codes as 'ubi_io_read_ec_hdr()'.
+ */
+static int check_ec_hdr(struct ubi_device *ubi, int pnum,
+			struct ubi_ec_hdr *ec_hdr, int read_err, int verbose)
+{
+	int err;
+	uint32_t crc, magic, hdr_crc;
+
 	magic = be32_to_cpu(ec_hdr->magic);
 	if (magic != UBI_EC_HDR_MAGIC) {
 		if (mtd_is_eccerr(read_err))
@@ -997,8 +1019,7 @@ bad:
 int ubi_io_read_vid_hdr(struct ubi_device *ubi, int pnum,
 			struct ubi_vid_hdr *vid_hdr, int verbose)
 {
-	int err, read_err;
-	uint32_t crc, magic, hdr_crc;
+	int read_err;
 	void *p;
 
 	dbg_io("read VID header from PEB %d", pnum);
@@ -1010,6 +1031,25 @@ int ubi_io_read_vid_hdr(struct ubi_device *ubi, int pnum,
 	if (read_err && read_err != UBI_IO_BITFLIPS && !mtd_is_eccerr(read_err))
 		return read_err;
 
+	return check_vid_hdr(ubi, pnum, vid_hdr, read_err, verbose);
+}
+
+/**
+ * check_vid_hdr - check a volume identifier header which has been read.
+ * @ubi: UBI device description object
+ * @pnum: physical eraseblock the header was read from
+ * @vid_hdr: the volume identifier header
+ * @read_err: what 'ubi_io_read()' returned when reading the header
+ * @verbose: be verbose if the header is corrupted or wasn't found
+ *
+ * Returns the same codes as 'ubi_io_read_vid_hdr()'.
+ */
+static int check_vid_hdr(struct ubi_device *ubi, int pnum,
+			 struct ubi_vid_hdr *vid_hdr, int read_err, int verbose)
+{
+	int err;
+	uint32_t crc, magic, hdr_crc;
+
 	magic = be32_to_cpu(vid_hdr->magic);
 	if (magic != UBI_VID_HDR_MAGIC) {
 		if (mtd_is_eccerr(read_err))
@@ -1063,6 +1103,50 @@ int ubi_io_read_vid_hdr(struct ubi_device *ubi, int pnum,
 	return read_err ? UBI_IO_BITFLIPS : 0;
 }
 
+/**
+ * ubi_io_read_hdrs - read and check both headers of a PEB at once.
+ * @ubi: UBI device description object
+ * @pnum: physical eraseblock number to read from
+ * @buf: buffer of %ubi->vid_hdr_aloffset + %ubi->vid_hdr_alsize bytes; the
+ *       EC header is stored at its start and the VID header at
+ *       %ubi->vid_hdr_offset
+ * @vid_err: the VID header status is returned here
+ *
+ * This function reads the erase counter and the volume identifier header
+ * with a single flash read, which saves a read per PEB when attaching. It
+ * returns what 'ubi_io_read_ec_hdr()' would return for the EC header and
+ * stores what 'ubi_io_read_vid_hdr()' would return for the VID header in
+ * @vid_err. If the flash reports bit-flips or an ECC error, the headers are
+ * read once more one at a time, so that the error is put down to the right
+ * header.
+ */
+int ubi_io_read_hdrs(struct ubi_device *ubi, int pnum, void *buf,
+		     int *vid_err)
+{
+	struct ubi_ec_hdr *ec_hdr = buf;
+	struct ubi_vid_hdr *vid_hdr = buf + ubi->vid_hdr_offset;
+	int err;
+
+	dbg_io("read EC and VID headers from PEB %d", pnum);
+	ubi_assert(pnum >= 0 && pnum < ubi->peb_count);
+
+	err = ubi_io_read(ubi, buf, pnum, 0,
+			  ubi->vid_hdr_aloffset + ubi->vid_hdr_alsize);
+	if (!err) {
+		*vid_err = check_vid_hdr(ubi, pnum, vid_hdr, 0, 0);
+		return check_ec_hdr(ubi, pnum, ec_hdr, 0, 0);
+	}
+	if (err != UBI_IO_BITFLIPS && !mtd_is_eccerr(err))
+		return err;
+
+	err = ubi_io_read_ec_hdr(ubi, pnum, ec_hdr, 0);
+	if (err < 0)
+		return err;
+	*vid_err = ubi_io_read_vid_hdr(ubi, pnum, vid_hdr, 0);
+
+	return err;
+}
+
 /**
  * ubi_io_write_vid_hdr - write a volume identifier header.
  * @ubi: UBI device description object
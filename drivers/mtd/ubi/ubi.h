@@ -717,6 +717,10 @@ struct ubi_ainf_volume {
  * @ec_sum: a temporary variable used when calculating @mean_ec
  * @ec_count: a temporary variable used when calculating @mean_ec
  * @aeb_slab_cache: slab cache for &struct ubi_ainf_peb objects
+ * @aeb_pool: preallocated &struct ubi_ainf_peb objects, one per PEB
+ * @aeb_pool_size: number of objects in @aeb_pool
+ * @aeb_pool_used: number of objects handed out from @aeb_pool so far
+ * @aeb_pool_free: objects from @aeb_pool which have been freed again
  *
  * This data structure contains the result of attaching an MTD device and may
  * be used by other UBI sub-systems to build final UBI data structures, further
@@ -743,6 +747,10 @@ struct ubi_attach_info {
 	uint64_t ec_sum;
 	int ec_count;
 	struct kmem_cache *aeb_slab_cache;
+	struct ubi_ainf_peb *aeb_pool;
+	int aeb_pool_size;
+	int aeb_pool_used;
+	struct list_head aeb_pool_free;
 };
 
 /**
@@ -792,6 +800,8 @@ struct ubi_ainf_peb *ubi_early_get_peb(struct ubi_device *ubi,
 				       struct ubi_attach_info *ai);
 int ubi_attach(struct ubi_device *ubi, int force_scan);
 void ubi_destroy_ai(struct ubi_attach_info *ai);
+struct ubi_ainf_peb *ubi_alloc_aeb(struct ubi_attach_info *ai);
+void ubi_free_aeb(struct ubi_attach_info *ai, struct ubi_ainf_peb *aeb);
 
 /* vtbl.c */
 int ubi_change_vtbl_record(struct ubi_device *ubi, int idx,
@@ -893,6 +903,8 @@ int ubi_io_write_ec_hdr(struct ubi_device *ubi, int pnum,
 			struct ubi_ec_hdr *ec_hdr);
 int ubi_io_read_vid_hdr(struct ubi_device *ubi, int pnum,
 			struct ubi_vid_hdr *vid_hdr, int verbose);
+int ubi_io_read_hdrs(struct ubi_device *ubi, int pnum, void *buf,
+		     int *vid_err);
 int ubi_io_write_vid_hdr(struct ubi_device *ubi, int pnum,
 			 struct ubi_vid_hdr *vid_hdr);
 
@@ -19,6 +19,7 @@
 #include <video.h>
 #include <linux/compiler.h>
 #include <asm/state.h>
+#include <asm/test.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -39,8 +40,18 @@ struct sandbox_serial_platdata {
 	int colour;	/* Text colour to use for output, -1 for none */
 };
 
+/**
+ * struct sandbox_serial_priv - Private data for this driver
+ *
+ * @start_of_line:	true if the next character starts a new line
+ * @tx_space:		Number of characters putc() accepts before it returns
+ *			-EAGAIN as if the transmit FIFO was full, -1 for no limit
+ * @tx_count:		Number of characters written
+ */
 struct sandbox_serial_priv {
 	bool start_of_line;
+	int tx_space;
+	uint tx_count;
 };
 
 /**
@@ -69,6 +80,7 @@ static int sandbox_serial_probe(struct udevice *dev)
 	if (state->term_raw != STATE_TERM_COOKED)
 		os_tty_raw(0, state->term_raw == STATE_TERM_RAW_WITH_SIGS);
 	priv->start_of_line = 0;
+	priv->tx_space = -1;
 
 	return 0;
 }
@@ -88,6 +100,12 @@ static int sandbox_serial_putc(struct udevice *dev, const char ch)
 	struct sandbox_serial_priv *priv = dev_get_priv(dev);
 	struct sandbox_serial_platdata *plat = dev->platdata;
 
+	if (!priv->tx_space)
+		return -EAGAIN;
+	if (priv->tx_space > 0)
+		priv->tx_space--;
+	priv->tx_count++;
+
 	if (priv->start_of_line && plat->colour != -1) {
 		priv->start_of_line = false;
 		output_ansi_colour(plat->colour);
@@ -100,6 +118,23 @@ static int sandbox_serial_putc(struct udevice *dev, const char ch)
 	return 0;
 }
 
+void sandbox_serial_set_tx_space(struct udevice *dev, int space)
+{
+	struct sandbox_serial_priv *priv = dev_get_priv(dev);
+
+	priv->tx_space = space;
+}
+
+uint sandbox_serial_get_tx_count(struct udevice *dev)
+{
+	struct sandbox_serial_priv *priv = dev_get_priv(dev);
+	uint count = priv->tx_count;
+
+	priv->tx_count = 0;
+
+	return count;
+}
+
 static unsigned int increment_buffer_index(unsigned int index)
 {
 	return (index + 1) % ARRAY_SIZE(serial_buf);
@@ -15,6 +15,7 @@
 #include <watchdog.h>
 #include <dm/lists.h>
 #include <dm/device-internal.h>
+#include <linux/bug.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -118,6 +119,117 @@ void serial_initialize(void)
 	serial_init();
 }
 
+#ifdef CONFIG_SERIAL_TX_BUFFER
+/*
+ * Moves characters from the output buffer to the UART until the buffer is
+ * empty or, unless @wait is true, the UART does not accept any more
+ */
+static void serial_tx_drain(struct udevice *dev, bool wait)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+	struct dm_serial_ops *ops = serial_get_ops(dev);
+	int err;
+
+	while (upriv->tx_tail != upriv->tx_head) {
+		err = ops->putc(dev, upriv->tx_buf[upriv->tx_tail %
+				CONFIG_SERIAL_TX_BUFFER_SIZE]);
+		if (err == -EAGAIN) {
+			if (!wait)
+				break;
+			continue;
+		}
+		upriv->tx_tail++;
+	}
+}
+
+static void serial_tx_add(struct udevice *dev, char ch)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+	struct dm_serial_ops *ops = serial_get_ops(dev);
+
+	/* tx_head and tx_tail wrap, so the size must divide 2^32 */
+	BUILD_BUG_ON_NOT_POWER_OF_2(CONFIG_SERIAL_TX_BUFFER_SIZE);
+	while (upriv->tx_head - upriv->tx_tail ==
+	       CONFIG_SERIAL_TX_BUFFER_SIZE) {
+		if (IS_ENABLED(CONFIG_SERIAL_TX_BUFFER_NONBLOCK)) {
+			upriv->tx_dropped++;
+			return;
+		}
+		/* Wait for room for one character */
+		if (ops->putc(dev, upriv->tx_buf[upriv->tx_tail %
+			      CONFIG_SERIAL_TX_BUFFER_SIZE]) != -EAGAIN)
+			upriv->tx_tail++;
+	}
+	upriv->tx_buf[upriv->tx_head++ % CONFIG_SERIAL_TX_BUFFER_SIZE] = ch;
+}
+
+static void _serial_putc(struct udevice *dev, char ch)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+	struct dm_serial_ops *ops = serial_get_ops(dev);
+	int err;
+
+	if (upriv->tx_buf) {
+		if (ch == '\n')
+			serial_tx_add(dev, '\r');
+		serial_tx_add(dev, ch);
+		serial_tx_drain(dev, false);
+		return;
+	}
+
+	if (ch == '\n')
+		_serial_putc(dev, '\r');
+
+	do {
+		err = ops->putc(dev, ch);
+	} while (err == -EAGAIN);
+}
+
+static void _serial_puts(struct udevice *dev, const char *str)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+
+	if (!upriv->tx_buf) {
+		while (*str)
+			_serial_putc(dev, *str++);
+		return;
+	}
+
+	/* Fill the buffer first and only then feed the UART */
+	for (; *str; str++) {
+		if (*str == '\n')
+			serial_tx_add(dev, '\r');
+		serial_tx_add(dev, *str);
+	}
+	serial_tx_drain(dev, false);
+}
+
+#ifndef CONFIG_SPL_BUILD
+void serial_flush(void)
+{
+	struct udevice *dev = gd->cur_serial_dev;
+	struct serial_dev_priv *upriv;
+	uint dropped;
+
+	if (!dev)
+		return;
+	serial_tx_drain(dev, true);
+
+	/* Say how much output was lost, once per loss */
+	upriv = dev_get_uclass_priv(dev);
+	dropped = upriv->tx_dropped;
+	if (dropped) {
+		upriv->tx_dropped = 0;
+		printf("serial: %u characters dropped\n", dropped);
+		serial_tx_drain(dev, true);
+	}
+}
+#endif
+#else
+static void serial_tx_drain(struct udevice *dev, bool wait)
+{
+}
+
 static void _serial_putc(struct udevice *dev, char ch)
 {
 	struct dm_serial_ops *ops = serial_get_ops(dev);
@@ -136,6 +248,7 @@ static void _serial_puts(struct udevice *dev, const char *str)
 	while (*str)
 		_serial_putc(dev, *str++);
 }
+#endif
 
 static int _serial_getc(struct udevice *dev)
 {
@@ -143,6 +256,7 @@ static int _serial_getc(struct udevice *dev)
 	int err;
 
 	do {
+		serial_tx_drain(dev, false);
 		err = ops->getc(dev);
 		if (err == -EAGAIN)
 			WATCHDOG_RESET();
@@ -155,6 +269,7 @@ static int _serial_tstc(struct udevice *dev)
 {
 	struct dm_serial_ops *ops = serial_get_ops(dev);
 
+	serial_tx_drain(dev, false);
 	if (ops->pending)
 		return ops->pending(dev, true);
 
@@ -292,8 +407,10 @@ U_BOOT_ENV_CALLBACK(baudrate, on_baudrate);
 static int serial_post_probe(struct udevice *dev)
 {
 	struct dm_serial_ops *ops = serial_get_ops(dev);
-#ifdef CONFIG_DM_STDIO
+#if defined(CONFIG_DM_STDIO) || defined(CONFIG_SERIAL_TX_BUFFER)
 	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+#endif
+#ifdef CONFIG_DM_STDIO
 	struct stdio_dev sdev;
 #endif
 	int ret;
@@ -321,6 +438,10 @@ static int serial_post_probe(struct udevice *dev)
 			return ret;
 	}
 
+#ifdef CONFIG_SERIAL_TX_BUFFER
+	if (gd->flags & GD_FLG_RELOC)
+		upriv->tx_buf = malloc(CONFIG_SERIAL_TX_BUFFER_SIZE);
+#endif
 #ifdef CONFIG_DM_STDIO
 	if (!(gd->flags & GD_FLG_RELOC))
 		return 0;
@@ -340,12 +461,21 @@ static int serial_post_probe(struct udevice *dev)
 
 static int serial_pre_remove(struct udevice *dev)
 {
-#ifdef CONFIG_SYS_STDIO_DEREGISTER
+#if defined(CONFIG_SYS_STDIO_DEREGISTER) || defined(CONFIG_SERIAL_TX_BUFFER)
 	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+#endif
 
+#ifdef CONFIG_SYS_STDIO_DEREGISTER
 	if (stdio_deregister_dev(upriv->sdev, 0))
 		return -EPERM;
 #endif
+#ifdef CONFIG_SERIAL_TX_BUFFER
+	if (upriv->tx_buf) {
+		serial_tx_drain(dev, true);
+		free(upriv->tx_buf);
+		upriv->tx_buf = NULL;
+	}
+#endif
 
 	return 0;
 }
@@ -49,17 +49,40 @@ __weak int sandbox_spi_get_emul(struct sandbox_state *state,
 	return -ENOENT;
 }
 
-static int sandbox_spi_xfer(struct udevice *slave, unsigned int bitlen,
-			    const void *dout, void *din, unsigned long flags)
+/* Find and probe the emulator attached to a slave */
+static int sandbox_spi_find_emul(struct udevice *slave, struct udevice **emulp)
 {
 	struct udevice *bus = slave->parent;
 	struct sandbox_state *state = state_get_current();
+	uint busnum, cs;
+	int ret;
+
+	busnum = bus->seq;
+	cs = spi_chip_select(slave);
+	if (busnum >= CONFIG_SANDBOX_SPI_MAX_BUS ||
+	    cs >= CONFIG_SANDBOX_SPI_MAX_CS) {
+		printf("%s: busnum=%u, cs=%u: out of range\n", __func__,
+		       busnum, cs);
+		return -ENOENT;
+	}
+	ret = sandbox_spi_get_emul(state, bus, slave, emulp);
+	if (ret) {
+		printf("%s: busnum=%u, cs=%u: no emulation available (err=%d)\n",
+		       __func__, busnum, cs, ret);
+		return -ENOENT;
+	}
+
+	return device_probe(*emulp);
+}
+
+static int sandbox_spi_xfer(struct udevice *slave, unsigned int bitlen,
+			    const void *dout, void *din, unsigned long flags)
+{
 	struct dm_spi_emul_ops *ops;
 	struct udevice *emul;
 	uint bytes = bitlen / 8, i;
 	int ret;
 	u8 *tx = (void *)dout, *rx = din;
-	uint busnum, cs;
 
 	if (bitlen == 0)
 		return 0;
@@ -71,21 +94,7 @@ static int sandbox_spi_xfer(struct udevice *slave, unsigned int bitlen,
 		return -EINVAL;
 	}
 
-	busnum = bus->seq;
-	cs = spi_chip_select(slave);
-	if (busnum >= CONFIG_SANDBOX_SPI_MAX_BUS ||
-	    cs >= CONFIG_SANDBOX_SPI_MAX_CS) {
-		printf("%s: busnum=%u, cs=%u: out of range\n", __func__,
-		       busnum, cs);
-		return -ENOENT;
-	}
-	ret = sandbox_spi_get_emul(state, bus, slave, &emul);
-	if (ret) {
-		printf("%s: busnum=%u, cs=%u: no emulation available (err=%d)\n",
-		       __func__, busnum, cs, ret);
-		return -ENOENT;
-	}
-	ret = device_probe(emul);
+	ret = sandbox_spi_find_emul(slave, &emul);
 	if (ret)
 		return ret;
 
@@ -124,6 +133,23 @@ static int sandbox_spi_xfer(struct udevice *slave, unsigned int bitlen,
 	return ret;
 }
 
+static int sandbox_spi_read_bulk(struct udevice *slave,
+				 const struct spi_bulk_read *op, void *buf)
+{
+	struct dm_spi_emul_ops *ops;
+	struct udevice *emul;
+	int ret;
+
+	ret = sandbox_spi_find_emul(slave, &emul);
+	if (ret)
+		return ret;
+	ops = spi_emul_get_ops(emul);
+	if (!ops->read_bulk)
+		return -ENOSYS;
+
+	return ops->read_bulk(emul, op, buf);
+}
+
 static int sandbox_spi_set_speed(struct udevice *bus, uint speed)
 {
 	return 0;
@@ -149,6 +175,7 @@ static const struct dm_spi_ops sandbox_spi_ops = {
 	.set_speed	= sandbox_spi_set_speed,
 	.set_mode	= sandbox_spi_set_mode,
 	.cs_info	= sandbox_cs_info,
+	.read_bulk	= sandbox_spi_read_bulk,
 };
 
 static const struct udevice_id sandbox_spi_ids[] = {
@@ -93,6 +93,21 @@ int dm_spi_xfer(struct udevice *dev, unsigned int bitlen,
 	return spi_get_ops(bus)->xfer(dev, bitlen, dout, din, flags);
 }
 
+int dm_spi_read_bulk(struct udevice *dev, const struct spi_bulk_read *op,
+		     void *buf)
+{
+	struct udevice *bus = dev->parent;
+	struct dm_spi_ops *ops;
+
+	if (bus->uclass->uc_drv->id != UCLASS_SPI)
+		return -EOPNOTSUPP;
+	ops = spi_get_ops(bus);
+	if (!ops->read_bulk)
+		return -ENOSYS;
+
+	return ops->read_bulk(dev, op, buf);
+}
+
 int spi_claim_bus(struct spi_slave *slave)
 {
 	return dm_spi_claim_bus(slave->dev);
@@ -150,6 +165,8 @@ static int spi_post_probe(struct udevice *bus)
 		ops->set_mode += gd->reloc_off;
 	if (ops->cs_info)
 		ops->cs_info += gd->reloc_off;
+	if (ops->read_bulk)
+		ops->read_bulk += gd->reloc_off;
 #endif
 
 	return 0;
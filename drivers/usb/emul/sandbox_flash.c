@@ -10,6 +10,8 @@
 #include <os.h>
 #include <scsi.h>
 #include <usb.h>
+#include <asm/test.h>
+#include <asm/unaligned.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -52,6 +54,7 @@ enum {
  * @status_buff:	Data buffer for outgoing status
  * @buff_used:	Number of bytes ready to transfer back to host
  * @buff:	Data buffer for outgoing data
+ * @stats:	Command counters, see sandbox_flash_get_stats()
  */
 struct sandbox_flash_priv {
 	bool error;
@@ -65,6 +68,7 @@ struct sandbox_flash_priv {
 	struct umass_bbb_csw status;
 	int buff_used;
 	u8 buff[512];
+	struct sandbox_flash_stats stats;
 };
 
 struct sandbox_flash_plat {
@@ -89,6 +93,21 @@ struct scsi_read_capacity_resp {
 	u32 block_len;
 };
 
+struct scsi_read_capacity16_resp {
+	u64 last_block_addr;
+	u32 block_len;
+	u8 spare[20];
+};
+
+struct __packed scsi_read16_req {
+	u8 cmd;
+	u8 flags;
+	u64 lba;
+	u32 transfer_len;
+	u8 group;
+	u8 control;
+};
+
 struct __packed scsi_read10_req {
 	u8 cmd;
 	u8 lun_flags;
@@ -230,6 +249,8 @@ static void handle_read(struct sandbox_flash_priv *priv, ulong lba,
 			ulong transfer_len)
 {
 	debug("%s: lba=%lx, transfer_len=%lx\n", __func__, lba, transfer_len);
+	priv->stats.reads++;
+	priv->stats.read_blocks += transfer_len;
 	if (priv->fd != -1) {
 		os_lseek(priv->fd, lba * SANDBOX_FLASH_BLOCK_LEN, OS_SEEK_SET);
 		priv->read_len = transfer_len;
@@ -246,6 +267,7 @@ static int handle_ufi_command(struct sandbox_flash_plat *plat,
 {
 	const struct SCSI_cmd_block *req = buff;
 
+	priv->stats.cmds++;
 	switch (*req->cmd) {
 	case SCSI_INQUIRY: {
 		struct scsi_inquiry_resp *resp = (void *)priv->buff;
@@ -280,6 +302,23 @@ static int handle_ufi_command(struct sandbox_flash_plat *plat,
 		setup_response(priv, resp, sizeof(*resp));
 		break;
 	}
+	case SCSI_RD_CAPAC16: {
+		struct scsi_read_capacity16_resp *resp = (void *)priv->buff;
+		u64 blocks;
+
+		/* Only the READ CAPACITY(16) service action is supported */
+		if ((req->cmd[1] & 0x1f) != 0x10)
+			return -EPROTONOSUPPORT;
+		if (priv->file_size)
+			blocks = priv->file_size / SANDBOX_FLASH_BLOCK_LEN - 1;
+		else
+			blocks = 0;
+		memset(resp, '\0', sizeof(*resp));
+		put_unaligned_be64(blocks, &resp->last_block_addr);
+		put_unaligned_be32(SANDBOX_FLASH_BLOCK_LEN, &resp->block_len);
+		setup_response(priv, resp, sizeof(*resp));
+		break;
+	}
 	case SCSI_READ10: {
 		struct scsi_read10_req *req = (void *)buff;
 
@@ -287,6 +326,13 @@ static int handle_ufi_command(struct sandbox_flash_plat *plat,
 			    be16_to_cpu(req->transfer_len));
 		break;
 	}
+	case SCSI_READ16: {
+		struct scsi_read16_req *req = (void *)buff;
+
+		handle_read(priv, get_unaligned_be64(&req->lba),
+			    get_unaligned_be32(&req->transfer_len));
+		break;
+	}
 	default:
 		debug("Command not supported: %x\n", req->cmd[0]);
 		return -EPROTONOSUPPORT;
@@ -318,7 +364,7 @@ static int sandbox_flash_bulk(struct udevice *dev, struct usb_device *udev,
 			if ((cbw->bCBWFlags & CBWFLAGS_SBZ) ||
 			    cbw->bCBWLUN != 0)
 				goto err;
-			if (cbw->bCDBLength < 1 || cbw->bCDBLength >= 0x10)
+			if (cbw->bCDBLength < 1 || cbw->bCDBLength > 0x10)
 				goto err;
 			priv->transfer_len = cbw->dCBWDataTransferLength;
 			priv->tag = cbw->dCBWTag;
@@ -368,6 +414,14 @@ err:
 	return 0;
 }
 
+void sandbox_flash_get_stats(struct udevice *dev,
+			     struct sandbox_flash_stats *stats)
+{
+	struct sandbox_flash_priv *priv = dev_get_priv(dev);
+
+	*stats = priv->stats;
+}
+
 static int sandbox_flash_ofdata_to_platdata(struct udevice *dev)
 {
 	struct sandbox_flash_plat *plat = dev_get_platdata(dev);
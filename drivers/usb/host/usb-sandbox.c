@@ -12,6 +12,14 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+/* Largest bulk transfer to report, 0 for no limit */
+static size_t sandbox_usb_max_xfer_size;
+
+void sandbox_usb_set_max_xfer_size(size_t size)
+{
+	sandbox_usb_max_xfer_size = size;
+}
+
 static void usbmon_trace(struct udevice *bus, ulong pipe,
 			 struct devrequest *setup, struct udevice *emul)
 {
@@ -110,6 +118,14 @@ static int sandbox_alloc_device(struct udevice *dev, struct usb_device *udev)
 	return 0;
 }
 
+static int sandbox_get_max_xfer_size(struct udevice *dev, size_t *size)
+{
+	*size = sandbox_usb_max_xfer_size ? sandbox_usb_max_xfer_size :
+		SIZE_MAX;
+
+	return 0;
+}
+
 static int sandbox_usb_probe(struct udevice *dev)
 {
 	return 0;
@@ -120,6 +136,7 @@ static const struct dm_usb_ops sandbox_usb_ops = {
 	.bulk		= sandbox_submit_bulk,
 	.interrupt	= sandbox_submit_int,
 	.alloc_device	= sandbox_alloc_device,
+	.get_max_xfer_size = sandbox_get_max_xfer_size,
 };
 
 static const struct udevice_id sandbox_usb_ids[] = {
@@ -140,6 +140,29 @@ int usb_reset_root_port(struct usb_device *udev)
 	return ops->reset_root_port(bus, udev);
 }
 
+int usb_get_max_xfer_size(struct usb_device *udev, size_t *size)
+{
+	struct udevice *bus = udev->controller_dev;
+	struct dm_usb_ops *ops = usb_get_ops(bus);
+
+	if (!ops->get_max_xfer_size)
+		return -ENOSYS;
+
+	return ops->get_max_xfer_size(bus, size);
+}
+
+int usb_submit_bulk_queue(struct usb_device *udev, unsigned long pipe,
+			  struct usb_bulk_req *reqs, int count)
+{
+	struct udevice *bus = udev->controller_dev;
+	struct dm_usb_ops *ops = usb_get_ops(bus);
+
+	if (!ops->bulk_queue)
+		return -ENOSYS;
+
+	return ops->bulk_queue(bus, udev, pipe, reqs, count);
+}
+
 int usb_stop(void)
 {
 	struct udevice *bus;
@@ -185,25 +208,53 @@ int usb_stop(void)
 	return err;
 }
 
-static void usb_scan_bus(struct udevice *bus, bool recurse)
+/*
+ * Scan the primary controllers, or the companions, together. The root hub of
+ * each bus is set up first, which only queues its ports. Then all the queued
+ * ports are scanned in one go, so that the port delays overlap.
+ */
+static void usb_scan_buses(struct uclass *uc, bool companion)
 {
 	struct usb_bus_priv *priv;
-	struct udevice *dev;
+	struct udevice *bus, *dev;
 	int ret;
 
-	priv = dev_get_uclass_priv(bus);
+	usb_hub_defer_scan();
+	uclass_foreach_dev(bus, uc) {
+		if (!device_active(bus))
+			continue;
 
-	assert(recurse);	/* TODO: Support non-recusive */
+		priv = dev_get_uclass_priv(bus);
+		if (priv->companion != companion)
+			continue;
 
-	printf("scanning bus %d for devices... ", bus->seq);
-	debug("\n");
-	ret = usb_scan_device(bus, 0, USB_SPEED_FULL, &dev);
-	if (ret)
-		printf("failed, error %d\n", ret);
-	else if (priv->next_addr == 0)
-		printf("No USB Device found\n");
-	else
-		printf("%d USB Device(s) found\n", priv->next_addr);
+		debug("%s: root hub of bus %d\n", __func__, bus->seq);
+		ret = usb_scan_device(bus, 0, USB_SPEED_FULL, &dev);
+		if (ret)
+			printf("scanning bus %d for devices... failed, error %d\n",
+			       bus->seq, ret);
+	}
+	usb_hub_scan_queued();
+
+	uclass_foreach_dev(bus, uc) {
+		if (!device_active(bus))
+			continue;
+
+		priv = dev_get_uclass_priv(bus);
+		if (priv->companion != companion)
+			continue;
+
+		/* Failures were reported above */
+		device_find_first_child(bus, &dev);
+		if (!dev || !device_active(dev))
+			continue;
+
+		printf("scanning bus %d for devices... ", bus->seq);
+		if (priv->next_addr == 0)
+			printf("No USB Device found\n");
+		else
+			printf("%d USB Device(s) found\n", priv->next_addr);
+	}
 }
 
 static void remove_inactive_children(struct uclass *uc, struct udevice *bus)
@@ -224,7 +275,6 @@ int usb_init(void)
 {
 	int controllers_initialized = 0;
 	struct usb_uclass_priv *uc_priv;
-	struct usb_bus_priv *priv;
 	struct udevice *bus;
 	struct uclass *uc;
 	int count = 0;
@@ -258,35 +308,23 @@ int usb_init(void)
 		usb_started = true;
 	}
 
+	bootstage_mark_name(BOOTSTAGE_ID_USB_CTRL_READY, "usb_ctrl_ready");
+
 	/*
 	 * lowlevel init done, now scan the bus for devices i.e. search HUBs
 	 * and configure them, first scan primary controllers.
 	 */
-	uclass_foreach_dev(bus, uc) {
-		if (!device_active(bus))
-			continue;
-
-		priv = dev_get_uclass_priv(bus);
-		if (!priv->companion)
-			usb_scan_bus(bus, true);
-	}
+	usb_scan_buses(uc, false);
 
 	/*
 	 * Now that the primary controllers have been scanned and have handed
 	 * over any devices they do not understand to their companions, scan
 	 * the companions if necessary.
 	 */
-	if (uc_priv->companion_device_count) {
-		uclass_foreach_dev(bus, uc) {
-			if (!device_active(bus))
-				continue;
-
-			priv = dev_get_uclass_priv(bus);
-			if (priv->companion)
-				usb_scan_bus(bus, true);
-		}
-	}
+	if (uc_priv->companion_device_count)
+		usb_scan_buses(uc, true);
 
+	bootstage_mark_name(BOOTSTAGE_ID_USB_SCAN_DONE, "usb_scan_done");
 	debug("scan end\n");
 
 	/* Remove any devices that were not found on this scan */
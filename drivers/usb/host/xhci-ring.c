@@ -467,6 +467,25 @@ union xhci_trb *xhci_wait_for_event(struct xhci_ctrl *ctrl, trb_type expected)
 	BUG();
 }
 
+/*
+ * Throws away all unprocessed TRBs on a stopped or reset endpoint by setting
+ * the xHC's dequeue pointer to our enqueue pointer.
+ */
+static void skip_queued_tds(struct usb_device *udev, int ep_index)
+{
+	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
+	struct xhci_ring *ring =  ctrl->devs[udev->slot_id]->eps[ep_index].ring;
+	union xhci_trb *event;
+
+	xhci_queue_command(ctrl, (void *)((uintptr_t)ring->enqueue |
+		ring->cycle_state), udev->slot_id, ep_index, TRB_SET_DEQ);
+	event = xhci_wait_for_event(ctrl, TRB_COMPLETION);
+	BUG_ON(TRB_TO_SLOT_ID(le32_to_cpu(event->event_cmd.flags))
+		!= udev->slot_id || GET_COMP_CODE(le32_to_cpu(
+		event->event_cmd.status)) != COMP_SUCCESS);
+	xhci_acknowledge_event(ctrl);
+}
+
 /*
  * Stops transfer processing for an endpoint and throws away all unprocessed
  * TRBs by setting the xHC's dequeue pointer to our enqueue pointer. The next
@@ -478,7 +497,6 @@ union xhci_trb *xhci_wait_for_event(struct xhci_ctrl *ctrl, trb_type expected)
 static void abort_td(struct usb_device *udev, int ep_index)
 {
 	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
-	struct xhci_ring *ring =  ctrl->devs[udev->slot_id]->eps[ep_index].ring;
 	union xhci_trb *event;
 	u32 field;
 
@@ -498,13 +516,28 @@ static void abort_td(struct usb_device *udev, int ep_index)
 		event->event_cmd.status)) != COMP_SUCCESS);
 	xhci_acknowledge_event(ctrl);
 
-	xhci_queue_command(ctrl, (void *)((uintptr_t)ring->enqueue |
-		ring->cycle_state), udev->slot_id, ep_index, TRB_SET_DEQ);
+	skip_queued_tds(udev, ep_index);
+}
+
+/*
+ * Recovers an endpoint which halted because of an error such as a stall.
+ * The xHC will not touch the endpoint's ring again until it is reset, after
+ * which the TRBs of the failed TD and of any TDs queued behind it are thrown
+ * away. The caller still has to clear the halt on the device side.
+ */
+static void reset_ep(struct usb_device *udev, int ep_index)
+{
+	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
+	union xhci_trb *event;
+
+	xhci_queue_command(ctrl, NULL, udev->slot_id, ep_index, TRB_RESET_EP);
 	event = xhci_wait_for_event(ctrl, TRB_COMPLETION);
 	BUG_ON(TRB_TO_SLOT_ID(le32_to_cpu(event->event_cmd.flags))
 		!= udev->slot_id || GET_COMP_CODE(le32_to_cpu(
 		event->event_cmd.status)) != COMP_SUCCESS);
 	xhci_acknowledge_event(ctrl);
+
+	skip_queued_tds(udev, ep_index);
 }
 
 static void record_transfer_result(struct usb_device *udev,
@@ -536,52 +569,25 @@ static void record_transfer_result(struct usb_device *udev,
 }
 
 /**** Bulk and Control transfer methods ****/
+
+/*
+ * The ring is empty whenever we start queueing, since each call waits for
+ * all of its TDs to complete, so every TRB but the link TRB can be used.
+ */
+#define XHCI_BULK_MAX_TRBS	(TRBS_PER_SEGMENT - 1)
+
 /**
- * Queues up the BULK Request
+ * Works out how many TRBs a bulk TD needs
  *
- * @param udev		pointer to the USB device structure
- * @param pipe		contains the DIR_IN or OUT , devnum
+ * @param buffer	buffer to be read/written
  * @param length	length of the buffer
- * @param buffer	buffer to be read/written based on the request
- * @return returns 0 if successful else -1 on failure
+ * @return number of TRBs
  */
-int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
-			int length, void *buffer)
+static int bulk_td_num_trbs(void *buffer, int length)
 {
+	int running_total;
 	int num_trbs = 0;
-	struct xhci_generic_trb *start_trb;
-	bool first_trb = 0;
-	int start_cycle;
-	u32 field = 0;
-	u32 length_field = 0;
-	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
-	int slot_id = udev->slot_id;
-	int ep_index;
-	struct xhci_virt_device *virt_dev;
-	struct xhci_ep_ctx *ep_ctx;
-	struct xhci_ring *ring;		/* EP transfer ring */
-	union xhci_trb *event;
-
-	int running_total, trb_buff_len;
-	unsigned int total_packet_count;
-	int maxpacketsize;
-	u64 addr;
-	int ret;
-	u32 trb_fields[4];
-	u64 val_64 = (uintptr_t)buffer;
-
-	debug("dev=%p, pipe=%lx, buffer=%p, length=%d\n",
-		udev, pipe, buffer, length);
 
-	ep_index = usb_pipe_ep_index(pipe);
-	virt_dev = ctrl->devs[slot_id];
-
-	xhci_inval_cache((uintptr_t)virt_dev->out_ctx->bytes,
-			 virt_dev->out_ctx->size);
-
-	ep_ctx = xhci_get_ep_ctx(ctrl, virt_dev->out_ctx, ep_index);
-
-	ring = virt_dev->eps[ep_index].ring;
 	/*
 	 * How much data is (potentially) left before the 64KB boundary?
 	 * XHCI Spec puts restriction( TABLE 49 and 6.4.1 section of XHCI Spec)
@@ -589,8 +595,8 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 	 * we send request in more than 1 TRB by chaining them.
 	 */
 	running_total = TRB_MAX_BUFF_SIZE -
-			(lower_32_bits(val_64) & (TRB_MAX_BUFF_SIZE - 1));
-	trb_buff_len = running_total;
+			(lower_32_bits((uintptr_t)buffer) &
+			 (TRB_MAX_BUFF_SIZE - 1));
 	running_total &= TRB_MAX_BUFF_SIZE - 1;
 
 	/*
@@ -606,54 +612,54 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 		running_total += TRB_MAX_BUFF_SIZE;
 	}
 
-	/*
-	 * XXX: Calling routine prepare_ring() called in place of
-	 * prepare_trasfer() as there in 'Linux' since we are not
-	 * maintaining multiple TDs/transfer at the same time.
-	 */
-	ret = prepare_ring(ctrl, ring,
-			   le32_to_cpu(ep_ctx->ep_info) & EP_STATE_MASK);
-	if (ret < 0)
-		return ret;
+	return num_trbs;
+}
 
-	/*
-	 * Don't give the first TRB to the hardware (by toggling the cycle bit)
-	 * until we've finished creating all the other TRBs.  The ring's cycle
-	 * state may change as we enqueue the other TRBs, so save it too.
-	 */
-	start_trb = &ring->enqueue->generic;
-	start_cycle = ring->cycle_state;
+/**
+ * Queues the chained TRBs of a bulk TD, interrupting on the last one
+ *
+ * @param udev		pointer to the USB device structure
+ * @param ring		EP transfer ring
+ * @param pipe		contains the DIR_IN or OUT , devnum
+ * @param buffer	buffer to be read/written
+ * @param length	length of the buffer
+ * @param num_trbs	number of TRBs, from bulk_td_num_trbs()
+ * @param hold_first	true to keep the first TRB from the hardware until
+ *			giveback_first_trb() is called
+ * @return none
+ */
+static void queue_bulk_td(struct usb_device *udev, struct xhci_ring *ring,
+			  unsigned long pipe, void *buffer, int length,
+			  int num_trbs, bool hold_first)
+{
+	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
+	unsigned int total_packet_count;
+	int running_total, trb_buff_len;
+	int maxpacketsize;
+	u32 trb_fields[4];
+	u32 length_field;
+	u32 field;
+	u64 addr = (uintptr_t)buffer;
 
-	running_total = 0;
 	maxpacketsize = usb_maxpacket(udev, pipe);
-
 	total_packet_count = DIV_ROUND_UP(length, maxpacketsize);
 
 	/* How much data is in the first TRB? */
-	/*
-	 * How much data is (potentially) left before the 64KB boundary?
-	 * XHCI Spec puts restriction( TABLE 49 and 6.4.1 section of XHCI Spec)
-	 * that the buffer should not span 64KB boundary. if so
-	 * we send request in more than 1 TRB by chaining them.
-	 */
-	addr = val_64;
-
+	trb_buff_len = TRB_MAX_BUFF_SIZE -
+		       (lower_32_bits(addr) & (TRB_MAX_BUFF_SIZE - 1));
 	if (trb_buff_len > length)
 		trb_buff_len = length;
 
-	first_trb = true;
-
-	/* flush the buffer before use */
-	xhci_flush_cache((uintptr_t)buffer, length);
+	running_total = 0;
 
 	/* Queue the first TRB, even if it's zero-length */
 	do {
 		u32 remainder = 0;
 		field = 0;
 		/* Don't change the cycle bit of the first TRB until later */
-		if (first_trb) {
-			first_trb = false;
-			if (start_cycle == 0)
+		if (hold_first) {
+			hold_first = false;
+			if (ring->cycle_state == 0)
 				field |= TRB_CYCLE;
 		} else {
 			field |= ring->cycle_state;
@@ -702,27 +708,167 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 		addr += trb_buff_len;
 		trb_buff_len = min((length - running_total), TRB_MAX_BUFF_SIZE);
 	} while (running_total < length);
+}
 
-	giveback_first_trb(udev, ep_index, start_cycle, start_trb);
+/**
+ * Queues up a list of BULK Requests and waits for them to complete
+ *
+ * As many requests as fit on the ring are queued together and the doorbell
+ * is rung once for all of them. Their transfer events arrive in order. If a
+ * request halts the endpoint, it is recovered and the requests after it are
+ * dropped, keeping a status of USB_ST_NOT_PROC.
+ *
+ * @param udev		pointer to the USB device structure
+ * @param pipe		contains the DIR_IN or OUT , devnum
+ * @param reqs		requests to process
+ * @param count		number of requests
+ * @return 0 if all requests were processed, else error code on failure
+ */
+int xhci_bulk_queue(struct usb_device *udev, unsigned long pipe,
+		    struct usb_bulk_req *reqs, int count)
+{
+	struct xhci_generic_trb *start_trb;
+	int start_cycle;
+	u32 field;
+	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
+	int slot_id = udev->slot_id;
+	int ep_index;
+	struct xhci_virt_device *virt_dev;
+	struct xhci_ep_ctx *ep_ctx;
+	struct xhci_ring *ring;		/* EP transfer ring */
+	union xhci_trb *event;
+	int first, last, i;
+	int num_trbs;
+	int ret;
 
-	event = xhci_wait_for_event(ctrl, TRB_TRANSFER);
-	if (!event) {
-		debug("XHCI bulk transfer timed out, aborting...\n");
-		abort_td(udev, ep_index);
-		udev->status = USB_ST_NAK_REC;  /* closest thing to a timeout */
-		udev->act_len = 0;
-		return -ETIMEDOUT;
+	debug("dev=%p, pipe=%lx, count=%d\n", udev, pipe, count);
+
+	ep_index = usb_pipe_ep_index(pipe);
+	virt_dev = ctrl->devs[slot_id];
+	ring = virt_dev->eps[ep_index].ring;
+
+	for (first = 0; first < count; first = last) {
+		/* Take as many requests as will fit on the ring */
+		num_trbs = 0;
+		for (last = first; last < count; last++) {
+			int n = bulk_td_num_trbs(reqs[last].buffer,
+						 reqs[last].length);
+
+			if (num_trbs + n > XHCI_BULK_MAX_TRBS)
+				break;
+			num_trbs += n;
+		}
+		if (last == first) {
+			debug("XHCI bulk transfer of %d bytes is too large\n",
+			      reqs[first].length);
+			return -EINVAL;
+		}
+
+		xhci_inval_cache((uintptr_t)virt_dev->out_ctx->bytes,
+				 virt_dev->out_ctx->size);
+		ep_ctx = xhci_get_ep_ctx(ctrl, virt_dev->out_ctx, ep_index);
+		ret = prepare_ring(ctrl, ring, le32_to_cpu(ep_ctx->ep_info) &
+				   EP_STATE_MASK);
+		if (ret < 0)
+			return ret;
+
+		/*
+		 * Don't give the first TRB to the hardware (by toggling the
+		 * cycle bit) until we've finished creating all the other TRBs.
+		 * The ring's cycle state may change as we enqueue the other
+		 * TRBs, so save it too.
+		 */
+		start_trb = &ring->enqueue->generic;
+		start_cycle = ring->cycle_state;
+
+		for (i = first; i < last; i++) {
+			/* flush the buffer before use */
+			xhci_flush_cache((uintptr_t)reqs[i].buffer,
+					 reqs[i].length);
+			queue_bulk_td(udev, ring, pipe, reqs[i].buffer,
+				      reqs[i].length,
+				      bulk_td_num_trbs(reqs[i].buffer,
+						       reqs[i].length),
+				      i == first);
+		}
+
+		giveback_first_trb(udev, ep_index, start_cycle, start_trb);
+
+		for (i = first; i < last; i++) {
+			event = xhci_wait_for_event(ctrl, TRB_TRANSFER);
+			if (!event) {
+				debug("XHCI bulk transfer timed out, aborting...\n");
+				abort_td(udev, ep_index);
+				/* closest thing to a timeout */
+				reqs[i].status = USB_ST_NAK_REC;
+				reqs[i].act_len = 0;
+				return -ETIMEDOUT;
+			}
+			field = le32_to_cpu(event->trans_event.flags);
+
+			BUG_ON(TRB_TO_SLOT_ID(field) != slot_id);
+			BUG_ON(TRB_TO_EP_INDEX(field) != ep_index);
+			BUG_ON(*(void **)(uintptr_t)
+			       le64_to_cpu(event->trans_event.buffer) -
+			       reqs[i].buffer > (size_t)reqs[i].length);
+
+			record_transfer_result(udev, event, reqs[i].length);
+			xhci_acknowledge_event(ctrl);
+
+			/* Only data coming from the device needs this */
+			if (usb_pipein(pipe))
+				xhci_inval_cache((uintptr_t)reqs[i].buffer,
+						 reqs[i].length);
+
+			reqs[i].act_len = udev->act_len;
+			reqs[i].status = udev->status;
+			if (!udev->status)
+				continue;
+
+			/*
+			 * Errors such as a stall halt the endpoint, so nothing
+			 * queued after this will complete
+			 */
+			xhci_inval_cache((uintptr_t)virt_dev->out_ctx->bytes,
+					 virt_dev->out_ctx->size);
+			if ((le32_to_cpu(ep_ctx->ep_info) & EP_STATE_MASK) ==
+			    EP_STATE_HALTED) {
+				reset_ep(udev, ep_index);
+				return 0;
+			}
+		}
 	}
-	field = le32_to_cpu(event->trans_event.flags);
 
-	BUG_ON(TRB_TO_SLOT_ID(field) != slot_id);
-	BUG_ON(TRB_TO_EP_INDEX(field) != ep_index);
-	BUG_ON(*(void **)(uintptr_t)le64_to_cpu(event->trans_event.buffer) -
-		buffer > (size_t)length);
+	return 0;
+}
 
-	record_transfer_result(udev, event, length);
-	xhci_acknowledge_event(ctrl);
-	xhci_inval_cache((uintptr_t)buffer, length);
+/**
+ * Queues up the BULK Request
+ *
+ * @param udev		pointer to the USB device structure
+ * @param pipe		contains the DIR_IN or OUT , devnum
+ * @param length	length of the buffer
+ * @param buffer	buffer to be read/written based on the request
+ * @return returns 0 if successful else -1 on failure
+ */
+int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
+			int length, void *buffer)
+{
+	struct usb_bulk_req req;
+	int ret;
+
+	debug("dev=%p, pipe=%lx, buffer=%p, length=%d\n",
+		udev, pipe, buffer, length);
+
+	req.buffer = buffer;
+	req.length = length;
+	req.act_len = 0;
+	req.status = USB_ST_NOT_PROC;
+	ret = xhci_bulk_queue(udev, pipe, &req, 1);
+	udev->act_len = req.act_len;
+	udev->status = req.status;
+	if (ret)
+		return ret;
 
 	return (udev->status != USB_ST_NOT_PROC) ? 0 : -1;
 }
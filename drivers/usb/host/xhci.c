@@ -1174,6 +1174,19 @@ static int xhci_submit_bulk_msg(struct udevice *dev, struct usb_device *udev,
 	return _xhci_submit_bulk_msg(udev, pipe, buffer, length);
 }
 
+static int xhci_submit_bulk_queue(struct udevice *dev, struct usb_device *udev,
+				  unsigned long pipe, struct usb_bulk_req *reqs,
+				  int count)
+{
+	debug("%s: dev='%s', udev=%p\n", __func__, dev->name, udev);
+	if (usb_pipetype(pipe) != PIPE_BULK) {
+		printf("non-bulk pipe (type=%lu)", usb_pipetype(pipe));
+		return -EINVAL;
+	}
+
+	return xhci_bulk_queue(udev, pipe, reqs, count);
+}
+
 static int xhci_submit_int_msg(struct udevice *dev, struct usb_device *udev,
 			       unsigned long pipe, void *buffer, int length,
 			       int interval)
@@ -1235,11 +1248,27 @@ int xhci_deregister(struct udevice *dev)
 	return 0;
 }
 
+static int xhci_get_max_xfer_size(struct udevice *dev, size_t *size)
+{
+	/*
+	 * xHCD allocates one segment which includes 64 TRBs for each endpoint
+	 * and the last TRB in this segment is configured as a link TRB to form
+	 * a TRB ring. Each TRB can transfer up to 64K bytes, however data
+	 * buffers referenced by transfer TRBs shall not span 64KB boundaries.
+	 * Hence the maximum number of TRBs we can use in one transfer is 62.
+	 */
+	*size = (TRBS_PER_SEGMENT - 2) * TRB_MAX_BUFF_SIZE;
+
+	return 0;
+}
+
 struct dm_usb_ops xhci_usb_ops = {
 	.control = xhci_submit_control_msg,
 	.bulk = xhci_submit_bulk_msg,
 	.interrupt = xhci_submit_int_msg,
 	.alloc_device = xhci_alloc_device,
+	.get_max_xfer_size = xhci_get_max_xfer_size,
+	.bulk_queue = xhci_submit_bulk_queue,
 };
 
 #endif
@@ -10,10 +10,35 @@
 
 #include <common.h>
 #include <dm.h>
+#include <malloc.h>
 #include <video.h>
 #include <video_console.h>
 #include <video_font.h>		/* Get font data, width and height */
 
+/**
+ * struct console_normal_priv - Private data for this driver
+ *
+ * Characters are drawn by copying a pre-rendered glyph in the pixel format
+ * of the display, rather than expanding the font bits for every pixel.
+ * Glyphs are rendered the first time they are used.
+ *
+ * @glyphs:	Pre-rendered glyphs, VIDEO_FONT_CHARS of @glyph_size bytes
+ *		each, or NULL if not allocated yet
+ * @glyph_size:	Size of a pre-rendered glyph in bytes
+ * @rendered:	Bitmap of glyphs that have been rendered
+ * @colour_fg:	Foreground colour used for rendering the glyphs
+ * @colour_bg:	Background colour used for rendering the glyphs
+ * @cache_off:	true to draw characters without the glyphs
+ */
+struct console_normal_priv {
+	void *glyphs;
+	int glyph_size;
+	u32 rendered[VIDEO_FONT_CHARS / 32];
+	int colour_fg;
+	int colour_bg;
+	bool cache_off;
+};
+
 static int console_normal_set_row(struct udevice *dev, uint row, int clr)
 {
 	struct video_priv *vid_priv = dev_get_uclass_priv(dev->parent);
@@ -71,18 +96,14 @@ static int console_normal_move_rows(struct udevice *dev, uint rowdst,
 	return 0;
 }
 
-static int console_normal_putc_xy(struct udevice *dev, uint x_frac, uint y,
-				  char ch)
+/*
+ * Draws character @ch at @line, with @pitch bytes between rows. Returns 0
+ * on success or -ENOSYS if the pixel format is not supported.
+ */
+static int console_normal_draw(struct video_priv *vid_priv, void *line,
+			       int pitch, uchar ch)
 {
-	struct vidconsole_priv *vc_priv = dev_get_uclass_priv(dev);
-	struct udevice *vid = dev->parent;
-	struct video_priv *vid_priv = dev_get_uclass_priv(vid);
 	int i, row;
-	void *line = vid_priv->fb + y * vid_priv->line_length +
-		VID_TO_PIXEL(x_frac) * VNBYTES(vid_priv->bpix);
-
-	if (x_frac + VID_TO_POS(vc_priv->x_charsize) > vc_priv->xsize_frac)
-		return -EAGAIN;
 
 	for (row = 0; row < VIDEO_FONT_HEIGHT; row++) {
 		uchar bits = video_fontdata[ch * VIDEO_FONT_HEIGHT + row];
@@ -127,12 +148,86 @@ static int console_normal_putc_xy(struct udevice *dev, uint x_frac, uint y,
 		default:
 			return -ENOSYS;
 		}
-		line += vid_priv->line_length;
+		line += pitch;
+	}
+
+	return 0;
+}
+
+/*
+ * Returns the pre-rendered glyph for @ch, rendering it if needed, or NULL
+ * if there is no memory for the glyphs
+ */
+static void *console_normal_glyph(struct udevice *dev, uchar ch)
+{
+	struct console_normal_priv *priv = dev_get_priv(dev);
+	struct video_priv *vid_priv = dev_get_uclass_priv(dev->parent);
+	const int pitch = VIDEO_FONT_WIDTH * VNBYTES(vid_priv->bpix);
+	void *glyph;
+
+	if (!priv->glyphs) {
+		priv->glyph_size = pitch * VIDEO_FONT_HEIGHT;
+		priv->glyphs = malloc(VIDEO_FONT_CHARS * priv->glyph_size);
+		if (!priv->glyphs)
+			return NULL;
+	}
+	if (vid_priv->colour_fg != priv->colour_fg ||
+	    vid_priv->colour_bg != priv->colour_bg) {
+		memset(priv->rendered, '\0', sizeof(priv->rendered));
+		priv->colour_fg = vid_priv->colour_fg;
+		priv->colour_bg = vid_priv->colour_bg;
+	}
+
+	glyph = priv->glyphs + ch * priv->glyph_size;
+	if (!(priv->rendered[ch / 32] & (1U << (ch % 32)))) {
+		if (console_normal_draw(vid_priv, glyph, pitch, ch))
+			return NULL;
+		priv->rendered[ch / 32] |= 1U << (ch % 32);
+	}
+
+	return glyph;
+}
+
+static int console_normal_putc_xy(struct udevice *dev, uint x_frac, uint y,
+				  char ch)
+{
+	struct vidconsole_priv *vc_priv = dev_get_uclass_priv(dev);
+	struct console_normal_priv *priv = dev_get_priv(dev);
+	struct udevice *vid = dev->parent;
+	struct video_priv *vid_priv = dev_get_uclass_priv(vid);
+	const int pitch = VIDEO_FONT_WIDTH * VNBYTES(vid_priv->bpix);
+	void *line = vid_priv->fb + y * vid_priv->line_length +
+		VID_TO_PIXEL(x_frac) * VNBYTES(vid_priv->bpix);
+	void *glyph;
+	int row, ret;
+
+	if (x_frac + VID_TO_POS(vc_priv->x_charsize) > vc_priv->xsize_frac)
+		return -EAGAIN;
+
+	glyph = priv->cache_off ? NULL : console_normal_glyph(dev, ch);
+	if (glyph) {
+		for (row = 0; row < VIDEO_FONT_HEIGHT; row++) {
+			memcpy(line, glyph, pitch);
+			line += vid_priv->line_length;
+			glyph += pitch;
+		}
+	} else {
+		ret = console_normal_draw(vid_priv, line,
+					  vid_priv->line_length, ch);
+		if (ret)
+			return ret;
 	}
 
 	return VID_TO_POS(VIDEO_FONT_WIDTH);
 }
 
+void console_normal_set_glyph_cache(struct udevice *dev, bool enable)
+{
+	struct console_normal_priv *priv = dev_get_priv(dev);
+
+	priv->cache_off = !enable;
+}
+
 static int console_normal_probe(struct udevice *dev)
 {
 	struct vidconsole_priv *vc_priv = dev_get_uclass_priv(dev);
@@ -147,6 +242,15 @@ static int console_normal_probe(struct udevice *dev)
 	return 0;
 }
 
+static int console_normal_remove(struct udevice *dev)
+{
+	struct console_normal_priv *priv = dev_get_priv(dev);
+
+	free(priv->glyphs);
+
+	return 0;
+}
+
 struct vidconsole_ops console_normal_ops = {
 	.putc_xy	= console_normal_putc_xy,
 	.move_rows	= console_normal_move_rows,
@@ -158,4 +262,6 @@ U_BOOT_DRIVER(vidconsole_normal) = {
 	.id	= UCLASS_VIDEO_CONSOLE,
 	.ops	= &console_normal_ops,
 	.probe	= console_normal_probe,
+	.remove	= console_normal_remove,
+	.priv_auto_alloc_size	= sizeof(struct console_normal_priv),
 };
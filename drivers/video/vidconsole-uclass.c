@@ -19,32 +19,68 @@
 #define CONFIG_CONSOLE_SCROLL_LINES 1
 #endif
 
+/*
+ * Record the console lines which have been drawn on, so that video_sync()
+ * only has to flush those. Rotated consoles do not map rows to display lines,
+ * so they mark the whole display.
+ */
+static void vidconsole_damage(struct udevice *dev, int y, int height)
+{
+	struct udevice *vid = dev->parent;
+	struct video_priv *vid_priv = dev_get_uclass_priv(vid);
+
+	if (vid_priv->rot)
+		video_damage(vid, 0, vid_priv->ysize);
+	else
+		video_damage(vid, y, height);
+}
+
 int vidconsole_putc_xy(struct udevice *dev, uint x, uint y, char ch)
 {
+	struct vidconsole_priv *priv = dev_get_uclass_priv(dev);
 	struct vidconsole_ops *ops = vidconsole_get_ops(dev);
+	int ret;
 
 	if (!ops->putc_xy)
 		return -ENOSYS;
-	return ops->putc_xy(dev, x, y, ch);
+	ret = ops->putc_xy(dev, x, y, ch);
+	if (ret >= 0)
+		vidconsole_damage(dev, y, priv->y_charsize);
+
+	return ret;
 }
 
 int vidconsole_move_rows(struct udevice *dev, uint rowdst, uint rowsrc,
 			 uint count)
 {
+	struct vidconsole_priv *priv = dev_get_uclass_priv(dev);
 	struct vidconsole_ops *ops = vidconsole_get_ops(dev);
+	int ret;
 
 	if (!ops->move_rows)
 		return -ENOSYS;
-	return ops->move_rows(dev, rowdst, rowsrc, count);
+	ret = ops->move_rows(dev, rowdst, rowsrc, count);
+	if (!ret)
+		vidconsole_damage(dev, rowdst * priv->y_charsize,
+				  count * priv->y_charsize);
+
+	return ret;
 }
 
 int vidconsole_set_row(struct udevice *dev, uint row, int clr)
 {
+	struct vidconsole_priv *priv = dev_get_uclass_priv(dev);
 	struct vidconsole_ops *ops = vidconsole_get_ops(dev);
+	int ret;
 
 	if (!ops->set_row)
 		return -ENOSYS;
-	return ops->set_row(dev, row, clr);
+	ret = ops->set_row(dev, row, clr);
+	if (!ret)
+		vidconsole_damage(dev, row * priv->y_charsize,
+				  priv->y_charsize);
+
+	return ret;
 }
 
 static int vidconsole_entry_start(struct udevice *dev)
@@ -65,6 +101,8 @@ static int vidconsole_back(struct udevice *dev)
 
 	if (ops->backspace) {
 		ret = ops->backspace(dev);
+		if (!ret)
+			vidconsole_damage(dev, priv->ycur, priv->y_charsize);
 		if (ret != -ENOSYS)
 			return ret;
 	}
@@ -93,8 +131,27 @@ static void vidconsole_newline(struct udevice *dev)
 	priv->xcur_frac = priv->xstart_frac;
 	priv->ycur += priv->y_charsize;
 
-	/* Check if we need to scroll the terminal */
-	if ((priv->ycur + priv->y_charsize) / priv->y_charsize > priv->rows) {
+	if (IS_ENABLED(CONFIG_CONSOLE_WRAP)) {
+		int row = priv->ycur / priv->y_charsize;
+
+		/*
+		 * Rather than moving the whole display up, go back to the top
+		 * and clear the line after the cursor so that the newest
+		 * output is easy to find.
+		 */
+		if (row >= priv->rows) {
+			row = 0;
+			priv->ycur = 0;
+		}
+		/*
+		 * The new cursor line was cleared as the line after the cursor
+		 * by the previous newline, so only the next one needs clearing
+		 */
+		vidconsole_set_row(dev, (row + 1) % priv->rows,
+				   vid_priv->colour_bg);
+	} else if ((priv->ycur + priv->y_charsize) / priv->y_charsize >
+		   priv->rows) {
+		/* Scroll the terminal */
 		vidconsole_move_rows(dev, 0, rows, priv->rows - rows);
 		for (i = 0; i < rows; i++)
 			vidconsole_set_row(dev, priv->rows - i - 1,
@@ -97,34 +97,63 @@ static int video_clear(struct udevice *dev)
 	} else {
 		memset(priv->fb, priv->colour_bg, priv->fb_size);
 	}
+	video_damage(dev, 0, priv->ysize);
 
 	return 0;
 }
 
+void video_damage(struct udevice *vid, int y, int height)
+{
+	struct video_priv *priv = dev_get_uclass_priv(vid);
+	int yend = min(y + height, (int)priv->ysize);
+
+	y = max(y, 0);
+	if (y >= yend)
+		return;
+	if (!priv->damage_yend || y < priv->damage_ystart)
+		priv->damage_ystart = y;
+	if (yend > priv->damage_yend)
+		priv->damage_yend = yend;
+}
+
 /* Flush video activity to the caches */
 void video_sync(struct udevice *vid)
 {
+	struct video_priv *priv = dev_get_uclass_priv(vid);
+
 	/*
 	 * flush_dcache_range() is declared in common.h but it seems that some
 	 * architectures do not actually implement it. Is there a way to find
 	 * out whether it exists? For now, ARM is safe.
 	 */
 #if defined(CONFIG_ARM) && !defined(CONFIG_SYS_DCACHE_OFF)
-	struct video_priv *priv = dev_get_uclass_priv(vid);
-
 	if (priv->flush_dcache) {
-		flush_dcache_range((ulong)priv->fb,
-				   (ulong)priv->fb + priv->fb_size);
+		int ystart = priv->damage_ystart;
+		int yend = priv->damage_yend;
+		ulong start, end;
+
+		/* Writers which have not reported any damage get a full sync */
+		if (!yend) {
+			ystart = 0;
+			yend = priv->ysize;
+		}
+		start = (ulong)priv->fb + ystart * priv->line_length;
+		end = (ulong)priv->fb + yend * priv->line_length;
+
+		/* Only flush the lines which have changed */
+		flush_dcache_range(start & ~(ARCH_DMA_MINALIGN - 1),
+				   ALIGN(end, ARCH_DMA_MINALIGN));
 	}
 #elif defined(CONFIG_VIDEO_SANDBOX_SDL)
-	struct video_priv *priv = dev_get_uclass_priv(vid);
 	static ulong last_sync;
 
-	if (get_timer(last_sync) > 10) {
-		sandbox_sdl_sync(priv->fb);
-		last_sync = get_timer(0);
-	}
+	/* Keep the damage until the next update of the window */
+	if (get_timer(last_sync) <= 10)
+		return;
+	sandbox_sdl_sync(priv->fb);
+	last_sync = get_timer(0);
 #endif
+	priv->damage_yend = 0;
 }
 
 void video_sync_all(void)
@@ -346,6 +346,7 @@ int video_bmp_display(struct udevice *dev, ulong bmp_image, int x, int y,
 		break;
 	};
 
+	video_damage(dev, y, height);
 	video_sync(dev);
 
 	return 0;
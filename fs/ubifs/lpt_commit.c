@@ -27,7 +27,6 @@
 
 #ifndef __UBOOT__
 static int dbg_populate_lsave(struct ubifs_info *c);
-#endif
 
 /**
  * first_dirty_cnode - find first dirty cnode.
@@ -324,7 +323,6 @@ no_space:
 	return err;
 }
 
-#ifndef __UBOOT__
 /**
  * realloc_lpt_leb - allocate an LPT LEB that is empty.
  * @c: UBIFS file-system description object
@@ -548,7 +546,6 @@ no_space:
 	dump_stack();
 	return err;
 }
-#endif
 
 /**
  * next_pnode_to_dirty - find next pnode to dirty.
@@ -615,6 +612,7 @@ static struct ubifs_pnode *next_pnode_to_dirty(struct ubifs_info *c,
 		iip = 0;
 	return ubifs_get_pnode(c, nnode, iip);
 }
+#endif
 
 /**
  * pnode_lookup - lookup a pnode in the LPT.
@@ -685,6 +683,7 @@ static void do_make_pnode_dirty(struct ubifs_info *c, struct ubifs_pnode *pnode)
 	}
 }
 
+#ifndef __UBOOT__
 /**
  * make_tree_dirty - mark the entire LEB properties tree dirty.
  * @c: UBIFS file-system description object
@@ -712,6 +711,7 @@ static int make_tree_dirty(struct ubifs_info *c)
 	}
 	return 0;
 }
+#endif
 
 /**
  * need_write_all - determine if the LPT area is running out of free space.
@@ -739,6 +739,7 @@ static int need_write_all(struct ubifs_info *c)
 	return 0;
 }
 
+#ifndef __UBOOT__
 /**
  * lpt_tgc_start - start trivial garbage collection of LPT LEBs.
  * @c: UBIFS file-system description object
@@ -763,6 +764,7 @@ static void lpt_tgc_start(struct ubifs_info *c)
 		}
 	}
 }
+#endif
 
 /**
  * lpt_tgc_end - end trivial garbage collection of LPT LEBs.
@@ -788,6 +790,7 @@ static int lpt_tgc_end(struct ubifs_info *c)
 	return 0;
 }
 
+#ifndef __UBOOT__
 /**
  * populate_lsave - fill the lsave array with important LEB numbers.
  * @c: the UBIFS file-system description object
@@ -812,10 +815,8 @@ static void populate_lsave(struct ubifs_info *c)
 		ubifs_add_lpt_dirt(c, c->lsave_lnum, c->lsave_sz);
 	}
 
-#ifndef __UBOOT__
 	if (dbg_populate_lsave(c))
 		return;
-#endif
 
 	list_for_each_entry(lprops, &c->empty_list, list) {
 		c->lsave[cnt++] = lprops->lnum;
@@ -854,6 +855,7 @@ static void populate_lsave(struct ubifs_info *c)
 	while (cnt < c->lsave_cnt)
 		c->lsave[cnt++] = c->main_first;
 }
+#endif
 
 /**
  * nnode_lookup - lookup a nnode in the LPT.
@@ -1212,6 +1214,7 @@ static int lpt_gc(struct ubifs_info *c)
 	return lpt_gc_lnum(c, lnum);
 }
 
+#ifndef __UBOOT__
 /**
  * ubifs_lpt_start_commit - UBIFS commit starts.
  * @c: the UBIFS file-system description object
@@ -1288,6 +1291,7 @@ out:
 	mutex_unlock(&c->lp_mutex);
 	return err;
 }
+#endif
 
 /**
  * free_obsolete_cnodes - free obsolete cnodes for commit end.
@@ -13,6 +13,7 @@
  */
 
 #include <common.h>
+#include <mapmem.h>
 #include <memalign.h>
 #include "ubifs.h"
 #include <u-boot/zlib.h>
@@ -676,28 +677,17 @@ out:
 
 /* file.c */
 
-static inline void *kmap(struct page *page)
-{
-	return page->addr;
-}
-
-static int read_block(struct inode *inode, void *addr, unsigned int block,
-		      struct ubifs_data_node *dn)
+/*
+ * Decompresses data node @dn of block @block into @addr and zeroes the rest
+ * of the block. Returns 0 on success or -EINVAL if the node is bad.
+ */
+static int read_data_node(struct ubifs_info *c, struct inode *inode,
+			  void *addr, unsigned int block,
+			  struct ubifs_data_node *dn)
 {
-	struct ubifs_info *c = inode->i_sb->s_fs_info;
 	int err, len, out_len;
-	union ubifs_key key;
 	unsigned int dlen;
 
-	data_key_init(c, &key, inode->i_ino, block);
-	err = ubifs_tnc_lookup(c, &key, dn);
-	if (err) {
-		if (err == -ENOENT)
-			/* Not found, so it must be a hole */
-			memset(addr, 0, UBIFS_BLOCK_SIZE);
-		return err;
-	}
-
 	ubifs_assert(le64_to_cpu(dn->ch.sqnum) > ubifs_inode(inode)->creat_sqnum);
 
 	len = le32_to_cpu(dn->size);
@@ -728,114 +718,169 @@ dump:
 	return -EINVAL;
 }
 
-static int do_readpage(struct ubifs_info *c, struct inode *inode,
-		       struct page *page, int last_block_size)
+static struct ubifs_cached_blk *blk_cache_find(struct ubifs_info *c,
+					       ino_t inum, unsigned int block)
 {
-	void *addr;
-	int err = 0, i;
-	unsigned int block, beyond;
-	struct ubifs_data_node *dn;
-	loff_t i_size = inode->i_size;
+	struct ubifs_cached_blk *cb;
+	int i;
 
-	dbg_gen("ino %lu, pg %lu, i_size %lld",
-		inode->i_ino, page->index, i_size);
+	if (!c->blk_cache)
+		return NULL;
+	for (i = 0, cb = c->blk_cache; i < UBIFS_BLK_CACHE_CNT; i++, cb++) {
+		if (cb->stamp && cb->inum == inum && cb->block == block) {
+			cb->stamp = ++c->blk_cache_stamp;
+			return cb;
+		}
+	}
 
-	addr = kmap(page);
+	return NULL;
+}
 
-	block = page->index << UBIFS_BLOCKS_PER_PAGE_SHIFT;
-	beyond = (i_size + UBIFS_BLOCK_SIZE - 1) >> UBIFS_BLOCK_SHIFT;
-	if (block >= beyond) {
-		/* Reading beyond inode */
-		memset(addr, 0, PAGE_CACHE_SIZE);
-		goto out;
-	}
+/* Keeps a copy of a decompressed block, replacing the least recently used */
+static void blk_cache_add(struct ubifs_info *c, ino_t inum, unsigned int block,
+			  const void *data)
+{
+	struct ubifs_cached_blk *cb, *oldest;
+	int i;
 
-	dn = kmalloc(UBIFS_MAX_DATA_NODE_SZ, GFP_NOFS);
-	if (!dn)
+	if (!c->blk_cache) {
+		c->blk_cache = kzalloc(UBIFS_BLK_CACHE_CNT * sizeof(*cb),
+				       GFP_NOFS);
+		if (!c->blk_cache)
+			return;
+	}
+	oldest = c->blk_cache;
+	for (i = 0, cb = c->blk_cache; i < UBIFS_BLK_CACHE_CNT; i++, cb++) {
+		if (cb->stamp < oldest->stamp)
+			oldest = cb;
+	}
+	oldest->inum = inum;
+	oldest->block = block;
+	oldest->stamp = ++c->blk_cache_stamp;
+	memcpy(oldest->data, data, UBIFS_BLOCK_SIZE);
+}
+
+/*
+ * Reads @size bytes of @inode into @buf, starting at block @first. The data
+ * nodes of consecutive blocks are looked up together and read with a single
+ * LEB read if they are adjacent on the flash (see 'ubifs_tnc_get_bu_keys()').
+ * The first and the last block of each read are kept in the block cache, so
+ * that re-reading the start of a file, e.g. to look at a header, is cheap.
+ *
+ * Returns 0 on success and a negative error code on failure, @actread is set
+ * to the number of bytes read.
+ */
+static int read_blocks(struct ubifs_info *c, struct inode *inode, void *buf,
+		       unsigned int first, loff_t size, loff_t *actread)
+{
+	unsigned int end = first + DIV_ROUND_UP(size, UBIFS_BLOCK_SIZE);
+	unsigned int beyond = DIV_ROUND_UP(inode->i_size, UBIFS_BLOCK_SIZE);
+	struct bu_info *bu = &c->bu;
+	struct ubifs_cached_blk *cb;
+	unsigned int block = first, holes;
+	void *bounce, *node;
+	int err = 0, i;
+
+	if (!bu->buf) {
+		bu->buf = kmalloc(c->max_bu_buf_len, GFP_NOFS);
+		if (!bu->buf)
+			return -ENOMEM;
+	}
+	bounce = malloc_cache_aligned(UBIFS_BLOCK_SIZE);
+	if (!bounce)
 		return -ENOMEM;
 
-	i = 0;
-	while (1) {
-		int ret;
+	while (block < end) {
+		void *addr = buf + (block - first) * UBIFS_BLOCK_SIZE;
+		int len = min_t(loff_t, UBIFS_BLOCK_SIZE,
+				size - (block - first) * UBIFS_BLOCK_SIZE);
 
+		cb = blk_cache_find(c, inode->i_ino, block);
+		if (cb) {
+			memcpy(addr, cb->data, len);
+			block++;
+			continue;
+		}
 		if (block >= beyond) {
 			/* Reading beyond inode */
-			err = -ENOENT;
-			memset(addr, 0, UBIFS_BLOCK_SIZE);
-		} else {
+			memset(addr, 0, len);
+			block++;
+			continue;
+		}
+
+		data_key_init(c, &bu->key, inode->i_ino, block);
+		bu->buf_len = min_t(int, c->max_bu_buf_len,
+				    (end - block) * UBIFS_MAX_DATA_NODE_SZ);
+		err = ubifs_tnc_get_bu_keys(c, bu);
+		if (!err && bu->cnt)
+			err = ubifs_tnc_bulk_read(c, bu);
+		if (err)
+			break;
+		if (!bu->cnt) {
 			/*
-			 * Reading last block? Make sure to not write beyond
-			 * the requested size in the destination buffer.
+			 * At the end of the file the rest is a hole. Otherwise
+			 * the next data node is too far away for a bulk read,
+			 * after at least @blk_cnt blocks of hole.
 			 */
-			if (((block + 1) == beyond) || last_block_size) {
-				void *buff;
-				int dlen;
-
-				/*
-				 * We need to buffer the data locally for the
-				 * last block. This is to not pad the
-				 * destination area to a multiple of
-				 * UBIFS_BLOCK_SIZE.
-				 */
-				buff = malloc_cache_aligned(UBIFS_BLOCK_SIZE);
-				if (!buff) {
-					printf("%s: Error, malloc fails!\n",
-					       __func__);
-					err = -ENOMEM;
-					break;
-				}
-
-				/* Read block-size into temp buffer */
-				ret = read_block(inode, buff, block, dn);
-				if (ret) {
-					err = ret;
-					if (err != -ENOENT) {
-						free(buff);
-						break;
-					}
-				}
-
-				if (last_block_size)
-					dlen = last_block_size;
-				else
-					dlen = le32_to_cpu(dn->size);
-
-				/* Now copy required size back to dest */
-				memcpy(addr, buff, dlen);
-
-				free(buff);
-			} else {
-				ret = read_block(inode, addr, block, dn);
-				if (ret) {
-					err = ret;
-					if (err != -ENOENT)
-						break;
-				}
-			}
+			holes = bu->eof ? end - block :
+				min_t(unsigned int, max(bu->blk_cnt, 1),
+				      end - block);
+			memset(addr, 0, min_t(loff_t,
+					      holes * UBIFS_BLOCK_SIZE,
+					      size - (block - first) *
+					      UBIFS_BLOCK_SIZE));
+			block += holes;
+			continue;
 		}
-		if (++i >= UBIFS_BLOCKS_PER_PAGE)
-			break;
-		block += 1;
-		addr += UBIFS_BLOCK_SIZE;
-	}
-	if (err) {
-		if (err == -ENOENT) {
-			/* Not found, so it must be a hole */
-			dbg_gen("hole");
-			goto out_free;
+
+		node = bu->buf;
+		for (i = 0; i < bu->cnt && block < end; i++) {
+			unsigned int next = key_block(c, &bu->zbranch[i].key);
+			void *dst;
+
+			/* Blocks without a data node are holes */
+			for (; block < next && block < end; block++) {
+				addr = buf + (block - first) * UBIFS_BLOCK_SIZE;
+				len = min_t(loff_t, UBIFS_BLOCK_SIZE,
+					    size - (block - first) *
+					    UBIFS_BLOCK_SIZE);
+				memset(addr, 0, len);
+			}
+			if (block == end)
+				break;
+
+			/*
+			 * Do not write beyond the requested size in the
+			 * destination buffer, decompress a short last block
+			 * into a temporary one.
+			 */
+			addr = buf + (block - first) * UBIFS_BLOCK_SIZE;
+			len = min_t(loff_t, UBIFS_BLOCK_SIZE,
+				    size - (block - first) * UBIFS_BLOCK_SIZE);
+			dst = len < UBIFS_BLOCK_SIZE ? bounce : addr;
+			err = read_data_node(c, inode, dst, block, node);
+			if (err)
+				goto out;
+			if (dst == bounce)
+				memcpy(addr, bounce, len);
+			if (block == first || block + 1 == end)
+				blk_cache_add(c, inode->i_ino, block, dst);
+
+			node += ALIGN(bu->zbranch[i].len, 8);
+			block++;
 		}
-		ubifs_err(c, "cannot read page %lu of inode %lu, error %d",
-			  page->index, inode->i_ino, err);
-		goto error;
 	}
 
-out_free:
-	kfree(dn);
 out:
-	return 0;
+	free(bounce);
+	if (err) {
+		ubifs_err(c, "cannot read block %u of inode %lu, error %d",
+			  block, inode->i_ino, err);
+		*actread = (block - first) * UBIFS_BLOCK_SIZE;
+	} else {
+		*actread = size;
+	}
 
-error:
-	kfree(dn);
 	return err;
 }
 
@@ -845,17 +890,13 @@ int ubifs_read(const char *filename, void *buf, loff_t offset,
 	struct ubifs_info *c = ubifs_sb->s_fs_info;
 	unsigned long inum;
 	struct inode *inode;
-	struct page page;
 	int err = 0;
-	int i;
-	int count;
-	int last_block_size = 0;
 
 	*actread = 0;
 
-	if (offset & (PAGE_SIZE - 1)) {
+	if (offset & (UBIFS_BLOCK_SIZE - 1)) {
 		printf("ubifs: Error offset must be a multple of %d\n",
-		       PAGE_SIZE);
+		       UBIFS_BLOCK_SIZE);
 		return -1;
 	}
 
@@ -892,32 +933,10 @@ int ubifs_read(const char *filename, void *buf, loff_t offset,
 	if ((size == 0) || (size > (inode->i_size - offset)))
 		size = inode->i_size - offset;
 
-	count = (size + UBIFS_BLOCK_SIZE - 1) >> UBIFS_BLOCK_SHIFT;
-
-	page.addr = buf;
-	page.index = offset / PAGE_SIZE;
-	page.inode = inode;
-	for (i = 0; i < count; i++) {
-		/*
-		 * Make sure to not read beyond the requested size
-		 */
-		if (((i + 1) == count) && (size < inode->i_size))
-			last_block_size = size - (i * PAGE_SIZE);
-
-		err = do_readpage(c, inode, &page, last_block_size);
-		if (err)
-			break;
-
-		page.addr += PAGE_SIZE;
-		page.index++;
-	}
-
-	if (err) {
+	err = read_blocks(c, inode, buf, offset >> UBIFS_BLOCK_SHIFT, size,
+			  actread);
+	if (err)
 		printf("Error reading file '%s'\n", filename);
-		*actread = i * PAGE_SIZE;
-	} else {
-		*actread = size;
-	}
 
 put_inode:
 	ubifs_iput(inode);
@@ -935,11 +954,14 @@ void ubifs_close(void)
 int ubifs_load(char *filename, u32 addr, u32 size)
 {
 	loff_t actread;
+	void *buf;
 	int err;
 
 	printf("Loading file '%s' to addr 0x%08x...\n", filename, addr);
 
-	err = ubifs_read(filename, (void *)addr, 0, size, &actread);
+	buf = map_sysmem(addr, size);
+	err = ubifs_read(filename, buf, 0, size, &actread);
+	unmap_sysmem(buf);
 	if (err == 0) {
 		setenv_hex("filesize", actread);
 		printf("Done\n");
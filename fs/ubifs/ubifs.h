@@ -1400,6 +1400,27 @@ struct bu_info {
 	int eof;
 };
 
+#ifdef __UBOOT__
+/* Number of decompressed data blocks kept in the block cache */
+#define UBIFS_BLK_CACHE_CNT 8
+
+/**
+ * struct ubifs_cached_blk - decompressed data block.
+ * @inum: inode number the block belongs to
+ * @block: block number within the inode
+ * @stamp: time of the last use, the oldest entry is replaced first
+ * @data: block contents, zero-padded to %UBIFS_BLOCK_SIZE
+ *
+ * An entry with @stamp zero is unused.
+ */
+struct ubifs_cached_blk {
+	ino_t inum;
+	unsigned int block;
+	unsigned long stamp;
+	u8 data[UBIFS_BLOCK_SIZE];
+};
+#endif
+
 /**
  * struct ubifs_node_range - node length range description data structure.
  * @len: fixed node length
@@ -1651,6 +1672,8 @@ struct ubifs_debug_info;
  * @max_bu_buf_len: maximum bulk-read buffer length
  * @bu_mutex: protects the pre-allocated bulk-read buffer and @c->bu
  * @bu: pre-allocated bulk-read information
+ * @blk_cache: decompressed blocks kept between reads (U-Boot only)
+ * @blk_cache_stamp: last stamp given to a @blk_cache entry (U-Boot only)
  *
  * @write_reserve_mutex: protects @write_reserve_buf
  * @write_reserve_buf: on the write path we allocate memory, which might
@@ -1893,6 +1916,10 @@ struct ubifs_info {
 	int max_bu_buf_len;
 	struct mutex bu_mutex;
 	struct bu_info bu;
+#ifdef __UBOOT__
+	struct ubifs_cached_blk *blk_cache;
+	unsigned long blk_cache_stamp;
+#endif
 
 	struct mutex write_reserve_mutex;
 	void *write_reserve_buf;
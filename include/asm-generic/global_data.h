@@ -104,6 +104,9 @@ typedef struct global_data {
 	unsigned long malloc_base;	/* base address of early malloc() */
 	unsigned long malloc_limit;	/* limit address */
 	unsigned long malloc_ptr;	/* current address */
+	unsigned long malloc_peak;	/* highest malloc_ptr asked for */
+	unsigned long malloc_free_list;	/* first freed block, or 0 */
+	unsigned int malloc_count;	/* number of blocks in use */
 #endif
 #ifdef CONFIG_PCI
 	struct pci_controller *hose;	/* PCI hose for early use */
@@ -89,6 +89,22 @@ struct blk_desc {
 #define PAD_TO_BLOCKSIZE(size, blk_desc) \
 	(PAD_SIZE(size, blk_desc->blksz))
 
+#if defined(CONFIG_EFI_PARTITION) && defined(HAVE_BLOCK_DEVICE) && \
+	(!defined(CONFIG_SPL_BUILD) || defined(CONFIG_SPL_LIBDISK_SUPPORT))
+/**
+ * part_efi_invalidate() - discard the parsed GPT kept for a device
+ *
+ * This is called by blkcache_invalidate(), so that a write to the device
+ * makes the next partition lookup read the table again.
+ *
+ * @param iftype - IF_TYPE_x for type of device
+ * @param dev - device index of particular type
+ */
+void part_efi_invalidate(int iftype, int dev);
+#else
+static inline void part_efi_invalidate(int iftype, int dev) {}
+#endif
+
 #ifdef CONFIG_BLOCK_CACHE
 /**
  * blkcache_read() - attempt to read a set of blocks from cache
@@ -122,6 +138,23 @@ void blkcache_fill(int iftype, int dev,
 		   lbaint_t start, lbaint_t blkcnt,
 		   unsigned long blksz, void const *buffer);
 
+/**
+ * blkcache_fill_readahead() - add a readahead window to the block cache
+ *
+ * This is the same as blkcache_fill() except that the maximum number of
+ * blocks per entry is not applied, so the caller must bound @blkcnt.
+ *
+ * @param iftype - IF_TYPE_x for type of device
+ * @param dev - device index of particular type
+ * @param start - starting block number
+ * @param blkcnt - number of blocks available
+ * @param blksz - size in bytes of each block
+ * @param buf - buffer containing data to cache
+ */
+void blkcache_fill_readahead(int iftype, int dev,
+			     lbaint_t start, lbaint_t blkcnt,
+			     unsigned long blksz, void const *buffer);
+
 /**
  * blkcache_invalidate() - discard the cache for a set of blocks
  * because of a write or device (re)initialization.
@@ -170,7 +203,15 @@ static inline void blkcache_fill(int iftype, int dev,
 				 lbaint_t start, lbaint_t blkcnt,
 				 unsigned long blksz, void const *buffer) {}
 
-static inline void blkcache_invalidate(int iftype, int dev) {}
+static inline void blkcache_fill_readahead(int iftype, int dev,
+					   lbaint_t start, lbaint_t blkcnt,
+					   unsigned long blksz,
+					   void const *buffer) {}
+
+static inline void blkcache_invalidate(int iftype, int dev)
+{
+	part_efi_invalidate(iftype, dev);
+}
 
 #endif
 
@@ -179,6 +179,8 @@ enum bootstage_id {
 	BOOTSTAGE_ID_START_UBOOT_F,
 	BOOTSTAGE_ID_START_UBOOT_R,
 	BOOTSTAGE_ID_USB_START,
+	BOOTSTAGE_ID_USB_CTRL_READY,
+	BOOTSTAGE_ID_USB_SCAN_DONE,
 	BOOTSTAGE_ID_ETH_START,
 	BOOTSTAGE_ID_BOOTP_START,
 	BOOTSTAGE_ID_BOOTP_STOP,
@@ -198,6 +200,9 @@ enum bootstage_id {
 	BOOTSTAGE_ID_ACCUM_SCSI,
 	BOOTSTAGE_ID_ACCUM_SPI,
 	BOOTSTAGE_ID_ACCUM_DECOMP,
+	BOOTSTAGE_ID_ACCUM_USB_ENUM,
+	BOOTSTAGE_ID_ACCUM_DM_R,
+	BOOTSTAGE_ID_ACCUM_ENV,
 	BOOTSTAGE_ID_FPGA_INIT,
 
 	/* a few spare for the user, from here */
@@ -611,6 +611,11 @@ void	serial_putc_raw(const char);
 void	serial_puts   (const char *);
 int	serial_getc   (void);
 int	serial_tstc   (void);
+#if defined(CONFIG_SERIAL_TX_BUFFER) && !defined(CONFIG_SPL_BUILD)
+void	serial_flush  (void);
+#else
+static inline void serial_flush(void) {}
+#endif
 
 /* These versions take a stdio_dev pointer */
 struct stdio_dev;
@@ -75,6 +75,11 @@
 #define CONFIG_CMD_BMP
 #endif
 
+/* The EFI loader keeps its memory map in an rbtree */
+#if defined(CONFIG_EFI_LOADER_MEMORY) && !defined(CONFIG_RBTREE)
+#define CONFIG_RBTREE
+#endif
+
 #ifndef CONFIG_SYS_PBSIZE
 #define CONFIG_SYS_PBSIZE	(CONFIG_SYS_CBSIZE + 128)
 #endif
@@ -134,6 +134,7 @@ struct dfu_entity {
 	u8 *i_buf_end;
 	long r_left;
 	long b_left;
+	ulong start_time;
 
 	u32 bad_skip;	/* for nand use */
 
@@ -163,6 +164,19 @@ int dfu_read(struct dfu_entity *de, void *buf, int size, int blk_seq_num);
 int dfu_write(struct dfu_entity *de, void *buf, int size, int blk_seq_num);
 int dfu_flush(struct dfu_entity *de, void *buf, int size, int blk_seq_num);
 
+/**
+ * dfu_write_deferred - write out a buffer queued by dfu_write()
+ *
+ * With CONFIG_DFU_WRITE_DEFER, dfu_write() queues a full buffer and
+ * carries on receiving into a second one. The download loop calls this
+ * function between USB transactions to store the queued buffer on the
+ * medium; it is also done from dfu_write() and dfu_flush() when needed.
+ *
+ * @return - 0 on success (or nothing queued), error code from the medium
+ *	     write otherwise
+ */
+int dfu_write_deferred(void);
+
 /*
  * dfu_defer_flush - pointer to store dfu_entity for deferred flashing.
  *		     It should be NULL when not used.
@@ -124,6 +124,71 @@ void device_free(struct udevice *dev);
 static inline void device_free(struct udevice *dev) {}
 #endif
 
+/**
+ * device_bind_deps() - Find the devices which a device depends on
+ *
+ * This looks through the device's device tree node for properties such as
+ * 'clocks' and 'resets' and records the nodes they refer to. The devices
+ * for these nodes may not be bound yet, so they are looked up when the
+ * device is probed.
+ *
+ * @dev: Device to check, which must have its of_offset set
+ * @return 0 if OK, -ENOMEM if there is not enough memory
+ */
+#if CONFIG_IS_ENABLED(DM_PROBE_DEPS)
+int device_bind_deps(struct udevice *dev);
+#else
+static inline int device_bind_deps(struct udevice *dev) { return 0; }
+#endif
+
+/**
+ * device_probe_deps() - Probe the devices which a device depends on
+ *
+ * Any that are not bound or fail to probe are skipped, leaving the driver
+ * to report the error when it asks for the resource. A dependency which is
+ * itself probing its own dependencies is also skipped, to break loops.
+ *
+ * @dev: Device whose dependencies should be probed
+ */
+#if CONFIG_IS_ENABLED(DM_PROBE_DEPS)
+void device_probe_deps(struct udevice *dev);
+#else
+static inline void device_probe_deps(struct udevice *dev) {}
+#endif
+
+/**
+ * device_free_deps() - Free the list of devices which a device depends on
+ *
+ * @dev: Device to update
+ */
+#if CONFIG_IS_ENABLED(DM_PROBE_DEPS)
+void device_free_deps(struct udevice *dev);
+#else
+static inline void device_free_deps(struct udevice *dev) {}
+#endif
+
+/**
+ * device_free_area() - Free private data which was allocated for a device
+ *
+ * Data carved from the device's arena is left alone, since the arena is
+ * freed as a whole when the device is unbound.
+ *
+ * @dev: Device which owns the data
+ * @ptr: Data to free
+ */
+void device_free_area(struct udevice *dev, void *ptr);
+
+/**
+ * device_free_arena() - Free the arena holding a device's private data
+ *
+ * @dev: Device to update
+ */
+#if CONFIG_IS_ENABLED(DM_DEVICE_ARENA)
+void device_free_arena(struct udevice *dev);
+#else
+static inline void device_free_arena(struct udevice *dev) {}
+#endif
+
 /**
  * simple_bus_translate() - translate a bus address to a system address
  *
@@ -44,6 +44,33 @@ struct driver_info;
 /* Device name is allocated and should be freed on unbind() */
 #define DM_NAME_ALLOCED			(1 << 7)
 
+/* Device is probing the devices it depends on */
+#define DM_FLAG_PROBE_DEPS		(1 << 8)
+
+/**
+ * struct device_dep - A device which another device depends on
+ *
+ * This records a reference, such as an entry in a 'clocks' property, from
+ * the device tree node of one device to that of another.
+ *
+ * @uclass_id: Uclass of the device, given by the property which refers to it
+ * @of_offset: Device tree node offset of the device
+ */
+struct device_dep {
+	enum uclass_id uclass_id;
+	int of_offset;
+};
+
+/* Keys by which a uclass indexes its devices (see CONFIG_DM_UCLASS_HASH) */
+enum uclass_hash_key {
+	UCLASS_HASH_SEQ,
+	UCLASS_HASH_REQ_SEQ,
+	UCLASS_HASH_NAME,
+	UCLASS_HASH_OF_OFFSET,
+
+	UCLASS_HASH_KEYS,
+};
+
 /**
  * struct udevice - An instance of a driver
  *
@@ -85,6 +112,18 @@ struct driver_info;
  *		When CONFIG_DEVRES is enabled, devm_kmalloc() and friends will
  *		add to this list. Memory so-allocated will be freed
  *		automatically when the device is removed / unbound
+ * @deps: Devices which must be probed before this one, found when it is
+ *		bound (see CONFIG_DM_PROBE_DEPS)
+ * @dep_count: Number of entries in @deps
+ * @probe_time_us: Time taken by the last probe of this device, not counting
+ *		its parent and the devices it depends on
+ * @probe_level: Probe level worked out by dm_dump_probe_time(), 0 if not
+ *		known yet, -1 while it is being worked out
+ * @uclass_hash: Used by uclass to index this device by each of its keys
+ * @arena: Block holding the private and platform data which is allocated
+ *		automatically, sized when the device is bound (see
+ *		CONFIG_DM_DEVICE_ARENA)
+ * @arena_size: Size of @arena in bytes
  */
 struct udevice {
 	const struct driver *driver;
@@ -108,6 +147,21 @@ struct udevice {
 #ifdef CONFIG_DEVRES
 	struct list_head devres_head;
 #endif
+#if CONFIG_IS_ENABLED(DM_PROBE_DEPS)
+	struct device_dep *deps;
+	int dep_count;
+#endif
+#if CONFIG_IS_ENABLED(DM_PROBE_TIME)
+	ulong probe_time_us;
+	int probe_level;
+#endif
+#if CONFIG_IS_ENABLED(DM_UCLASS_HASH)
+	struct hlist_node uclass_hash[UCLASS_HASH_KEYS];
+#endif
+#if CONFIG_IS_ENABLED(DM_DEVICE_ARENA)
+	void *arena;
+	int arena_size;
+#endif
 };
 
 /* Maximum sequence number supported */
@@ -519,6 +573,29 @@ bool device_has_active_children(struct udevice *dev);
  */
 bool device_is_last_sibling(struct udevice *dev);
 
+/**
+ * device_get_dep() - Get a device which a device depends on
+ *
+ * These are the devices which provide the clocks, resets, power domains and
+ * GPIOs given in the device's device tree node. They are probed before the
+ * device itself.
+ *
+ * @dev:	Device to check
+ * @index:	Index of the dependency (0 = first)
+ * @devp:	Returns the device, or NULL if no device is bound to the
+ *		node referred to. The device is not probed.
+ * @return 0 if OK, -ENOENT if there is no dependency with that index
+ */
+#if CONFIG_IS_ENABLED(DM_PROBE_DEPS)
+int device_get_dep(struct udevice *dev, int index, struct udevice **devp);
+#else
+static inline int device_get_dep(struct udevice *dev, int index,
+				 struct udevice **devp)
+{
+	return -ENOENT;
+}
+#endif
+
 /**
  * device_set_name() - set the name of a device
  *
@@ -63,7 +63,8 @@ int uclass_find_next_device(struct udevice **devp);
 /**
  * uclass_find_device_by_name() - Find uclass device based on ID and name
  *
- * This searches for a device with the exactly given name.
+ * This searches for a device with the exactly given name. If there is none,
+ * the first device whose name starts with @name is returned.
  *
  * The device is NOT probed, it is merely returned.
  *
@@ -138,6 +139,32 @@ int uclass_unbind_device(struct udevice *dev);
 static inline int uclass_unbind_device(struct udevice *dev) { return 0; }
 #endif
 
+/**
+ * uclass_index_device() - Update the uclass's index of a bound device
+ *
+ * The name, requested sequence number and device tree node of a device are
+ * indexed when it is bound, but the bind methods may change them. This
+ * updates the index once they have run, and when the device is renamed.
+ *
+ * @dev:	Pointer to the device
+ */
+#if CONFIG_IS_ENABLED(DM_UCLASS_HASH)
+void uclass_index_device(struct udevice *dev);
+#else
+static inline void uclass_index_device(struct udevice *dev) {}
+#endif
+
+/**
+ * uclass_set_device_seq() - Set the sequence number of a device
+ *
+ * This must be used instead of setting @dev->seq directly, so that the
+ * device can be found by its new sequence number.
+ *
+ * @dev:	Pointer to the device
+ * @seq:	New sequence number, or -1 for none
+ */
+void uclass_set_device_seq(struct udevice *dev, int seq);
+
 /**
  * uclass_pre_probe_device() - Deal with a device that is about to be probed
  *
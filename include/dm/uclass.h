@@ -30,12 +30,21 @@
  * @dev_head: List of devices in this uclass (devices are attached to their
  * uclass when their bind method is called)
  * @sibling_node: Next uclass in the linked list of uclasses
+ * @hash: Hash tables of devices in this uclass, one for each of
+ * enum uclass_hash_key, or NULL if there are only a few devices
+ * @hash_bits: log2 of the number of buckets in each table
+ * @dev_count: Number of devices in @dev_head
  */
 struct uclass {
 	void *priv;
 	struct uclass_driver *uc_drv;
 	struct list_head dev_head;
 	struct list_head sibling_node;
+#if CONFIG_IS_ENABLED(DM_UCLASS_HASH)
+	struct hlist_head *hash;
+	int hash_bits;
+	int dev_count;
+#endif
 };
 
 struct udevice;
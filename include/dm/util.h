@@ -39,6 +39,18 @@ void dm_dump_all(void);
 /* Dump out a list of uclasses and their devices */
 void dm_dump_uclass(void);
 
+/*
+ * Dump out the time each probed device took to probe, and its level in the
+ * dependency graph
+ */
+#if CONFIG_IS_ENABLED(DM_PROBE_TIME)
+void dm_dump_probe_time(void);
+#else
+static inline void dm_dump_probe_time(void)
+{
+}
+#endif
+
 #ifdef CONFIG_DEBUG_DEVRES
 /* Dump out a list of device resources */
 void dm_dump_devres(void);
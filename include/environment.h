@@ -220,6 +220,12 @@ int set_default_vars(int nvars, char * const vars[]);
 /* Import from binary representation into hash table */
 int env_import(const char *buf, int check);
 
+/*
+ * As env_import(), but parse the environment where it is, changing it. This
+ * saves copying the whole environment when the caller has its own buffer.
+ */
+int env_import_inplace(char *buf, int check);
+
 /* Export from hash table into binary representation */
 int env_export(env_t *env_out);
 
@@ -4,9 +4,20 @@
  * SPDX-License-Identifier: GPL-2.0
  */
 
+#ifndef __FDT_EDIT_H
+#define __FDT_EDIT_H
+
 void *fdt_copy_get_blob_src_default(void);
 
 int fdt_copy_env_proplist(void *blob_dst);
 int fdt_copy_env_nodelist(void *blob_dst);
 int fdt_del_env_nodelist(void *blob_dst);
 int fdt_del_env_proplist(void *blob_dst);
+
+/*
+ * Apply all of the above in one pass: delete nodes, delete properties, copy
+ * nodes, then copy properties
+ */
+int fdt_edit_env_all(void *blob_dst);
+
+#endif
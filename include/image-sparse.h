@@ -15,6 +15,16 @@ struct sparse_storage {
 	lbaint_t	size;
 	void		*priv;
 
+	/*
+	 * Optional erase support: when erase() is set, FILL chunks whose
+	 * pattern equals erase_val (and DONT_CARE chunks, if discard is
+	 * set) are erased rather than written. Only whole erase_grp sized
+	 * and aligned ranges are passed to erase().
+	 */
+	lbaint_t	erase_grp;
+	u32		erase_val;
+	bool		discard;
+
 	lbaint_t	(*write)(struct sparse_storage *info,
 				 lbaint_t blk,
 				 lbaint_t blkcnt,
@@ -23,6 +33,12 @@ struct sparse_storage {
 	lbaint_t	(*reserve)(struct sparse_storage *info,
 				 lbaint_t blk,
 				 lbaint_t blkcnt);
+
+	lbaint_t	(*erase)(struct sparse_storage *info,
+				 lbaint_t blk,
+				 lbaint_t blkcnt);
+
+	void		(*mssg)(const char *str);
 };
 
 static inline int is_sparse_image(void *buf)
@@ -36,5 +52,17 @@ static inline int is_sparse_image(void *buf)
 	return 0;
 }
 
-void write_sparse_image(struct sparse_storage *info, const char *part_name,
-			void *data, unsigned sz);
+/**
+ * write_sparse_image() - Write an Android sparse image to storage
+ *
+ * Consecutive RAW chunks are merged into a single write by moving their
+ * data together inside @data, so the image buffer is modified.
+ *
+ * @info:	Storage description and access callbacks
+ * @part_name:	Partition name, for messages
+ * @data:	Sparse image
+ * @sz:		Size of the sparse image in bytes
+ * @return 0 if OK, -ve on error (info->mssg() has been called)
+ */
+int write_sparse_image(struct sparse_storage *info, const char *part_name,
+		       void *data, unsigned sz);
@@ -810,6 +810,7 @@ int bootz_setup(ulong image, ulong *start, ulong *end);
 #define FIT_KERNEL_PROP		"kernel"
 #define FIT_RAMDISK_PROP	"ramdisk"
 #define FIT_FDT_PROP		"fdt"
+#define FIT_FIRMWARE_PROP	"firmware"
 #define FIT_LOADABLE_PROP	"loadables"
 #define FIT_DEFAULT_PROP	"default"
 #define FIT_SETUP_PROP		"setup"
@@ -890,10 +891,13 @@ int fit_set_timestamp(void *fit, int noffset, time_t timestamp);
  * @fit:	Pointer to the FIT format image header
  * @comment:	Comment to add to signature nodes
  * @require_keys: Mark all keys as 'required'
+ * @jobs:	Number of threads to use for component image hashes and
+ *		signatures (1 to process them one at a time)
  *
  * Adds hash values for all component images in the FIT blob.
  * Hashes are calculated for all component images which have hash subnodes
  * with algorithm property set to one of the supported hash algorithms.
+ * The result does not depend on the number of threads used.
  *
  * Also add signatures if signature nodes are present.
  *
@@ -902,8 +906,20 @@ int fit_set_timestamp(void *fit, int noffset, time_t timestamp);
  *     libfdt error code, on failure
  */
 int fit_add_verification_data(const char *keydir, void *keydest, void *fit,
-			      const char *comment, int require_keys);
+			      const char *comment, int require_keys, int jobs);
 
+/**
+ * fit_image_check_hash() - verify data against one hash node of an image
+ *
+ * @fit:	Pointer to the FIT format image header
+ * @noffset:	Offset of the hash node
+ * @data:	Image data to check
+ * @size:	Size of the image data in bytes
+ * @err_msgp:	Returns an error message on failure
+ * @return 0 if the hash matches, -1 otherwise
+ */
+int fit_image_check_hash(const void *fit, int noffset, const void *data,
+			 size_t size, char **err_msgp);
 int fit_image_verify(const void *fit, int noffset);
 int fit_config_verify(const void *fit, int conf_noffset);
 int fit_all_image_verify(const void *fit);
@@ -11,6 +11,10 @@
  * SPDX-License-Identifier:	GPL-2.0+
  */
 
+/*
+ * Number of regions which are stored without allocating memory. Tables
+ * that need more are moved to the heap and grown as needed.
+ */
 #define MAX_LMB_REGIONS 8
 
 struct lmb_property {
@@ -20,8 +24,10 @@ struct lmb_property {
 
 struct lmb_region {
 	unsigned long cnt;
+	unsigned long max;
 	phys_size_t size;
-	struct lmb_property region[MAX_LMB_REGIONS+1];
+	struct lmb_property *region;
+	struct lmb_property initial[MAX_LMB_REGIONS];
 };
 
 struct lmb {
@@ -32,6 +38,8 @@ struct lmb {
 extern struct lmb lmb;
 
 extern void lmb_init(struct lmb *lmb);
+/* Frees any memory allocated for the region tables of an initialised lmb */
+extern void lmb_release(struct lmb *lmb);
 extern long lmb_add(struct lmb *lmb, phys_addr_t base, phys_size_t size);
 extern long lmb_reserve(struct lmb *lmb, phys_addr_t base, phys_size_t size);
 extern phys_addr_t lmb_alloc(struct lmb *lmb, phys_size_t size, ulong align);
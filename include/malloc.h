@@ -876,10 +876,14 @@ extern Void_t*     sbrk();
 #define malloc malloc_simple
 #define realloc realloc_simple
 #define memalign memalign_simple
-static inline void free(void *ptr) {}
 void *calloc(size_t nmemb, size_t size);
 void *memalign_simple(size_t alignment, size_t bytes);
 void *realloc_simple(void *ptr, size_t size);
+void free_simple(void *ptr);
+static inline void free(void *ptr)
+{
+	free_simple(ptr);
+}
 #else
 
 # ifdef USE_DL_PREFIX
@@ -913,6 +917,17 @@ int initf_malloc(void);
 
 /* Simple versions which can be used when space is tight */
 void *malloc_simple(size_t size);
+void *memalign_simple(size_t alignment, size_t bytes);
+void *realloc_simple(void *ptr, size_t size);
+void free_simple(void *ptr);
+
+/**
+ * malloc_simple_usable_size() - Get the size of a block from malloc_simple()
+ *
+ * @ptr: Pointer to check
+ * @return size of the block, or 0 if @ptr is not in the malloc_simple() area
+ */
+size_t malloc_simple_usable_size(void *ptr);
 
 #pragma GCC visibility push(hidden)
 # if __STD_C
@@ -957,6 +972,96 @@ extern ulong mem_malloc_brk;
 
 void mem_malloc_init(ulong start, ulong size);
 
+/**
+ * struct malloc_stats - Usage of the malloc() heap
+ *
+ * @total: Bytes taken from the heap area so far
+ * @in_use: Bytes in allocated blocks, including their headers
+ * @free: Bytes in free blocks, including the unused top of the heap
+ * @largest_free: Size of the largest free block
+ * @allocs: Number of allocations, counting each slab object
+ * @free_blocks: Number of free blocks
+ */
+struct malloc_stats {
+	ulong total;
+	ulong in_use;
+	ulong free;
+	ulong largest_free;
+	uint allocs;
+	uint free_blocks;
+};
+
+/**
+ * malloc_get_stats() - Find out how the malloc() heap is being used
+ *
+ * This walks the whole heap, so is intended for diagnostics.
+ *
+ * @stats: Returns the usage of the heap
+ */
+void malloc_get_stats(struct malloc_stats *stats);
+
+/* Largest request which the slab front end handles */
+#define MALLOC_SLAB_MAX		256
+
+/**
+ * struct malloc_slab_stats - Usage of one slab size class
+ *
+ * @size: Size of each object in the class
+ * @pages: Number of pages taken from the heap
+ * @objects: Number of objects allocated
+ * @free: Number of free objects in the pages
+ */
+struct malloc_slab_stats {
+	uint size;
+	uint pages;
+	uint objects;
+	uint free;
+};
+
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+/**
+ * malloc_slab() - Allocate a small object from a slab
+ *
+ * @bytes: Size to allocate, at most MALLOC_SLAB_MAX
+ * @return pointer to the object, or NULL if no slab page could be allocated
+ */
+void *malloc_slab(size_t bytes);
+
+/**
+ * malloc_slab_free() - Free an object if it was allocated from a slab
+ *
+ * @mem: Pointer to free
+ * @return true if @mem was a slab object and has been freed, else false
+ */
+bool malloc_slab_free(void *mem);
+
+/**
+ * malloc_slab_size() - Get the usable size of a slab object
+ *
+ * @mem: Pointer to check
+ * @return size of the object, or 0 if @mem is not a slab object
+ */
+size_t malloc_slab_size(void *mem);
+
+/**
+ * malloc_slab_usage() - Get the heap space taken by slab pages
+ *
+ * @page_bytesp: Returns the number of bytes in slab pages
+ * @obj_bytesp: Returns the number of bytes in allocated objects
+ * @return number of allocated objects
+ */
+uint malloc_slab_usage(ulong *page_bytesp, ulong *obj_bytesp);
+
+/**
+ * malloc_slab_get_stats() - Get the usage of a slab size class
+ *
+ * @index: Index of the class, from 0
+ * @stats: Returns the usage of the class
+ * @return 0 if OK, -ENOENT if @index is past the last class
+ */
+int malloc_slab_get_stats(int index, struct malloc_slab_stats *stats);
+#endif
+
 #ifdef __cplusplus
 };  /* end of extern "C" */
 #endif
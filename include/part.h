@@ -236,6 +236,18 @@ struct part_driver {
 int part_get_info_efi_by_name(struct blk_desc *dev_desc,
 			      const char *name, disk_partition_t *info);
 
+/**
+ * part_get_info_efi_by_uuid() - Find a GPT partition by its unique GUID
+ *
+ * @param dev_desc - block device descriptor
+ * @param uuid - the partition GUID, as returned in info->uuid
+ * @param info - returns the disk partition info
+ *
+ * @return - '0' on match, '-1' on no match, otherwise error
+ */
+int part_get_info_efi_by_uuid(struct blk_desc *dev_desc, const char *uuid,
+			      disk_partition_t *info);
+
 /**
  * write_gpt_table() - Write the GUID Partition Table to disk
  *
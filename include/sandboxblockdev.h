@@ -13,6 +13,7 @@ struct host_block_dev {
 #endif
 	char *filename;
 	int fd;
+	uint read_count;	/* number of reads, for tests */
 };
 
 int host_dev_bind(int dev, char *filename);
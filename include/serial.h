@@ -160,9 +160,20 @@ struct dm_serial_ops {
  * struct serial_dev_priv - information about a device used by the uclass
  *
  * @sdev: stdio device attached to this uart
+ * @tx_buf: Output buffer (CONFIG_SERIAL_TX_BUFFER_SIZE bytes), NULL if
+ *	output goes straight to the uart
+ * @tx_head: Number of characters ever added to @tx_buf
+ * @tx_tail: Number of characters ever sent from @tx_buf
+ * @tx_dropped: Number of characters discarded because @tx_buf was full
  */
 struct serial_dev_priv {
 	struct stdio_dev *sdev;
+#ifdef CONFIG_SERIAL_TX_BUFFER
+	char *tx_buf;
+	uint tx_head;
+	uint tx_tail;
+	uint tx_dropped;
+#endif
 };
 
 /* Access the serial operations for a device */
@@ -366,6 +366,31 @@ struct spi_cs_info {
 	struct udevice *dev;
 };
 
+/**
+ * struct spi_bulk_read - A read from a SPI flash in a single transfer
+ *
+ * This describes a complete flash read command, so that a controller which
+ * can send the command itself (e.g. with a DMA engine) does not need the
+ * data to be split into separate xfer() calls.
+ *
+ * @opcode:	Read command to send, on a single line
+ * @addr_len:	Number of address bytes (3 or 4)
+ * @dummy_len:	Number of dummy bytes following the address
+ * @addr_width:	Number of lines used for the address and dummy bytes
+ * @data_width:	Number of lines used for the data (1, 2 or 4)
+ * @addr:	Flash address to read from
+ * @len:	Number of bytes to read
+ */
+struct spi_bulk_read {
+	u8 opcode;
+	u8 addr_len;
+	u8 dummy_len;
+	u8 addr_width;
+	u8 data_width;
+	u32 addr;
+	size_t len;
+};
+
 /**
  * struct struct dm_spi_ops - Driver model SPI operations
  *
@@ -477,6 +502,21 @@ struct dm_spi_ops {
 	 *	   is invalid, other -ve value on error
 	 */
 	int (*cs_info)(struct udevice *bus, uint cs, struct spi_cs_info *info);
+
+	/**
+	 * Read from a SPI flash in a single transfer (optional)
+	 *
+	 * Controllers which can issue a whole flash read command should
+	 * implement this, so that large reads need not be split into
+	 * chunks. The bus is claimed by the caller.
+	 *
+	 * @dev:	The SPI slave
+	 * @op:		Read command to perform
+	 * @buf:	Buffer for @op->len bytes of data
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*read_bulk)(struct udevice *dev, const struct spi_bulk_read *op,
+			 void *buf);
 };
 
 struct dm_spi_emul_ops {
@@ -506,6 +546,19 @@ struct dm_spi_emul_ops {
 	 */
 	int (*xfer)(struct udevice *slave, unsigned int bitlen,
 		    const void *dout, void *din, unsigned long flags);
+
+	/**
+	 * Read from a SPI flash in a single transfer (optional)
+	 *
+	 * See read_bulk() in struct dm_spi_ops.
+	 *
+	 * @slave:	The SPI slave to read from
+	 * @op:		Read command to perform
+	 * @buf:	Buffer for @op->len bytes of data
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*read_bulk)(struct udevice *slave, const struct spi_bulk_read *op,
+			 void *buf);
 };
 
 /**
@@ -664,6 +717,20 @@ void dm_spi_release_bus(struct udevice *dev);
 int dm_spi_xfer(struct udevice *dev, unsigned int bitlen,
 		const void *dout, void *din, unsigned long flags);
 
+/**
+ * dm_spi_read_bulk() - Read from a SPI flash in a single transfer
+ *
+ * The bus must be claimed with dm_spi_claim_bus() first.
+ *
+ * @dev:	The SPI slave device to read from
+ * @op:		Read command to perform
+ * @buf:	Buffer for @op->len bytes of data
+ * @return 0 if OK, -ENOSYS if the controller cannot do this, other -ve
+ *	   value on error
+ */
+int dm_spi_read_bulk(struct udevice *dev, const struct spi_bulk_read *op,
+		     void *buf);
+
 /* Access the operations for a SPI device */
 #define spi_get_ops(dev)	((struct dm_spi_ops *)(dev)->driver->ops)
 #define spi_emul_get_ops(dev)	((struct dm_spi_emul_ops *)(dev)->driver->ops)
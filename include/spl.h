@@ -59,6 +59,16 @@ struct spl_load_info {
  */
 int spl_load_simple_fit(struct spl_load_info *info, ulong sector, void *fdt);
 
+/**
+ * board_spl_fit_buffer() - Get the buffer to read the FIT header into
+ * @fit_size:	Size of the FIT header in bytes
+ * @bl_len:	Block length of the device being read
+ *
+ * The default places the FIT header just below CONFIG_SYS_TEXT_BASE.
+ * Returns a pointer to a buffer large enough for the FIT header.
+ */
+void *board_spl_fit_buffer(ulong fit_size, int bl_len);
+
 #define SPL_COPY_PAYLOAD_ONLY	1
 
 extern struct spl_image_info spl_image;
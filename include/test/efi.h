@@ -0,0 +1,13 @@
+/*
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __TEST_EFI_H__
+#define __TEST_EFI_H__
+
+#include <test/test.h>
+
+/* Declare a new EFI loader test */
+#define EFI_TEST(_name, _flags)	UNIT_TEST(_name, _flags, efi_test)
+
+#endif /* __TEST_EFI_H__ */
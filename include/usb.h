@@ -157,6 +157,22 @@ struct usb_device {
 
 struct int_queue;
 
+/**
+ * struct usb_bulk_req - One buffer in a queue of bulk transfers
+ *
+ * @buffer:	Data to send, or space for the data received
+ * @length:	Length of @buffer in bytes
+ * @act_len:	Returns the number of bytes transferred
+ * @status:	Returns the USB_ST_... status of the transfer, USB_ST_NOT_PROC
+ *		if it was not done because an earlier one failed
+ */
+struct usb_bulk_req {
+	void *buffer;
+	int length;
+	int act_len;
+	unsigned long status;
+};
+
 /*
  * You can initialize platform's USB host or device
  * ports by passing this enum as an argument to
@@ -261,6 +277,25 @@ int usb_control_msg(struct usb_device *dev, unsigned int pipe,
 			void *data, unsigned short size, int timeout);
 int usb_bulk_msg(struct usb_device *dev, unsigned int pipe,
 			void *data, int len, int *actual_length, int timeout);
+
+/**
+ * usb_bulk_msg_queue() - Send or receive several bulk buffers in one go
+ *
+ * The buffers are transferred in order on the same pipe. Controllers which
+ * support it queue them all before starting the first one, so there is no
+ * gap between them; otherwise they are sent one at a time. A short transfer
+ * does not stop the ones after it. After any other error the remaining
+ * requests may not be done, in which case their status is USB_ST_NOT_PROC.
+ *
+ * @dev:	USB device to talk to
+ * @pipe:	Bulk pipe to use
+ * @reqs:	Requests to process
+ * @count:	Number of requests
+ * @timeout:	Timeout in milliseconds for each request
+ * @return 0 if all requests completed, -EIO if one failed, other -ve on error
+ */
+int usb_bulk_msg_queue(struct usb_device *dev, unsigned int pipe,
+		       struct usb_bulk_req *reqs, int count, int timeout);
 int usb_submit_int_msg(struct usb_device *dev, unsigned long pipe,
 			void *buffer, int transfer_len, int interval);
 int usb_disable_asynch(int disable);
@@ -730,6 +765,33 @@ struct dm_usb_ops {
 	 * reset_root_port() - Reset usb root port
 	 */
 	int (*reset_root_port)(struct udevice *bus, struct usb_device *udev);
+
+	/**
+	 * get_max_xfer_size() - Get the maximum bulk transfer size
+	 *
+	 * This is the largest buffer the controller can move in a single
+	 * bulk message. It is used by class drivers to size their requests.
+	 *
+	 * @size:	Returns the maximum size in bytes
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*get_max_xfer_size)(struct udevice *bus, size_t *size);
+
+	/**
+	 * bulk_queue() - Queue several bulk messages on the same pipe
+	 *
+	 * All the requests are handed to the controller before waiting for
+	 * the first one to complete. The method fills in the act_len and
+	 * status of each request, as described for usb_bulk_msg_queue(). If
+	 * this is NULL, the requests are sent one at a time with bulk().
+	 *
+	 * @reqs:	Requests to process, in order
+	 * @count:	Number of requests
+	 * @return 0 if all requests completed, -ve on error
+	 */
+	int (*bulk_queue)(struct udevice *bus, struct usb_device *udev,
+			  unsigned long pipe, struct usb_bulk_req *reqs,
+			  int count);
 };
 
 #define usb_get_ops(dev)	((struct dm_usb_ops *)(dev)->driver->ops)
@@ -750,6 +812,28 @@ struct dm_usb_ops {
  */
 struct usb_device *usb_get_dev_index(struct udevice *bus, int index);
 
+/**
+ * usb_get_max_xfer_size() - Get the maximum bulk transfer size of a device
+ *
+ * @udev:	USB device whose controller should be checked
+ * @size:	Returns the maximum size in bytes of a bulk message
+ * @return 0 if OK, -ENOSYS if the controller does not report a limit
+ */
+int usb_get_max_xfer_size(struct usb_device *udev, size_t *size);
+
+/**
+ * usb_submit_bulk_queue() - Queue several bulk messages with the controller
+ *
+ * @udev:	USB device to talk to
+ * @pipe:	Bulk pipe to use
+ * @reqs:	Requests to process, in order
+ * @count:	Number of requests
+ * @return 0 if all requests completed, -ENOSYS if the controller cannot
+ *	queue bulk messages, other -ve on error
+ */
+int usb_submit_bulk_queue(struct usb_device *udev, unsigned long pipe,
+			  struct usb_bulk_req *reqs, int count);
+
 /**
  * usb_setup_device() - set up a device ready for use
  *
@@ -860,6 +944,26 @@ bool usb_device_has_child_on_port(struct usb_device *parent, int port);
 int usb_hub_probe(struct usb_device *dev, int ifnum);
 void usb_hub_reset(void);
 
+/**
+ * usb_hub_defer_scan() - Only queue the ports of hubs which are set up
+ *
+ * Hubs set up after this call add their ports to the scanning list but do
+ * not scan them. This allows the ports of all the root hubs to be scanned
+ * together by usb_hub_scan_queued(), so that port power-on and reset delays
+ * overlap across hubs and controllers instead of adding up.
+ */
+void usb_hub_defer_scan(void);
+
+/**
+ * usb_hub_scan_queued() - Scan all the ports on the scanning list
+ *
+ * This ends a usb_hub_defer_scan() and scans the queued ports, along with
+ * the ports of any hubs found on them, until all have been dealt with.
+ *
+ * @return 0 if OK, -ve on error
+ */
+int usb_hub_scan_queued(void);
+
 /**
  * legacy_hub_port_reset() - reset a port given its usb_device pointer
  *
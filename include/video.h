@@ -67,6 +67,9 @@ enum video_log2_bpp {
  * @flush_dcache:	true to enable flushing of the data cache after
  *		the LCD is updated
  * @cmap:	Colour map for 8-bit-per-pixel displays
+ * @damage_ystart:	First frame buffer line changed since the last sync
+ * @damage_yend:	Line after the last one changed since the last sync, 0
+ *		if no change has been reported
  */
 struct video_priv {
 	/* Things set up by the driver: */
@@ -88,6 +91,8 @@ struct video_priv {
 	int colour_bg;
 	bool flush_dcache;
 	ushort *cmap;
+	int damage_ystart;
+	int damage_yend;
 };
 
 /* Placeholder - there are no video operations at present */
@@ -114,6 +119,19 @@ struct video_ops {
  */
 int video_reserve(ulong *addrp);
 
+/**
+ * video_damage() - Record that part of the frame buffer has changed
+ *
+ * video_sync() only deals with the lines which have changed since it was
+ * last called, so anything drawing into the frame buffer should report what
+ * it touched. If nothing was reported, video_sync() deals with all lines.
+ *
+ * @vid:	Device to update
+ * @y:		First frame buffer line that changed
+ * @height:	Number of lines that changed
+ */
+void video_damage(struct udevice *vid, int y, int height);
+
 /**
  * video_sync() - Sync a device's frame buffer with its hardware
  *
@@ -185,4 +185,16 @@ int vidconsole_put_char(struct udevice *dev, char ch);
 void vidconsole_position_cursor(struct udevice *dev, unsigned col,
 				unsigned row);
 
+/**
+ * console_normal_set_glyph_cache() - Turn the glyph cache on or off
+ *
+ * The normal console draws characters from pre-rendered glyphs. With the
+ * cache off, it expands the font bits for each character instead. This is
+ * used by tests to check the cached output.
+ *
+ * @dev:	Normal console device
+ * @enable:	true to use the cache (the default), false to draw directly
+ */
+void console_normal_set_glyph_cache(struct udevice *dev, bool enable);
+
 #endif
@@ -31,6 +31,8 @@ struct efi_disk_obj {
 	struct efi_device_path_file_path *dp;
 	/* Offset into disk for simple partitions */
 	lbaint_t offset;
+	/* Buffer for read-ahead of small reads, allocated on first use */
+	void *ra_buf;
 };
 
 static efi_status_t efi_disk_open_block(void *handle, efi_guid_t *protocol,
@@ -67,6 +69,54 @@ enum efi_disk_direction {
 	EFI_DISK_WRITE,
 };
 
+#ifdef CONFIG_EFI_LOADER_READAHEAD
+/*
+ * EFI applications such as grub tend to read a few blocks at a time. Read
+ * a larger window for these and keep it in the block cache, where it is
+ * dropped again on any write to the device.
+ */
+static unsigned long efi_disk_read_ahead(struct efi_disk_obj *diskobj,
+					 struct blk_desc *desc, lbaint_t lba,
+					 lbaint_t blocks, void *buffer)
+{
+	lbaint_t count = CONFIG_EFI_LOADER_READAHEAD;
+
+	if (blocks >= count || lba >= desc->lba)
+		return blk_dread(desc, lba, blocks, buffer);
+
+	if (blkcache_read(desc->if_type, desc->devnum, lba, blocks,
+			  desc->blksz, buffer))
+		return blocks;
+
+	if (!diskobj->ra_buf) {
+		diskobj->ra_buf = memalign(ARCH_DMA_MINALIGN,
+					   count * desc->blksz);
+		if (!diskobj->ra_buf)
+			return blk_dread(desc, lba, blocks, buffer);
+	}
+
+	/* Don't read past the end of the device */
+	if (lba + count > desc->lba)
+		count = desc->lba - lba;
+	if (count <= blocks ||
+	    blk_dread(desc, lba, count, diskobj->ra_buf) != count)
+		return blk_dread(desc, lba, blocks, buffer);
+
+	blkcache_fill_readahead(desc->if_type, desc->devnum, lba, count,
+				desc->blksz, diskobj->ra_buf);
+	memcpy(buffer, diskobj->ra_buf, blocks * desc->blksz);
+
+	return blocks;
+}
+#else
+static unsigned long efi_disk_read_ahead(struct efi_disk_obj *diskobj,
+					 struct blk_desc *desc, lbaint_t lba,
+					 lbaint_t blocks, void *buffer)
+{
+	return blk_dread(desc, lba, blocks, buffer);
+}
+#endif
+
 static efi_status_t EFIAPI efi_disk_rw_blocks(struct efi_block_io *this,
 			u32 media_id, u64 lba, unsigned long buffer_size,
 			void *buffer, enum efi_disk_direction direction)
@@ -92,7 +142,7 @@ static efi_status_t EFIAPI efi_disk_rw_blocks(struct efi_block_io *this,
 		return EFI_EXIT(EFI_DEVICE_ERROR);
 
 	if (direction == EFI_DISK_READ)
-		n = blk_dread(desc, lba, blocks, buffer);
+		n = efi_disk_read_ahead(diskobj, desc, lba, blocks, buffer);
 	else
 		n = blk_dwrite(desc, lba, blocks, buffer);
 
@@ -107,6 +157,21 @@ static efi_status_t EFIAPI efi_disk_rw_blocks(struct efi_block_io *this,
 	return EFI_EXIT(EFI_SUCCESS);
 }
 
+#ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
+/*
+ * The bounce buffer is allocated below 4GiB and cache aligned. A buffer
+ * that already meets both conditions can be used for DMA directly.
+ */
+static bool efi_disk_need_bounce(void *buffer, unsigned long buffer_size)
+{
+	uintptr_t start = (uintptr_t)buffer;
+
+	return (start & (ARCH_DMA_MINALIGN - 1)) ||
+	       (buffer_size & (ARCH_DMA_MINALIGN - 1)) ||
+	       (u64)start + buffer_size > 0x100000000ULL;
+}
+#endif
+
 static efi_status_t efi_disk_read_blocks(struct efi_block_io *this,
 			u32 media_id, u64 lba, unsigned long buffer_size,
 			void *buffer)
@@ -115,18 +180,21 @@ static efi_status_t efi_disk_read_blocks(struct efi_block_io *this,
 	efi_status_t r;
 
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
-	if (buffer_size > EFI_LOADER_BOUNCE_BUFFER_SIZE) {
-		r = efi_disk_read_blocks(this, media_id, lba,
-			EFI_LOADER_BOUNCE_BUFFER_SIZE, buffer);
-		if (r != EFI_SUCCESS)
-			return r;
-		return efi_disk_read_blocks(this, media_id, lba +
-			EFI_LOADER_BOUNCE_BUFFER_SIZE / this->media->block_size,
-			buffer_size - EFI_LOADER_BOUNCE_BUFFER_SIZE,
-			buffer + EFI_LOADER_BOUNCE_BUFFER_SIZE);
-	}
+	if (efi_disk_need_bounce(buffer, buffer_size)) {
+		if (buffer_size > EFI_LOADER_BOUNCE_BUFFER_SIZE) {
+			r = efi_disk_read_blocks(this, media_id, lba,
+				EFI_LOADER_BOUNCE_BUFFER_SIZE, buffer);
+			if (r != EFI_SUCCESS)
+				return r;
+			return efi_disk_read_blocks(this, media_id, lba +
+				EFI_LOADER_BOUNCE_BUFFER_SIZE /
+				this->media->block_size,
+				buffer_size - EFI_LOADER_BOUNCE_BUFFER_SIZE,
+				buffer + EFI_LOADER_BOUNCE_BUFFER_SIZE);
+		}
 
-	real_buffer = efi_bounce_buffer;
+		real_buffer = efi_bounce_buffer;
+	}
 #endif
 
 	EFI_ENTRY("%p, %x, %"PRIx64", %lx, %p", this, media_id, lba,
@@ -150,18 +218,21 @@ static efi_status_t efi_disk_write_blocks(struct efi_block_io *this,
 	efi_status_t r;
 
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
-	if (buffer_size > EFI_LOADER_BOUNCE_BUFFER_SIZE) {
-		r = efi_disk_write_blocks(this, media_id, lba,
-			EFI_LOADER_BOUNCE_BUFFER_SIZE, buffer);
-		if (r != EFI_SUCCESS)
-			return r;
-		return efi_disk_write_blocks(this, media_id, lba +
-			EFI_LOADER_BOUNCE_BUFFER_SIZE / this->media->block_size,
-			buffer_size - EFI_LOADER_BOUNCE_BUFFER_SIZE,
-			buffer + EFI_LOADER_BOUNCE_BUFFER_SIZE);
-	}
+	if (efi_disk_need_bounce(buffer, buffer_size)) {
+		if (buffer_size > EFI_LOADER_BOUNCE_BUFFER_SIZE) {
+			r = efi_disk_write_blocks(this, media_id, lba,
+				EFI_LOADER_BOUNCE_BUFFER_SIZE, buffer);
+			if (r != EFI_SUCCESS)
+				return r;
+			return efi_disk_write_blocks(this, media_id, lba +
+				EFI_LOADER_BOUNCE_BUFFER_SIZE /
+				this->media->block_size,
+				buffer_size - EFI_LOADER_BOUNCE_BUFFER_SIZE,
+				buffer + EFI_LOADER_BOUNCE_BUFFER_SIZE);
+		}
 
-	real_buffer = efi_bounce_buffer;
+		real_buffer = efi_bounce_buffer;
+	}
 #endif
 
 	EFI_ENTRY("%p, %x, %"PRIx64", %lx, %p", this, media_id, lba,
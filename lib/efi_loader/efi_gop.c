@@ -28,6 +28,9 @@ struct efi_gop_obj {
 	struct efi_gop_mode mode;
 	/* Fields we only have acces to during init */
 	u32 bpix;
+#ifdef CONFIG_DM_VIDEO
+	struct udevice *vdev;
+#endif
 };
 
 static efi_status_t EFIAPI gop_query_mode(struct efi_gop *this, u32 mode_number,
@@ -116,6 +119,7 @@ static efi_status_t EFIAPI gop_blt(struct efi_gop *this, void *buffer,
 	}
 
 #ifdef CONFIG_DM_VIDEO
+	video_damage(gopobj->vdev, dy, height);
 	video_sync_all();
 #else
 	lcd_sync();
@@ -184,6 +188,9 @@ int efi_gop_register(void)
 	gopobj->info.pixels_per_scanline = col;
 
 	gopobj->bpix = bpix;
+#ifdef CONFIG_DM_VIDEO
+	gopobj->vdev = vdev;
+#endif
 
 	/* Hook up to the device list */
 	list_add_tail(&gopobj->parent.link, &efi_obj_list);
@@ -9,242 +9,312 @@
 #include <common.h>
 #include <efi_loader.h>
 #include <malloc.h>
+#include <mapmem.h>
 #include <asm/global_data.h>
 #include <libfdt_env.h>
-#include <linux/list_sort.h>
+#include <linux/rbtree_augmented.h>
 #include <inttypes.h>
 #include <watchdog.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
+/*
+ * The memory map is kept in a red-black tree ordered by start address.
+ * Each node also records the size of the largest free (conventional
+ * memory) region in its subtree, so that a free region of a given size
+ * can be found without visiting every entry.
+ */
 struct efi_mem_list {
-	struct list_head link;
+	struct rb_node node;
 	struct efi_mem_desc desc;
+	/* Largest number of free pages in one region of this subtree */
+	uint64_t max_free_pages;
+	/* Allocated by efi_allocate_pages(), so it may be freed */
+	bool allocated;
 };
 
-#define EFI_CARVE_NO_OVERLAP		-1
-#define EFI_CARVE_LOOP_AGAIN		-2
-#define EFI_CARVE_OVERLAPS_NONRAM	-3
-
-/* This list contains all memory map items */
-LIST_HEAD(efi_mem);
+/* This tree contains all memory map items */
+static struct rb_root efi_mem = RB_ROOT;
+static int efi_mem_count;
 
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 void *efi_bounce_buffer;
 #endif
 
-/*
- * Sorts the memory list from highest address to lowest address
- *
- * When allocating memory we should always start from the highest
- * address chunk, so sort the memory list such that the first list
- * iterator gets the highest address and goes lower from there.
- */
-static int efi_mem_cmp(void *priv, struct list_head *a, struct list_head *b)
+static inline struct efi_mem_list *efi_mem_entry(struct rb_node *node)
 {
-	struct efi_mem_list *mema = list_entry(a, struct efi_mem_list, link);
-	struct efi_mem_list *memb = list_entry(b, struct efi_mem_list, link);
+	return node ? rb_entry(node, struct efi_mem_list, node) : NULL;
+}
 
-	if (mema->desc.physical_start == memb->desc.physical_start)
-		return 0;
-	else if (mema->desc.physical_start < memb->desc.physical_start)
-		return 1;
-	else
-		return -1;
+static inline uint64_t efi_mem_end(struct efi_mem_list *mem)
+{
+	return mem->desc.physical_start +
+	       (mem->desc.num_pages << EFI_PAGE_SHIFT);
+}
+
+static uint64_t efi_mem_compute_max(struct efi_mem_list *mem)
+{
+	struct efi_mem_list *child;
+	uint64_t max_free = 0;
+
+	if (mem->desc.type == EFI_CONVENTIONAL_MEMORY)
+		max_free = mem->desc.num_pages;
+	child = efi_mem_entry(mem->node.rb_left);
+	if (child && child->max_free_pages > max_free)
+		max_free = child->max_free_pages;
+	child = efi_mem_entry(mem->node.rb_right);
+	if (child && child->max_free_pages > max_free)
+		max_free = child->max_free_pages;
+
+	return max_free;
+}
+
+RB_DECLARE_CALLBACKS(static, efi_mem_cb, struct efi_mem_list, node, uint64_t,
+		     max_free_pages, efi_mem_compute_max)
+
+/* Must be called after changing the size or type of a map entry */
+static void efi_mem_update(struct efi_mem_list *mem)
+{
+	efi_mem_cb.propagate(&mem->node, NULL);
+}
+
+static void efi_mem_insert(struct efi_mem_list *newmem)
+{
+	struct rb_node **link = &efi_mem.rb_node;
+	struct rb_node *parent = NULL;
+	struct efi_mem_list *mem;
+	uint64_t start = newmem->desc.physical_start;
+
+	newmem->max_free_pages = efi_mem_compute_max(newmem);
+	while (*link) {
+		parent = *link;
+		mem = efi_mem_entry(parent);
+		if (mem->max_free_pages < newmem->max_free_pages)
+			mem->max_free_pages = newmem->max_free_pages;
+		if (start < mem->desc.physical_start)
+			link = &parent->rb_left;
+		else
+			link = &parent->rb_right;
+	}
+
+	rb_link_node(&newmem->node, parent, link);
+	rb_insert_augmented(&newmem->node, &efi_mem, &efi_mem_cb);
+	efi_mem_count++;
+}
+
+static void efi_mem_remove(struct efi_mem_list *mem)
+{
+	rb_erase_augmented(&mem->node, &efi_mem, &efi_mem_cb);
+	efi_mem_count--;
+	free(mem);
 }
 
-static void efi_mem_sort(void)
+/* Returns the entry with the highest start address below addr */
+static struct efi_mem_list *efi_mem_find_below(uint64_t addr)
 {
-	list_sort(NULL, &efi_mem, efi_mem_cmp);
+	struct rb_node *node = efi_mem.rb_node;
+	struct efi_mem_list *found = NULL;
+
+	while (node) {
+		struct efi_mem_list *mem = efi_mem_entry(node);
+
+		if (mem->desc.physical_start < addr) {
+			found = mem;
+			node = node->rb_right;
+		} else {
+			node = node->rb_left;
+		}
+	}
+
+	return found;
 }
 
 /*
- * Unmaps all memory occupied by the carve_desc region from the
- * list entry pointed to by map.
- *
- * Returns 1 if carving was performed or 0 if the regions don't overlap.
- * Returns -1 if it would affect non-RAM regions but overlap_only_ram is set.
- * Carving is only guaranteed to complete when all regions return 0.
+ * Unmaps all memory in [carve_start, carve_end) from the map entry mem,
+ * which must overlap it. The entry is shrunk, split or removed.
  */
-static int efi_mem_carve_out(struct efi_mem_list *map,
-			     struct efi_mem_desc *carve_desc,
-			     bool overlap_only_ram)
+static void efi_mem_carve_out(struct efi_mem_list *mem, uint64_t carve_start,
+			      uint64_t carve_end)
 {
-	struct efi_mem_list *newmap;
-	struct efi_mem_desc *map_desc = &map->desc;
-	uint64_t map_start = map_desc->physical_start;
-	uint64_t map_end = map_start + (map_desc->num_pages << EFI_PAGE_SHIFT);
-	uint64_t carve_start = carve_desc->physical_start;
-	uint64_t carve_end = carve_start +
-			     (carve_desc->num_pages << EFI_PAGE_SHIFT);
-
-	/* check whether we're overlapping */
-	if ((carve_end <= map_start) || (carve_start >= map_end))
-		return EFI_CARVE_NO_OVERLAP;
-
-	/* We're overlapping with non-RAM, warn the caller if desired */
-	if (overlap_only_ram && (map_desc->type != EFI_CONVENTIONAL_MEMORY))
-		return EFI_CARVE_OVERLAPS_NONRAM;
-
-	/* Sanitize carve_start and carve_end to lie within our bounds */
-	carve_start = max(carve_start, map_start);
-	carve_end = min(carve_end, map_end);
-
-	/* Carving at the beginning of our map? Just move it! */
-	if (carve_start == map_start) {
-		if (map_end == carve_end) {
-			/* Full overlap, just remove map */
-			list_del(&map->link);
-		}
+	struct efi_mem_list *newmem;
+	struct efi_mem_desc *desc = &mem->desc;
+	uint64_t map_start = desc->physical_start;
+	uint64_t map_end = efi_mem_end(mem);
+
+	/* Full overlap, just remove map */
+	if (carve_start <= map_start && carve_end >= map_end) {
+		efi_mem_remove(mem);
+		return;
+	}
 
-		map_desc->physical_start = carve_end;
-		map_desc->num_pages = (map_end - carve_end) >> EFI_PAGE_SHIFT;
-		return (carve_end - carve_start) >> EFI_PAGE_SHIFT;
+	/* Carving in the middle, keep [ carve_end ... map_end ] separately */
+	if (carve_start > map_start && carve_end < map_end) {
+		newmem = calloc(1, sizeof(*newmem));
+		newmem->desc = *desc;
+		newmem->allocated = mem->allocated;
+		newmem->desc.physical_start = carve_end;
+		newmem->desc.virtual_start = carve_end;
+		newmem->desc.num_pages = (map_end - carve_end) >> EFI_PAGE_SHIFT;
+		desc->num_pages = (carve_start - map_start) >> EFI_PAGE_SHIFT;
+		efi_mem_update(mem);
+		efi_mem_insert(newmem);
+		return;
 	}
 
-	/*
-	 * Overlapping maps, just split the list map at carve_start,
-	 * it will get moved or removed in the next iteration.
-	 *
-	 * [ map_desc |__carve_start__| newmap ]
-	 */
+	if (carve_start > map_start) {
+		/* Shrink the map to [ map_start ... carve_start ] */
+		desc->num_pages = (carve_start - map_start) >> EFI_PAGE_SHIFT;
+	} else {
+		/* Move the map to [ carve_end ... map_end ] */
+		desc->physical_start = carve_end;
+		desc->virtual_start = carve_end;
+		desc->num_pages = (map_end - carve_end) >> EFI_PAGE_SHIFT;
+	}
+	efi_mem_update(mem);
+}
 
-	/* Create a new map from [ carve_start ... map_end ] */
-	newmap = calloc(1, sizeof(*newmap));
-	newmap->desc = map->desc;
-	newmap->desc.physical_start = carve_start;
-	newmap->desc.num_pages = (map_end - carve_start) >> EFI_PAGE_SHIFT;
-        list_add_tail(&newmap->link, &efi_mem);
+static bool efi_mem_can_merge(struct efi_mem_list *a, struct efi_mem_list *b)
+{
+	return a && b && a->desc.type == b->desc.type &&
+	       a->desc.attribute == b->desc.attribute &&
+	       a->allocated == b->allocated &&
+	       efi_mem_end(a) == b->desc.physical_start;
+}
 
-	/* Shrink the map to [ map_start ... carve_start ] */
-	map_desc->num_pages = (carve_start - map_start) >> EFI_PAGE_SHIFT;
+/* Joins mem with neighbouring entries of the same kind */
+static void efi_mem_merge(struct efi_mem_list *mem)
+{
+	struct efi_mem_list *prev = efi_mem_entry(rb_prev(&mem->node));
+	struct efi_mem_list *next = efi_mem_entry(rb_next(&mem->node));
+
+	if (efi_mem_can_merge(prev, mem)) {
+		prev->desc.num_pages += mem->desc.num_pages;
+		efi_mem_remove(mem);
+		mem = prev;
+		efi_mem_update(mem);
+	}
 
-	return EFI_CARVE_LOOP_AGAIN;
+	if (efi_mem_can_merge(mem, next)) {
+		mem->desc.num_pages += next->desc.num_pages;
+		efi_mem_remove(next);
+		efi_mem_update(mem);
+	}
 }
 
-uint64_t efi_add_memory_map(uint64_t start, uint64_t pages, int memory_type,
-			    bool overlap_only_ram)
+static uint64_t efi_mem_add(uint64_t start, uint64_t pages, int memory_type,
+			    bool overlap_only_ram, bool allocated)
 {
-	struct list_head *lhandle;
-	struct efi_mem_list *newlist;
-	bool carve_again;
-	uint64_t carved_pages = 0;
+	struct efi_mem_list *newmem, *mem, *prev;
+	uint64_t end = start + (pages << EFI_PAGE_SHIFT);
+	uint64_t carved = 0;
 
 	if (!pages)
 		return start;
 
-	newlist = calloc(1, sizeof(*newlist));
-	newlist->desc.type = memory_type;
-	newlist->desc.physical_start = start;
-	newlist->desc.virtual_start = start;
-	newlist->desc.num_pages = pages;
+	/* Check the overlapping entries before changing anything */
+	if (overlap_only_ram) {
+		for (mem = efi_mem_find_below(end);
+		     mem && efi_mem_end(mem) > start;
+		     mem = efi_mem_entry(rb_prev(&mem->node))) {
+			/*
+			 * The user requested to only have RAM overlaps,
+			 * but we hit a non-RAM region. Error out.
+			 */
+			if (mem->desc.type != EFI_CONVENTIONAL_MEMORY)
+				return 0;
+			carved += min(end, efi_mem_end(mem)) -
+				  max(start, mem->desc.physical_start);
+		}
+
+		/*
+		 * The payload wanted to have RAM overlaps, but we overlapped
+		 * with an unallocated region. Error out.
+		 */
+		if (carved != end - start)
+			return 0;
+	}
+
+	/* Carve the new range out of all overlapping entries */
+	mem = efi_mem_find_below(end);
+	while (mem && efi_mem_end(mem) > start) {
+		prev = efi_mem_entry(rb_prev(&mem->node));
+		efi_mem_carve_out(mem, start, end);
+		mem = prev;
+	}
+
+	newmem = calloc(1, sizeof(*newmem));
+	newmem->desc.type = memory_type;
+	newmem->desc.physical_start = start;
+	newmem->desc.virtual_start = start;
+	newmem->desc.num_pages = pages;
+	newmem->allocated = allocated;
 
 	switch (memory_type) {
 	case EFI_RUNTIME_SERVICES_CODE:
 	case EFI_RUNTIME_SERVICES_DATA:
-		newlist->desc.attribute = (1 << EFI_MEMORY_WB_SHIFT) |
-					  (1ULL << EFI_MEMORY_RUNTIME_SHIFT);
+		newmem->desc.attribute = (1 << EFI_MEMORY_WB_SHIFT) |
+					 (1ULL << EFI_MEMORY_RUNTIME_SHIFT);
 		break;
 	case EFI_MMAP_IO:
-		newlist->desc.attribute = 1ULL << EFI_MEMORY_RUNTIME_SHIFT;
+		newmem->desc.attribute = 1ULL << EFI_MEMORY_RUNTIME_SHIFT;
 		break;
 	default:
-		newlist->desc.attribute = 1 << EFI_MEMORY_WB_SHIFT;
+		newmem->desc.attribute = 1 << EFI_MEMORY_WB_SHIFT;
 		break;
 	}
 
 	/* Add our new map */
-	do {
-		carve_again = false;
-		list_for_each(lhandle, &efi_mem) {
-			struct efi_mem_list *lmem;
-			int r;
-
-			lmem = list_entry(lhandle, struct efi_mem_list, link);
-			r = efi_mem_carve_out(lmem, &newlist->desc,
-					      overlap_only_ram);
-			switch (r) {
-			case EFI_CARVE_OVERLAPS_NONRAM:
-				/*
-				 * The user requested to only have RAM overlaps,
-				 * but we hit a non-RAM region. Error out.
-				 */
-				return 0;
-			case EFI_CARVE_NO_OVERLAP:
-				/* Just ignore this list entry */
-				break;
-			case EFI_CARVE_LOOP_AGAIN:
-				/*
-				 * We split an entry, but need to loop through
-				 * the list again to actually carve it.
-				 */
-				carve_again = true;
-				break;
-			default:
-				/* We carved a number of pages */
-				carved_pages += r;
-				carve_again = true;
-				break;
-			}
-
-			if (carve_again) {
-				/* The list changed, we need to start over */
-				break;
-			}
-		}
-	} while (carve_again);
-
-	if (overlap_only_ram && (carved_pages != pages)) {
-		/*
-		 * The payload wanted to have RAM overlaps, but we overlapped
-		 * with an unallocated region. Error out.
-		 */
-		return 0;
-	}
-
-	/* Add our new map */
-        list_add_tail(&newlist->link, &efi_mem);
-
-	/* And make sure memory is listed in descending order */
-	efi_mem_sort();
+	efi_mem_insert(newmem);
+	efi_mem_merge(newmem);
 
 	return start;
 }
 
-static uint64_t efi_find_free_memory(uint64_t len, uint64_t max_addr)
+uint64_t efi_add_memory_map(uint64_t start, uint64_t pages, int memory_type,
+			    bool overlap_only_ram)
 {
-	struct list_head *lhandle;
-
-	list_for_each(lhandle, &efi_mem) {
-		struct efi_mem_list *lmem = list_entry(lhandle,
-			struct efi_mem_list, link);
-		struct efi_mem_desc *desc = &lmem->desc;
-		uint64_t desc_len = desc->num_pages << EFI_PAGE_SHIFT;
-		uint64_t desc_end = desc->physical_start + desc_len;
-		uint64_t curmax = min(max_addr, desc_end);
-		uint64_t ret = curmax - len;
+	return efi_mem_add(start, pages, memory_type, overlap_only_ram, false);
+}
 
-		/* We only take memory from free RAM */
-		if (desc->type != EFI_CONVENTIONAL_MEMORY)
-			continue;
+/*
+ * Returns the highest page aligned address of a free region of len bytes
+ * ending at or below max_addr, searching the subtree at node. Subtrees
+ * without a large enough free region are skipped.
+ */
+static uint64_t efi_find_free_memory_in(struct rb_node *node, uint64_t len,
+					uint64_t max_addr)
+{
+	struct efi_mem_list *mem = efi_mem_entry(node);
+	struct efi_mem_desc *desc;
+	uint64_t curmax, ret;
 
-		/* Out of bounds for max_addr */
-		if ((ret + len) > max_addr)
-			continue;
+	if (!mem || (mem->max_free_pages << EFI_PAGE_SHIFT) < len)
+		return 0;
+	desc = &mem->desc;
 
-		/* Out of bounds for upper map limit */
-		if ((ret + len) > desc_end)
-			continue;
+	/* Higher addresses first */
+	if (desc->physical_start < max_addr) {
+		ret = efi_find_free_memory_in(node->rb_right, len, max_addr);
+		if (ret)
+			return ret;
+	}
 
-		/* Out of bounds for lower map limit */
-		if (ret < desc->physical_start)
-			continue;
+	/* We only take memory from free RAM */
+	if (desc->type == EFI_CONVENTIONAL_MEMORY) {
+		curmax = min(max_addr, efi_mem_end(mem));
+		ret = (curmax - len) & ~EFI_PAGE_MASK;
 
 		/* Return the highest address in this map within bounds */
-		return ret;
+		if (curmax >= len && ret >= desc->physical_start)
+			return ret;
 	}
 
-	return 0;
+	return efi_find_free_memory_in(node->rb_left, len, max_addr);
+}
+
+static uint64_t efi_find_free_memory(uint64_t len, uint64_t max_addr)
+{
+	return efi_find_free_memory_in(efi_mem.rb_node, len, max_addr);
 }
 
 efi_status_t efi_allocate_pages(int type, int memory_type,
@@ -285,7 +355,7 @@ efi_status_t efi_allocate_pages(int type, int memory_type,
 		uint64_t ret;
 
 		/* Reserve that map in our memory maps */
-		ret = efi_add_memory_map(addr, pages, memory_type, true);
+		ret = efi_mem_add(addr, pages, memory_type, true, true);
 		if (ret == addr) {
 			*memory = addr;
 		} else {
@@ -305,14 +375,153 @@ void *efi_alloc(uint64_t len, int memory_type)
 
 	r = efi_allocate_pages(0, memory_type, pages, &ret);
 	if (r == EFI_SUCCESS)
-		return (void*)(uintptr_t)ret;
+		return map_sysmem(ret, len);
 
 	return NULL;
 }
 
 efi_status_t efi_free_pages(uint64_t memory, unsigned long pages)
 {
-	/* We don't free, let's cross our fingers we have plenty RAM */
+	uint64_t end = memory + ((uint64_t)pages << EFI_PAGE_SHIFT);
+	struct efi_mem_list *mem;
+	uint64_t covered = 0;
+	uint64_t r;
+
+	if (!pages || (memory & EFI_PAGE_MASK) || end <= memory)
+		return EFI_INVALID_PARAMETER;
+
+	/* Only pages from efi_allocate_pages() may be freed */
+	for (mem = efi_mem_find_below(end);
+	     mem && efi_mem_end(mem) > memory;
+	     mem = efi_mem_entry(rb_prev(&mem->node))) {
+		if (!mem->allocated)
+			return EFI_NOT_FOUND;
+		covered += min(end, efi_mem_end(mem)) -
+			   max(memory, mem->desc.physical_start);
+	}
+	if (covered != end - memory)
+		return EFI_NOT_FOUND;
+
+	/* Hand the pages back as free RAM */
+	r = efi_mem_add(memory, pages, EFI_CONVENTIONAL_MEMORY, false, false);
+
+	return (r == memory) ? EFI_SUCCESS : EFI_NOT_FOUND;
+}
+
+/*
+ * Pool allocations up to EFI_POOL_MAX_SIZE are served from free lists
+ * per memory type and power-of-two size class, which are refilled
+ * EFI_POOL_CHUNK_PAGES at a time. Larger ones get pages of their own.
+ * A header in front of each allocation records where it came from.
+ */
+#define EFI_POOL_MIN_SHIFT	5
+#define EFI_POOL_MAX_SHIFT	11
+#define EFI_POOL_MAX_SIZE	(1UL << EFI_POOL_MAX_SHIFT)
+#define EFI_POOL_CLASSES	(EFI_POOL_MAX_SHIFT - EFI_POOL_MIN_SHIFT + 1)
+#define EFI_POOL_CHUNK_PAGES	16
+
+struct efi_pool_header {
+	u32 memory_type;
+	u32 size_class;		/* EFI_POOL_CLASSES for page allocations */
+	u64 pages;		/* Number of pages for page allocations */
+};
+
+struct efi_pool_free {
+	struct efi_pool_free *next;
+};
+
+static struct efi_pool_free *efi_pool[EFI_MAX_MEMORY_TYPE][EFI_POOL_CLASSES];
+
+static int efi_pool_class(unsigned long size)
+{
+	int class = 0;
+
+	while ((1UL << (class + EFI_POOL_MIN_SHIFT)) < size)
+		class++;
+
+	return class;
+}
+
+static efi_status_t efi_pool_refill(int pool_type, int class)
+{
+	unsigned long obj_size = 1UL << (class + EFI_POOL_MIN_SHIFT);
+	unsigned long len = EFI_POOL_CHUNK_PAGES << EFI_PAGE_SHIFT;
+	struct efi_pool_free *obj;
+	uint64_t addr;
+	efi_status_t r;
+	unsigned long i;
+
+	r = efi_allocate_pages(0, pool_type, EFI_POOL_CHUNK_PAGES, &addr);
+	if (r != EFI_SUCCESS)
+		return r;
+
+	for (i = 0; i < len; i += obj_size) {
+		obj = map_sysmem(addr + i, obj_size);
+		obj->next = efi_pool[pool_type][class];
+		efi_pool[pool_type][class] = obj;
+	}
+
+	return EFI_SUCCESS;
+}
+
+efi_status_t efi_allocate_pool(int pool_type, unsigned long size,
+			       void **buffer)
+{
+	struct efi_pool_header *hdr;
+	unsigned long total = size + sizeof(*hdr);
+	uint64_t addr, pages;
+	efi_status_t r;
+	int class;
+
+	if (pool_type < 0 || pool_type >= EFI_MAX_MEMORY_TYPE || !buffer)
+		return EFI_INVALID_PARAMETER;
+
+	if (total > EFI_POOL_MAX_SIZE) {
+		pages = (total + EFI_PAGE_MASK) >> EFI_PAGE_SHIFT;
+		r = efi_allocate_pages(0, pool_type, pages, &addr);
+		if (r != EFI_SUCCESS)
+			return r;
+		hdr = map_sysmem(addr, total);
+		hdr->size_class = EFI_POOL_CLASSES;
+		hdr->pages = pages;
+	} else {
+		class = efi_pool_class(total);
+		if (!efi_pool[pool_type][class]) {
+			r = efi_pool_refill(pool_type, class);
+			if (r != EFI_SUCCESS)
+				return r;
+		}
+		hdr = (void *)efi_pool[pool_type][class];
+		efi_pool[pool_type][class] = efi_pool[pool_type][class]->next;
+		hdr->size_class = class;
+		hdr->pages = 0;
+	}
+	hdr->memory_type = pool_type;
+	*buffer = hdr + 1;
+
+	return EFI_SUCCESS;
+}
+
+efi_status_t efi_free_pool(void *buffer)
+{
+	struct efi_pool_header *hdr;
+	struct efi_pool_free *obj;
+
+	if (!buffer)
+		return EFI_INVALID_PARAMETER;
+
+	hdr = (struct efi_pool_header *)buffer - 1;
+	if (hdr->memory_type >= EFI_MAX_MEMORY_TYPE ||
+	    hdr->size_class > EFI_POOL_CLASSES)
+		return EFI_INVALID_PARAMETER;
+
+	if (hdr->size_class == EFI_POOL_CLASSES)
+		return efi_free_pages(map_to_sysmem(hdr), hdr->pages);
+
+	obj = (struct efi_pool_free *)hdr;
+	obj->next = efi_pool[hdr->memory_type][hdr->size_class];
+	efi_pool[hdr->memory_type][hdr->size_class] = obj;
+
 	return EFI_SUCCESS;
 }
 
@@ -323,11 +532,8 @@ efi_status_t efi_get_memory_map(unsigned long *memory_map_size,
 			       uint32_t *descriptor_version)
 {
 	ulong map_size = 0;
-	int map_entries = 0;
-	struct list_head *lhandle;
-
-	list_for_each(lhandle, &efi_mem)
-		map_entries++;
+	int map_entries = efi_mem_count;
+	struct rb_node *node;
 
 	map_size = map_entries * sizeof(struct efi_mem_desc);
 
@@ -339,17 +545,10 @@ efi_status_t efi_get_memory_map(unsigned long *memory_map_size,
 	if (*memory_map_size < map_size)
 		return EFI_BUFFER_TOO_SMALL;
 
-	/* Copy list into array */
+	/* Copy tree into array, in ascending order */
 	if (memory_map) {
-		/* Return the list in ascending order */
-		memory_map = &memory_map[map_entries - 1];
-		list_for_each(lhandle, &efi_mem) {
-			struct efi_mem_list *lmem;
-
-			lmem = list_entry(lhandle, struct efi_mem_list, link);
-			*memory_map = lmem->desc;
-			memory_map--;
-		}
+		for (node = rb_first(&efi_mem); node; node = rb_next(node))
+			*memory_map++ = efi_mem_entry(node)->desc;
 	}
 
 	return EFI_SUCCESS;
@@ -357,7 +556,6 @@ efi_status_t efi_get_memory_map(unsigned long *memory_map_size,
 
 int efi_memory_init(void)
 {
-	unsigned long runtime_start, runtime_end, runtime_pages;
 	unsigned long uboot_start, uboot_pages;
 	unsigned long uboot_stack_size = 16 * 1024 * 1024;
 	int i;
@@ -378,13 +576,17 @@ int efi_memory_init(void)
 	uboot_pages = (gd->ram_top - uboot_start) >> EFI_PAGE_SHIFT;
 	efi_add_memory_map(uboot_start, uboot_pages, EFI_LOADER_DATA, false);
 
-	/* Add Runtime Services */
+#ifdef CONFIG_EFI_LOADER
+	/* Add Runtime Services, sandbox has no such section */
+	unsigned long runtime_start, runtime_end, runtime_pages;
+
 	runtime_start = (ulong)&__efi_runtime_start & ~EFI_PAGE_MASK;
 	runtime_end = (ulong)&__efi_runtime_stop;
 	runtime_end = (runtime_end + EFI_PAGE_MASK) & ~EFI_PAGE_MASK;
 	runtime_pages = (runtime_end - runtime_start) >> EFI_PAGE_SHIFT;
 	efi_add_memory_map(runtime_start, runtime_pages,
 			   EFI_RUNTIME_SERVICES_CODE, false);
+#endif
 
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 	/* Request a 32bit 64MB bounce buffer region */
@@ -778,7 +778,7 @@ int himport_r(struct hsearch_data *htab,
 		const char *env, size_t size, const char sep, int flag,
 		int crlf_is_lf, int nvars, char * const vars[])
 {
-	char *data, *sp, *dp, *name, *value;
+	char *data, *copy, *sp, *dp, *name, *value;
 	char *localvars[nvars];
 	int i;
 
@@ -788,14 +788,25 @@ int himport_r(struct hsearch_data *htab,
 		return 0;
 	}
 
-	/* we allocate new space to make sure we can write to the array */
-	if ((data = malloc(size + 1)) == NULL) {
-		debug("himport_r: can't malloc %zu bytes\n", size + 1);
-		__set_errno(ENOMEM);
-		return 0;
+	/*
+	 * We need to write to the array, so parse a copy unless the caller
+	 * lets us change theirs. That also needs it to be terminated, since
+	 * we cannot add the '\0' ourselves.
+	 */
+	if ((flag & H_INPLACE) && size && !env[size - 1]) {
+		copy = NULL;
+		data = (char *)env;
+	} else {
+		copy = malloc(size + 1);
+		if (!copy) {
+			debug("himport_r: can't malloc %zu bytes\n", size + 1);
+			__set_errno(ENOMEM);
+			return 0;
+		}
+		memcpy(copy, env, size);
+		copy[size] = '\0';
+		data = copy;
 	}
-	memcpy(data, env, size);
-	data[size] = '\0';
 	dp = data;
 
 	/* make a local copy of the list of variables */
@@ -837,13 +848,13 @@ int himport_r(struct hsearch_data *htab,
 		debug("Create Hash Table: N=%d\n", nent);
 
 		if (hcreate_r(nent, htab) == 0) {
-			free(data);
+			free(copy);
 			return 0;
 		}
 	}
 
 	if (!size) {
-		free(data);
+		free(copy);
 		return 1;		/* everything OK */
 	}
 	if(crlf_is_lf) {
@@ -909,7 +920,7 @@ int himport_r(struct hsearch_data *htab,
 		if (*name == 0) {
 			debug("INSERT: unable to use an empty key\n");
 			__set_errno(EINVAL);
-			free(data);
+			free(copy);
 			return 0;
 		}
 
@@ -931,8 +942,8 @@ int himport_r(struct hsearch_data *htab,
 			rv, name, value);
 	} while ((dp < data + size) && *dp);	/* size check needed for text */
 						/* without '\0' termination */
-	debug("INSERT: free(data = %p)\n", data);
-	free(data);
+	debug("INSERT: free(data = %p)\n", copy);
+	free(copy);
 
 	/* process variables which were not considered */
 	for (i = 0; i < nvars; i++) {
@@ -9,6 +9,7 @@
 
 #include <common.h>
 #include <lmb.h>
+#include <malloc.h>
 
 #define LMB_ALLOC_ANYWHERE	0
 
@@ -41,135 +42,152 @@ void lmb_dump_all(struct lmb *lmb)
 #endif /* DEBUG */
 }
 
-static long lmb_addrs_overlap(phys_addr_t base1,
-		phys_size_t size1, phys_addr_t base2, phys_size_t size2)
+/*
+ * Regions are kept sorted by base address and never overlap or touch each
+ * other, so both their bases and their ends are ascending and can be
+ * searched with a binary search.
+ */
+static inline phys_addr_t lmb_region_end(struct lmb_region *rgn,
+					 unsigned long r)
 {
-	return ((base1 < (base2+size2)) && (base2 < (base1+size1)));
+	return rgn->region[r].base + rgn->region[r].size;
 }
 
-static long lmb_addrs_adjacent(phys_addr_t base1, phys_size_t size1,
-		phys_addr_t base2, phys_size_t size2)
+/* Returns the index of the first region which ends after addr */
+static unsigned long lmb_find_end_after(struct lmb_region *rgn,
+					phys_addr_t addr)
 {
-	if (base2 == base1 + size1)
-		return 1;
-	else if (base1 == base2 + size2)
+	unsigned long lo = 0, hi = rgn->cnt, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (lmb_region_end(rgn, mid) > addr)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	return lo;
+}
+
+/* Returns the index of the first region which starts after addr */
+static unsigned long lmb_find_base_after(struct lmb_region *rgn,
+					 phys_addr_t addr)
+{
+	unsigned long lo = 0, hi = rgn->cnt, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (rgn->region[mid].base > addr)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	return lo;
+}
+
+/* Makes room for at least one more region, allocating a larger table */
+static long lmb_grow_region(struct lmb_region *rgn)
+{
+	struct lmb_property *region;
+	unsigned long max;
+
+	if (rgn->cnt < rgn->max)
+		return 0;
+
+	max = rgn->max * 2;
+	region = malloc(max * sizeof(*region));
+	if (!region)
 		return -1;
+	memcpy(region, rgn->region, rgn->cnt * sizeof(*region));
+	if (rgn->region != rgn->initial)
+		free(rgn->region);
+	rgn->region = region;
+	rgn->max = max;
 
 	return 0;
 }
 
-static long lmb_regions_adjacent(struct lmb_region *rgn,
-		unsigned long r1, unsigned long r2)
+static long lmb_insert_region(struct lmb_region *rgn, unsigned long r,
+			      phys_addr_t base, phys_size_t size)
 {
-	phys_addr_t base1 = rgn->region[r1].base;
-	phys_size_t size1 = rgn->region[r1].size;
-	phys_addr_t base2 = rgn->region[r2].base;
-	phys_size_t size2 = rgn->region[r2].size;
+	if (lmb_grow_region(rgn) < 0)
+		return -1;
+
+	memmove(&rgn->region[r + 1], &rgn->region[r],
+		(rgn->cnt - r) * sizeof(*rgn->region));
+	rgn->region[r].base = base;
+	rgn->region[r].size = size;
+	rgn->cnt++;
 
-	return lmb_addrs_adjacent(base1, size1, base2, size2);
+	return 0;
 }
 
-static void lmb_remove_region(struct lmb_region *rgn, unsigned long r)
+static void lmb_remove_regions(struct lmb_region *rgn, unsigned long r,
+			       unsigned long count)
 {
-	unsigned long i;
-
-	for (i = r; i < rgn->cnt - 1; i++) {
-		rgn->region[i].base = rgn->region[i + 1].base;
-		rgn->region[i].size = rgn->region[i + 1].size;
-	}
-	rgn->cnt--;
+	memmove(&rgn->region[r], &rgn->region[r + count],
+		(rgn->cnt - r - count) * sizeof(*rgn->region));
+	rgn->cnt -= count;
 }
 
-/* Assumption: base addr of region 1 < base addr of region 2 */
-static void lmb_coalesce_regions(struct lmb_region *rgn,
-		unsigned long r1, unsigned long r2)
+static void lmb_init_region(struct lmb_region *rgn)
 {
-	rgn->region[r1].size += rgn->region[r2].size;
-	lmb_remove_region(rgn, r2);
+	rgn->region = rgn->initial;
+	rgn->max = ARRAY_SIZE(rgn->initial);
+	rgn->cnt = 0;
+	rgn->size = 0;
 }
 
 void lmb_init(struct lmb *lmb)
 {
-	/* Create a dummy zero size LMB which will get coalesced away later.
-	 * This simplifies the lmb_add() code below...
-	 */
-	lmb->memory.region[0].base = 0;
-	lmb->memory.region[0].size = 0;
-	lmb->memory.cnt = 1;
-	lmb->memory.size = 0;
-
-	/* Ditto. */
-	lmb->reserved.region[0].base = 0;
-	lmb->reserved.region[0].size = 0;
-	lmb->reserved.cnt = 1;
-	lmb->reserved.size = 0;
+	lmb_init_region(&lmb->memory);
+	lmb_init_region(&lmb->reserved);
 }
 
-/* This routine called with relocation disabled. */
-static long lmb_add_region(struct lmb_region *rgn, phys_addr_t base, phys_size_t size)
+static void lmb_release_region(struct lmb_region *rgn)
 {
-	unsigned long coalesced = 0;
-	long adjacent, i;
-
-	if ((rgn->cnt == 1) && (rgn->region[0].size == 0)) {
-		rgn->region[0].base = base;
-		rgn->region[0].size = size;
-		return 0;
-	}
+	if (rgn->region && rgn->region != rgn->initial)
+		free(rgn->region);
+	rgn->region = NULL;
+}
 
-	/* First try and coalesce this LMB with another. */
-	for (i=0; i < rgn->cnt; i++) {
-		phys_addr_t rgnbase = rgn->region[i].base;
-		phys_size_t rgnsize = rgn->region[i].size;
-
-		if ((rgnbase == base) && (rgnsize == size))
-			/* Already have this region, so we're done */
-			return 0;
-
-		adjacent = lmb_addrs_adjacent(base,size,rgnbase,rgnsize);
-		if ( adjacent > 0 ) {
-			rgn->region[i].base -= size;
-			rgn->region[i].size += size;
-			coalesced++;
-			break;
-		}
-		else if ( adjacent < 0 ) {
-			rgn->region[i].size += size;
-			coalesced++;
-			break;
-		}
-	}
+void lmb_release(struct lmb *lmb)
+{
+	lmb_release_region(&lmb->memory);
+	lmb_release_region(&lmb->reserved);
+}
 
-	if ((i < rgn->cnt-1) && lmb_regions_adjacent(rgn, i, i+1) ) {
-		lmb_coalesce_regions(rgn, i, i+1);
-		coalesced++;
-	}
+/*
+ * Adds a region, merging it with all regions it overlaps or touches.
+ * Returns the number of regions it was merged with, or -1 if there was
+ * no memory to store it.
+ */
+static long lmb_add_region(struct lmb_region *rgn, phys_addr_t base, phys_size_t size)
+{
+	phys_addr_t end = base + size;
+	unsigned long first, last;
 
-	if (coalesced)
-		return coalesced;
-	if (rgn->cnt >= MAX_LMB_REGIONS)
-		return -1;
+	if (!size)
+		return 0;
 
-	/* Couldn't coalesce the LMB, so add it to the sorted table. */
-	for (i = rgn->cnt-1; i >= 0; i--) {
-		if (base < rgn->region[i].base) {
-			rgn->region[i+1].base = rgn->region[i].base;
-			rgn->region[i+1].size = rgn->region[i].size;
-		} else {
-			rgn->region[i+1].base = base;
-			rgn->region[i+1].size = size;
-			break;
-		}
-	}
+	/* Regions [first, last) overlap or are adjacent to the new one */
+	first = lmb_find_end_after(rgn, base);
+	if (first && lmb_region_end(rgn, first - 1) == base)
+		first--;
+	last = lmb_find_base_after(rgn, end);
 
-	if (base < rgn->region[0].base) {
-		rgn->region[0].base = base;
-		rgn->region[0].size = size;
-	}
+	if (first == last)
+		return lmb_insert_region(rgn, first, base, size);
 
-	rgn->cnt++;
+	base = min(base, rgn->region[first].base);
+	end = max(end, lmb_region_end(rgn, last - 1));
+	rgn->region[first].base = base;
+	rgn->region[first].size = end - base;
+	lmb_remove_regions(rgn, first + 1, last - first - 1);
 
-	return 0;
+	return last - first;
 }
 
 /* This routine may be called with relocation disabled. */
@@ -185,26 +203,23 @@ long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 	struct lmb_region *rgn = &(lmb->reserved);
 	phys_addr_t rgnbegin, rgnend;
 	phys_addr_t end = base + size;
-	int i;
-
-	rgnbegin = rgnend = 0; /* supress gcc warnings */
+	unsigned long i;
 
 	/* Find the region where (base, size) belongs to */
-	for (i=0; i < rgn->cnt; i++) {
-		rgnbegin = rgn->region[i].base;
-		rgnend = rgnbegin + rgn->region[i].size;
-
-		if ((rgnbegin <= base) && (end <= rgnend))
-			break;
-	}
+	i = lmb_find_base_after(rgn, base);
+	if (!i)
+		return -1;
+	i--;
+	rgnbegin = rgn->region[i].base;
+	rgnend = lmb_region_end(rgn, i);
 
 	/* Didn't find the region */
-	if (i == rgn->cnt)
+	if (end > rgnend)
 		return -1;
 
 	/* Check to see if we are removing entire region */
 	if ((rgnbegin == base) && (rgnend == end)) {
-		lmb_remove_region(rgn, i);
+		lmb_remove_regions(rgn, i, 1);
 		return 0;
 	}
 
@@ -225,8 +240,11 @@ long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 	 * We need to split the entry -  adjust the current one to the
 	 * beginging of the hole and add the region after hole.
 	 */
-	rgn->region[i].size = base - rgn->region[i].base;
-	return lmb_add_region(rgn, end, rgnend - end);
+	if (lmb_insert_region(rgn, i + 1, end, rgnend - end) < 0)
+		return -1;
+	rgn->region[i].size = base - rgnbegin;
+
+	return 0;
 }
 
 long lmb_reserve(struct lmb *lmb, phys_addr_t base, phys_size_t size)
@@ -241,15 +259,11 @@ static long lmb_overlaps_region(struct lmb_region *rgn, phys_addr_t base,
 {
 	unsigned long i;
 
-	for (i=0; i < rgn->cnt; i++) {
-		phys_addr_t rgnbase = rgn->region[i].base;
-		phys_size_t rgnsize = rgn->region[i].size;
-		if ( lmb_addrs_overlap(base,size,rgnbase,rgnsize) ) {
-			break;
-		}
-	}
+	i = lmb_find_end_after(rgn, base);
+	if (i < rgn->cnt && rgn->region[i].base < base + size)
+		return i;
 
-	return (i < rgn->cnt) ? i : -1;
+	return -1;
 }
 
 phys_addr_t lmb_alloc(struct lmb *lmb, phys_size_t size, ulong align)
@@ -280,59 +294,64 @@ static phys_addr_t lmb_align_up(phys_addr_t addr, ulong size)
 	return (addr + (size - 1)) & ~(size - 1);
 }
 
+/*
+ * Allocations are placed as high as possible below max_addr. The free
+ * gaps of each memory region are visited from the top down, using the
+ * sorted reserved regions, so each reserved region is looked at at most
+ * once.
+ */
 phys_addr_t __lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align, phys_addr_t max_addr)
 {
+	struct lmb_region *res = &lmb->reserved;
+	phys_addr_t lmbbase, top, bottom, base;
 	long i, j;
-	phys_addr_t base = 0;
-	phys_addr_t res_base;
 
-	for (i = lmb->memory.cnt-1; i >= 0; i--) {
-		phys_addr_t lmbbase = lmb->memory.region[i].base;
-		phys_size_t lmbsize = lmb->memory.region[i].size;
+	for (i = lmb->memory.cnt - 1; i >= 0; i--) {
+		lmbbase = lmb->memory.region[i].base;
+		top = lmb_region_end(&lmb->memory, i);
+		if (top < lmbbase)
+			top = -1;
 
-		if (lmbsize < size)
-			continue;
-		if (max_addr == LMB_ALLOC_ANYWHERE)
-			base = lmb_align_down(lmbbase + lmbsize - size, align);
-		else if (lmbbase < max_addr) {
-			base = lmbbase + lmbsize;
-			if (base < lmbbase)
-				base = -1;
-			base = min(base, max_addr);
-			base = lmb_align_down(base - size, align);
-		} else
+		if (lmb->memory.region[i].size < size)
 			continue;
+		if (max_addr != LMB_ALLOC_ANYWHERE) {
+			if (lmbbase >= max_addr)
+				continue;
+			top = min(top, max_addr);
+		}
 
-		while (base && lmbbase <= base) {
-			j = lmb_overlaps_region(&lmb->reserved, base, size);
-			if (j < 0) {
-				/* This area isn't reserved, take it */
-				if (lmb_add_region(&lmb->reserved, base,
-							lmb_align_up(size,
-								align)) < 0)
+		/* Last reserved region starting below the top of the gap */
+		j = (long)lmb_find_base_after(res, top - 1) - 1;
+		while (top > lmbbase) {
+			bottom = lmbbase;
+			if (j >= 0 && lmb_region_end(res, j) > bottom)
+				bottom = lmb_region_end(res, j);
+
+			if (top >= bottom + size) {
+				base = lmb_align_down(top - size, align);
+				if (!base)
 					return 0;
-				return base;
+				if (base >= bottom) {
+					if (lmb_add_region(res, base,
+							   lmb_align_up(size,
+								align)) < 0)
+						return 0;
+					return base;
+				}
 			}
-			res_base = lmb->reserved.region[j].base;
-			if (res_base < size)
+
+			if (j < 0)
 				break;
-			base = lmb_align_down(res_base - size, align);
+			top = res->region[j--].base;
 		}
 	}
+
 	return 0;
 }
 
 int lmb_is_reserved(struct lmb *lmb, phys_addr_t addr)
 {
-	int i;
-
-	for (i = 0; i < lmb->reserved.cnt; i++) {
-		phys_addr_t upper = lmb->reserved.region[i].base +
-			lmb->reserved.region[i].size - 1;
-		if ((addr >= lmb->reserved.region[i].base) && (addr <= upper))
-			return 1;
-	}
-	return 0;
+	return lmb_overlaps_region(&lmb->reserved, addr, 1) >= 0;
 }
 
 __weak void board_lmb_reserve(struct lmb *lmb)
@@ -16,6 +16,9 @@ static cmd_tbl_t cmd_ut_sub[] = {
 #if defined(CONFIG_UT_DM)
 	U_BOOT_CMD_MKENT(dm, CONFIG_SYS_MAXARGS, 1, do_ut_dm, "", ""),
 #endif
+#if defined(CONFIG_UT_EFI)
+	U_BOOT_CMD_MKENT(efi, CONFIG_SYS_MAXARGS, 1, do_ut_efi, "", ""),
+#endif
 #if defined(CONFIG_UT_ENV)
 	U_BOOT_CMD_MKENT(env, CONFIG_SYS_MAXARGS, 1, do_ut_env, "", ""),
 #endif
@@ -65,6 +68,9 @@ static char ut_help_text[] =
 #ifdef CONFIG_UT_DM
 	"ut dm [test-name]\n"
 #endif
+#ifdef CONFIG_UT_EFI
+	"ut efi [test-name]\n"
+#endif
 #ifdef CONFIG_UT_ENV
 	"ut env [test-name]\n"
 #endif
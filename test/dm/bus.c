@@ -520,3 +520,54 @@ static int dm_test_bus_child_pre_probe_uclass(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_bus_child_pre_probe_uclass,
 	DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(DM_DEVICE_ARENA)
+/* Check that a pointer lies within a device's arena */
+static bool in_arena(struct udevice *dev, void *ptr)
+{
+	char *arena = dev->arena;
+
+	return ptr && (char *)ptr >= arena &&
+		(char *)ptr < arena + dev->arena_size;
+}
+
+/* Test that the data for a child is carved from its arena */
+static int dm_test_bus_arena(struct unit_test_state *uts)
+{
+	struct dm_test_parent_data *parent_data;
+	struct dm_test_priv *priv;
+	struct udevice *bus, *dev;
+
+	ut_assertok(uclass_get_device(UCLASS_TEST_BUS, 0, &bus));
+	ut_assertok(device_find_child_by_seq(bus, 0, true, &dev));
+	ut_assertnonnull(dev->arena);
+	ut_assert(in_arena(dev, dev_get_platdata(dev)));
+	ut_assert(in_arena(dev, dev_get_parent_platdata(dev)));
+
+	ut_assertok(device_probe(dev));
+	priv = dev_get_priv(dev);
+	parent_data = dev_get_parent_priv(dev);
+	ut_assert(in_arena(dev, priv));
+	ut_assert(in_arena(dev, parent_data));
+	ut_assert(priv != (void *)parent_data);
+
+	/* The private data is cleared each time the device is probed */
+	priv->ping_total = 1234;
+	parent_data->sum = 5;
+	ut_assertok(device_remove(dev));
+	ut_asserteq_ptr(NULL, dev_get_priv(dev));
+	ut_asserteq_ptr(NULL, dev_get_parent_priv(dev));
+	ut_assertok(device_probe(dev));
+	ut_asserteq_ptr(priv, dev_get_priv(dev));
+	ut_asserteq_ptr(parent_data, dev_get_parent_priv(dev));
+	ut_asserteq(DM_TEST_START_TOTAL, priv->ping_total);
+	ut_asserteq(0, parent_data->sum);
+
+	/* Platform data is kept until the device is unbound */
+	ut_asserteq(1, ((struct dm_test_parent_platdata *)
+			dev_get_parent_platdata(dev))->bind_flag);
+
+	return 0;
+}
+DM_TEST(dm_test_bus_arena, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+#endif
@@ -786,6 +786,153 @@ static int dm_test_uclass_devices_get_by_name(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_uclass_devices_get_by_name, DM_TESTF_SCAN_FDT);
 
+#define HASH_TEST_COUNT		100
+#define HASH_BENCH_COUNT	500
+
+/* Test finding devices in a uclass with many devices */
+static int dm_test_uclass_hash(struct unit_test_state *uts)
+{
+	struct dm_test_state *dms = uts->priv;
+	struct udevice *dev[HASH_TEST_COUNT], *found;
+	char name[20];
+	int i, seq;
+
+	dms->skip_post_probe = 1;
+	ut_assertok(create_children(uts, dms->root, HASH_TEST_COUNT, 0, dev));
+
+	/* Drivers may change these after the device is bound */
+	for (i = 0; i < HASH_TEST_COUNT; i++) {
+		if (i == 3 || i == 4)
+			strcpy(name, "dup");
+		else
+			sprintf(name, "hash%d", i);
+		ut_assertok(device_set_name(dev[i], name));
+		if (i % 2)
+			dev[i]->req_seq = 1000 + i;
+	}
+#if CONFIG_IS_ENABLED(DM_UCLASS_HASH)
+	ut_assertnonnull(dev[0]->uclass->hash);
+#endif
+
+	for (i = 0; i < HASH_TEST_COUNT; i++) {
+		if (i == 3 || i == 4)
+			continue;
+		sprintf(name, "hash%d", i);
+		ut_assertok(uclass_find_device_by_name(UCLASS_TEST, name,
+						       &found));
+		ut_asserteq_ptr(dev[i], found);
+	}
+
+	/* The first of several devices with a name is found */
+	ut_assertok(uclass_find_device_by_name(UCLASS_TEST, "dup", &found));
+	ut_asserteq_ptr(dev[3], found);
+
+	/* An exact match is preferred over a longer name which starts alike */
+	ut_assertok(uclass_find_device_by_name(UCLASS_TEST, "hash1", &found));
+	ut_asserteq_ptr(dev[1], found);
+	ut_assertok(uclass_find_device_by_name(UCLASS_TEST, "hash", &found));
+	ut_asserteq_ptr(dev[0], found);
+	ut_asserteq(-ENODEV, uclass_find_device_by_name(UCLASS_TEST, "nosuch",
+							&found));
+
+	ut_assertok(uclass_find_device_by_seq(UCLASS_TEST, 1021, true, &found));
+	ut_asserteq_ptr(dev[21], found);
+	ut_asserteq(-ENODEV, uclass_find_device_by_seq(UCLASS_TEST, 1020, true,
+						       &found));
+
+	/* Sequence numbers are allocated and indexed on probe */
+	ut_asserteq(-ENODEV, uclass_find_device_by_seq(UCLASS_TEST, 0, false,
+						       &found));
+	for (i = 0; i < HASH_TEST_COUNT; i++)
+		ut_assertok(device_probe(dev[i]));
+	for (i = 0; i < HASH_TEST_COUNT; i++) {
+		ut_assert(dev[i]->seq != -1);
+		ut_assertok(uclass_find_device_by_seq(UCLASS_TEST, dev[i]->seq,
+						      false, &found));
+		ut_asserteq_ptr(dev[i], found);
+	}
+
+	/* And dropped on remove */
+	seq = dev[5]->seq;
+	ut_assertok(device_remove(dev[5]));
+	ut_asserteq(-ENODEV, uclass_find_device_by_seq(UCLASS_TEST, seq, false,
+						       &found));
+	ut_assertok(device_probe(dev[5]));
+	ut_assertok(uclass_find_device_by_seq(UCLASS_TEST, dev[5]->seq, false,
+					      &found));
+	ut_asserteq_ptr(dev[5], found);
+
+	/* Unbound devices cannot be found */
+	seq = dev[7]->seq;
+	ut_assertok(device_remove(dev[7]));
+	ut_assertok(device_unbind(dev[7]));
+	ut_asserteq(-ENODEV, uclass_find_device_by_seq(UCLASS_TEST, seq, false,
+						       &found));
+	ut_asserteq(-ENODEV, uclass_find_device_by_seq(UCLASS_TEST, 1007, true,
+						       &found));
+	ut_assertok(uclass_find_device_by_name(UCLASS_TEST, "hash7", &found));
+	ut_asserteq_ptr(dev[70], found);
+
+	/* Device tree nodes */
+	for (i = 0; i < HASH_TEST_COUNT; i += 10)
+		dev[i]->of_offset = 0x1000 + i;
+	ut_assertok(uclass_find_device_by_of_offset(UCLASS_TEST, 0x1000 + 90,
+						    &found));
+	ut_asserteq_ptr(dev[90], found);
+	ut_asserteq(-ENODEV, uclass_find_device_by_of_offset(UCLASS_TEST,
+							     0x1000 + 91,
+							     &found));
+	for (i = 0; i < HASH_TEST_COUNT; i += 10)
+		dev[i]->of_offset = -1;
+
+	return 0;
+}
+DM_TEST(dm_test_uclass_hash, 0);
+
+/* Measure the time taken to find devices in a large uclass */
+static int dm_test_uclass_hash_bench(struct unit_test_state *uts)
+{
+	struct dm_test_state *dms = uts->priv;
+	struct udevice *dev[HASH_BENCH_COUNT], *found;
+	ulong start, elapsed;
+	char name[20];
+	int i;
+
+	dms->skip_post_probe = 1;
+	ut_assertok(create_children(uts, dms->root, HASH_BENCH_COUNT, 0, dev));
+	for (i = 0; i < HASH_BENCH_COUNT; i++) {
+		sprintf(name, "bench%d", i);
+		ut_assertok(device_set_name(dev[i], name));
+	}
+
+	start = timer_get_us();
+	for (i = 0; i < HASH_BENCH_COUNT; i++)
+		ut_assertok(device_probe(dev[i]));
+	elapsed = timer_get_us() - start;
+	printf("%d devices: probe %7lu us", HASH_BENCH_COUNT, elapsed);
+
+	start = timer_get_us();
+	for (i = 0; i < HASH_BENCH_COUNT; i++) {
+		ut_assertok(uclass_find_device_by_seq(UCLASS_TEST, dev[i]->seq,
+						      false, &found));
+		ut_asserteq_ptr(dev[i], found);
+	}
+	elapsed = timer_get_us() - start;
+	printf(", by seq %7lu us", elapsed);
+
+	start = timer_get_us();
+	for (i = 0; i < HASH_BENCH_COUNT; i++) {
+		ut_assertok(uclass_find_device_by_name(UCLASS_TEST,
+						       dev[i]->name, &found));
+		ut_asserteq_ptr(dev[i], found);
+	}
+	elapsed = timer_get_us() - start;
+	printf(", by name %7lu us\n", elapsed);
+
+	return 0;
+}
+DM_TEST(dm_test_uclass_hash_bench, 0);
+
 static int dm_test_device_get_uclass_id(struct unit_test_state *uts)
 {
 	struct udevice *dev;
@@ -0,0 +1,226 @@
+/*
+ * Tests for copying DT nodes and properties from the boot loader's DT
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <fdt_edit.h>
+#include <fdtdec.h>
+#include <libfdt.h>
+#include <malloc.h>
+#include <dm/test.h>
+#include <test/ut.h>
+
+#define DT_EDIT_TEST_SIZE	0x4000
+
+static const char *const dt_edit_test_vars[] = {
+	"fdt_copy_src_addr",
+	"fdt_del_node_paths",
+	"fdt_del_prop_paths",
+	"fdt_copy_node_paths",
+	"fdt_copy_prop_paths",
+};
+
+/* Add a node with a string property, returning its offset */
+static int dt_edit_test_node(void *blob, int parent, const char *name,
+			     const char *prop, const char *val)
+{
+	int ofs;
+
+	ofs = fdt_add_subnode(blob, parent, name);
+	if (ofs >= 0 && prop)
+		fdt_setprop_string(blob, ofs, prop, val);
+
+	return ofs;
+}
+
+/* Create a DT like the one cboot passes to U-Boot on Tegra186 */
+static void *dt_edit_test_src(void)
+{
+	const u8 mac[] = { 0x00, 0x04, 0x4b, 0x8c, 0xa1, 0x12 };
+	void *blob;
+	int ofs;
+
+	blob = malloc(DT_EDIT_TEST_SIZE);
+	if (!blob || fdt_create_empty_tree(blob, DT_EDIT_TEST_SIZE))
+		return NULL;
+
+	fdt_setprop_string(blob, 0, "serial-number", "0421017050386");
+	ofs = dt_edit_test_node(blob, 0, "chosen", "bootargs",
+				"console=ttyS0,115200 root=/dev/mmcblk0p1");
+	fdt_setprop_u32(blob, ofs, "nvidia,bootloader-version", 0x1c);
+	ofs = dt_edit_test_node(blob, ofs, "plugin-manager", NULL, NULL);
+	ofs = dt_edit_test_node(blob, ofs, "odm-data", "android-build",
+				"no");
+	fdt_setprop_u32(blob, ofs, "enable-pcie-on-uphy-lane0", 1);
+
+	ofs = dt_edit_test_node(blob, 0, "memory@80000000", "device_type",
+				"memory");
+	fdt_setprop_u64(blob, ofs, "reg", 0x80000000);
+	fdt_appendprop_u64(blob, ofs, "reg", 0x1f0000000ULL);
+
+	ofs = dt_edit_test_node(blob, 0, "reserved-memory", NULL, NULL);
+	dt_edit_test_node(blob, ofs, "ramoops_carveout", "compatible",
+			  "nvidia,ramoops");
+	dt_edit_test_node(blob, ofs, "vpr-carveout", "compatible",
+			  "nvidia,vpr-carveout");
+
+	dt_edit_test_node(blob, 0, "bpmp", "compatible", "nvidia,tegra186-bpmp");
+	ofs = dt_edit_test_node(blob, 0, "ethernet@2490000", "status", "okay");
+	fdt_setprop(blob, ofs, "mac-address", mac, sizeof(mac));
+	fdt_pack(blob);
+
+	return blob;
+}
+
+/* Create the kernel's DT, which has some of the same nodes */
+static void *dt_edit_test_dst(void)
+{
+	void *blob;
+	int ofs;
+
+	blob = malloc(DT_EDIT_TEST_SIZE);
+	if (!blob || fdt_create_empty_tree(blob, DT_EDIT_TEST_SIZE))
+		return NULL;
+
+	ofs = dt_edit_test_node(blob, 0, "chosen", "bootargs", "");
+	fdt_setprop_u32(blob, ofs, "linux,initrd-start", 0x85000000);
+	ofs = dt_edit_test_node(blob, 0, "reserved-memory", NULL, NULL);
+	dt_edit_test_node(blob, ofs, "ramoops_carveout", "status", "okay");
+	dt_edit_test_node(blob, 0, "bpmp", "status", "disabled");
+	dt_edit_test_node(blob, 0, "ethernet@2490000", "status", "okay");
+	dt_edit_test_node(blob, 0, "pcie@10003000", "status", "okay");
+	fdt_pack(blob);
+
+	return blob;
+}
+
+static void dt_edit_test_setenv(void *src, const char *del_nodes,
+				const char *del_props, const char *copy_nodes,
+				const char *copy_props)
+{
+	char addr[20];
+
+	snprintf(addr, sizeof(addr), "%lx", (ulong)src);
+	setenv(dt_edit_test_vars[0], addr);
+	setenv(dt_edit_test_vars[1], del_nodes);
+	setenv(dt_edit_test_vars[2], del_props);
+	setenv(dt_edit_test_vars[3], copy_nodes);
+	setenv(dt_edit_test_vars[4], copy_props);
+}
+
+static void dt_edit_test_cleanup(void *src, void *dst)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(dt_edit_test_vars); i++)
+		setenv(dt_edit_test_vars[i], NULL);
+	free(src);
+	free(dst);
+}
+
+/* Test applying all the edits in one pass */
+static int dm_test_dt_edit(struct unit_test_state *uts)
+{
+	const void *prop;
+	void *src, *dst;
+	int ofs, len;
+
+	src = dt_edit_test_src();
+	dst = dt_edit_test_dst();
+	ut_assertnonnull(src);
+	ut_assertnonnull(dst);
+	dt_edit_test_setenv(src,
+			    "/reserved-memory/ramoops_carveout:/no-such-node",
+			    "/chosen/linux,initrd-start:/no-such-node/prop",
+			    "/chosen:/reserved-memory:/memory@80000000:/bpmp",
+			    "/serial-number:/ethernet@2490000/mac-address");
+
+	ut_assertok(fdt_edit_env_all(dst));
+	ut_assertok(fdt_check_header(dst));
+
+	/* Deleted before the copies, so the source's copy is used */
+	ofs = fdt_path_offset(dst, "/reserved-memory/ramoops_carveout");
+	ut_assert(ofs >= 0);
+	ut_asserteq_str("nvidia,ramoops",
+			fdt_getprop(dst, ofs, "compatible", NULL));
+	ut_asserteq_ptr(NULL, fdt_getprop(dst, ofs, "status", NULL));
+	ut_assert(fdt_path_offset(dst, "/reserved-memory/vpr-carveout") >= 0);
+
+	/* Copied recursively, with the deleted property gone */
+	ofs = fdt_path_offset(dst, "/chosen");
+	ut_asserteq_str("console=ttyS0,115200 root=/dev/mmcblk0p1",
+			fdt_getprop(dst, ofs, "bootargs", NULL));
+	ut_asserteq_ptr(NULL,
+			fdt_getprop(dst, ofs, "linux,initrd-start", NULL));
+	ofs = fdt_path_offset(dst, "/chosen/plugin-manager/odm-data");
+	ut_asserteq(1, fdtdec_get_int(dst, ofs, "enable-pcie-on-uphy-lane0",
+				      0));
+
+	/* Created in the destination */
+	ofs = fdt_path_offset(dst, "/memory@80000000");
+	ut_assert(ofs >= 0);
+	prop = fdt_getprop(dst, ofs, "reg", &len);
+	ut_asserteq(16, len);
+	ut_assert(fdt64_to_cpu(((fdt64_t *)prop)[1]) == 0x1f0000000ULL);
+
+	/* Disabled in the destination, so not copied */
+	ofs = fdt_path_offset(dst, "/bpmp");
+	ut_asserteq_ptr(NULL, fdt_getprop(dst, ofs, "compatible", NULL));
+
+	/* Properties */
+	ut_asserteq_str("0421017050386",
+			fdt_getprop(dst, 0, "serial-number", NULL));
+	ofs = fdt_path_offset(dst, "/ethernet@2490000");
+	prop = fdt_getprop(dst, ofs, "mac-address", &len);
+	ut_asserteq(6, len);
+	ut_asserteq(0x12, ((u8 *)prop)[5]);
+	ut_assert(fdt_path_offset(dst, "/pcie@10003000") >= 0);
+
+	dt_edit_test_cleanup(src, dst);
+
+	return 0;
+}
+DM_TEST(dm_test_dt_edit, 0);
+
+/* Test that an error stops its own list but not the others */
+static int dm_test_dt_edit_error(struct unit_test_state *uts)
+{
+	void *src, *dst;
+	int ofs;
+
+	src = dt_edit_test_src();
+	dst = dt_edit_test_dst();
+	ut_assertnonnull(src);
+	ut_assertnonnull(dst);
+	dt_edit_test_setenv(src, "/pcie@10003000", NULL, "/chosen",
+			    "/no-such-prop:/serial-number");
+
+	ut_asserteq(-1, fdt_edit_env_all(dst));
+	ut_assertok(fdt_check_header(dst));
+	ut_asserteq(-FDT_ERR_NOTFOUND, fdt_path_offset(dst, "/pcie@10003000"));
+	ofs = fdt_path_offset(dst, "/chosen");
+	ut_assertnonnull(fdt_getprop(dst, ofs, "nvidia,bootloader-version",
+				     NULL));
+	ut_asserteq_ptr(NULL, fdt_getprop(dst, 0, "serial-number", NULL));
+
+	/* The separate functions give the same result */
+	free(dst);
+	dst = dt_edit_test_dst();
+	ut_assertnonnull(dst);
+	ut_assertok(fdt_del_env_nodelist(dst));
+	ut_assertok(fdt_del_env_proplist(dst));
+	ut_assertok(fdt_copy_env_nodelist(dst));
+	ut_asserteq(-1, fdt_copy_env_proplist(dst));
+	ut_asserteq(-FDT_ERR_NOTFOUND, fdt_path_offset(dst, "/pcie@10003000"));
+	ofs = fdt_path_offset(dst, "/chosen");
+	ut_assertnonnull(fdt_getprop(dst, ofs, "nvidia,bootloader-version",
+				     NULL));
+
+	dt_edit_test_cleanup(src, dst);
+
+	return 0;
+}
+DM_TEST(dm_test_dt_edit_error, 0);
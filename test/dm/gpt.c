@@ -0,0 +1,135 @@
+/*
+ * Tests for looking up GPT partitions
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <dm.h>
+#include <os.h>
+#include <part.h>
+#include <sandboxblockdev.h>
+#include <dm/test.h>
+#include <test/ut.h>
+
+#define GPT_TEST_FILE		"/tmp/gpt_test.img"
+#define GPT_TEST_BLKS		1024
+#define GPT_TEST_PARTS		32
+#define GPT_TEST_DISK_GUID	"375a56f7-d6c9-4e81-b5f0-09d41ca89efe"
+
+/* Write a GPT with GPT_TEST_PARTS partitions, the last @dups named "dup" */
+static int gpt_test_write(struct unit_test_state *uts, struct blk_desc *desc,
+			  const char *prefix, int dups)
+{
+	disk_partition_t parts[GPT_TEST_PARTS];
+	int i;
+
+	memset(parts, '\0', sizeof(parts));
+	for (i = 0; i < GPT_TEST_PARTS; i++) {
+		if (i >= GPT_TEST_PARTS - dups)
+			strcpy((char *)parts[i].name, "dup");
+		else
+			sprintf((char *)parts[i].name, "%s%d", prefix, i);
+		parts[i].size = 16;
+		sprintf(parts[i].uuid, "%08x-0000-4000-8000-00000000000%d", i,
+			dups);
+	}
+	ut_assertok(gpt_restore(desc, GPT_TEST_DISK_GUID, parts,
+				GPT_TEST_PARTS));
+	part_init(desc);
+	ut_asserteq(PART_TYPE_EFI, desc->part_type);
+
+	return 0;
+}
+
+/* Check that the GPT on @desc is read once and invalidated by a write */
+static int gpt_test_cache(struct unit_test_state *uts, struct blk_desc *desc)
+{
+	struct host_block_dev *host_dev = dev_get_priv(desc->bdev);
+	disk_partition_t info, first;
+	char name[32], blk[512];
+	int i;
+
+	ut_assertok(gpt_test_write(uts, desc, "part", 2));
+
+	/* The header and the entries are read once, for the first lookup */
+	host_dev->read_count = 0;
+	ut_assertok(part_get_info_efi_by_name(desc, "part0", &first));
+	ut_asserteq(2, host_dev->read_count);
+	ut_asserteq(34, first.start);
+	ut_asserteq(16, first.size);
+
+	for (i = 1; i < GPT_TEST_PARTS - 2; i++) {
+		sprintf(name, "part%d", i);
+		ut_assertok(part_get_info_efi_by_name(desc, name, &info));
+		ut_asserteq(34 + i * 16, info.start);
+		ut_asserteq_str(name, (char *)info.name);
+	}
+	ut_assertok(part_get_info(desc, GPT_TEST_PARTS, &info));
+	ut_asserteq(-1, part_get_info(desc, GPT_TEST_PARTS + 1, &info));
+	ut_asserteq(-1, part_get_info_efi_by_name(desc, "nosuch", &info));
+
+	/* The first of two partitions with the same name is found */
+	ut_assertok(part_get_info_efi_by_name(desc, "dup", &info));
+	ut_asserteq(34 + (GPT_TEST_PARTS - 2) * 16, info.start);
+
+	/* Partitions can be found by the GUID in their info */
+	ut_assertok(part_get_info_efi_by_uuid(desc, first.uuid, &info));
+	ut_asserteq(first.start, info.start);
+	ut_assertok(part_get_info(desc, 8, &info));
+	ut_assertok(part_get_info_efi_by_uuid(desc, info.uuid, &info));
+	ut_asserteq(34 + 7 * 16, info.start);
+	ut_asserteq(-1, part_get_info_efi_by_uuid(desc,
+			"00000000-0000-0000-0000-000000000000", &info));
+	ut_asserteq(-EINVAL, part_get_info_efi_by_uuid(desc, "bad", &info));
+	ut_asserteq(2, host_dev->read_count);
+
+	/* Writing a new table drops the old one */
+	ut_assertok(gpt_test_write(uts, desc, "new", 0));
+	host_dev->read_count = 0;
+	ut_asserteq(-1, part_get_info_efi_by_name(desc, "part0", &info));
+	ut_asserteq(-1, part_get_info_efi_by_name(desc, "dup", &info));
+	ut_asserteq(-1, part_get_info_efi_by_uuid(desc, first.uuid, &info));
+	ut_assertok(part_get_info_efi_by_name(desc, "new31", &info));
+	ut_asserteq(34 + 31 * 16, info.start);
+	ut_asserteq(2, host_dev->read_count);
+
+	/* So does any other write to the device */
+	memset(blk, '\0', sizeof(blk));
+	ut_asserteq(1, blk_dwrite(desc, GPT_TEST_BLKS - 40, 1, blk));
+	ut_assertok(part_get_info_efi_by_name(desc, "new0", &info));
+	ut_asserteq(4, host_dev->read_count);
+
+	return 0;
+}
+
+/* Test the GPT cache on a host device, removing its file on any failure */
+static int dm_test_gpt_cache(struct unit_test_state *uts)
+{
+	struct blk_desc *desc;
+	char blk[512];
+	int fd, i, ret;
+
+	fd = os_open(GPT_TEST_FILE, OS_O_RDWR | OS_O_CREAT);
+	ut_assert(fd >= 0);
+	memset(blk, '\0', sizeof(blk));
+	for (i = 0; i < GPT_TEST_BLKS; i++) {
+		if (os_write(fd, blk, sizeof(blk)) != sizeof(blk))
+			break;
+	}
+	os_close(fd);
+	ret = -EIO;
+	if (i == GPT_TEST_BLKS)
+		ret = host_dev_bind(0, GPT_TEST_FILE);
+	if (!ret && blk_get_device_by_str("host", "0", &desc) < 0)
+		ret = -ENODEV;
+	if (!ret)
+		ret = gpt_test_cache(uts, desc);
+	host_dev_bind(0, NULL);
+	os_unlink(GPT_TEST_FILE);
+	ut_assertok(ret);
+
+	return 0;
+}
+DM_TEST(dm_test_gpt_cache, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
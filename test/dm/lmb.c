@@ -0,0 +1,159 @@
+/*
+ * Tests for the logical memory block allocator
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <lmb.h>
+#include <dm/test.h>
+#include <test/ut.h>
+
+static int check_region(struct unit_test_state *uts, struct lmb_region *rgn,
+			unsigned long r, phys_addr_t base, phys_size_t size)
+{
+	ut_assert(r < rgn->cnt);
+	ut_asserteq(base, rgn->region[r].base);
+	ut_asserteq(size, rgn->region[r].size);
+
+	return 0;
+}
+
+/* Test that overlapping and adjacent regions are coalesced */
+static int dm_test_lmb_coalesce(struct unit_test_state *uts)
+{
+	struct lmb lmb;
+
+	lmb_init(&lmb);
+	ut_asserteq(0, lmb_reserve(&lmb, 0x1000, 0x1000));
+	ut_asserteq(0, lmb_reserve(&lmb, 0x4000, 0x1000));
+	ut_asserteq(0, lmb_reserve(&lmb, 0x8000, 0x1000));
+	ut_asserteq(3, lmb.reserved.cnt);
+
+	/* Adjacent on both sides joins three regions */
+	ut_asserteq(2, lmb_reserve(&lmb, 0x2000, 0x2000));
+	ut_asserteq(2, lmb.reserved.cnt);
+	ut_assertok(check_region(uts, &lmb.reserved, 0, 0x1000, 0x4000));
+
+	/* Overlapping a region at the front and one at the end */
+	ut_asserteq(2, lmb_reserve(&lmb, 0x4800, 0x4000));
+	ut_asserteq(1, lmb.reserved.cnt);
+	ut_assertok(check_region(uts, &lmb.reserved, 0, 0x1000, 0x8000));
+
+	/* Contained and identical regions change nothing */
+	ut_asserteq(1, lmb_reserve(&lmb, 0x2000, 0x100));
+	ut_asserteq(1, lmb_reserve(&lmb, 0x1000, 0x8000));
+	ut_asserteq(1, lmb.reserved.cnt);
+	ut_assertok(check_region(uts, &lmb.reserved, 0, 0x1000, 0x8000));
+
+	/* Freeing splits, trims and removes regions */
+	ut_asserteq(0, lmb_free(&lmb, 0x3000, 0x1000));
+	ut_asserteq(2, lmb.reserved.cnt);
+	ut_assertok(check_region(uts, &lmb.reserved, 0, 0x1000, 0x2000));
+	ut_assertok(check_region(uts, &lmb.reserved, 1, 0x4000, 0x5000));
+	ut_asserteq(0, lmb_free(&lmb, 0x1000, 0x1000));
+	ut_asserteq(0, lmb_free(&lmb, 0x8000, 0x1000));
+	ut_assertok(check_region(uts, &lmb.reserved, 0, 0x2000, 0x1000));
+	ut_assertok(check_region(uts, &lmb.reserved, 1, 0x4000, 0x4000));
+	ut_asserteq(0, lmb_free(&lmb, 0x2000, 0x1000));
+	ut_asserteq(1, lmb.reserved.cnt);
+	ut_asserteq(-1, lmb_free(&lmb, 0x7000, 0x2000));
+	ut_asserteq(-1, lmb_free(&lmb, 0x1000, 0x1000));
+
+	ut_asserteq(0, lmb_is_reserved(&lmb, 0x3fff));
+	ut_asserteq(1, lmb_is_reserved(&lmb, 0x4000));
+	ut_asserteq(1, lmb_is_reserved(&lmb, 0x7fff));
+	ut_asserteq(0, lmb_is_reserved(&lmb, 0x8000));
+	lmb_release(&lmb);
+
+	return 0;
+}
+DM_TEST(dm_test_lmb_coalesce, 0);
+
+/* Test that the region tables grow beyond MAX_LMB_REGIONS */
+static int dm_test_lmb_many(struct unit_test_state *uts)
+{
+	const int count = MAX_LMB_REGIONS * 8;
+	struct lmb lmb;
+	int i;
+
+	lmb_init(&lmb);
+	ut_asserteq(0, lmb_add(&lmb, 0x10000000, 0x10000000));
+
+	/* Reserve every other page, in reverse order */
+	for (i = count - 1; i >= 0; i--) {
+		ut_asserteq(0, lmb_reserve(&lmb, 0x10000000 + i * 0x2000,
+					   0x1000));
+	}
+	ut_asserteq(count, lmb.reserved.cnt);
+	for (i = 0; i < count; i++) {
+		ut_assertok(check_region(uts, &lmb.reserved, i,
+					 0x10000000 + i * 0x2000, 0x1000));
+	}
+
+	/* A page-sized allocation fits in the top gap */
+	ut_asserteq(0x1ffff000, lmb_alloc(&lmb, 0x1000, 0x1000));
+
+	/* Filling the holes joins everything into one region again */
+	for (i = 0; i < count; i++) {
+		ut_assert(lmb_reserve(&lmb, 0x10001000 + i * 0x2000,
+				      0x1000) > 0);
+	}
+	ut_asserteq(2, lmb.reserved.cnt);
+	ut_assertok(check_region(uts, &lmb.reserved, 0, 0x10000000,
+				 count * 0x2000));
+	lmb_release(&lmb);
+
+	return 0;
+}
+DM_TEST(dm_test_lmb_many, 0);
+
+/* Test allocation alignment and the max_addr limit */
+static int dm_test_lmb_alloc(struct unit_test_state *uts)
+{
+	struct lmb lmb;
+	phys_addr_t addr;
+
+	lmb_init(&lmb);
+	ut_asserteq(0, lmb_add(&lmb, 0x40000000, 0x1000000));
+	ut_asserteq(0, lmb_add(&lmb, 0x80000000, 0x100000));
+
+	/* Allocations come from the top of the highest memory region */
+	addr = lmb_alloc(&lmb, 0x1234, 0x1000);
+	ut_asserteq(0x800fe000, addr);
+	ut_assertok(check_region(uts, &lmb.reserved, 0, 0x800fe000, 0x2000));
+
+	/* The next one is placed below it, aligned down, and merged */
+	addr = lmb_alloc(&lmb, 0x100, 0x10000);
+	ut_asserteq(0x800f0000, addr);
+	ut_assertok(check_region(uts, &lmb.reserved, 0, 0x800f0000, 0x10000));
+	ut_asserteq(1, lmb.reserved.cnt);
+
+	/* Too large for the upper region, so the lower one is used */
+	addr = lmb_alloc(&lmb, 0x200000, 0x100000);
+	ut_asserteq(0x40e00000, addr);
+
+	/* max_addr is honoured, also when it lies inside a region */
+	addr = lmb_alloc_base(&lmb, 0x1000, 0x1000, 0x40800000);
+	ut_asserteq(0x407ff000, addr);
+	addr = lmb_alloc_base(&lmb, 0x1000, 0x1000, 0x80000000);
+	ut_asserteq(0x40dff000, addr);
+
+	/* An allocation which cannot fit anywhere fails */
+	ut_asserteq(0, __lmb_alloc_base(&lmb, 0x1000000, 0x1000, 0));
+	ut_asserteq(0, __lmb_alloc_base(&lmb, 0x1000, 0x1000, 0x40000000));
+
+	/* A gap between two reservations is found */
+	ut_asserteq(0, lmb_free(&lmb, 0x407ff000, 0x1000));
+	ut_asserteq(0, lmb_reserve(&lmb, 0x40000000, 0x7ff000));
+	ut_asserteq(1, lmb_reserve(&lmb, 0x40800000, 0x5ff000));
+	addr = __lmb_alloc_base(&lmb, 0x800, 0x800, 0x40e00000);
+	ut_asserteq(0x407ff800, addr);
+	addr = __lmb_alloc_base(&lmb, 0x1000, 0x1000, 0x40e00000);
+	ut_asserteq(0, addr);
+	lmb_release(&lmb);
+
+	return 0;
+}
+DM_TEST(dm_test_lmb_alloc, 0);
@@ -0,0 +1,249 @@
+/*
+ * Tests for malloc_simple() and the slab front end of malloc()
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <dm/test.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define SIMPLE_TEST_SIZE	0x200
+/* Free RAM for the area used before relocation, away from the heap */
+#define SIMPLE_TEST_ADDR	0x200000
+
+/* Point malloc_simple() at a buffer of SIMPLE_TEST_SIZE bytes */
+static void simple_test_setup(void *buf)
+{
+	gd->malloc_base = map_to_sysmem(buf);
+	gd->malloc_limit = SIMPLE_TEST_SIZE;
+	gd->malloc_ptr = 0;
+	gd->malloc_peak = 0;
+	gd->malloc_free_list = 0;
+	gd->malloc_count = 0;
+}
+
+static int simple_test(struct unit_test_state *uts)
+{
+	char *ptr[SIMPLE_TEST_SIZE / 16];
+	char *a, *b, *c;
+	int count, i;
+
+	/* Freed blocks are reused */
+	a = malloc_simple(20);
+	b = malloc_simple(40);
+	c = malloc_simple(20);
+	ut_assertnonnull(c);
+	ut_asserteq(3, gd->malloc_count);
+	ut_asserteq(24, malloc_simple_usable_size(a));
+	ut_asserteq(40, malloc_simple_usable_size(b));
+	free_simple(a);
+	ut_asserteq_ptr(a, malloc_simple(16));
+
+	/* A large block is split, and the rest used for the next */
+	free_simple(b);
+	ut_asserteq_ptr(b, malloc_simple(8));
+	ut_asserteq(8, malloc_simple_usable_size(b));
+	ut_asserteq_ptr(b + 16, malloc_simple(24));
+
+	/* Freeing the last block gives back its space */
+	free_simple(c);
+	ut_asserteq(c - 8 - (char *)map_sysmem(gd->malloc_base, 0),
+		    gd->malloc_ptr);
+	ut_asserteq_ptr(c, malloc_simple(20));
+	ut_asserteq(4, gd->malloc_count);
+
+	/* Growing a block moves it, keeping its contents */
+	strcpy(c, "simple");
+	ut_asserteq_ptr(c, realloc_simple(c, 24));
+	a = realloc_simple(c, 100);
+	ut_assertnonnull(a);
+	ut_asserteq_str("simple", a);
+
+	a = memalign_simple(64, 10);
+	ut_assertnonnull(a);
+	ut_asserteq(0, map_to_sysmem(a) & 63);
+	free_simple(a);
+	free_simple(NULL);
+	free_simple(&count);
+
+	/* Run out of space, then free everything and use it all again */
+	for (count = 0; count < ARRAY_SIZE(ptr); count++) {
+		ptr[count] = malloc_simple(16);
+		if (!ptr[count])
+			break;
+	}
+	ut_assert(count > 0 && count < ARRAY_SIZE(ptr));
+	ut_assert(gd->malloc_ptr <= gd->malloc_limit);
+	ut_assert(gd->malloc_peak > gd->malloc_limit);
+	for (i = 0; i < count; i++)
+		free_simple(ptr[i]);
+	ut_asserteq(4, gd->malloc_count);
+
+	return 0;
+}
+
+/*
+ * Check that after relocation free() leaves a block from before relocation
+ * alone, and that realloc() copies it into the heap
+ */
+static int simple_test_reloc(struct unit_test_state *uts, void *early,
+			     void *copy)
+{
+	char *mem, *moved;
+
+	simple_test_setup(early);
+	mem = malloc_simple(16);
+	ut_assertnonnull(mem);
+	strcpy(mem, "early");
+	memcpy(copy, early, SIMPLE_TEST_SIZE);
+
+	ut_asserteq(16, malloc_usable_size(mem));
+	free(mem);
+	ut_assertok(memcmp(copy, early, SIMPLE_TEST_SIZE));
+	ut_asserteq(1, gd->malloc_count);
+
+	moved = realloc(mem, 200);
+	ut_assertnonnull(moved);
+	ut_asserteq(0, malloc_simple_usable_size(moved));
+	ut_asserteq_str("early", moved);
+	ut_assertok(memcmp(copy, early, SIMPLE_TEST_SIZE));
+	ut_asserteq(1, gd->malloc_count);
+	free(moved);
+
+	return 0;
+}
+
+/* Test that malloc_simple() reuses freed memory and recovers when full */
+static int dm_test_malloc_simple(struct unit_test_state *uts)
+{
+	ulong base = gd->malloc_base, limit = gd->malloc_limit;
+	ulong ptr = gd->malloc_ptr, peak = gd->malloc_peak;
+	ulong free_list = gd->malloc_free_list;
+	uint count = gd->malloc_count;
+	void *buf, *early;
+	int ret;
+
+	/* The area used as if before relocation must be outside the heap */
+	early = map_sysmem(SIMPLE_TEST_ADDR, SIMPLE_TEST_SIZE);
+	ut_assert((ulong)early + SIMPLE_TEST_SIZE <= mem_malloc_start ||
+		  (ulong)early >= mem_malloc_end);
+
+	/* Use memory which map_sysmem() can reach */
+	buf = malloc(SIMPLE_TEST_SIZE);
+	ut_assertnonnull(buf);
+	simple_test_setup(buf);
+	ret = simple_test(uts);
+	if (!ret)
+		ret = simple_test_reloc(uts, early, buf);
+
+	gd->malloc_base = base;
+	gd->malloc_limit = limit;
+	gd->malloc_ptr = ptr;
+	gd->malloc_peak = peak;
+	gd->malloc_free_list = free_list;
+	gd->malloc_count = count;
+	free(buf);
+	ut_assertok(ret);
+
+	return 0;
+}
+DM_TEST(dm_test_malloc_simple, 0);
+
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+/* Test that small allocations come from the slab and behave as before */
+static int dm_test_malloc_slab(struct unit_test_state *uts)
+{
+	struct malloc_stats before, after;
+	char *ptr, *big, *aligned;
+	int i;
+
+	malloc_get_stats(&before);
+
+	/* Requests are rounded up to the size of their class */
+	ptr = malloc(20);
+	ut_assertnonnull(ptr);
+	ut_asserteq(32, malloc_slab_size(ptr));
+	ut_asserteq(32, malloc_usable_size(ptr));
+
+	/* A freed object is reused, and cleared by calloc() */
+	memset(ptr, '\xff', 20);
+	free(ptr);
+	ptr = calloc(1, 24);
+	ut_assertnonnull(ptr);
+	for (i = 0; i < 32; i++)
+		ut_asserteq(0, ptr[i]);
+
+	/* Growing within the class keeps the object, else it is moved */
+	strcpy(ptr, "slab");
+	ut_asserteq_ptr(ptr, realloc(ptr, 30));
+	big = realloc(ptr, 1000);
+	ut_assertnonnull(big);
+	ut_asserteq(0, malloc_slab_size(big));
+	ut_asserteq_str("slab", big);
+	ptr = realloc(big, 100);
+	ut_assertnonnull(ptr);
+	ut_asserteq_str("slab", ptr);
+
+	/* Larger and aligned allocations come from the heap */
+	big = malloc(MALLOC_SLAB_MAX + 1);
+	ut_assertnonnull(big);
+	ut_asserteq(0, malloc_slab_size(big));
+	aligned = memalign(64, 32);
+	ut_assertnonnull(aligned);
+	ut_asserteq(0, (ulong)aligned & 63);
+	ut_asserteq(0, malloc_slab_size(aligned));
+
+	free(aligned);
+	free(big);
+	free(ptr);
+	malloc_get_stats(&after);
+	ut_asserteq(before.in_use, after.in_use);
+	ut_asserteq(before.allocs, after.allocs);
+
+	return 0;
+}
+DM_TEST(dm_test_malloc_slab, 0);
+
+/* Test that the heap statistics count slab objects */
+static int dm_test_malloc_stats(struct unit_test_state *uts)
+{
+	struct malloc_stats before, stats;
+	struct malloc_slab_stats slab;
+	void *ptr[100];
+	int i;
+
+	malloc_get_stats(&before);
+	ut_assert(before.total >= before.in_use + before.free);
+	ut_assert(before.largest_free <= before.free);
+
+	for (i = 0; i < ARRAY_SIZE(ptr); i++) {
+		ptr[i] = malloc(64);
+		ut_assertnonnull(ptr[i]);
+	}
+	malloc_get_stats(&stats);
+	ut_asserteq(before.allocs + ARRAY_SIZE(ptr), stats.allocs);
+	ut_assert(stats.in_use >= before.in_use + ARRAY_SIZE(ptr) * 64);
+
+	ut_assertok(malloc_slab_get_stats(3, &slab));
+	ut_asserteq(64, slab.size);
+	ut_assert(slab.objects >= ARRAY_SIZE(ptr));
+	ut_assert(slab.pages >= 2);
+	ut_asserteq(-ENOENT, malloc_slab_get_stats(-1, &slab));
+	ut_asserteq(-ENOENT, malloc_slab_get_stats(8, &slab));
+
+	for (i = 0; i < ARRAY_SIZE(ptr); i++)
+		free(ptr[i]);
+	malloc_get_stats(&stats);
+	ut_asserteq(before.allocs, stats.allocs);
+	ut_asserteq(before.in_use, stats.in_use);
+
+	return 0;
+}
+DM_TEST(dm_test_malloc_stats, 0);
+#endif
@@ -0,0 +1,60 @@
+/*
+ * Tests for the serial uclass
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <serial.h>
+#include <asm/test.h>
+#include <dm/test.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Test that console output is buffered while the uart is busy */
+static int dm_test_serial_tx_buffer(struct unit_test_state *uts)
+{
+	struct serial_dev_priv *upriv;
+	struct udevice *dev, *old;
+	uint queued, polled, flushed;
+
+	ut_assertok(uclass_get_device(UCLASS_SERIAL, 0, &dev));
+	upriv = dev_get_uclass_priv(dev);
+	ut_assertnonnull(upriv->tx_buf);
+	sandbox_serial_get_tx_count(dev);
+
+	/*
+	 * With the FIFO full, writing returns at once. Polling for input
+	 * sends what the FIFO has room for and flushing sends the rest.
+	 */
+	old = gd->cur_serial_dev;
+	gd->cur_serial_dev = dev;
+	sandbox_serial_set_tx_space(dev, 0);
+	serial_puts("buffered\n");
+	queued = sandbox_serial_get_tx_count(dev);
+	sandbox_serial_set_tx_space(dev, 3);
+	serial_tstc();
+	polled = sandbox_serial_get_tx_count(dev);
+	sandbox_serial_set_tx_space(dev, -1);
+	serial_flush();
+	flushed = sandbox_serial_get_tx_count(dev);
+	gd->cur_serial_dev = old;
+
+	ut_asserteq(0, queued);
+	ut_asserteq(3, polled);
+	ut_asserteq(strlen("buffered\r\n") - 3, flushed);
+	ut_asserteq(upriv->tx_head, upriv->tx_tail);
+
+	/* Flushing reports dropped output once */
+	gd->cur_serial_dev = dev;
+	upriv->tx_dropped = 5;
+	serial_flush();
+	gd->cur_serial_dev = old;
+	ut_asserteq(0, upriv->tx_dropped);
+	ut_asserteq(upriv->tx_head, upriv->tx_tail);
+
+	return 0;
+}
+DM_TEST(dm_test_serial_tx_buffer, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
@@ -7,11 +7,18 @@
 #include <common.h>
 #include <dm.h>
 #include <fdtdec.h>
+#include <malloc.h>
+#include <os.h>
 #include <spi.h>
 #include <spi_flash.h>
 #include <asm/state.h>
+#include <asm/test.h>
+#include <dm/device-internal.h>
+#include <dm/lists.h>
+#include <dm/root.h>
 #include <dm/test.h>
 #include <dm/util.h>
+#include <linux/sizes.h>
 #include <test/ut.h>
 
 /* Test that sandbox SPI flash works correctly */
@@ -41,3 +48,66 @@ static int dm_test_spi_flash(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_spi_flash, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#define SF_BULK_FILE	"/tmp/spi-bulk.bin"
+#define SF_BULK_SPEC	"W25Q256:" SF_BULK_FILE
+#define SF_BULK_OFFSET	(SZ_16M - 0x10000)
+#define SF_BULK_LEN	0x20000
+
+/* Test that a quad read across the 16MiB mark is done in one transfer */
+static int dm_test_spi_flash_bulk(struct unit_test_state *uts)
+{
+	struct sandbox_state *state = state_get_current();
+	struct dm_spi_slave_platdata *plat;
+	struct sandbox_sf_stats stats;
+	struct udevice *bus, *dev;
+	u8 *buf, *expect;
+	int fd, i;
+
+	/* A sparse backing file with a pattern where the read will be */
+	expect = malloc(SF_BULK_LEN);
+	buf = malloc(SF_BULK_LEN);
+	ut_assertnonnull(expect);
+	ut_assertnonnull(buf);
+	for (i = 0; i < SF_BULK_LEN; i++)
+		expect[i] = i ^ (i >> 8) ^ (i >> 16);
+	fd = os_open(SF_BULK_FILE, OS_O_RDWR | OS_O_CREAT);
+	ut_assert(fd >= 0);
+	ut_assert(os_lseek(fd, SF_BULK_OFFSET, OS_SEEK_SET) >= 0);
+	ut_asserteq(SF_BULK_LEN, os_write(fd, expect, SF_BULK_LEN));
+	os_close(fd);
+
+	/* A quad-capable controller with a 32MiB flash on chip select 0 */
+	ut_assertok(device_bind_driver(dm_root(), "spi_sandbox", "spi-bulk",
+				       &bus));
+	ut_assertok(device_probe(bus));
+	ut_assertok(device_bind_driver(bus, "spi_flash_std", "W25Q256", &dev));
+	plat = dev_get_parent_platdata(dev);
+	plat->mode_rx = SPI_RX_QUAD;
+	state->spi[bus->seq][0].spec = SF_BULK_SPEC;
+	ut_assertok(sandbox_sf_bind_emul(state, bus->seq, 0, bus, -1,
+					 SF_BULK_SPEC));
+	ut_assertok(device_probe(dev));
+
+	ut_assertok(spi_flash_read_dm(dev, SF_BULK_OFFSET, SF_BULK_LEN, buf));
+	ut_assertok(memcmp(expect, buf, SF_BULK_LEN));
+	sandbox_sf_get_stats(state->spi[bus->seq][0].emul, &stats);
+	ut_asserteq(1, stats.bulk_reads);
+	ut_asserteq(SF_BULK_LEN, stats.bulk_bytes);
+	ut_asserteq(0x6c, stats.bulk_opcode);
+
+	/* Unwritten parts of the flash read as erased */
+	ut_assertok(spi_flash_read_dm(dev, SZ_32M - 0x100, 0x100, buf));
+	for (i = 0; i < 0x100; i++)
+		ut_asserteq(0xff, buf[i]);
+	ut_assert(spi_flash_read_dm(dev, SZ_32M - 0x100, 0x101, buf));
+
+	sandbox_sf_unbind_emul(state, bus->seq, 0);
+	state->spi[bus->seq][0].spec = NULL;
+	os_unlink(SF_BULK_FILE);
+	free(buf);
+	free(expect);
+
+	return 0;
+}
+DM_TEST(dm_test_spi_flash_bulk, 0);
@@ -0,0 +1,324 @@
+/*
+ * Tests for writing Android sparse images
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <dm.h>
+#include <image-sparse.h>
+#include <malloc.h>
+#include <os.h>
+#include <sandboxblockdev.h>
+#include <dm/test.h>
+#include <test/ut.h>
+
+#define SPARSE_TEST_FILE	"sparse_test.img"
+#define SPARSE_TEST_BLKS	64
+#define SPARSE_TEST_ERASE_GRP	4
+
+struct sparse_test_priv {
+	struct blk_desc *desc;
+	int writes;
+	int erases;
+	lbaint_t erased;
+	const char *mssg;
+};
+
+static struct sparse_test_priv *sparse_test;
+
+static lbaint_t sparse_test_write(struct sparse_storage *info, lbaint_t blk,
+				  lbaint_t blkcnt, const void *buffer)
+{
+	struct sparse_test_priv *priv = info->priv;
+
+	priv->writes++;
+
+	return blk_dwrite(priv->desc, blk, blkcnt, buffer);
+}
+
+static lbaint_t sparse_test_reserve(struct sparse_storage *info, lbaint_t blk,
+				    lbaint_t blkcnt)
+{
+	return blkcnt;
+}
+
+/* The host device cannot erase, so write the erased value instead */
+static lbaint_t sparse_test_erase(struct sparse_storage *info, lbaint_t blk,
+				  lbaint_t blkcnt)
+{
+	struct sparse_test_priv *priv = info->priv;
+	char *buf;
+	lbaint_t ret;
+
+	if (blk % info->erase_grp || blkcnt % info->erase_grp)
+		return 0;
+	buf = calloc(blkcnt, info->blksz);
+	if (!buf)
+		return 0;
+	ret = blk_dwrite(priv->desc, blk, blkcnt, buf);
+	free(buf);
+	priv->erases++;
+	priv->erased += blkcnt;
+
+	return ret;
+}
+
+static void sparse_test_mssg(const char *str)
+{
+	sparse_test->mssg = str;
+}
+
+static void *add_chunk(void *ptr, int type, int blks, int data_sz)
+{
+	chunk_header_t *chunk = ptr;
+
+	chunk->chunk_type = type;
+	chunk->reserved1 = 0;
+	chunk->chunk_sz = blks;
+	chunk->total_sz = sizeof(*chunk) + data_sz;
+
+	return ptr + sizeof(*chunk);
+}
+
+static void *add_raw(void *ptr, int blks, int val)
+{
+	ptr = add_chunk(ptr, CHUNK_TYPE_RAW, blks, blks * 512);
+	memset(ptr, val, blks * 512);
+
+	return ptr + blks * 512;
+}
+
+static void *add_fill(void *ptr, int blks, u32 val)
+{
+	ptr = add_chunk(ptr, CHUNK_TYPE_FILL, blks, sizeof(val));
+	memcpy(ptr, &val, sizeof(val));
+
+	return ptr + sizeof(val);
+}
+
+static int check_blocks(struct unit_test_state *uts, struct blk_desc *desc,
+			int start, int count, int val)
+{
+	char buf[512];
+	int i, j;
+
+	for (i = start; i < start + count; i++) {
+		ut_asserteq(1, blk_dread(desc, i, 1, buf));
+		for (j = 0; j < sizeof(buf); j++)
+			ut_asserteq(val, buf[j] & 0xff);
+	}
+
+	return 0;
+}
+
+/* Create a backing file full of 0xaa and attach it as host device 0 */
+static int sparse_test_dev(struct unit_test_state *uts,
+			   struct blk_desc **descp)
+{
+	char blk[512];
+	int fd, i;
+
+	fd = os_open(SPARSE_TEST_FILE, OS_O_RDWR | OS_O_CREAT);
+	ut_assert(fd >= 0);
+	memset(blk, 0xaa, sizeof(blk));
+	for (i = 0; i < SPARSE_TEST_BLKS; i++)
+		ut_asserteq(sizeof(blk), os_write(fd, blk, sizeof(blk)));
+	os_close(fd);
+	ut_assertok(host_dev_bind(0, SPARSE_TEST_FILE));
+	ut_assertok(blk_get_device_by_str("host", "0", descp));
+
+	return 0;
+}
+
+static void sparse_test_dev_remove(void)
+{
+	host_dev_bind(0, NULL);
+	os_unlink(SPARSE_TEST_FILE);
+}
+
+/* Fill in a sparse header and return where the first chunk goes */
+static void *sparse_test_header(void *img, int total_blks, int total_chunks)
+{
+	sparse_header_t *hdr = img;
+
+	memset(hdr, '\0', sizeof(*hdr));
+	hdr->magic = SPARSE_HEADER_MAGIC;
+	hdr->major_version = 1;
+	hdr->file_hdr_sz = sizeof(*hdr);
+	hdr->chunk_hdr_sz = sizeof(chunk_header_t);
+	hdr->blk_sz = 512;
+	hdr->total_blks = total_blks;
+	hdr->total_chunks = total_chunks;
+
+	return img + sizeof(*hdr);
+}
+
+/* Set up @info to write @size blocks to @desc, with erase groups of @grp */
+static void sparse_test_info(struct sparse_storage *info,
+			     struct sparse_test_priv *priv,
+			     struct blk_desc *desc, lbaint_t size,
+			     lbaint_t grp)
+{
+	memset(priv, '\0', sizeof(*priv));
+	priv->desc = desc;
+	sparse_test = priv;
+	memset(info, '\0', sizeof(*info));
+	info->blksz = 512;
+	info->size = size;
+	info->priv = priv;
+	info->write = sparse_test_write;
+	info->reserve = sparse_test_reserve;
+	info->erase = sparse_test_erase;
+	info->erase_grp = grp;
+	info->discard = grp != 0;
+	info->mssg = sparse_test_mssg;
+}
+
+/* Test merging of RAW chunks and erasing of FILL / DONT_CARE chunks */
+static int dm_test_sparse_write(struct unit_test_state *uts)
+{
+	struct sparse_test_priv priv;
+	struct sparse_storage info;
+	struct blk_desc *desc;
+	void *img, *ptr;
+
+	ut_assertok(sparse_test_dev(uts, &desc));
+
+	img = malloc(SPARSE_TEST_BLKS * 512);
+	ut_assert(img != NULL);
+	ptr = sparse_test_header(img, 34, 6);
+	ut_asserteq(1, is_sparse_image(img));
+	ptr = add_raw(ptr, 2, 0x11);		/* blocks 0-1 */
+	ptr = add_raw(ptr, 3, 0x22);		/* blocks 2-4 */
+	ptr = add_fill(ptr, 4, 0x5a5a5a5a);	/* blocks 5-8 */
+	ptr = add_chunk(ptr, CHUNK_TYPE_DONT_CARE, 8, 0); /* blocks 9-16 */
+	ptr = add_fill(ptr, 16, 0);		/* blocks 17-32 */
+	ptr = add_raw(ptr, 1, 0x33);		/* block 33 */
+
+	sparse_test_info(&info, &priv, desc, SPARSE_TEST_BLKS,
+			 SPARSE_TEST_ERASE_GRP);
+	ut_assertok(write_sparse_image(&info, "test", img, ptr - img));
+	ut_asserteq_ptr(NULL, priv.mssg);
+
+	/*
+	 * One write for the two merged RAW chunks, one for the 0x5a fill,
+	 * two for the unaligned ends of the zero fill and one for the final
+	 * RAW chunk.
+	 */
+	ut_asserteq(5, priv.writes);
+
+	/* Blocks 12-15 (DONT_CARE) and 20-31 (zero fill) */
+	ut_asserteq(2, priv.erases);
+	ut_asserteq(16, priv.erased);
+
+	ut_assertok(check_blocks(uts, desc, 0, 2, 0x11));
+	ut_assertok(check_blocks(uts, desc, 2, 3, 0x22));
+	ut_assertok(check_blocks(uts, desc, 5, 4, 0x5a));
+	ut_assertok(check_blocks(uts, desc, 9, 3, 0xaa));
+	ut_assertok(check_blocks(uts, desc, 12, 4, 0));
+	ut_assertok(check_blocks(uts, desc, 16, 1, 0xaa));
+	ut_assertok(check_blocks(uts, desc, 17, 16, 0));
+	ut_assertok(check_blocks(uts, desc, 33, 1, 0x33));
+	ut_assertok(check_blocks(uts, desc, 34, 1, 0xaa));
+
+	free(img);
+	sparse_test_dev_remove();
+
+	return 0;
+}
+DM_TEST(dm_test_sparse_write, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Test erasing with an erase group size which is not a power of two */
+static int dm_test_sparse_erase_grp(struct unit_test_state *uts)
+{
+	struct sparse_test_priv priv;
+	struct sparse_storage info;
+	struct blk_desc *desc;
+	void *img, *ptr;
+
+	ut_assertok(sparse_test_dev(uts, &desc));
+
+	img = malloc(8 * 512);
+	ut_assert(img != NULL);
+	ptr = sparse_test_header(img, 8, 3);
+	ptr = add_raw(ptr, 1, 0x11);		/* block 0 */
+	ptr = add_chunk(ptr, CHUNK_TYPE_DONT_CARE, 6, 0); /* blocks 1-6 */
+	ptr = add_raw(ptr, 1, 0x22);		/* block 7 */
+
+	sparse_test_info(&info, &priv, desc, SPARSE_TEST_BLKS, 3);
+	ut_assertok(write_sparse_image(&info, "test", img, ptr - img));
+	ut_asserteq_ptr(NULL, priv.mssg);
+
+	/* Only blocks 3-5 make up a whole erase group */
+	ut_asserteq(1, priv.erases);
+	ut_asserteq(3, priv.erased);
+	ut_assertok(check_blocks(uts, desc, 0, 1, 0x11));
+	ut_assertok(check_blocks(uts, desc, 1, 2, 0xaa));
+	ut_assertok(check_blocks(uts, desc, 3, 3, 0));
+	ut_assertok(check_blocks(uts, desc, 6, 1, 0xaa));
+	ut_assertok(check_blocks(uts, desc, 7, 1, 0x22));
+
+	free(img);
+	sparse_test_dev_remove();
+
+	return 0;
+}
+DM_TEST(dm_test_sparse_erase_grp, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Test that a RAW chunk which does not fit is rejected */
+static int dm_test_sparse_too_large(struct unit_test_state *uts)
+{
+	struct sparse_test_priv priv;
+	struct sparse_storage info;
+	void *img, *ptr;
+
+	img = malloc(8 * 512);
+	ut_assert(img != NULL);
+	ptr = sparse_test_header(img, 4, 2);
+	ptr = add_raw(ptr, 2, 0x11);
+	ptr = add_raw(ptr, 2, 0x22);
+
+	sparse_test_info(&info, &priv, NULL, 3, 0);
+	ut_asserteq(-ENOSPC, write_sparse_image(&info, "test", img,
+						ptr - img));
+	ut_asserteq_str("Request would exceed partition size!", priv.mssg);
+	ut_asserteq(0, priv.writes);
+	free(img);
+
+	return 0;
+}
+DM_TEST(dm_test_sparse_too_large, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Test that a DONT_CARE chunk past the end does not erase beyond it */
+static int dm_test_sparse_dont_care_too_large(struct unit_test_state *uts)
+{
+	struct sparse_test_priv priv;
+	struct sparse_storage info;
+	struct blk_desc *desc;
+	void *img, *ptr;
+
+	ut_assertok(sparse_test_dev(uts, &desc));
+
+	img = malloc(8 * 512);
+	ut_assert(img != NULL);
+	ptr = sparse_test_header(img, 12, 2);
+	ptr = add_raw(ptr, 4, 0x11);		/* blocks 0-3 */
+	ptr = add_chunk(ptr, CHUNK_TYPE_DONT_CARE, 8, 0); /* blocks 4-11 */
+
+	/* The device is larger, but only the first 8 blocks are ours */
+	sparse_test_info(&info, &priv, desc, 8, SPARSE_TEST_ERASE_GRP);
+	ut_asserteq(-ENOSPC, write_sparse_image(&info, "test", img,
+						ptr - img));
+	ut_asserteq_str("Request would exceed partition size!", priv.mssg);
+	ut_asserteq(0, priv.erases);
+	ut_assertok(check_blocks(uts, desc, 8, 4, 0xaa));
+
+	free(img);
+	sparse_test_dev_remove();
+
+	return 0;
+}
+DM_TEST(dm_test_sparse_dont_care_too_large,
+	DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
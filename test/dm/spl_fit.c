@@ -0,0 +1,263 @@
+/*
+ * Tests for loading U-Boot from a FIT in SPL
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <image.h>
+#include <libfdt.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <spl.h>
+#include <dm/test.h>
+#include <test/ut.h>
+#include <u-boot/crc.h>
+
+#define SPL_FIT_TEST_BLKSZ	512
+#define SPL_FIT_TEST_LOAD	0x100000
+#define SPL_FIT_TEST_FDT_SIZE	0x1000
+
+/* Sizes of the images in the FIT, in the order their data is stored */
+enum {
+	SPL_FIT_UBOOT,
+	SPL_FIT_UNUSED,
+	SPL_FIT_FDT1,
+	SPL_FIT_FDT2,
+
+	SPL_FIT_COUNT,
+};
+
+static const int spl_fit_test_size[SPL_FIT_COUNT] = {
+	0x1235, 0x10000, 0x100, 0x321,
+};
+
+static const char *const spl_fit_test_name[SPL_FIT_COUNT] = {
+	"uboot", "unused", "fdt-1", "fdt-2",
+};
+
+struct spl_fit_test_dev {
+	u8 *data;
+	int size;
+	ulong bytes_read;
+	int reads;
+	int misaligned;
+};
+
+/*
+ * Sandbox has no SPL, but builds the SPL FIT loader with these tests.
+ * Provide what the loader needs from SPL and the board.
+ */
+struct spl_image_info spl_image;
+
+int board_fit_config_name_match(const char *name)
+{
+	return strcmp(name, "sandbox");
+}
+
+void *board_spl_fit_buffer(ulong fit_size, int bl_len)
+{
+	static void *fit_buf;
+
+	free(fit_buf);
+	fit_buf = memalign(ARCH_DMA_MINALIGN, fit_size + bl_len);
+
+	return fit_buf;
+}
+
+static ulong spl_fit_test_read(struct spl_load_info *load, ulong sector,
+			       ulong count, void *buf)
+{
+	struct spl_fit_test_dev *dev = load->priv;
+	ulong offset = sector * SPL_FIT_TEST_BLKSZ;
+	ulong len = count * SPL_FIT_TEST_BLKSZ;
+
+	if (offset + len > dev->size)
+		return 0;
+	memcpy(buf, dev->data + offset, len);
+	if ((ulong)buf & (ARCH_DMA_MINALIGN - 1))
+		dev->misaligned++;
+	dev->bytes_read += len;
+	dev->reads++;
+
+	return count;
+}
+
+static int add_config(void *fit, const char *name, const char *desc,
+		      const char *fdt)
+{
+	fdt_begin_node(fit, name);
+	fdt_property_string(fit, "description", desc);
+	fdt_property_string(fit, FIT_FIRMWARE_PROP, "uboot");
+	fdt_property_string(fit, FIT_FDT_PROP, fdt);
+
+	return fdt_end_node(fit);
+}
+
+/*
+ * Builds a FIT with external data, as written by 'mkimage -E', followed by
+ * the image data. Image i is filled with the value i + 1.
+ */
+static int spl_fit_test_create(struct spl_fit_test_dev *dev, u8 **datap)
+{
+	int offset[SPL_FIT_COUNT];
+	int fit_size, base, i;
+	void *fit;
+	u8 *data;
+
+	fit = malloc(SPL_FIT_TEST_FDT_SIZE);
+	data = malloc(spl_fit_test_size[SPL_FIT_UNUSED]);
+	if (!fit || !data) {
+		free(data);
+		free(fit);
+		return -ENOMEM;
+	}
+	fdt_create(fit, SPL_FIT_TEST_FDT_SIZE);
+	fdt_finish_reservemap(fit);
+	fdt_begin_node(fit, "");
+	fdt_begin_node(fit, "images");
+	for (i = 0, base = 0; i < SPL_FIT_COUNT; i++) {
+		offset[i] = base;
+		memset(data, i + 1, spl_fit_test_size[i]);
+		fdt_begin_node(fit, spl_fit_test_name[i]);
+		fdt_property_u32(fit, "data-offset", base);
+		fdt_property_u32(fit, "data-size", spl_fit_test_size[i]);
+		if (i == SPL_FIT_UBOOT)
+			fdt_property_u32(fit, "load", SPL_FIT_TEST_LOAD);
+		fdt_begin_node(fit, FIT_HASH_NODENAME "@1");
+		fdt_property_string(fit, FIT_ALGO_PROP, "crc32");
+		fdt_property_u32(fit, FIT_VALUE_PROP,
+				 crc32(0, data, spl_fit_test_size[i]));
+		fdt_end_node(fit);
+		fdt_end_node(fit);
+		base += (spl_fit_test_size[i] + 3) & ~3;
+	}
+	fdt_end_node(fit);
+	fdt_begin_node(fit, "configurations");
+	add_config(fit, "config-1", "other", "fdt-1");
+	add_config(fit, "config-2", "sandbox", "fdt-2");
+	fdt_end_node(fit);
+	fdt_end_node(fit);
+	free(data);
+	if (fdt_finish(fit)) {
+		free(fit);
+		return -EINVAL;
+	}
+
+	/* Place the data after the FIT, rounded up to whole blocks */
+	fit_size = (fdt_totalsize(fit) + 3) & ~3;
+	dev->size = ALIGN(fit_size + base, SPL_FIT_TEST_BLKSZ);
+	data = calloc(1, dev->size);
+	if (!data) {
+		free(fit);
+		return -ENOMEM;
+	}
+	memcpy(data, fit, fdt_totalsize(fit));
+	for (i = 0; i < SPL_FIT_COUNT; i++) {
+		memset(data + fit_size + offset[i], i + 1,
+		       spl_fit_test_size[i]);
+	}
+	free(fit);
+	dev->data = data;
+	*datap = data + fit_size + offset[SPL_FIT_FDT2];
+
+	return fit_size;
+}
+
+/* Number of bytes read to get size bytes at offset */
+static ulong spl_fit_test_span(int offset, int size)
+{
+	int first = offset / SPL_FIT_TEST_BLKSZ;
+	int last = (offset + size + SPL_FIT_TEST_BLKSZ - 1) /
+		SPL_FIT_TEST_BLKSZ;
+
+	return (last - first) * SPL_FIT_TEST_BLKSZ;
+}
+
+static void spl_fit_test_init(struct spl_load_info *info,
+			      struct spl_fit_test_dev *dev)
+{
+	memset(info, '\0', sizeof(*info));
+	info->priv = dev;
+	info->bl_len = SPL_FIT_TEST_BLKSZ;
+	info->read = spl_fit_test_read;
+}
+
+/* Test that only the selected images are read, straight to their place */
+static int dm_test_spl_fit_load(struct unit_test_state *uts)
+{
+	struct spl_fit_test_dev dev;
+	struct spl_load_info info;
+	int fit_size, fdt2_offset;
+	u8 *fdt2, *ptr;
+	ulong expect, end;
+	int i;
+
+	memset(&dev, '\0', sizeof(dev));
+	fit_size = spl_fit_test_create(&dev, &fdt2);
+	ut_assert(fit_size > 0);
+	fdt2_offset = fdt2 - dev.data;
+
+	/* Put markers around the images to check what is overwritten */
+	ptr = map_sysmem(SPL_FIT_TEST_LOAD - SPL_FIT_TEST_BLKSZ,
+			 SPL_FIT_TEST_BLKSZ);
+	memset(ptr, 0xff, SPL_FIT_TEST_BLKSZ);
+	end = SPL_FIT_TEST_LOAD + spl_fit_test_size[SPL_FIT_UBOOT] +
+		spl_fit_test_size[SPL_FIT_FDT2];
+	ptr = map_sysmem(end, 2 * SPL_FIT_TEST_BLKSZ);
+	memset(ptr, 0xee, 2 * SPL_FIT_TEST_BLKSZ);
+
+	spl_fit_test_init(&info, &dev);
+	ut_assertok(spl_load_simple_fit(&info, 0, dev.data));
+	ut_asserteq(SPL_FIT_TEST_LOAD, spl_image.load_addr);
+	ut_asserteq(SPL_FIT_TEST_LOAD, spl_image.entry_point);
+
+	/* The header, U-Boot and the selected device tree, one read each */
+	expect = spl_fit_test_span(0, fit_size) +
+		spl_fit_test_span(fit_size, spl_fit_test_size[SPL_FIT_UBOOT]) +
+		spl_fit_test_span(fdt2_offset, spl_fit_test_size[SPL_FIT_FDT2]);
+	ut_asserteq(expect, dev.bytes_read);
+	ut_asserteq(3, dev.reads);
+	ut_asserteq(0, dev.misaligned);
+
+	/* The device tree follows U-Boot directly */
+	ptr = map_sysmem(SPL_FIT_TEST_LOAD, 0);
+	for (i = 0; i < spl_fit_test_size[SPL_FIT_UBOOT]; i++)
+		ut_asserteq(SPL_FIT_UBOOT + 1, ptr[i]);
+	ptr += spl_fit_test_size[SPL_FIT_UBOOT];
+	for (i = 0; i < spl_fit_test_size[SPL_FIT_FDT2]; i++)
+		ut_asserteq(SPL_FIT_FDT2 + 1, ptr[i]);
+
+	/* Less than one block before the image was overwritten */
+	ptr = map_sysmem(SPL_FIT_TEST_LOAD - SPL_FIT_TEST_BLKSZ, 0);
+	ut_asserteq(0xff, ptr[0]);
+
+	/* Nothing after the device tree was overwritten */
+	ptr = map_sysmem(end, 0);
+	for (i = 0; i < 2 * SPL_FIT_TEST_BLKSZ; i++)
+		ut_asserteq(0xee, ptr[i]);
+	free(dev.data);
+
+	return 0;
+}
+DM_TEST(dm_test_spl_fit_load, 0);
+
+/* Test that an image with a bad hash is rejected */
+static int dm_test_spl_fit_bad_hash(struct unit_test_state *uts)
+{
+	struct spl_fit_test_dev dev;
+	struct spl_load_info info;
+	u8 *fdt2;
+
+	memset(&dev, '\0', sizeof(dev));
+	ut_assert(spl_fit_test_create(&dev, &fdt2) > 0);
+	fdt2[spl_fit_test_size[SPL_FIT_FDT2] - 1] ^= 1;
+
+	spl_fit_test_init(&info, &dev);
+	ut_asserteq(-EPERM, spl_load_simple_fit(&info, 0, dev.data));
+	free(dev.data);
+
+	return 0;
+}
+DM_TEST(dm_test_spl_fit_bad_hash, 0);
@@ -10,6 +10,8 @@
 #include <fdtdec.h>
 #include <malloc.h>
 #include <asm/io.h>
+#include <dm/device-internal.h>
+#include <dm/lists.h>
 #include <dm/test.h>
 #include <dm/root.h>
 #include <dm/uclass-internal.h>
@@ -266,3 +268,126 @@ static int dm_test_fdt_offset(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_fdt_offset, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Test that the devices providing a device's clocks, etc. are probed first */
+static int dm_test_fdt_probe_deps(struct unit_test_state *uts)
+{
+	struct udevice *dev, *fixed, *sbox, *gpio_a, *gpio_b, *dep;
+
+	ut_assertok(uclass_find_device_by_name(UCLASS_MISC, "clk-test", &dev));
+	ut_assertok(uclass_find_device_by_name(UCLASS_CLK, "clk-fixed",
+					       &fixed));
+	ut_assertok(uclass_find_device_by_name(UCLASS_CLK, "clk-sbox", &sbox));
+
+	/* Two clocks from the same device give one dependency */
+	ut_assertok(device_get_dep(dev, 0, &dep));
+	ut_asserteq_ptr(fixed, dep);
+	ut_assertok(device_get_dep(dev, 1, &dep));
+	ut_asserteq_ptr(sbox, dep);
+	ut_asserteq(-ENOENT, device_get_dep(dev, 2, &dep));
+
+	ut_assert(!device_active(fixed));
+	ut_assert(!device_active(sbox));
+	ut_assertok(device_probe(dev));
+	ut_assert(device_active(fixed));
+	ut_assert(device_active(sbox));
+
+	/* Empty entries are skipped and all the GPIO properties are used */
+	ut_assertok(uclass_find_device_by_name(UCLASS_TEST_FDT, "a-test",
+					       &dev));
+	ut_assertok(uclass_find_device_by_name(UCLASS_GPIO, "base-gpios",
+					       &gpio_a));
+	ut_assertok(uclass_find_device_by_name(UCLASS_GPIO, "extra-gpios",
+					       &gpio_b));
+	ut_assertok(device_get_dep(dev, 0, &dep));
+	ut_asserteq_ptr(gpio_a, dep);
+	ut_assertok(device_get_dep(dev, 1, &dep));
+	ut_asserteq_ptr(gpio_b, dep);
+	ut_asserteq(-ENOENT, device_get_dep(dev, 2, &dep));
+
+	/* A device which refers to nothing has no dependencies */
+	ut_assertok(uclass_find_device_by_name(UCLASS_TEST_FDT, "e-test",
+					       &dev));
+	ut_asserteq(-ENOENT, device_get_dep(dev, 0, &dep));
+
+	return 0;
+}
+DM_TEST(dm_test_fdt_probe_deps, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Bind a node with two compatible strings */
+static int bind_compat_pair(struct unit_test_state *uts, void *blob,
+			    const char *compat1, const char *compat2,
+			    struct udevice **devp)
+{
+	const void *fdt_blob = gd->fdt_blob;
+	char compat[80];
+	int len, ofs, ret;
+
+	len = strlen(compat1) + 1;
+	strcpy(compat, compat1);
+	strcpy(compat + len, compat2);
+	len += strlen(compat2) + 1;
+	ofs = fdt_path_offset(blob, "/pair");
+	if (ofs < 0)
+		ofs = fdt_add_subnode(blob, 0, "pair");
+	ut_assert(ofs >= 0);
+	ut_assertok(fdt_setprop(blob, ofs, "compatible", compat, len));
+
+	/* The device's bind methods must see the same tree */
+	gd->fdt_blob = blob;
+	ret = lists_bind_fdt(dm_root(), blob, ofs, devp);
+	gd->fdt_blob = fdt_blob;
+	ut_assertok(ret);
+	ut_assertnonnull(*devp);
+
+	return 0;
+}
+
+static int check_compat_order(struct unit_test_state *uts, void *blob)
+{
+	struct udevice *dev;
+
+	/* The first driver in the linker list wins, whatever the order */
+	ut_assertok(bind_compat_pair(uts, blob, "denx,u-boot-fdt-test",
+				     "denx,u-boot-test-bus", &dev));
+	ut_asserteq_str("testbus_drv", dev->driver->name);
+	ut_assertok(device_unbind(dev));
+	ut_assertok(bind_compat_pair(uts, blob, "denx,u-boot-test-bus",
+				     "denx,u-boot-fdt-test", &dev));
+	ut_asserteq_str("testbus_drv", dev->driver->name);
+	ut_assertok(device_unbind(dev));
+
+	/* And so does the first of its own compatible strings */
+	ut_assertok(bind_compat_pair(uts, blob, "google,another-fdt-test",
+				     "denx,u-boot-fdt-test", &dev));
+	ut_asserteq_str("testfdt_drv", dev->driver->name);
+	ut_asserteq(DM_TEST_TYPE_FIRST, dev_get_driver_data(dev));
+	ut_assertok(device_unbind(dev));
+
+	ut_assertok(bind_compat_pair(uts, blob, "nosuch,device",
+				     "google,another-fdt-test", &dev));
+	ut_asserteq(DM_TEST_TYPE_SECOND, dev_get_driver_data(dev));
+	ut_assertok(device_unbind(dev));
+
+	return 0;
+}
+
+/* Test that binding picks the same driver with and without the table */
+static int dm_test_fdt_compat_order(struct unit_test_state *uts)
+{
+	ulong flags = gd->flags;
+	char blob[512];
+	int ret;
+
+	ut_assertok(fdt_create_empty_tree(blob, sizeof(blob)));
+	ut_assertok(check_compat_order(uts, blob));
+
+	/* Before relocation each driver is checked in turn */
+	gd->flags &= ~GD_FLG_RELOC;
+	ret = check_compat_order(uts, blob);
+	gd->flags = flags;
+	ut_assertok(ret);
+
+	return 0;
+}
+DM_TEST(dm_test_fdt_compat_order, 0);
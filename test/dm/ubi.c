@@ -0,0 +1,154 @@
+/*
+ * Tests for attaching UBI devices
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <mtd.h>
+#include <ubi_uboot.h>
+#include <asm/test.h>
+#include <linux/sizes.h>
+#include <dm/device-internal.h>
+#include <dm/lists.h>
+#include <dm/root.h>
+#include <dm/test.h>
+#include <test/ut.h>
+
+#define UBI_TEST_BLOCK_SIZE	SZ_128K
+#define UBI_TEST_PAGE_SIZE	SZ_2K
+
+static int ubi_test_create(struct unit_test_state *uts, u64 size,
+			   int subpage_sft, struct udevice **devp)
+{
+	struct sandbox_mtd_platdata *plat;
+	struct udevice *dev;
+
+	ut_assertok(device_bind_driver(dm_root(), "sandbox_mtd", "ubi-test",
+				       &dev));
+	plat = dev_get_platdata(dev);
+	plat->size = size;
+	plat->erasesize = UBI_TEST_BLOCK_SIZE;
+	plat->writesize = UBI_TEST_PAGE_SIZE;
+	plat->subpage_sft = subpage_sft;
+	ut_assertok(device_probe(dev));
+	*devp = dev;
+
+	return 0;
+}
+
+static int ubi_test_destroy(struct unit_test_state *uts, struct udevice *dev)
+{
+	ut_assertok(device_remove(dev));
+	ut_assertok(device_unbind(dev));
+
+	return 0;
+}
+
+/*
+ * Attaches the device, formatting it if it is empty, and returns the
+ * number of read calls needed to do so
+ */
+static int ubi_test_attach(struct unit_test_state *uts, struct udevice *dev,
+			   uint *readsp)
+{
+	struct mtd_info *mtd = dev_get_uclass_priv(dev);
+	struct sandbox_mtd_stats stats;
+	int num;
+
+	/* Detaching drops this reference */
+	ut_assert(!IS_ERR(get_mtd_device(mtd, -1)));
+	sandbox_mtd_get_stats(dev, &stats);
+	num = ubi_attach_mtd_dev(mtd, UBI_DEV_NUM_AUTO, 0, 0);
+	ut_assert(num >= 0);
+	sandbox_mtd_get_stats(dev, &stats);
+	*readsp = stats.reads;
+
+	return num;
+}
+
+/*
+ * Checks attaching a device whose UBI headers take up hdr_pages pages,
+ * which must be read with no more than one read per page
+ */
+static int ubi_test_check_attach(struct unit_test_state *uts,
+				 int subpage_sft, int hdr_pages)
+{
+	const u64 size = SZ_32M;
+	const int peb_count = size / UBI_TEST_BLOCK_SIZE;
+	struct ubi_device_info info;
+	struct udevice *dev;
+	uint reads;
+	int num;
+
+	ut_assertok(ubi_test_create(uts, size, subpage_sft, &dev));
+	ut_assertok(ubi_init());
+
+	/* The first attach formats the empty device */
+	num = ubi_test_attach(uts, dev, &reads);
+	ut_assert(num >= 0);
+	ut_assertok(ubi_get_device_info(num, &info));
+	ut_asserteq(UBI_TEST_BLOCK_SIZE - hdr_pages * UBI_TEST_PAGE_SIZE,
+		    info.leb_size);
+	ut_assertok(ubi_detach_mtd_dev(num, 1));
+
+	/* Both headers of a PEB come in with one read where possible */
+	num = ubi_test_attach(uts, dev, &reads);
+	ut_assert(num >= 0);
+	ut_assert(reads >= peb_count);
+	ut_assert(reads < peb_count * hdr_pages + 16);
+	ut_assertok(ubi_detach_mtd_dev(num, 1));
+
+	ubi_exit();
+	ut_assertok(ubi_test_destroy(uts, dev));
+
+	return 0;
+}
+
+/* Test attaching with sub-pages, where both headers share a page */
+static int dm_test_ubi_attach_subpage(struct unit_test_state *uts)
+{
+	return ubi_test_check_attach(uts, 2, 1);
+}
+DM_TEST(dm_test_ubi_attach_subpage, 0);
+
+/* Test attaching with the VID header in a page of its own */
+static int dm_test_ubi_attach_page(struct unit_test_state *uts)
+{
+	return ubi_test_check_attach(uts, 0, 2);
+}
+DM_TEST(dm_test_ubi_attach_page, 0);
+
+/*
+ * Measure the time taken to attach devices of different sizes, which must
+ * need one read per PEB plus one for each copy of the volume table
+ */
+static int dm_test_ubi_attach_bench(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+	ulong start, elapsed;
+	uint reads;
+	u64 size;
+	int num;
+
+	ut_assertok(ubi_init());
+	for (size = SZ_64M; size <= SZ_1G; size <<= 1) {
+		ut_assertok(ubi_test_create(uts, size, 2, &dev));
+		num = ubi_test_attach(uts, dev, &reads);
+		ut_assertok(ubi_detach_mtd_dev(num, 1));
+
+		start = timer_get_us();
+		num = ubi_test_attach(uts, dev, &reads);
+		elapsed = timer_get_us() - start;
+		printf("%5llu MiB, %5llu PEBs: %6u reads, %7lu us\n",
+		       size >> 20, size / UBI_TEST_BLOCK_SIZE, reads, elapsed);
+		ut_asserteq(size / UBI_TEST_BLOCK_SIZE + 2, reads);
+		ut_assertok(ubi_detach_mtd_dev(num, 1));
+		ut_assertok(ubi_test_destroy(uts, dev));
+	}
+	ubi_exit();
+
+	return 0;
+}
+DM_TEST(dm_test_ubi_attach_bench, 0);
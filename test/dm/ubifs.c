@@ -0,0 +1,673 @@
+/*
+ * Tests for reading files from UBIFS
+ *
+ * The file-system is written by the test itself, in the same way as the
+ * kernel formats an empty volume, with the files added to the main area and
+ * a single index node pointing at all of them.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <malloc.h>
+#include <mtd.h>
+#include <ubi_uboot.h>
+#include <asm/test.h>
+#include <linux/sizes.h>
+#include <dm/device-internal.h>
+#include <dm/lists.h>
+#include <dm/root.h>
+#include <dm/test.h>
+#include <test/ut.h>
+
+/* UBI and UBIFS each have their own version of these */
+#undef dbg_gen
+#undef dbg_io
+#include "../../fs/ubifs/ubifs.h"
+
+#define UBIFS_TEST_VOL		"ubifs-test"
+#define UBIFS_TEST_VOL_SIZE	SZ_16M
+#define UBIFS_TEST_FANOUT	64
+#define UBIFS_TEST_MAX_NODES	(UBIFS_TEST_FANOUT * UBIFS_TEST_FANOUT)
+
+/**
+ * struct ubifs_test_file - a file in the root directory of the test image
+ *
+ * @name:	File name
+ * @size:	File size in bytes
+ * @hole:	First block which has no data node, or -1 for none
+ * @holes:	Number of blocks from @hole which have no data node
+ */
+struct ubifs_test_file {
+	const char *name;
+	int size;
+	int hole;
+	int holes;
+};
+
+/*
+ * State of the image while it is written. The index has two levels: the
+ * branches to all nodes are collected in @idx, then split up into level 0
+ * index nodes referred to by the root index node @root.
+ */
+struct ubifs_test_img {
+	struct ubifs_info *c;
+	struct ubifs_idx_node *idx;
+	struct ubifs_idx_node *root;
+	int child_cnt;
+	int idx_size;
+	u8 *buf;
+	int lnum;
+	int offs;
+	long long used;
+};
+
+/* Contents of byte @pos of the file with inode number @inum */
+static u8 ubifs_test_byte(ino_t inum, int pos)
+{
+	return (pos >> UBIFS_BLOCK_SHIFT) * 7 + pos + inum;
+}
+
+/* Pads the LEB being filled up to the next I/O unit and writes it */
+static int ubifs_test_flush(struct ubifs_test_img *img)
+{
+	struct ubifs_info *c = img->c;
+	int len = ALIGN(img->offs, c->min_io_size);
+	int err;
+
+	ubifs_pad(c, img->buf + img->offs, len - img->offs);
+	err = ubi_leb_change(c->ubi, img->lnum, img->buf, len);
+	img->lnum++;
+	img->offs = 0;
+
+	return err;
+}
+
+/* Copies a node to the main area and fills in the branch pointing to it */
+static int ubifs_test_place(struct ubifs_test_img *img, void *node, int len,
+			    struct ubifs_branch *br)
+{
+	struct ubifs_info *c = img->c;
+	int err;
+
+	if (img->offs + len > c->leb_size) {
+		err = ubifs_test_flush(img);
+		if (err)
+			return err;
+	}
+	ubifs_prepare_node(c, node, len, 0);
+	memset(img->buf + img->offs, '\0', ALIGN(len, 8));
+	memcpy(img->buf + img->offs, node, len);
+	br->lnum = cpu_to_le32(img->lnum);
+	br->offs = cpu_to_le32(img->offs);
+	br->len = cpu_to_le32(len);
+	img->offs += ALIGN(len, 8);
+	img->used += ALIGN(len, 8);
+
+	return 0;
+}
+
+/* Adds a leaf node to the main area */
+static int ubifs_test_add(struct ubifs_test_img *img, void *node, int len,
+			  union ubifs_key *key)
+{
+	struct ubifs_branch *br;
+
+	if (img->child_cnt == UBIFS_TEST_MAX_NODES)
+		return -ENOSPC;
+	br = ubifs_idx_branch(img->c, img->idx, img->child_cnt++);
+	key_write_idx(img->c, key, &br->key);
+
+	return ubifs_test_place(img, node, len, br);
+}
+
+/* Writes the level 0 index nodes and sets up the root index node */
+static int ubifs_test_add_index(struct ubifs_test_img *img)
+{
+	struct ubifs_info *c = img->c;
+	struct ubifs_idx_node *idx;
+	struct ubifs_branch *br;
+	int i, cnt, len, root_cnt = 0, err = 0;
+
+	idx = calloc(1, ubifs_idx_node_sz(c, UBIFS_TEST_FANOUT));
+	if (!idx)
+		return -ENOMEM;
+	for (i = 0; !err && i < img->child_cnt; i += cnt) {
+		cnt = min(img->child_cnt - i, UBIFS_TEST_FANOUT);
+		len = ubifs_idx_node_sz(c, cnt);
+		idx->ch.node_type = UBIFS_IDX_NODE;
+		idx->child_cnt = cpu_to_le16(cnt);
+		idx->level = 0;
+		br = ubifs_idx_branch(c, img->idx, i);
+		memcpy(idx->branches, br, len - UBIFS_IDX_NODE_SZ);
+
+		/* The key of an index node is the key of its first child */
+		br = ubifs_idx_branch(c, img->root, root_cnt++);
+		memcpy(br->key, ubifs_idx_branch(c, img->idx, i)->key,
+		       c->key_len);
+		err = ubifs_test_place(img, idx, len, br);
+		img->idx_size += ALIGN(len, 8);
+	}
+	free(idx);
+
+	img->root->ch.node_type = UBIFS_IDX_NODE;
+	img->root->child_cnt = cpu_to_le16(root_cnt);
+	img->root->level = cpu_to_le16(1);
+
+	return err;
+}
+
+static int ubifs_test_add_ino(struct ubifs_test_img *img, ino_t inum,
+			      int mode, int nlink, loff_t size)
+{
+	struct ubifs_info *c = img->c;
+	struct ubifs_ino_node ino;
+	union ubifs_key key;
+
+	memset(&ino, '\0', sizeof(ino));
+	ino.ch.node_type = UBIFS_INO_NODE;
+	ino_key_init(c, &key, inum);
+	key_write(c, &key, ino.key);
+	/* The inode is created with the sequence number of its node */
+	ino.creat_sqnum = cpu_to_le64(c->max_sqnum + 1);
+	ino.size = cpu_to_le64(size);
+	ino.nlink = cpu_to_le32(nlink);
+	ino.mode = cpu_to_le32(mode);
+	ino.compr_type = cpu_to_le16(UBIFS_COMPR_NONE);
+
+	return ubifs_test_add(img, &ino, UBIFS_INO_NODE_SZ, &key);
+}
+
+static int ubifs_test_add_dent(struct ubifs_test_img *img, ino_t inum,
+			       const char *name)
+{
+	struct ubifs_info *c = img->c;
+	struct ubifs_dent_node *dent;
+	union ubifs_key key;
+	struct qstr nm;
+	int len, err;
+
+	nm.name = (char *)name;
+	nm.len = strlen(name);
+	len = UBIFS_DENT_NODE_SZ + nm.len + 1;
+	dent = calloc(1, ALIGN(len, 8));
+	if (!dent)
+		return -ENOMEM;
+	dent->ch.node_type = UBIFS_DENT_NODE;
+	dent_key_init(c, &key, UBIFS_ROOT_INO, &nm);
+	key_write(c, &key, dent->key);
+	dent->inum = cpu_to_le64(inum);
+	dent->type = UBIFS_ITYPE_REG;
+	dent->nlen = cpu_to_le16(nm.len);
+	memcpy(dent->name, name, nm.len);
+	err = ubifs_test_add(img, dent, len, &key);
+	free(dent);
+
+	return err;
+}
+
+static int ubifs_test_add_data(struct ubifs_test_img *img,
+			       struct ubifs_data_node *dn, ino_t inum,
+			       const struct ubifs_test_file *file)
+{
+	struct ubifs_info *c = img->c;
+	union ubifs_key key;
+	int block, size, i, err;
+
+	for (block = 0; block * UBIFS_BLOCK_SIZE < file->size; block++) {
+		if (block >= file->hole && block < file->hole + file->holes)
+			continue;
+		size = min(file->size - block * UBIFS_BLOCK_SIZE,
+			   UBIFS_BLOCK_SIZE);
+		memset(dn, '\0', UBIFS_DATA_NODE_SZ);
+		dn->ch.node_type = UBIFS_DATA_NODE;
+		data_key_init(c, &key, inum, block);
+		key_write(c, &key, dn->key);
+		dn->size = cpu_to_le32(size);
+		dn->compr_type = cpu_to_le16(UBIFS_COMPR_NONE);
+		for (i = 0; i < size; i++) {
+			dn->data[i] = ubifs_test_byte(inum,
+					block * UBIFS_BLOCK_SIZE + i);
+		}
+		err = ubifs_test_add(img, dn, UBIFS_DATA_NODE_SZ + size, &key);
+		if (err)
+			return err;
+	}
+
+	return 0;
+}
+
+/* Writes a node padded to a whole I/O unit at the start of a LEB */
+static int ubifs_test_write_node(struct ubifs_info *c, void *node, int len,
+				 int lnum)
+{
+	ubifs_prepare_node(c, node, len, 1);
+
+	return ubi_leb_change(c->ubi, lnum, node, ALIGN(len, c->min_io_size));
+}
+
+/* Adds the files to the root directory, their names sorted by hash */
+static int ubifs_test_add_files(struct ubifs_test_img *img,
+				const struct ubifs_test_file *files, int cnt)
+{
+	struct ubifs_info *c = img->c;
+	struct ubifs_data_node *dn;
+	int order[cnt];
+	int i, j, err;
+
+	for (i = 0; i < cnt; i++) {
+		for (j = i; j > 0 &&
+		     c->key_hash(files[order[j - 1]].name,
+				 strlen(files[order[j - 1]].name)) >
+		     c->key_hash(files[i].name, strlen(files[i].name)); j--)
+			order[j] = order[j - 1];
+		order[j] = i;
+	}
+
+	err = ubifs_test_add_ino(img, UBIFS_ROOT_INO, S_IFDIR | 0755, 2,
+				 UBIFS_INO_NODE_SZ);
+	for (i = 0; !err && i < cnt; i++) {
+		err = ubifs_test_add_dent(img, UBIFS_FIRST_INO + order[i],
+					  files[order[i]].name);
+	}
+	if (err)
+		return err;
+
+	dn = malloc(UBIFS_MAX_DATA_NODE_SZ);
+	if (!dn)
+		return -ENOMEM;
+	for (i = 0; !err && i < cnt; i++) {
+		err = ubifs_test_add_ino(img, UBIFS_FIRST_INO + i,
+					 S_IFREG | 0644, 1, files[i].size);
+		if (!err) {
+			err = ubifs_test_add_data(img, dn, UBIFS_FIRST_INO + i,
+						  &files[i]);
+		}
+	}
+	free(dn);
+	if (!err)
+		err = ubifs_test_add_index(img);
+	if (!err && img->offs)
+		err = ubifs_test_flush(img);
+
+	return err;
+}
+
+/*
+ * Writes the superblock, the master nodes, the LPT and the log, following
+ * 'create_default_filesystem()' in the kernel
+ */
+static int ubifs_test_write_fs(struct ubifs_test_img *img, int log_lebs,
+			       int orph_lebs, int main_lebs, int lpt_lebs,
+			       int big_lpt, int files)
+{
+	struct ubifs_info *c = img->c;
+	int main_first = c->leb_cnt - main_lebs;
+	int data_lebs = img->lnum - main_first - 1;
+	int idx_len = ubifs_idx_node_sz(c, le16_to_cpu(img->root->child_cnt));
+	struct ubifs_sb_node *sup;
+	struct ubifs_mst_node *mst;
+	struct ubifs_cs_node *cs;
+	int err;
+
+	/* The root index node has a LEB of its own */
+	err = ubifs_test_write_node(c, img->root, idx_len, main_first);
+	if (err)
+		return err;
+
+	sup = calloc(1, ALIGN(UBIFS_SB_NODE_SZ, c->min_io_size));
+	if (!sup)
+		return -ENOMEM;
+	sup->ch.node_type = UBIFS_SB_NODE;
+	sup->key_hash = UBIFS_KEY_HASH_R5;
+	sup->key_fmt = UBIFS_SIMPLE_KEY_FMT;
+	sup->flags = cpu_to_le32(big_lpt ? UBIFS_FLG_BIGLPT : 0);
+	sup->min_io_size = cpu_to_le32(c->min_io_size);
+	sup->leb_size = cpu_to_le32(c->leb_size);
+	sup->leb_cnt = cpu_to_le32(c->leb_cnt);
+	sup->max_leb_cnt = cpu_to_le32(c->max_leb_cnt);
+	sup->max_bud_bytes = cpu_to_le64((long long)UBIFS_MIN_BUD_LEBS *
+					 c->leb_size);
+	sup->log_lebs = cpu_to_le32(log_lebs);
+	sup->lpt_lebs = cpu_to_le32(lpt_lebs);
+	sup->orph_lebs = cpu_to_le32(orph_lebs);
+	sup->jhead_cnt = cpu_to_le32(1);
+	sup->fanout = cpu_to_le32(UBIFS_TEST_FANOUT);
+	sup->lsave_cnt = cpu_to_le32(c->lsave_cnt);
+	sup->fmt_version = cpu_to_le32(UBIFS_FORMAT_VERSION);
+	sup->time_gran = cpu_to_le32(1000000000);
+	sup->default_compr = cpu_to_le16(UBIFS_COMPR_NONE);
+	sup->ro_compat_version = cpu_to_le32(UBIFS_RO_COMPAT_VERSION);
+	err = ubifs_test_write_node(c, sup, UBIFS_SB_NODE_SZ, UBIFS_SB_LNUM);
+	free(sup);
+	if (err)
+		return err;
+
+	cs = calloc(1, ALIGN(UBIFS_CS_NODE_SZ, c->min_io_size));
+	if (!cs)
+		return -ENOMEM;
+	cs->ch.node_type = UBIFS_CS_NODE;
+	err = ubifs_test_write_node(c, cs, UBIFS_CS_NODE_SZ, UBIFS_LOG_LNUM);
+	free(cs);
+	if (err)
+		return err;
+
+	mst = calloc(1, ALIGN(UBIFS_MST_NODE_SZ, c->min_io_size));
+	if (!mst)
+		return -ENOMEM;
+	mst->ch.node_type = UBIFS_MST_NODE;
+	mst->log_lnum = cpu_to_le32(UBIFS_LOG_LNUM);
+	mst->highest_inum = cpu_to_le64(UBIFS_FIRST_INO + files - 1);
+	mst->root_lnum = cpu_to_le32(main_first);
+	mst->root_len = cpu_to_le32(idx_len);
+	mst->gc_lnum = cpu_to_le32(img->lnum);
+	mst->ihead_lnum = cpu_to_le32(main_first);
+	mst->ihead_offs = cpu_to_le32(ALIGN(idx_len, c->min_io_size));
+	mst->index_size = cpu_to_le64(img->idx_size + ALIGN(idx_len, 8));
+	mst->lpt_lnum = cpu_to_le32(c->lpt_lnum);
+	mst->lpt_offs = cpu_to_le32(c->lpt_offs);
+	mst->nhead_lnum = cpu_to_le32(c->nhead_lnum);
+	mst->nhead_offs = cpu_to_le32(c->nhead_offs);
+	mst->ltab_lnum = cpu_to_le32(c->ltab_lnum);
+	mst->ltab_offs = cpu_to_le32(c->ltab_offs);
+	mst->lsave_lnum = cpu_to_le32(c->lsave_lnum);
+	mst->lsave_offs = cpu_to_le32(c->lsave_offs);
+	mst->lscan_lnum = cpu_to_le32(main_first);
+	mst->empty_lebs = cpu_to_le32(main_lebs - 1 - data_lebs);
+	mst->idx_lebs = cpu_to_le32(1);
+	mst->leb_cnt = cpu_to_le32(c->leb_cnt);
+	mst->total_free = cpu_to_le64((long long)(main_lebs - 1 - data_lebs) *
+				      c->leb_size);
+	mst->total_used = cpu_to_le64(img->used + ALIGN(idx_len, 8));
+	err = ubifs_test_write_node(c, mst, UBIFS_MST_NODE_SZ, UBIFS_MST_LNUM);
+	if (!err) {
+		err = ubifs_test_write_node(c, mst, UBIFS_MST_NODE_SZ,
+					    UBIFS_MST_LNUM + 1);
+	}
+	free(mst);
+
+	return err;
+}
+
+/* Formats the volume and adds the files */
+static int ubifs_test_mkfs(struct ubi_volume_desc *desc,
+			   const struct ubifs_test_file *files, int cnt)
+{
+	int main_lebs, lpt_lebs, log_lebs, orph_lebs, big_lpt;
+	struct ubi_device_info di;
+	struct ubi_volume_info vi;
+	struct ubifs_test_img img;
+	struct ubifs_info *c;
+	int err = -ENOMEM;
+
+	memset(&img, '\0', sizeof(img));
+	c = calloc(1, sizeof(*c));
+	if (!c)
+		return -ENOMEM;
+	ubi_get_volume_info(desc, &vi);
+	ubi_get_device_info(vi.ubi_num, &di);
+	c->ubi = desc;
+	c->leb_size = vi.usable_leb_size;
+	c->leb_cnt = vi.size;
+	c->max_leb_cnt = c->leb_cnt;
+	c->min_io_size = di.min_io_size;
+	c->key_len = UBIFS_SK_LEN;
+	c->key_fmt = UBIFS_SIMPLE_KEY_FMT;
+	c->key_hash = key_r5_hash;
+	c->lsave_cnt = 256;
+	img.c = c;
+
+	/* The log only has to hold the commit start node */
+	log_lebs = UBIFS_MIN_LOG_LEBS;
+	orph_lebs = UBIFS_MIN_ORPH_LEBS;
+	main_lebs = c->leb_cnt - UBIFS_SB_LEBS - UBIFS_MST_LEBS - log_lebs -
+		orph_lebs;
+	/*
+	 * The LPT describes the empty file-system, with the root index node
+	 * in the first main LEB. That is all a read-only mount checks.
+	 */
+	err = ubifs_create_dflt_lpt(c, &main_lebs, UBIFS_LOG_LNUM + log_lebs,
+				    &lpt_lebs, &big_lpt);
+	if (err)
+		goto out;
+
+	err = -ENOMEM;
+	img.idx = calloc(1, ubifs_idx_node_sz(c, UBIFS_TEST_MAX_NODES));
+	img.root = calloc(1, ALIGN(ubifs_idx_node_sz(c, UBIFS_TEST_FANOUT),
+				   c->min_io_size));
+	img.buf = malloc(c->leb_size);
+	if (!img.idx || !img.root || !img.buf)
+		goto out;
+	img.lnum = c->leb_cnt - main_lebs + 1;
+
+	err = ubifs_test_add_files(&img, files, cnt);
+	if (!err) {
+		err = ubifs_test_write_fs(&img, log_lebs, orph_lebs, main_lebs,
+					  lpt_lebs, big_lpt, cnt);
+	}
+
+out:
+	free(img.buf);
+	free(img.root);
+	free(img.idx);
+	free(c);
+
+	return err;
+}
+
+/* Creates a NAND device with a UBI volume holding a UBIFS with the files */
+static int ubifs_test_create(struct unit_test_state *uts,
+			     const struct ubifs_test_file *files, int cnt,
+			     struct udevice **devp, int *ubi_nump)
+{
+	struct sandbox_mtd_platdata *plat;
+	struct ubi_volume_desc *desc;
+	struct ubi_mkvol_req req;
+	struct ubi_device *ubi;
+	struct mtd_info *mtd;
+	struct udevice *dev;
+	char name[30];
+	int num;
+
+	ut_assertok(device_bind_driver(dm_root(), "sandbox_mtd", "ubifs-test",
+				       &dev));
+	plat = dev_get_platdata(dev);
+	plat->size = SZ_64M;
+	plat->erasesize = SZ_128K;
+	plat->writesize = SZ_2K;
+	plat->subpage_sft = 2;
+	ut_assertok(device_probe(dev));
+	mtd = dev_get_uclass_priv(dev);
+
+	ut_assertok(ubi_init());
+	ut_assert(!IS_ERR(get_mtd_device(mtd, -1)));
+	num = ubi_attach_mtd_dev(mtd, UBI_DEV_NUM_AUTO, 0, 0);
+	ut_assert(num >= 0);
+
+	memset(&req, '\0', sizeof(req));
+	req.vol_id = UBI_VOL_NUM_AUTO;
+	req.alignment = 1;
+	req.bytes = UBIFS_TEST_VOL_SIZE;
+	req.vol_type = UBI_DYNAMIC_VOLUME;
+	strcpy(req.name, UBIFS_TEST_VOL);
+	req.name_len = strlen(UBIFS_TEST_VOL);
+	ubi = ubi_get_device(num);
+	ut_assertnonnull(ubi);
+	ut_assertok(ubi_create_volume(ubi, &req));
+	ubi_put_device(ubi);
+
+	desc = ubi_open_volume_nm(num, UBIFS_TEST_VOL, UBI_READWRITE);
+	ut_assert(!IS_ERR(desc));
+	ut_assertok(ubifs_test_mkfs(desc, files, cnt));
+	ubi_close_volume(desc);
+
+	ut_assertok(ubifs_init());
+	snprintf(name, sizeof(name), "ubi%d:%s", num, UBIFS_TEST_VOL);
+	ut_assertok(uboot_ubifs_mount(name));
+	*devp = dev;
+	*ubi_nump = num;
+
+	return 0;
+}
+
+static int ubifs_test_destroy(struct unit_test_state *uts,
+			      struct udevice *dev, int ubi_num)
+{
+	uboot_ubifs_umount();
+	ut_assertok(ubi_detach_mtd_dev(ubi_num, 1));
+	ubi_exit();
+	ut_assertok(device_remove(dev));
+	ut_assertok(device_unbind(dev));
+
+	return 0;
+}
+
+/*
+ * Reads part of a file, checks the contents and that nothing after it was
+ * overwritten. Returns the number of read calls made to the NAND device.
+ */
+static int ubifs_test_read(struct unit_test_state *uts, struct udevice *dev,
+			   const struct ubifs_test_file *files, int file,
+			   int offset, int size, uint *readsp)
+{
+	const struct ubifs_test_file *f = &files[file];
+	int expect = size ? size : f->size - offset;
+	struct sandbox_mtd_stats stats;
+	loff_t actread;
+	u8 *buf;
+	int i;
+
+	buf = malloc(expect + 1);
+	ut_assertnonnull(buf);
+	buf[expect] = 0xa5;
+	sandbox_mtd_get_stats(dev, &stats);
+	ut_assertok(ubifs_read(f->name, buf, offset, size, &actread));
+	sandbox_mtd_get_stats(dev, &stats);
+	ut_asserteq(expect, actread);
+	ut_asserteq(0xa5, buf[expect]);
+	for (i = 0; i < expect; i++) {
+		int pos = offset + i;
+		int block = pos >> UBIFS_BLOCK_SHIFT;
+		u8 val = 0;
+
+		if (block < f->hole || block >= f->hole + f->holes)
+			val = ubifs_test_byte(UBIFS_FIRST_INO + file, pos);
+		ut_asserteq(val, buf[i]);
+	}
+	free(buf);
+	*readsp = stats.reads;
+
+	return 0;
+}
+
+static const struct ubifs_test_file ubifs_test_files[] = {
+	{ "small", 100, -1, 0 },
+	{ "big", 64 * UBIFS_BLOCK_SIZE + 123, 10, 1 },
+	/* A hole too big for one bulk read, with data after it */
+	{ "sparse", 100 * UBIFS_BLOCK_SIZE, 5, 2 * UBIFS_MAX_BULK_READ + 3 },
+};
+
+/* Test that data nodes are read in bulk and that blocks are cached */
+static int dm_test_ubifs_read(struct unit_test_state *uts)
+{
+	const int big_blocks = DIV_ROUND_UP(ubifs_test_files[1].size,
+					    UBIFS_BLOCK_SIZE);
+	uint small, again, big;
+	struct ubifs_info *c;
+	struct udevice *dev;
+	int num;
+
+	ut_assertok(ubifs_test_create(uts, ubifs_test_files,
+				      ARRAY_SIZE(ubifs_test_files), &dev,
+				      &num));
+
+	/*
+	 * The second time, the data node comes from the block cache. Once
+	 * the cache is emptied, it has to be read from flash again.
+	 */
+	ut_assertok(ubifs_test_read(uts, dev, ubifs_test_files, 0, 0, 0,
+				    &small));
+	ut_assertok(ubifs_test_read(uts, dev, ubifs_test_files, 0, 0, 0,
+				    &again));
+	c = ubifs_sb->s_fs_info;
+	ut_assertnonnull(c->blk_cache);
+	memset(c->blk_cache, '\0', UBIFS_BLK_CACHE_CNT * sizeof(*c->blk_cache));
+	ut_assertok(ubifs_test_read(uts, dev, ubifs_test_files, 0, 0, 0,
+				    &small));
+	ut_asserteq(again + 1, small);
+
+	/*
+	 * Looking up the file costs as much as for the small one, the data
+	 * nodes take one read per UBIFS_MAX_BULK_READ nodes and per LEB
+	 */
+	ut_assertok(ubifs_test_read(uts, dev, ubifs_test_files, 1, 0, 0,
+				    &big));
+	ut_assert(big <= again + big_blocks / UBIFS_MAX_BULK_READ +
+		  DIV_ROUND_UP(big_blocks * UBIFS_MAX_DATA_NODE_SZ,
+			       SZ_128K) + 1);
+
+	/* Parts of the file, with a hole and a short last block */
+	ut_assertok(ubifs_test_read(uts, dev, ubifs_test_files, 1,
+				    8 * UBIFS_BLOCK_SIZE,
+				    3 * UBIFS_BLOCK_SIZE + 10, &big));
+	ut_assertok(ubifs_test_read(uts, dev, ubifs_test_files, 1,
+				    63 * UBIFS_BLOCK_SIZE, 0, &big));
+	ut_assertok(ubifs_test_read(uts, dev, ubifs_test_files, 1,
+				    10 * UBIFS_BLOCK_SIZE, UBIFS_BLOCK_SIZE,
+				    &big));
+
+	/* The data after a large hole, and parts starting inside it */
+	ut_assertok(ubifs_test_read(uts, dev, ubifs_test_files, 2, 0, 0,
+				    &big));
+	ut_assertok(ubifs_test_read(uts, dev, ubifs_test_files, 2,
+				    20 * UBIFS_BLOCK_SIZE, 0, &big));
+	ut_assertok(ubifs_test_read(uts, dev, ubifs_test_files, 2,
+				    6 * UBIFS_BLOCK_SIZE,
+				    70 * UBIFS_BLOCK_SIZE + 5, &big));
+
+	ut_assertok(ubifs_test_destroy(uts, dev, num));
+
+	return 0;
+}
+DM_TEST(dm_test_ubifs_read, 0);
+
+/*
+ * Measure the time taken to read files of different sizes, which must be
+ * read in bulk like the big file in dm_test_ubifs_read()
+ */
+static int dm_test_ubifs_read_bench(struct unit_test_state *uts)
+{
+	static const struct ubifs_test_file files[] = {
+		{ "small", 100, -1, 0 },
+		{ "256k", SZ_256K, -1, 0 },
+		{ "1m", SZ_1M, -1, 0 },
+		{ "4m", SZ_4M, -1, 0 },
+	};
+	struct udevice *dev;
+	ulong start, elapsed;
+	uint lookup, reads;
+	int num, blocks, i;
+
+	ut_assertok(ubifs_test_create(uts, files, ARRAY_SIZE(files), &dev,
+				      &num));
+
+	/* Reading the small file again only costs the lookup */
+	ut_assertok(ubifs_test_read(uts, dev, files, 0, 0, 0, &reads));
+	ut_assertok(ubifs_test_read(uts, dev, files, 0, 0, 0, &lookup));
+	for (i = 1; i < ARRAY_SIZE(files); i++) {
+		blocks = files[i].size / UBIFS_BLOCK_SIZE;
+		start = timer_get_us();
+		ut_assertok(ubifs_test_read(uts, dev, files, i, 0, 0, &reads));
+		elapsed = timer_get_us() - start;
+		printf("%7d bytes: %5u reads, %7lu us\n", files[i].size, reads,
+		       elapsed);
+		ut_assert(reads <= lookup + blocks / UBIFS_MAX_BULK_READ +
+			  DIV_ROUND_UP(blocks * UBIFS_MAX_DATA_NODE_SZ,
+				       SZ_128K) + 1);
+	}
+	ut_assertok(ubifs_test_destroy(uts, dev, num));
+
+	return 0;
+}
+DM_TEST(dm_test_ubifs_read_bench, 0);
@@ -7,6 +7,7 @@
 #include <common.h>
 #include <console.h>
 #include <dm.h>
+#include <malloc.h>
 #include <usb.h>
 #include <asm/io.h>
 #include <asm/state.h>
@@ -14,6 +15,7 @@
 #include <dm/device-internal.h>
 #include <dm/test.h>
 #include <dm/uclass-internal.h>
+#include <linux/sizes.h>
 #include <test/ut.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -58,6 +60,68 @@ static int dm_test_usb_flash(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_usb_flash, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
 
+/*
+ * Read the whole flash stick, with the controller limited to max_xfer
+ * bytes per transfer (0 for no limit), and check the transfers it took
+ */
+static int usb_flash_read_bench(struct unit_test_state *uts, size_t max_xfer)
+{
+	struct sandbox_flash_stats before, after;
+	struct udevice *dev, *emul;
+	struct blk_desc *dev_desc;
+	ulong start, elapsed, count;
+	uint max_blk, reads;
+	char *buf;
+	int cmp;
+
+	ut_assertok(usb_init());
+	ut_assertok(uclass_get_device(UCLASS_MASS_STORAGE, 0, &dev));
+	ut_assertok(usb_emul_find_for_dev(dev, &emul));
+	ut_assertok(blk_get_device_by_str("usb", "0", &dev_desc));
+	buf = malloc(dev_desc->lba * dev_desc->blksz);
+	ut_assertnonnull(buf);
+
+	sandbox_flash_get_stats(emul, &before);
+	start = timer_get_us();
+	count = blk_dread(dev_desc, 0, dev_desc->lba, buf);
+	elapsed = timer_get_us() - start;
+	sandbox_flash_get_stats(emul, &after);
+	cmp = strcmp(buf, "this is a test");
+	free(buf);
+	ut_asserteq(dev_desc->lba, count);
+	ut_assertok(cmp);
+
+	/* The transfers use the most blocks the controller allows */
+	max_blk = max_xfer ? max_xfer / 512 : 65535;
+	reads = after.reads - before.reads;
+	ut_asserteq(DIV_ROUND_UP(dev_desc->lba, max_blk), reads);
+	ut_asserteq(dev_desc->lba, after.read_blocks - before.read_blocks);
+	printf("%7lu bytes per transfer: %5u reads, %7lu us\n",
+	       (ulong)max_blk * 512, reads, elapsed);
+
+	return 0;
+}
+
+/* Read the whole flash stick with different controller transfer limits */
+static int dm_test_usb_flash_read_bench(struct unit_test_state *uts)
+{
+	static const size_t sizes[] = { 20 * 512, SZ_64K, SZ_1M, 0 };
+	int ret = 0;
+	int i;
+
+	state_set_skip_delays(true);
+	for (i = 0; !ret && i < ARRAY_SIZE(sizes); i++) {
+		sandbox_usb_set_max_xfer_size(sizes[i]);
+		ret = usb_flash_read_bench(uts, sizes[i]);
+		usb_stop();
+	}
+	sandbox_usb_set_max_xfer_size(0);
+	ut_assertok(ret);
+
+	return 0;
+}
+DM_TEST(dm_test_usb_flash_read_bench, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
 /* test that we can handle multiple storage devices */
 static int dm_test_usb_multi(struct unit_test_state *uts)
 {
@@ -74,6 +138,30 @@ static int dm_test_usb_multi(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_usb_multi, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
 
+/* test that ports waiting on real delays are still set up in port order */
+static int dm_test_usb_port_order(struct unit_test_state *uts)
+{
+	struct usb_device *udev;
+	struct udevice *dev;
+	char name[20];
+	int i;
+
+	state_set_skip_delays(false);
+	ut_assertok(usb_init());
+	for (i = 0; i < 3; i++) {
+		ut_assertok(uclass_get_device(UCLASS_MASS_STORAGE, i, &dev));
+		udev = dev_get_parent_priv(dev);
+		snprintf(name, sizeof(name), "flash-stick@%d", i);
+		ut_asserteq_str(name, udev->serial);
+		ut_asserteq(i + 1, udev->portnr);
+		ut_asserteq(i + 2, udev->devnum);
+	}
+	ut_assertok(usb_stop());
+
+	return 0;
+}
+DM_TEST(dm_test_usb_port_order, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
 static int count_usb_devices(void)
 {
 	struct udevice *hub;
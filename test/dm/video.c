@@ -135,6 +135,135 @@ static int dm_test_video_text(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_video_text, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
 
+/* Test that only the lines drawn on are marked for syncing */
+static int dm_test_video_damage(struct unit_test_state *uts)
+{
+	struct udevice *dev, *con;
+	struct video_priv *priv;
+
+	ut_assertok(select_vidconsole(uts, "vidconsole0"));
+	ut_assertok(uclass_get_device(UCLASS_VIDEO, 0, &dev));
+	ut_assertok(uclass_get_device(UCLASS_VIDEO_CONSOLE, 0, &con));
+	priv = dev_get_uclass_priv(dev);
+
+	/* Probing clears the whole display */
+	ut_asserteq(0, priv->damage_ystart);
+	ut_asserteq(768, priv->damage_yend);
+
+	priv->damage_yend = 0;
+	vidconsole_putc_xy(con, 0, 32, 'a');
+	ut_asserteq(32, priv->damage_ystart);
+	ut_asserteq(48, priv->damage_yend);
+
+	vidconsole_set_row(con, 4, WHITE);
+	ut_asserteq(32, priv->damage_ystart);
+	ut_asserteq(80, priv->damage_yend);
+
+	/* Off-screen damage is clipped */
+	video_damage(dev, 760, 100);
+	ut_asserteq(768, priv->damage_yend);
+
+	return 0;
+}
+DM_TEST(dm_test_video_damage, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/*
+ * Draw a line of text on the first row with the glyph cache on or off, and
+ * compare it with @expect, or copy it to @expect if @copy is true
+ */
+static int draw_glyph_line(struct unit_test_state *uts, struct udevice *con,
+			   bool cache, void *expect, bool copy)
+{
+	struct vidconsole_priv *vc_priv = dev_get_uclass_priv(con);
+	struct video_priv *priv = dev_get_uclass_priv(con->parent);
+	int size = vc_priv->y_charsize * priv->line_length;
+	int i;
+
+	console_normal_set_glyph_cache(con, cache);
+	vidconsole_set_row(con, 0, WHITE);
+	/* Each character is drawn twice, the second time from the cache */
+	for (i = 0; i < 80; i++)
+		vidconsole_putc_xy(con, VID_TO_POS(i * 8), 0, ' ' + i % 40);
+	if (copy)
+		memcpy(expect, priv->fb, size);
+	else
+		ut_assertok(memcmp(expect, priv->fb, size));
+
+	return 0;
+}
+
+/* Test that cached glyphs draw the same as the font, in any colour */
+static int dm_test_video_glyph_cache(struct unit_test_state *uts)
+{
+	struct vidconsole_priv *vc_priv;
+	struct udevice *dev, *con;
+	struct video_priv *priv;
+	void *expect;
+
+	ut_assertok(select_vidconsole(uts, "vidconsole0"));
+	ut_assertok(uclass_get_device(UCLASS_VIDEO, 0, &dev));
+	ut_assertok(uclass_get_device(UCLASS_VIDEO_CONSOLE, 0, &con));
+	priv = dev_get_uclass_priv(dev);
+	vc_priv = dev_get_uclass_priv(con);
+	expect = malloc(vc_priv->y_charsize * priv->line_length);
+	ut_assertnonnull(expect);
+
+	ut_assertok(draw_glyph_line(uts, con, false, expect, true));
+	ut_assertok(draw_glyph_line(uts, con, true, expect, false));
+	ut_assertok(draw_glyph_line(uts, con, true, expect, false));
+
+	/* New colours must not use the glyphs rendered in the old ones */
+	priv->colour_fg = 0x1234;
+	priv->colour_bg = 0x5678;
+	ut_assertok(draw_glyph_line(uts, con, false, expect, true));
+	ut_assertok(draw_glyph_line(uts, con, true, expect, false));
+	free(expect);
+
+	return 0;
+}
+DM_TEST(dm_test_video_glyph_cache, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Print @count lines of the test string on a console */
+static void put_bench_lines(struct udevice *con, int count)
+{
+	const char *test_string =
+		"The quick brown fox jumps over the lazy dog 0123456789\n";
+	const char *s;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		for (s = test_string; *s; s++)
+			vidconsole_put_char(con, *s);
+	}
+}
+
+/* Measure how long it takes to print a screenful of lines several times */
+static int dm_test_video_text_bench(struct unit_test_state *uts)
+{
+	struct vidconsole_priv *vc_priv;
+	struct udevice *dev, *con;
+	ulong start;
+
+	ut_assertok(select_vidconsole(uts, "vidconsole0"));
+	ut_assertok(uclass_get_device(UCLASS_VIDEO, 0, &dev));
+	ut_assertok(uclass_get_device(UCLASS_VIDEO_CONSOLE, 0, &con));
+	vc_priv = dev_get_uclass_priv(con);
+	start = timer_get_us();
+	put_bench_lines(con, 500);
+	printf("500 lines: %lu us\n", timer_get_us() - start);
+
+	/* Every row but the last shows the string */
+	ut_asserteq(1088, compress_frame_buffer(dev));
+
+	/* A screenful drawn without the glyph cache looks the same */
+	console_normal_set_glyph_cache(con, false);
+	put_bench_lines(con, vc_priv->rows);
+	ut_asserteq(1088, compress_frame_buffer(dev));
+
+	return 0;
+}
+DM_TEST(dm_test_video_text_bench, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
 /* Test handling of special characters in the console */
 static int dm_test_video_chars(struct unit_test_state *uts)
 {
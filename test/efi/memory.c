@@ -0,0 +1,188 @@
+/*
+ * Tests for the EFI loader memory map and pool allocator
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <efi_loader.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <test/efi.h>
+#include <test/ut.h>
+
+#define EFI_TEST_ALLOCS		512
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Reads the memory map into a malloc()ed buffer */
+static struct efi_mem_desc *efi_test_get_map(unsigned long *size)
+{
+	struct efi_mem_desc *map;
+
+	*size = 0;
+	efi_get_memory_map(size, NULL, NULL, NULL, NULL);
+	map = malloc(*size);
+	if (map && efi_get_memory_map(size, map, NULL, NULL, NULL) !=
+	    EFI_SUCCESS) {
+		free(map);
+		map = NULL;
+	}
+
+	return map;
+}
+
+/* Checks that the map is sorted and contains no overlapping entries */
+static int efi_test_check_map(struct unit_test_state *uts)
+{
+	struct efi_mem_desc *map;
+	unsigned long size;
+	int i;
+
+	map = efi_test_get_map(&size);
+	ut_assertnonnull(map);
+	for (i = 1; i < size / sizeof(*map); i++) {
+		ut_assert(map[i - 1].physical_start +
+			  (map[i - 1].num_pages << EFI_PAGE_SHIFT) <=
+			  map[i].physical_start);
+	}
+	free(map);
+
+	return 0;
+}
+
+/* Allocate and free many single pages, the map must end up unchanged */
+static int efi_test_pages_many(struct unit_test_state *uts)
+{
+	struct efi_mem_desc *before, *after;
+	unsigned long before_size, after_size;
+	uint64_t *addr;
+	int i;
+
+	before = efi_test_get_map(&before_size);
+	ut_assertnonnull(before);
+	addr = calloc(EFI_TEST_ALLOCS, sizeof(*addr));
+	ut_assertnonnull(addr);
+
+	for (i = 0; i < EFI_TEST_ALLOCS; i++) {
+		ut_asserteq(EFI_SUCCESS,
+			    efi_allocate_pages(0, EFI_LOADER_DATA, 1,
+					       &addr[i]));
+		ut_asserteq(0, addr[i] & EFI_PAGE_MASK);
+		/* Memory is handed out from the top down */
+		if (i)
+			ut_assert(addr[i] < addr[i - 1]);
+	}
+	ut_assertok(efi_test_check_map(uts));
+
+	/* Free every other page first to fragment the map */
+	for (i = 0; i < EFI_TEST_ALLOCS; i += 2)
+		ut_asserteq(EFI_SUCCESS, efi_free_pages(addr[i], 1));
+	ut_assertok(efi_test_check_map(uts));
+	for (i = 1; i < EFI_TEST_ALLOCS; i += 2)
+		ut_asserteq(EFI_SUCCESS, efi_free_pages(addr[i], 1));
+
+	after = efi_test_get_map(&after_size);
+	ut_assertnonnull(after);
+	ut_asserteq(before_size, after_size);
+	ut_assertok(memcmp(before, after, before_size));
+
+	free(after);
+	free(addr);
+	free(before);
+
+	return 0;
+}
+EFI_TEST(efi_test_pages_many, 0);
+
+/* An exact allocation over memory which is in use must fail */
+static int efi_test_pages_overlap(struct unit_test_state *uts)
+{
+	uint64_t addr, exact;
+
+	ut_asserteq(EFI_SUCCESS,
+		    efi_allocate_pages(0, EFI_LOADER_DATA, 4, &addr));
+	exact = addr + EFI_PAGE_SIZE;
+	ut_assert(efi_allocate_pages(2, EFI_LOADER_DATA, 1, &exact) ==
+		  EFI_OUT_OF_RESOURCES);
+	ut_asserteq(EFI_SUCCESS, efi_free_pages(addr, 4));
+	ut_asserteq(EFI_SUCCESS,
+		    efi_allocate_pages(2, EFI_LOADER_DATA, 1, &exact));
+	ut_asserteq(addr + EFI_PAGE_SIZE, exact);
+	ut_asserteq(EFI_SUCCESS, efi_free_pages(exact, 1));
+	ut_assertok(efi_test_check_map(uts));
+
+	return 0;
+}
+EFI_TEST(efi_test_pages_overlap, 0);
+
+/* Only whole pages from efi_allocate_pages() may be freed */
+static int efi_test_pages_bad_free(struct unit_test_state *uts)
+{
+	uint64_t addr;
+
+	ut_asserteq(EFI_SUCCESS,
+		    efi_allocate_pages(0, EFI_LOADER_DATA, 3, &addr));
+	ut_assert(efi_free_pages(addr + 1, 1) == EFI_INVALID_PARAMETER);
+	ut_assert(efi_free_pages(addr, 0) == EFI_INVALID_PARAMETER);
+
+	/* Once the first page is freed, it is no longer part of the range */
+	ut_asserteq(EFI_SUCCESS, efi_free_pages(addr, 1));
+	ut_assert(efi_free_pages(addr, 1) == EFI_NOT_FOUND);
+	ut_assert(efi_free_pages(addr, 3) == EFI_NOT_FOUND);
+
+	/* Nor is U-Boot's own memory */
+	ut_assert(efi_free_pages(gd->start_addr_sp & ~EFI_PAGE_MASK, 1) ==
+		  EFI_NOT_FOUND);
+
+	ut_asserteq(EFI_SUCCESS, efi_free_pages(addr + EFI_PAGE_SIZE, 2));
+	ut_assertok(efi_test_check_map(uts));
+
+	return 0;
+}
+EFI_TEST(efi_test_pages_bad_free, 0);
+
+/* Allocate many pool objects of different sizes and check their contents */
+static int efi_test_pool_many(struct unit_test_state *uts)
+{
+	unsigned long size;
+	u8 **buf, *reuse;
+	int i;
+
+	buf = calloc(EFI_TEST_ALLOCS, sizeof(*buf));
+	ut_assertnonnull(buf);
+
+	for (i = 0; i < EFI_TEST_ALLOCS; i++) {
+		size = 1 + (i * 37) % 5000;
+		ut_asserteq(EFI_SUCCESS,
+			    efi_allocate_pool(EFI_BOOT_SERVICES_DATA, size,
+					      (void **)&buf[i]));
+		ut_asserteq(0, map_to_sysmem(buf[i]) & 7);
+		memset(buf[i], i & 0xff, size);
+	}
+
+	/* No allocation may have overwritten another one */
+	for (i = 0; i < EFI_TEST_ALLOCS; i++) {
+		size = 1 + (i * 37) % 5000;
+		ut_asserteq(i & 0xff, buf[i][0]);
+		ut_asserteq(i & 0xff, buf[i][size - 1]);
+	}
+
+	for (i = 0; i < EFI_TEST_ALLOCS; i++)
+		ut_asserteq(EFI_SUCCESS, efi_free_pool(buf[i]));
+
+	/* Freed objects are reused, buf[0] is the only one in its class */
+	ut_asserteq(EFI_SUCCESS,
+		    efi_allocate_pool(EFI_BOOT_SERVICES_DATA, 1,
+				      (void **)&reuse));
+	ut_asserteq_ptr(buf[0], reuse);
+	ut_asserteq(EFI_SUCCESS, efi_free_pool(reuse));
+	ut_assert(efi_free_pool(NULL) == EFI_INVALID_PARAMETER);
+	ut_assert(efi_allocate_pool(EFI_MAX_MEMORY_TYPE, 1, (void **)&reuse) ==
+		  EFI_INVALID_PARAMETER);
+	ut_assertok(efi_test_check_map(uts));
+	free(buf);
+
+	return 0;
+}
+EFI_TEST(efi_test_pool_many, 0);
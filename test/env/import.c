@@ -0,0 +1,67 @@
+/*
+ * Tests for importing the environment into a hash table
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <search.h>
+#include <test/env.h>
+#include <test/ut.h>
+
+static const char import_test_env[] = "foo=bar\0baud=115200\0esc=a\\b\0";
+
+/* Check that each variable made it into @htab */
+static int env_test_import_check(struct unit_test_state *uts,
+				 struct hsearch_data *htab)
+{
+	ENTRY e = { .key = "foo" }, *ep;
+
+	ut_assert(hsearch_r(e, FIND, &ep, htab, 0));
+	ut_asserteq_str("bar", ep->data);
+	e.key = "baud";
+	ut_assert(hsearch_r(e, FIND, &ep, htab, 0));
+	ut_asserteq_str("115200", ep->data);
+	e.key = "esc";
+	ut_assert(hsearch_r(e, FIND, &ep, htab, 0));
+	ut_asserteq_str("ab", ep->data);
+
+	return 0;
+}
+
+static int env_test_import_inplace(struct unit_test_state *uts)
+{
+	struct hsearch_data htab = { .table = NULL };
+	ENTRY e, *ep;
+	size_t size = sizeof(import_test_env);
+	char *buf;
+
+	buf = malloc(size);
+	ut_assertnonnull(buf);
+
+	/* Without H_INPLACE the buffer must be left alone */
+	memcpy(buf, import_test_env, size);
+	ut_assert(himport_r(&htab, buf, size, '\0', 0, 0, 0, NULL));
+	ut_assertok(env_test_import_check(uts, &htab));
+	ut_assertok(memcmp(buf, import_test_env, size));
+
+	/* With it we should get the same result, parsing the buffer */
+	ut_assert(himport_r(&htab, buf, size, '\0', H_INPLACE, 0, 0, NULL));
+	ut_assertok(env_test_import_check(uts, &htab));
+	ut_assert(memcmp(buf, import_test_env, size));
+
+	/* An unterminated buffer is copied, since it cannot be parsed */
+	memcpy(buf, "foo=bar\0baud=9600", 17);
+	ut_assert(himport_r(&htab, buf, 17, '\0', H_INPLACE, 0, 0, NULL));
+	ut_assertok(memcmp(buf, "foo=bar\0baud=9600", 17));
+	e.key = "baud";
+	ut_assert(hsearch_r(e, FIND, &ep, &htab, 0));
+	ut_asserteq_str("9600", ep->data);
+
+	hdestroy_r(&htab);
+	free(buf);
+
+	return 0;
+}
+ENV_TEST(env_test_import_inplace, 0);
@@ -0,0 +1,128 @@
+#!/bin/bash
+#
+# Check fw_setenv against a file-backed redundant environment and show how
+# many updates it manages per second
+#
+# SPDX-License-Identifier:	GPL-2.0+
+#
+# To run this:
+#
+# make O=sandbox sandbox_config
+# make O=sandbox env
+# ./test/env/test-fw-setenv.sh [count]
+
+BASEDIR=sandbox
+SRCDIR=${BASEDIR}/fw-env
+FW_PRINTENV=${SRCDIR}/fw_printenv
+FW_SETENV=${SRCDIR}/fw_setenv
+CONFIG=${SRCDIR}/fw_env.config
+COUNT=${1:-200}
+
+# Remove all the files we created
+cleanup()
+{
+	rm -rf ${SRCDIR}
+}
+
+fail()
+{
+	echo "Failed: $1"
+	cleanup
+	exit 1
+}
+
+# Set up two environment copies in files, one of them at an offset which is
+# not page-aligned
+create_files()
+{
+	mkdir -p ${SRCDIR}
+	ln -s ../tools/env/fw_printenv ${FW_PRINTENV}
+	ln -s ../tools/env/fw_printenv ${FW_SETENV}
+	head -c 65536 /dev/zero >${SRCDIR}/env0
+	head -c 65536 /dev/zero >${SRCDIR}/env1
+	echo "${SRCDIR}/env0 0x0000 0x4000" >${CONFIG}
+	echo "${SRCDIR}/env1 0x2200 0x4000" >>${CONFIG}
+
+	# Start with a valid environment
+	${FW_SETENV} -c ${CONFIG} start 1 2>/dev/null
+}
+
+# Print the number of operations per second
+# Args:
+#    description
+#    number of operations
+#    start time in ns
+#    end time in ns
+report()
+{
+	local ms=$((($4 - $3) / 1000000))
+
+	[ ${ms} -gt 0 ] || ms=1
+	echo "$1: $2 in ${ms} ms, $(($2 * 1000 / ms)) per second"
+}
+
+# Set a different value each time, so every call writes the environment
+bench_setenv()
+{
+	local start end i
+
+	start=$(date +%s%N)
+	for ((i = 0; i < COUNT; i++)); do
+		${FW_SETENV} -c ${CONFIG} health ${i} || fail "fw_setenv"
+	done
+	end=$(date +%s%N)
+	report "fw_setenv, changing value" ${COUNT} ${start} ${end}
+
+	[ "$(${FW_PRINTENV} -c ${CONFIG} -n health)" = "$((COUNT - 1))" ] ||
+		fail "value not updated"
+}
+
+# Set the same value each time, which should not write the environment
+bench_unchanged()
+{
+	local start end i sum
+
+	sum=$(cat ${SRCDIR}/env0 ${SRCDIR}/env1 | md5sum)
+	start=$(date +%s%N)
+	for ((i = 0; i < COUNT; i++)); do
+		${FW_SETENV} -c ${CONFIG} health $((COUNT - 1)) ||
+			fail "fw_setenv"
+	done
+	end=$(date +%s%N)
+	report "fw_setenv, same value" ${COUNT} ${start} ${end}
+
+	[ "$(cat ${SRCDIR}/env0 ${SRCDIR}/env1 | md5sum)" = "${sum}" ] ||
+		fail "environment written when nothing changed"
+}
+
+# Apply all the updates in a single script, with one write
+bench_script()
+{
+	local start end i
+
+	for ((i = 0; i < COUNT; i++)); do
+		echo "var${i} ${i}"
+	done >${SRCDIR}/script
+	start=$(date +%s%N)
+	${FW_SETENV} -c ${CONFIG} -s ${SRCDIR}/script || fail "fw_setenv -s"
+	end=$(date +%s%N)
+	report "fw_setenv -s" ${COUNT} ${start} ${end}
+
+	[ "$(${FW_PRINTENV} -c ${CONFIG} -n var$((COUNT - 1)))" = \
+		"$((COUNT - 1))" ] || fail "script not applied"
+}
+
+main()
+{
+	create_files
+
+	bench_setenv
+	bench_unchanged
+	bench_script
+
+	cleanup
+
+	echo "Tests passed."
+}
+
+main
@@ -0,0 +1,107 @@
+#!/bin/bash
+#
+# Check that mkimage produces the same FIT whether or not it uses several
+# threads for hashing, and show how long each takes
+#
+# SPDX-License-Identifier:	GPL-2.0+
+#
+# To run this:
+#
+# make O=sandbox sandbox_config
+# make O=sandbox
+# ./test/image/test-mkimage-jobs.sh [jobs]
+
+BASEDIR=sandbox
+SRCDIR=${BASEDIR}/fit-jobs
+MKIMAGE=${BASEDIR}/tools/mkimage
+IMAGE_COUNT=16
+IMAGE_SIZE=4194304
+IMAGE_FIT_ITS=${SRCDIR}/fit.its
+JOBS=${1:-$(nproc)}
+
+# Make the output reproducible
+export SOURCE_DATE_EPOCH=1
+
+# Remove all the files we created
+cleanup()
+{
+	rm -rf ${SRCDIR}
+}
+
+# Create some image files and a FIT source with several hashes for each
+create_files()
+{
+	local i
+
+	mkdir -p ${SRCDIR}
+	echo "/dts-v1/;" >${IMAGE_FIT_ITS}
+	echo "/ {" >>${IMAGE_FIT_ITS}
+	echo "	description = \"FIT image\";" >>${IMAGE_FIT_ITS}
+	echo "	#address-cells = <1>;" >>${IMAGE_FIT_ITS}
+	echo "	images {" >>${IMAGE_FIT_ITS}
+	for ((i = 1; i <= IMAGE_COUNT; i++)); do
+		head -c ${IMAGE_SIZE} /dev/urandom >${SRCDIR}/fdt${i}.dtb
+		cat >>${IMAGE_FIT_ITS} <<EOF
+		fdt@${i} {
+			description = "device tree ${i}";
+			data = /incbin/("fdt${i}.dtb");
+			type = "flat_dt";
+			arch = "sandbox";
+			compression = "none";
+			hash@1 {
+				algo = "sha1";
+			};
+			hash@2 {
+				algo = "sha256";
+			};
+			hash@3 {
+				algo = "crc32";
+			};
+			hash@4 {
+				algo = "md5";
+			};
+		};
+EOF
+	done
+	echo "	};" >>${IMAGE_FIT_ITS}
+	echo "	configurations {" >>${IMAGE_FIT_ITS}
+	echo "		default = \"conf@1\";" >>${IMAGE_FIT_ITS}
+	echo "		conf@1 {" >>${IMAGE_FIT_ITS}
+	echo "			fdt = \"fdt@1\";" >>${IMAGE_FIT_ITS}
+	echo "		};" >>${IMAGE_FIT_ITS}
+	echo "	};" >>${IMAGE_FIT_ITS}
+	echo "};" >>${IMAGE_FIT_ITS}
+}
+
+# Build the FIT, showing how long it takes
+# Args:
+#    number of jobs
+#    output file
+build_fit()
+{
+	local jobs="$1"
+	local out="$2"
+
+	echo -e "\nBuilding FIT image with ${jobs} job(s)..."
+	time ${MKIMAGE} -j ${jobs} -f ${IMAGE_FIT_ITS} ${out} >/dev/null
+}
+
+main()
+{
+	create_files
+
+	build_fit 1 ${SRCDIR}/serial.itb
+	build_fit ${JOBS} ${SRCDIR}/parallel.itb
+
+	if ! cmp ${SRCDIR}/serial.itb ${SRCDIR}/parallel.itb; then
+		echo "Failed."
+		cleanup
+		exit 1
+	fi
+
+	cleanup
+
+	echo "Tests passed."
+}
+
+main
@@ -0,0 +1,98 @@
+#!/bin/bash
+#
+# Check that mkimage and dumpimage can create and extract a large FIT
+# without holding the image data in memory
+#
+# SPDX-License-Identifier:	GPL-2.0+
+#
+# To run this:
+#
+# make O=sandbox sandbox_config
+# make O=sandbox
+# ./test/image/test-mkimage-rss.sh
+
+BASEDIR=sandbox
+SRCDIR=${BASEDIR}/fit-rss
+MKIMAGE=${BASEDIR}/tools/mkimage
+DUMPIMAGE=${BASEDIR}/tools/dumpimage
+TIME=/usr/bin/time
+IMAGE_SIZE_MB=128
+DATA=${SRCDIR}/kernel.bin
+FIT=${SRCDIR}/fit.itb
+
+# Maximum peak RSS allowed for each tool, in KB
+MAX_RSS=$((IMAGE_SIZE_MB * 1024 / 4))
+
+# Make the output reproducible
+export SOURCE_DATE_EPOCH=1
+
+# The peak RSS comes from GNU time, not from the shell's built-in
+if [ ! -x "${TIME}" ]; then
+	echo "Missing ${TIME} binary. Exiting!"
+	exit 1
+fi
+
+# Remove all the files we created
+cleanup()
+{
+	rm -rf ${SRCDIR}
+}
+
+# Run a command and check that its peak RSS is below the limit
+# Args:
+#    description
+#    command and arguments
+run_rss()
+{
+	local desc="$1"
+	local rss
+
+	shift
+	rss=$(${TIME} -f %M "$@" 2>&1 >/dev/null | tail -1)
+	echo "${desc}: peak RSS ${rss} KB"
+	if [ -z "${rss}" ] || [ "${rss}" -gt ${MAX_RSS} ]; then
+		echo "Failed: more than ${MAX_RSS} KB"
+		cleanup
+		exit 1
+	fi
+}
+
+# Extract the data from a FIT and check that it matches the original
+# Args:
+#    FIT to extract from
+check_extract()
+{
+	local fit="$1"
+
+	run_rss "Extract from $(basename ${fit})" \
+		${DUMPIMAGE} -T flat_dt -i ${fit} -p 0 ${SRCDIR}/out.bin
+	if ! cmp ${DATA} ${SRCDIR}/out.bin; then
+		echo "Failed: extracted data does not match"
+		cleanup
+		exit 1
+	fi
+}
+
+main()
+{
+	local mkargs="-f auto -A arm -O linux -T kernel -C none -a 0 -e 0"
+
+	mkdir -p ${SRCDIR}
+	head -c $((IMAGE_SIZE_MB * 1024 * 1024)) /dev/urandom >${DATA}
+
+	run_rss "Build FIT" ${MKIMAGE} ${mkargs} -d ${DATA} ${FIT}
+	check_extract ${FIT}
+
+	run_rss "Build FIT with external data" \
+		${MKIMAGE} ${mkargs} -E -d ${DATA} ${SRCDIR}/ext.itb
+	check_extract ${SRCDIR}/ext.itb
+
+	run_rss "Import external data" ${MKIMAGE} -F ${SRCDIR}/ext.itb
+	check_extract ${SRCDIR}/ext.itb
+
+	cleanup
+
+	echo "Tests passed."
+}
+
+main
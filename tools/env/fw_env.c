@@ -22,6 +22,7 @@
 #include <string.h>
 #include <sys/types.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -56,6 +57,8 @@ struct envdev_s {
 	ulong erase_size;		/* device erase size */
 	ulong env_sectors;		/* number of environment sectors */
 	uint8_t mtd_type;		/* type of the MTD device */
+	void *map;			/* mapping of the environment, if any */
+	size_t map_len;			/* length of the mapping */
 };
 
 static struct envdev_s envdevices[2] =
@@ -113,6 +116,9 @@ static int env_aes_cbc_crypt(char *data, const int enc, uint8_t *key);
 
 static int HaveRedundEnv = 0;
 
+/* Set when the environment must be written back by fw_env_close() */
+static int env_changed;
+
 static unsigned char active_flag = 1;
 /* obsolete_flag must be 0 to efficiently set it on NOR flash without erasing */
 static unsigned char obsolete_flag = 0;
@@ -301,6 +307,10 @@ int fw_env_close(struct env_opts *opts)
 	if (!opts)
 		opts = &default_opts;
 
+	/* Avoid wearing out the flash when nothing has changed */
+	if (!env_changed)
+		return 0;
+
 	if (opts->aes_flag) {
 		ret = env_aes_cbc_crypt(environment.data, 1,
 					opts->aes_key);
@@ -397,6 +407,12 @@ int fw_env_write(char *name, char *value)
 		/* Nothing to do */
 		return 0;
 
+	/* Setting a variable to its current value does not change anything */
+	if (overwriting && !strcmp(oldval, value))
+		return 0;
+
+	env_changed = 1;
+
 	if (deleting || overwriting) {
 		if (*++nxt == '\0') {
 			*env = '\0';
@@ -1019,6 +1035,52 @@ static int flash_write (int fd_current, int fd_target, int dev_target)
 	return 0;
 }
 
+/*
+ * Map the environment straight from the page cache on devices which are
+ * not MTD, e.g. block devices and files, instead of copying it. The
+ * mapping is private, so changes to the environment only reach the device
+ * when it is written out with flash_io (O_RDWR).
+ * Returns NULL if the environment cannot be mapped.
+ */
+static void *flash_map (int dev, int fd)
+{
+	long pagesize = sysconf(_SC_PAGESIZE);
+	off_t start, end;
+	void *map;
+
+	end = lseek(fd, 0, SEEK_END);
+	if (end < 0 || end < DEVOFFSET(dev) + ENVSIZE(dev))
+		return NULL;
+
+	start = DEVOFFSET(dev) & ~(pagesize - 1);
+	envdevices[dev].map_len = DEVOFFSET(dev) - start + ENVSIZE(dev);
+	map = mmap(NULL, envdevices[dev].map_len, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE, fd, start);
+	if (map == MAP_FAILED)
+		return NULL;
+	envdevices[dev].map = map;
+#ifdef DEBUG
+	fprintf(stderr, "Mapped 0x%lx bytes at 0x%lx on %s\n",
+		ENVSIZE(dev), DEVOFFSET(dev), DEVNAME(dev));
+#endif
+
+	return map + DEVOFFSET(dev) - start;
+}
+
+/* Release an environment image read by flash_read() */
+static void flash_free (int dev, void *image)
+{
+	if (envdevices[dev].map) {
+		munmap(envdevices[dev].map, envdevices[dev].map_len);
+		envdevices[dev].map = NULL;
+	} else {
+		free(image);
+	}
+}
+
+/*
+ * Read the environment of the current device into a new environment.image
+ */
 static int flash_read (int fd)
 {
 	struct mtd_info_user mtdinfo;
@@ -1054,6 +1116,20 @@ static int flash_read (int fd)
 
 	DEVTYPE(dev_current) = mtdinfo.type;
 
+	if (mtdinfo.type == MTD_ABSENT) {
+		environment.image = flash_map(dev_current, fd);
+		if (environment.image)
+			return 0;
+	}
+
+	environment.image = calloc(1, CUR_ENVSIZE);
+	if (environment.image == NULL) {
+		fprintf(stderr,
+			"Not enough memory for environment (%ld bytes)\n",
+			CUR_ENVSIZE);
+		return -1;
+	}
+
 	rc = flash_read_buf(dev_current, fd, environment.image, CUR_ENVSIZE,
 			     DEVOFFSET (dev_current), mtdinfo.type);
 	if (rc != CUR_ENVSIZE)
@@ -1163,16 +1239,11 @@ int fw_env_open(struct env_opts *opts)
 	if (parse_config(opts))		/* should fill envdevices */
 		return -1;
 
-	addr0 = calloc(1, CUR_ENVSIZE);
-	if (addr0 == NULL) {
-		fprintf(stderr,
-			"Not enough memory for environment (%ld bytes)\n",
-			CUR_ENVSIZE);
-		return -1;
-	}
-
 	/* read environment from FLASH to local buffer */
-	environment.image = addr0;
+	dev_current = 0;
+	if (flash_io (O_RDONLY))
+		return -1;
+	addr0 = environment.image;
 
 	if (HaveRedundEnv) {
 		redundant = addr0;
@@ -1186,10 +1257,6 @@ int fw_env_open(struct env_opts *opts)
 		environment.data	= single->data;
 	}
 
-	dev_current = 0;
-	if (flash_io (O_RDONLY))
-		return -1;
-
 	crc0 = crc32 (0, (uint8_t *) environment.data, ENV_SIZE);
 
 	if (opts->aes_flag) {
@@ -1205,27 +1272,21 @@ int fw_env_open(struct env_opts *opts)
 			fprintf (stderr,
 				"Warning: Bad CRC, using default environment\n");
 			memcpy(environment.data, default_environment, sizeof default_environment);
+			env_changed = 1;
 		}
 	} else {
 		flag0 = *environment.flags;
 
 		dev_current = 1;
-		addr1 = calloc(1, CUR_ENVSIZE);
-		if (addr1 == NULL) {
-			fprintf(stderr,
-				"Not enough memory for environment (%ld bytes)\n",
-				CUR_ENVSIZE);
-			return -1;
-		}
-		redundant = addr1;
 
 		/*
-		 * have to set environment.image for flash_read(), careful -
-		 * other pointers in environment still point inside addr0
+		 * flash_read() sets environment.image, careful - other
+		 * pointers in environment still point inside addr0
 		 */
-		environment.image = addr1;
 		if (flash_io (O_RDONLY))
 			return -1;
+		addr1 = environment.image;
+		redundant = addr1;
 
 		/* Check flag scheme compatibility */
 		if (DEVTYPE(dev_current) == MTD_NORFLASH &&
@@ -1269,6 +1330,7 @@ int fw_env_open(struct env_opts *opts)
 				"Warning: Bad CRC, using default environment\n");
 			memcpy (environment.data, default_environment,
 				sizeof default_environment);
+			env_changed = 1;
 			dev_current = 0;
 		} else {
 			switch (environment.flag_scheme) {
@@ -1315,11 +1377,11 @@ int fw_env_open(struct env_opts *opts)
 			environment.crc		= &redundant->crc;
 			environment.flags	= &redundant->flags;
 			environment.data	= redundant->data;
-			free (addr0);
+			flash_free (0, addr0);
 		} else {
 			environment.image	= addr0;
 			/* Other pointers are already set */
-			free (addr1);
+			flash_free (1, addr1);
 		}
 #ifdef DEBUG
 		fprintf(stderr, "Selected env in %s\n", DEVNAME(dev_current));
@@ -59,7 +59,8 @@ static int fit_add_file_data(struct image_tool_params *params, size_t size_inc,
 	if (!ret) {
 		ret = fit_add_verification_data(params->keydir, dest_blob, ptr,
 						params->comment,
-						params->require_keys);
+						params->require_keys,
+						params->jobs);
 	}
 
 	if (dest_blob) {
@@ -75,42 +76,184 @@ err_keydest:
 }
 
 /**
- * fit_calc_size() - Calculate the approximate size of the FIT we will generate
+ * struct fit_data_src - Where to find the contents of a 'data' property
+ *
+ * Image data is copied between files without passing through memory, so
+ * that large images (such as ramdisks) do not need to be held in memory.
+ *
+ * @image:	Index of the image node within /images
+ * @node:	Offset of the image node (only valid until the FIT changes)
+ * @fd:		File containing the data
+ * @offset:	Offset of the data within @fd
+ * @size:	Size of the data in bytes
+ * @dest:	Offset of the data within the FIT, or within the external data
  */
-static int fit_calc_size(struct image_tool_params *params)
+struct fit_data_src {
+	int image;
+	int node;
+	int fd;
+	off_t offset;
+	int size;
+	off_t dest;
+};
+
+/**
+ * struct fit_data_list - List of data to copy into or out of a FIT
+ *
+ * @src:	Data sources, in the order they appear in the FIT
+ * @count:	Number of data sources
+ */
+struct fit_data_list {
+	struct fit_data_src *src;
+	int count;
+};
+
+static struct fit_data_src *fit_data_add(struct fit_data_list *list)
 {
-	struct content_info *cont;
-	int size, total_size;
+	struct fit_data_src *src;
 
-	size = imagetool_get_filesize(params, params->datafile);
-	if (size < 0)
-		return -1;
+	src = realloc(list->src, (list->count + 1) * sizeof(*src));
+	if (!src)
+		return NULL;
+	list->src = src;
+	src += list->count++;
+	memset(src, '\0', sizeof(*src));
+	src->fd = -1;
 
-	total_size = size;
-	for (cont = params->content_head; cont; cont = cont->next) {
-		size = imagetool_get_filesize(params, cont->fname);
-		if (size < 0)
-			return -1;
+	return src;
+}
+
+static void fit_data_free(struct fit_data_list *list, bool close_files)
+{
+	int i;
 
-		/* Add space for properties */
-		total_size += size + 300;
+	for (i = 0; close_files && i < list->count; i++) {
+		if (list->src[i].fd >= 0)
+			close(list->src[i].fd);
+	}
+	free(list->src);
+}
+
+/**
+ * fit_write_with_data() - Write out a FIT, filling in its 'data' properties
+ *
+ * The 'data' properties of the images given in @list must be present and
+ * empty. They are written out with their contents copied from the source
+ * files. The FIT is written with pwrite() so that only the parts of the
+ * output which come from @fdt pass through memory.
+ *
+ * @params:	mkimage parameters
+ * @fdt:	Packed FIT with empty 'data' properties. This is updated to
+ *		show the sizes of the properties.
+ * @list:	Data to write into the 'data' properties
+ * @fd:		File to write to
+ * @return 0 if OK, -ve on error
+ */
+static int fit_write_with_data(struct image_tool_params *params, void *fdt,
+			       struct fit_data_list *list, int fd)
+{
+	static const char pad[4];
+	int images, node, image;
+	struct fdt_property *prop;
+	int skel_size, extra;
+	int len, i;
+	off_t pos, out;
+
+	skel_size = fdt_totalsize(fdt);
+	images = fdt_path_offset(fdt, FIT_IMAGES_PATH);
+	if (images < 0)
+		return -EINVAL;
+
+	/* Find each empty 'data' property */
+	for (i = 0, image = 0, node = fdt_first_subnode(fdt, images);
+	     node >= 0 && i < list->count;
+	     node = fdt_next_subnode(fdt, node), image++) {
+		struct fit_data_src *src = &list->src[i];
+
+		if (src->image != image)
+			continue;
+		prop = fdt_get_property_w(fdt, node, "data", &len);
+		if (!prop || len)
+			return -EINVAL;
+		src->dest = (char *)prop->data - (char *)fdt;
+		i++;
+	}
+	if (i != list->count)
+		return -EINVAL;
+
+	/* Set the final sizes, now that we no longer need to scan the FIT */
+	extra = 0;
+	for (i = 0; i < list->count; i++) {
+		struct fit_data_src *src = &list->src[i];
+
+		prop = (struct fdt_property *)((char *)fdt + src->dest -
+					       sizeof(*prop));
+		prop->len = cpu_to_fdt32(src->size);
+		extra += (src->size + 3) & ~3;
+	}
+
+	/* The data goes in the structure block, which comes before strings */
+	fdt_set_totalsize(fdt, skel_size + extra);
+	fdt_set_off_dt_strings(fdt, fdt_off_dt_strings(fdt) + extra);
+	fdt_set_size_dt_struct(fdt, fdt_size_dt_struct(fdt) + extra);
+
+	for (i = 0, pos = 0, out = 0; i < list->count; i++) {
+		struct fit_data_src *src = &list->src[i];
+
+		len = src->dest - pos;
+		if (pwrite(fd, (char *)fdt + pos, len, out) != len)
+			goto err;
+		pos += len;
+		out += len;
+		if (imagetool_copy_range(src->fd, src->offset, fd, out,
+					 src->size))
+			goto err;
+		out += src->size;
+		len = -src->size & 3;
+		if (len && pwrite(fd, pad, len, out) != len)
+			goto err;
+		out += len;
 	}
+	len = skel_size - pos;
+	if (pwrite(fd, (char *)fdt + pos, len, out) != len)
+		goto err;
+
+	return 0;
+err:
+	fprintf(stderr, "%s: Can't write FIT: %s\n", params->cmdname,
+		strerror(errno));
+	return -EIO;
+}
+
+/**
+ * fit_calc_size() - Calculate the approximate size of the FIT we will generate
+ *
+ * This does not include the image data, which is added as the FIT is
+ * written out.
+ */
+static int fit_calc_size(struct image_tool_params *params)
+{
+	struct content_info *cont;
+	int total_size;
 
 	/* Add plenty of space for headers, properties, nodes, etc. */
-	total_size += 4096;
+	total_size = 4096;
+	for (cont = params->content_head; cont; cont = cont->next)
+		total_size += 300;
 
 	return total_size;
 }
 
 static int fdt_property_file(struct image_tool_params *params,
-			     void *fdt, const char *name, const char *fname)
+			     void *fdt, const char *name, const char *fname,
+			     struct fit_data_list *list)
 {
+	struct fit_data_src *src;
 	struct stat sbuf;
-	void *ptr;
 	int ret;
 	int fd;
 
-	fd = open(fname, O_RDWR | O_BINARY);
+	fd = open(fname, O_RDONLY | O_BINARY);
 	if (fd < 0) {
 		fprintf(stderr, "%s: Can't open %s: %s\n",
 			params->cmdname, fname, strerror(errno));
@@ -123,16 +266,16 @@ static int fdt_property_file(struct image_tool_params *params,
 		goto err;
 	}
 
-	ret = fdt_property_placeholder(fdt, "data", sbuf.st_size, &ptr);
+	/* The contents are copied in by fit_write_with_data() */
+	ret = fdt_property(fdt, name, NULL, 0);
 	if (ret)
 		goto err;
-	ret = read(fd, ptr, sbuf.st_size);
-	if (ret != sbuf.st_size) {
-		fprintf(stderr, "%s: Can't read %s: %s\n",
-			params->cmdname, fname, strerror(errno));
+	src = fit_data_add(list);
+	if (!src)
 		goto err;
-	}
-	close(fd);
+	src->image = list->count - 1;
+	src->fd = fd;
+	src->size = sbuf.st_size;
 
 	return 0;
 err:
@@ -179,7 +322,8 @@ static void get_basename(char *str, int size, const char *fname)
  * We always include the main image (params->datafile). If there are device
  * tree files, we include an fdt@ node for each of those too.
  */
-static int fit_write_images(struct image_tool_params *params, char *fdt)
+static int fit_write_images(struct image_tool_params *params, char *fdt,
+			    struct fit_data_list *list)
 {
 	struct content_info *cont;
 	const char *typename;
@@ -206,7 +350,7 @@ static int fit_write_images(struct image_tool_params *params, char *fdt)
 	 * Put data last since it is large. SPL may only load the first part
 	 * of the DT, so this way it can access all the above fields.
 	 */
-	ret = fdt_property_file(params, fdt, "data", params->datafile);
+	ret = fdt_property_file(params, fdt, "data", params->datafile, list);
 	if (ret)
 		return ret;
 	fdt_end_node(fdt);
@@ -221,7 +365,8 @@ static int fit_write_images(struct image_tool_params *params, char *fdt)
 
 		get_basename(str, sizeof(str), cont->fname);
 		fdt_property_string(fdt, "description", str);
-		ret = fdt_property_file(params, fdt, "data", cont->fname);
+		ret = fdt_property_file(params, fdt, "data", cont->fname,
+					list);
 		if (ret)
 			return ret;
 		fdt_property_string(fdt, "type", typename);
@@ -286,7 +431,8 @@ static void fit_write_configs(struct image_tool_params *params, char *fdt)
 	fdt_end_node(fdt);
 }
 
-static int fit_build_fdt(struct image_tool_params *params, char *fdt, int size)
+static int fit_build_fdt(struct image_tool_params *params, char *fdt, int size,
+			 struct fit_data_list *list)
 {
 	int ret;
 
@@ -295,12 +441,17 @@ static int fit_build_fdt(struct image_tool_params *params, char *fdt, int size)
 		return ret;
 	fdt_finish_reservemap(fdt);
 	fdt_begin_node(fdt, "");
+	/*
+	 * Reserve space for the timestamp, so that setting it does not need to
+	 * move the image data
+	 */
+	fdt_property_u32(fdt, FIT_TIMESTAMP_PROP, 0);
 	fdt_property_strf(fdt, "description",
 			  "%s image with one or more FDT blobs",
 			  genimg_get_type_name(params->fit_image_type));
 	fdt_property_strf(fdt, "creator", "U-Boot mkimage %s", PLAIN_VERSION);
 	fdt_property_u32(fdt, "#address-cells", 1);
-	ret = fit_write_images(params, fdt);
+	ret = fit_write_images(params, fdt, list);
 	if (ret)
 		return ret;
 	fit_write_configs(params, fdt);
@@ -314,10 +465,11 @@ static int fit_build_fdt(struct image_tool_params *params, char *fdt, int size)
 
 static int fit_build(struct image_tool_params *params, const char *fname)
 {
+	struct fit_data_list list = { NULL, 0 };
 	char *buf;
 	int size;
 	int ret;
-	int fd;
+	int fd = -1;
 
 	size = fit_calc_size(params);
 	if (size < 0)
@@ -328,32 +480,29 @@ static int fit_build(struct image_tool_params *params, const char *fname)
 			params->cmdname, size);
 		return -1;
 	}
-	ret = fit_build_fdt(params, buf, size);
+	ret = fit_build_fdt(params, buf, size, &list);
 	if (ret < 0) {
 		fprintf(stderr, "%s: Failed to build FIT image\n",
 			params->cmdname);
-		goto err_buf;
+		goto err;
 	}
-	size = ret;
 	fd = open(fname, O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0666);
 	if (fd < 0) {
 		fprintf(stderr, "%s: Can't open %s: %s\n",
 			params->cmdname, fname, strerror(errno));
 		goto err;
 	}
-	ret = write(fd, buf, size);
-	if (ret != size) {
-		fprintf(stderr, "%s: Can't write %s: %s\n",
-			params->cmdname, fname, strerror(errno));
+	if (fit_write_with_data(params, buf, &list, fd))
 		goto err;
-	}
 	close(fd);
+	fit_data_free(&list, true);
 	free(buf);
 
 	return 0;
 err:
-	close(fd);
-err_buf:
+	if (fd >= 0)
+		close(fd);
+	fit_data_free(&list, true);
 	free(buf);
 	return -1;
 }
@@ -366,33 +515,42 @@ err_buf:
  * using an offset into that area. The 'data' properties turn into
  * 'data-offset' properties.
  *
+ * The input file is mapped privately and the properties are removed in
+ * reverse order, so that the image data is never moved in memory. The new
+ * file is then written out with the data copied directly from the old one.
+ *
  * This function cannot cope with FITs with 'data-offset' properties. All
  * data must be in 'data' properties on entry.
  */
 static int fit_extract_data(struct image_tool_params *params, const char *fname)
 {
-	void *buf;
+	struct fit_data_list list = { NULL, 0 };
+	struct fit_data_src *src;
 	int buf_ptr;
-	int fit_size, new_size;
-	int fd;
+	int new_size;
+	int fd, new_fd = -1;
 	struct stat sbuf;
 	void *fdt;
 	int ret;
 	int images;
 	int node;
-
-	fd = mmap_fdt(params->cmdname, fname, 0, &fdt, &sbuf, false);
-	if (fd < 0)
+	int i;
+
+	fd = open(fname, O_RDONLY | O_BINARY);
+	if (fd < 0 || fstat(fd, &sbuf) < 0) {
+		fprintf(stderr, "%s: Can't open %s: %s\n", params->cmdname,
+			fname, strerror(errno));
+		if (fd >= 0)
+			close(fd);
+		return -EIO;
+	}
+	fdt = mmap(0, sbuf.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	if (fdt == MAP_FAILED) {
+		fprintf(stderr, "%s: Can't read %s: %s\n", params->cmdname,
+			fname, strerror(errno));
+		close(fd);
 		return -EIO;
-	fit_size = fdt_totalsize(fdt);
-
-	/* Allocate space to hold the image data we will extract */
-	buf = malloc(fit_size);
-	if (!buf) {
-		ret = -ENOMEM;
-		goto err_munmap;
 	}
-	buf_ptr = 0;
 
 	images = fdt_path_offset(fdt, FIT_IMAGES_PATH);
 	if (images < 0) {
@@ -401,6 +559,8 @@ static int fit_extract_data(struct image_tool_params *params, const char *fname)
 		goto err_munmap;
 	}
 
+	/* Work out where each piece of data is and where it will go */
+	buf_ptr = 0;
 	for (node = fdt_first_subnode(fdt, images);
 	     node >= 0;
 	     node = fdt_next_subnode(fdt, node)) {
@@ -410,41 +570,60 @@ static int fit_extract_data(struct image_tool_params *params, const char *fname)
 		data = fdt_getprop(fdt, node, "data", &len);
 		if (!data)
 			continue;
-		memcpy(buf + buf_ptr, data, len);
 		debug("Extracting data size %x\n", len);
+		src = fit_data_add(&list);
+		if (!src) {
+			ret = -ENOMEM;
+			goto err_munmap;
+		}
+		src->node = node;
+		src->offset = data - (const char *)fdt;
+		src->size = len;
+		src->dest = buf_ptr;
+
+		buf_ptr += (len + 3) & ~3;
+	}
 
-		ret = fdt_delprop(fdt, node, "data");
+	/*
+	 * Remove the data starting with the last image, so that the node
+	 * offsets of the earlier images stay valid and there is very little
+	 * to move each time.
+	 */
+	for (i = list.count - 1; i >= 0; i--) {
+		src = &list.src[i];
+		ret = fdt_delprop(fdt, src->node, "data");
 		if (ret) {
 			ret = -EPERM;
 			goto err_munmap;
 		}
 		if (params->external_offset > 0) {
 			/* An external offset positions the data absolutely. */
-			fdt_setprop_u32(fdt, node, "data-position",
-					params->external_offset + buf_ptr);
+			ret = fdt_setprop_u32(fdt, src->node, "data-position",
+					      params->external_offset +
+					      src->dest);
 		} else {
-			fdt_setprop_u32(fdt, node, "data-offset", buf_ptr);
+			ret = fdt_setprop_u32(fdt, src->node, "data-offset",
+					      src->dest);
+		}
+		if (!ret)
+			ret = fdt_setprop_u32(fdt, src->node, "data-size",
+					      src->size);
+		if (ret) {
+			debug("%s: Failed to set properties: %s\n", __func__,
+			      fdt_strerror(ret));
+			ret = -EINVAL;
+			goto err_munmap;
 		}
-		fdt_setprop_u32(fdt, node, "data-size", len);
-
-		buf_ptr += (len + 3) & ~3;
 	}
 
 	/* Pack the FDT and place the data after it */
 	fdt_pack(fdt);
 
-	debug("Size reduced from %x to %x\n", fit_size, fdt_totalsize(fdt));
+	debug("Size reduced from %x to %x\n", (int)sbuf.st_size,
+	      fdt_totalsize(fdt));
 	debug("External data size %x\n", buf_ptr);
 	new_size = fdt_totalsize(fdt);
 	new_size = (new_size + 3) & ~3;
-	munmap(fdt, sbuf.st_size);
-
-	if (ftruncate(fd, new_size)) {
-		debug("%s: Failed to truncate file: %s\n", __func__,
-		      strerror(errno));
-		ret = -EIO;
-		goto err;
-	}
 
 	/* Check if an offset for the external data was set. */
 	if (params->external_offset > 0) {
@@ -452,52 +631,120 @@ static int fit_extract_data(struct image_tool_params *params, const char *fname)
 			debug("External offset %x overlaps FIT length %x",
 			      params->external_offset, new_size);
 			ret = -EINVAL;
-			goto err;
+			goto err_munmap;
 		}
 		new_size = params->external_offset;
 	}
-	if (lseek(fd, new_size, SEEK_SET) < 0) {
-		debug("%s: Failed to seek to end of file: %s\n", __func__,
-		      strerror(errno));
+
+	/* Keep the old file open so that the data can be copied from it */
+	unlink(fname);
+	new_fd = open(fname, O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0666);
+	if (new_fd < 0) {
+		fprintf(stderr, "%s: Can't open %s: %s\n", params->cmdname,
+			fname, strerror(errno));
 		ret = -EIO;
-		goto err;
+		goto err_munmap;
 	}
-	if (write(fd, buf, buf_ptr) != buf_ptr) {
-		debug("%s: Failed to write external data to file %s\n",
-		      __func__, strerror(errno));
+	if (ftruncate(new_fd, new_size + buf_ptr) ||
+	    pwrite(new_fd, fdt, fdt_totalsize(fdt), 0) != fdt_totalsize(fdt)) {
+		debug("%s: Failed to write FIT: %s\n", __func__,
+		      strerror(errno));
 		ret = -EIO;
-		goto err;
+		goto err_munmap;
 	}
-	close(fd);
-	return 0;
+	for (i = 0; i < list.count; i++) {
+		src = &list.src[i];
+		if (imagetool_copy_range(fd, src->offset, new_fd,
+					 new_size + src->dest, src->size)) {
+			debug("%s: Failed to write external data to file %s\n",
+			      __func__, strerror(errno));
+			ret = -EIO;
+			goto err_munmap;
+		}
+	}
+	ret = 0;
 
 err_munmap:
 	munmap(fdt, sbuf.st_size);
-err:
-	if (buf)
-		free(buf);
+	fit_data_free(&list, false);
+	if (new_fd >= 0)
+		close(new_fd);
 	close(fd);
 	return ret;
 }
 
+/**
+ * fit_trim() - Remove the free space from the end of a FIT file
+ *
+ * If the blocks are already in order and contiguous this just updates the
+ * size in the header, so the image data is not touched.
+ */
+static int fit_trim(void *fdt)
+{
+	const struct fdt_reserve_entry *rsv;
+	int struct_off, strings_off;
+
+	struct_off = fdt_off_mem_rsvmap(fdt);
+	do {
+		rsv = (const void *)((char *)fdt + struct_off);
+		struct_off += sizeof(*rsv);
+	} while (fdt64_to_cpu(rsv->size));
+	strings_off = struct_off + fdt_size_dt_struct(fdt);
+	if (fdt_off_mem_rsvmap(fdt) < sizeof(struct fdt_header) ||
+	    fdt_off_dt_struct(fdt) != struct_off ||
+	    fdt_off_dt_strings(fdt) != strings_off)
+		return fdt_pack(fdt);
+	fdt_set_totalsize(fdt, strings_off + fdt_size_dt_strings(fdt));
+
+	return 0;
+}
+
 static int fit_import_data(struct image_tool_params *params, const char *fname)
 {
+	struct fit_data_list list = { NULL, 0 };
+	struct fit_data_src *src;
 	void *fdt, *old_fdt;
 	int fit_size, new_size, size, data_base;
-	int fd;
+	int fd, new_fd = -1;
 	struct stat sbuf;
 	int ret;
 	int images;
 	int node;
+	int image;
 
 	fd = mmap_fdt(params->cmdname, fname, 0, &old_fdt, &sbuf, false);
 	if (fd < 0)
 		return -EIO;
 	fit_size = fdt_totalsize(old_fdt);
 	data_base = (fit_size + 3) & ~3;
+	images = fdt_path_offset(old_fdt, FIT_IMAGES_PATH);
+	if (images < 0) {
+		debug("%s: Cannot find /images node: %d\n", __func__, images);
+		munmap(old_fdt, sbuf.st_size);
+		close(fd);
+		return -EINVAL;
+	}
+
+	for (node = fdt_first_subnode(old_fdt, images);
+	     node >= 0;
+	     node = fdt_next_subnode(old_fdt, node)) {
+		if (fdt_getprop(old_fdt, node, "data-offset", NULL))
+			break;
+	}
+
+	/* With no external data, just drop any free space in the FIT */
+	if (node < 0) {
+		ret = fit_trim(old_fdt);
+		new_size = fdt_totalsize(old_fdt);
+		munmap(old_fdt, sbuf.st_size);
+		if (!ret && ftruncate(fd, new_size))
+			ret = -EIO;
+		close(fd);
+		return ret ? -EINVAL : 0;
+	}
 
-	/* Allocate space to hold the new FIT */
-	size = sbuf.st_size + 16384;
+	/* Allocate space to hold the new FIT, without its data */
+	size = fit_size + 16384;
 	fdt = malloc(size);
 	if (!fdt) {
 		fprintf(stderr, "%s: Failed to allocate memory (%d bytes)\n",
@@ -514,15 +761,9 @@ static int fit_import_data(struct image_tool_params *params, const char *fname)
 	}
 
 	images = fdt_path_offset(fdt, FIT_IMAGES_PATH);
-	if (images < 0) {
-		debug("%s: Cannot find /images node: %d\n", __func__, images);
-		ret = -EINVAL;
-		goto err;
-	}
-
-	for (node = fdt_first_subnode(fdt, images);
+	for (node = fdt_first_subnode(fdt, images), image = 0;
 	     node >= 0;
-	     node = fdt_next_subnode(fdt, node)) {
+	     node = fdt_next_subnode(fdt, node), image++) {
 		int buf_ptr;
 		int len;
 
@@ -531,19 +772,34 @@ static int fit_import_data(struct image_tool_params *params, const char *fname)
 		if (buf_ptr == -1 || len == -1)
 			continue;
 		debug("Importing data size %x\n", len);
+		if (data_base + buf_ptr + len > sbuf.st_size) {
+			debug("%s: Data for image %d is outside the file\n",
+			      __func__, image);
+			ret = -EINVAL;
+			goto err;
+		}
 
-		ret = fdt_setprop(fdt, node, "data", fdt + data_base + buf_ptr,
-				  len);
+		/* The contents are copied in by fit_write_with_data() */
+		ret = fdt_setprop(fdt, node, "data", NULL, 0);
 		if (ret) {
 			debug("%s: Failed to write property: %s\n", __func__,
 			      fdt_strerror(ret));
 			ret = -EINVAL;
 			goto err;
 		}
+		src = fit_data_add(&list);
+		if (!src) {
+			ret = -ENOMEM;
+			goto err;
+		}
+		src->image = image;
+		src->fd = fd;
+		src->offset = data_base + buf_ptr;
+		src->size = len;
 	}
 
 	munmap(old_fdt, sbuf.st_size);
-	close(fd);
+	old_fdt = NULL;
 
 	/* Pack the FDT and place the data after it */
 	fdt_pack(fdt);
@@ -551,24 +807,24 @@ static int fit_import_data(struct image_tool_params *params, const char *fname)
 	new_size = fdt_totalsize(fdt);
 	debug("Size expanded from %x to %x\n", fit_size, new_size);
 
-	fd = open(fname, O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0666);
-	if (fd < 0) {
+	/* Keep the old file open so that the data can be copied from it */
+	unlink(fname);
+	new_fd = open(fname, O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0666);
+	if (new_fd < 0) {
 		fprintf(stderr, "%s: Can't open %s: %s\n",
 			params->cmdname, fname, strerror(errno));
-		free(fdt);
-		return -EIO;
-	}
-	if (write(fd, fdt, new_size) != new_size) {
-		debug("%s: Failed to write external data to file %s\n",
-		      __func__, strerror(errno));
 		ret = -EIO;
 		goto err;
 	}
-
-	ret = 0;
+	ret = fit_write_with_data(params, fdt, &list, new_fd);
 
 err:
+	if (old_fdt)
+		munmap(old_fdt, sbuf.st_size);
+	fit_data_free(&list, false);
 	free(fdt);
+	if (new_fd >= 0)
+		close(new_fd);
 	close(fd);
 	return ret;
 }
@@ -681,7 +937,11 @@ err_system:
  * fit_image_extract - extract a FIT component image
  * @fit: pointer to the FIT format image header
  * @image_noffset: offset of the component image node
- * @file_name: name of the file to store the FIT sub-image
+ * @params: command line parameters
+ *
+ * The data is copied straight from the FIT file to the output file, so it
+ * does not need to be read into memory. Both internal and external data
+ * are supported.
  *
  * returns:
  *     zero in case of success or a negative value if fail.
@@ -689,16 +949,37 @@ err_system:
 static int fit_image_extract(
 	const void *fit,
 	int image_noffset,
-	const char *file_name)
+	struct image_tool_params *params)
 {
 	const void *file_data;
 	size_t file_size = 0;
+	off_t offset;
+	int data_offset, data_size;
 
 	/* get the "data" property of component at offset "image_noffset" */
-	fit_image_get_data(fit, image_noffset, &file_data, &file_size);
+	if (!fit_image_get_data(fit, image_noffset, &file_data, &file_size)) {
+		offset = (const char *)file_data - (const char *)fit;
+	} else {
+		data_size = fdtdec_get_int(fit, image_noffset, "data-size", -1);
+		data_offset = fdtdec_get_int(fit, image_noffset, "data-offset",
+					     -1);
+		if (data_offset != -1) {
+			offset = (fdt_totalsize(fit) + 3) & ~3;
+			offset += data_offset;
+		} else {
+			offset = fdtdec_get_int(fit, image_noffset,
+						"data-position", -1);
+		}
+		if (offset == -1 || data_size == -1) {
+			printf("Can't find data for component\n");
+			return -1;
+		}
+		file_size = data_size;
+	}
 
-	/* save the "file_data" into the file specified by "file_name" */
-	return imagetool_save_subimage(file_name, (ulong) file_data, file_size);
+	/* save the data into the file specified by params->outfile */
+	return imagetool_copy_subimage(params->outfile, params->imagefile,
+				       offset, file_size);
 }
 
 /**
@@ -757,8 +1038,7 @@ static int fit_extract_contents(void *ptr, struct image_tool_params *params)
 
 				fit_image_print(fit, noffset, p);
 
-				return fit_image_extract(fit, noffset,
-						params->outfile);
+				return fit_image_extract(fit, noffset, params);
 			}
 
 			count++;
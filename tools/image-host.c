@@ -12,6 +12,7 @@
 #include "mkimage.h"
 #include <bootm.h>
 #include <image.h>
+#include <pthread.h>
 #include <version.h>
 
 /**
@@ -26,6 +27,7 @@
  *
  * returns
  *     0, on success
+ *     -ENOSPC, if there is no space in the FIT
  *     -1, on failure
  */
 static int fit_set_hash_value(void *fit, int noffset, uint8_t *value,
@@ -34,6 +36,8 @@ static int fit_set_hash_value(void *fit, int noffset, uint8_t *value,
 	int ret;
 
 	ret = fdt_setprop(fit, noffset, FIT_VALUE_PROP, value, value_len);
+	if (ret == -FDT_ERR_NOSPACE)
+		return -ENOSPC;
 	if (ret) {
 		printf("Can't set hash '%s' property for '%s' node(%s)\n",
 		       FIT_VALUE_PROP, fit_get_name(fit, noffset, NULL),
@@ -44,25 +48,44 @@ static int fit_set_hash_value(void *fit, int noffset, uint8_t *value,
 	return 0;
 }
 
+/* Store a hash value worked out by fit_image_calc_hash() */
+static int fit_image_write_hash(void *fit, const char *image_name,
+		int noffset, uint8_t *value, int value_len)
+{
+	int ret;
+
+	ret = fit_set_hash_value(fit, noffset, value, value_len);
+	if (ret == -ENOSPC)
+		return ret;
+	if (ret) {
+		printf("Can't set hash value for '%s' hash node in '%s' image node\n",
+		       fit_get_name(fit, noffset, NULL), image_name);
+		return -1;
+	}
+
+	return 0;
+}
+
 /**
- * fit_image_process_hash - Process a single subnode of the images/ node
+ * fit_image_calc_hash() - Calculate the value for a hash node
  *
- * Check each subnode and process accordingly. For hash nodes we generate
- * a hash of the supplised data and store it in the node.
+ * This does not change the FIT, so it can be called from several threads
+ * at once.
  *
  * @fit:	pointer to the FIT format image header
  * @image_name:	name of image being processes (used to display errors)
- * @noffset:	subnode offset
+ * @noffset:	hash node offset
  * @data:	data to process
  * @size:	size of data in bytes
+ * @value:	returns the hash value (FIT_MAX_HASH_LEN bytes)
+ * @value_lenp:	returns the length of the hash value
  * @return 0 if ok, -1 on error
  */
-static int fit_image_process_hash(void *fit, const char *image_name,
-		int noffset, const void *data, size_t size)
+static int fit_image_calc_hash(const void *fit, const char *image_name,
+		int noffset, const void *data, size_t size, uint8_t *value,
+		int *value_lenp)
 {
-	uint8_t value[FIT_MAX_HASH_LEN];
 	const char *node_name;
-	int value_len;
 	char *algo;
 
 	node_name = fit_get_name(fit, noffset, NULL);
@@ -73,19 +96,40 @@ static int fit_image_process_hash(void *fit, const char *image_name,
 		return -1;
 	}
 
-	if (calculate_hash(data, size, algo, value, &value_len)) {
+	if (calculate_hash(data, size, algo, value, value_lenp)) {
 		printf("Unsupported hash algorithm (%s) for '%s' hash node in '%s' image node\n",
 		       algo, node_name, image_name);
 		return -1;
 	}
 
-	if (fit_set_hash_value(fit, noffset, value, value_len)) {
-		printf("Can't set hash value for '%s' hash node in '%s' image node\n",
-		       node_name, image_name);
+	return 0;
+}
+
+/**
+ * fit_image_process_hash - Process a single subnode of the images/ node
+ *
+ * Check each subnode and process accordingly. For hash nodes we generate
+ * a hash of the supplised data and store it in the node.
+ *
+ * @fit:	pointer to the FIT format image header
+ * @image_name:	name of image being processes (used to display errors)
+ * @noffset:	subnode offset
+ * @data:	data to process
+ * @size:	size of data in bytes
+ * @return 0 if ok, -1 on error
+ */
+static int fit_image_process_hash(void *fit, const char *image_name,
+		int noffset, const void *data, size_t size)
+{
+	uint8_t value[FIT_MAX_HASH_LEN];
+	int value_len;
+
+	if (fit_image_calc_hash(fit, image_name, noffset, data, size, value,
+				&value_len))
 		return -1;
-	}
 
-	return 0;
+	return fit_image_write_hash(fit, image_name, noffset, value,
+				    value_len);
 }
 
 /**
@@ -175,6 +219,73 @@ static int fit_image_setup_sig(struct image_sign_info *info,
 	return 0;
 }
 
+/**
+ * fit_image_calc_sig() - Sign the data for an image's signature node
+ *
+ * Like fit_image_calc_hash() this does not change the FIT.
+ *
+ * @info:	Signing information, from fit_image_setup_sig()
+ * @image_name:	name of image being processes (used to display errors)
+ * @data:	data to process
+ * @size:	size of data in bytes
+ * @valuep:	returns the signature, which the caller must free
+ * @value_lenp:	returns the length of the signature
+ * @return 0 if ok, -ENOENT if the key is missing, other -ve on error
+ */
+static int fit_image_calc_sig(struct image_sign_info *info,
+		const char *image_name, const void *data, size_t size,
+		uint8_t **valuep, uint *value_lenp)
+{
+	struct image_region region;
+	int ret;
+
+	region.data = data;
+	region.size = size;
+	ret = info->algo->sign(info, &region, 1, valuep, value_lenp);
+	if (ret) {
+		printf("Failed to sign '%s' signature node in '%s' image node: %d\n",
+		       fit_get_name(info->fit, info->node_offset, NULL),
+		       image_name, ret);
+		return ret;
+	}
+
+	return 0;
+}
+
+/* Store a signature from fit_image_calc_sig() and write out its key */
+static int fit_image_write_sig_data(struct image_sign_info *info,
+		void *keydest, void *fit, const char *image_name, int noffset,
+		uint8_t *value, uint value_len, const char *comment)
+{
+	const char *node_name;
+	int ret;
+
+	node_name = fit_get_name(fit, noffset, NULL);
+	ret = fit_image_write_sig(fit, noffset, value, value_len, comment,
+			NULL, 0);
+	if (ret) {
+		if (ret == -FDT_ERR_NOSPACE)
+			return -ENOSPC;
+		printf("Can't write signature for '%s' signature node in '%s' conf node: %s\n",
+		       node_name, image_name, fdt_strerror(ret));
+		return -1;
+	}
+
+	/* Get keyname again, as FDT has changed and invalidated our pointer */
+	info->fit = fit;
+	info->node_offset = noffset;
+	info->keyname = fdt_getprop(fit, noffset, "key-name-hint", NULL);
+
+	/* Write the public key into the supplied FDT file */
+	if (keydest && info->algo->add_verify_data(info, keydest)) {
+		printf("Failed to add verification data for '%s' signature node in '%s' image node\n",
+		       node_name, image_name);
+		return -1;
+	}
+
+	return 0;
+}
+
 /**
  * fit_image_process_sig- Process a single subnode of the images/ node
  *
@@ -198,8 +309,6 @@ static int fit_image_process_sig(const char *keydir, void *keydest,
 		const char *comment, int require_keys)
 {
 	struct image_sign_info info;
-	struct image_region region;
-	const char *node_name;
 	uint8_t *value;
 	uint value_len;
 	int ret;
@@ -208,42 +317,20 @@ static int fit_image_process_sig(const char *keydir, void *keydest,
 				require_keys ? "image" : NULL))
 		return -1;
 
-	node_name = fit_get_name(fit, noffset, NULL);
-	region.data = data;
-	region.size = size;
-	ret = info.algo->sign(&info, &region, 1, &value, &value_len);
+	ret = fit_image_calc_sig(&info, image_name, data, size, &value,
+				 &value_len);
 	if (ret) {
-		printf("Failed to sign '%s' signature node in '%s' image node: %d\n",
-		       node_name, image_name, ret);
-
 		/* We allow keys to be missing */
 		if (ret == -ENOENT)
 			return 0;
 		return -1;
 	}
 
-	ret = fit_image_write_sig(fit, noffset, value, value_len, comment,
-			NULL, 0);
-	if (ret) {
-		if (ret == -FDT_ERR_NOSPACE)
-			return -ENOSPC;
-		printf("Can't write signature for '%s' signature node in '%s' conf node: %s\n",
-		       node_name, image_name, fdt_strerror(ret));
-		return -1;
-	}
+	ret = fit_image_write_sig_data(&info, keydest, fit, image_name,
+				       noffset, value, value_len, comment);
 	free(value);
 
-	/* Get keyname again, as FDT has changed and invalidated our pointer */
-	info.keyname = fdt_getprop(fit, noffset, "key-name-hint", NULL);
-
-	/* Write the public key into the supplied FDT file */
-	if (keydest && info.algo->add_verify_data(&info, keydest)) {
-		printf("Failed to add verification data for '%s' signature node in '%s' image node\n",
-		       node_name, image_name);
-		return -1;
-	}
-
-	return 0;
+	return ret;
 }
 
 /**
@@ -322,12 +409,337 @@ int fit_image_add_verification_data(const char *keydir, void *keydest,
 				comment, require_keys);
 		}
 		if (ret)
+			return ret == -ENOSPC ? ret : -1;
+	}
+
+	return 0;
+}
+
+/* Kinds of work to do for a subnode of a component image node */
+enum fit_job_type {
+	FIT_JOB_NONE,
+	FIT_JOB_HASH,
+	FIT_JOB_SIG,
+};
+
+/**
+ * struct fit_job - A hash or signature to calculate for an image
+ *
+ * @type:	Type of job (FIT_JOB_HASH or FIT_JOB_SIG)
+ * @image_name:	Name of the image node (only valid before the FIT changes)
+ * @noffset:	Offset of the hash or signature node (likewise)
+ * @data:	Image data to process (likewise)
+ * @size:	Size of image data in bytes
+ * @ret:	Result of the calculation, 0 if ok
+ * @value:	Hash value (FIT_JOB_HASH)
+ * @value_len:	Length of hash value (FIT_JOB_HASH)
+ * @info:	Signing information (FIT_JOB_SIG)
+ * @sig:	Signature, allocated by the signer (FIT_JOB_SIG)
+ * @sig_len:	Length of signature (FIT_JOB_SIG)
+ */
+struct fit_job {
+	enum fit_job_type type;
+	const char *image_name;
+	int noffset;
+	const void *data;
+	size_t size;
+	int ret;
+	uint8_t value[FIT_MAX_HASH_LEN];
+	int value_len;
+	struct image_sign_info info;
+	uint8_t *sig;
+	uint sig_len;
+};
+
+/**
+ * struct fit_job_list - Work shared between the worker threads
+ *
+ * @job:	List of jobs, in the order that they appear in the FIT
+ * @count:	Number of jobs
+ * @next:	Next job to hand out to a worker
+ * @lock:	Protects @next
+ * @sign_lock:	Serialises signing, since the signer sets up and tears
+ *		down the global state of the crypto library each time
+ * @fit:	FIT being processed, which must not change until all jobs
+ *		are complete
+ */
+struct fit_job_list {
+	struct fit_job *job;
+	int count;
+	int next;
+	pthread_mutex_t lock;
+	pthread_mutex_t sign_lock;
+	void *fit;
+};
+
+static enum fit_job_type fit_image_job_type(const char *keydir,
+					    const char *node_name)
+{
+	if (!strncmp(node_name, FIT_HASH_NODENAME, strlen(FIT_HASH_NODENAME)))
+		return FIT_JOB_HASH;
+	if (IMAGE_ENABLE_SIGN && keydir &&
+	    !strncmp(node_name, FIT_SIG_NODENAME, strlen(FIT_SIG_NODENAME)))
+		return FIT_JOB_SIG;
+
+	return FIT_JOB_NONE;
+}
+
+static void fit_job_run(struct fit_job_list *list, struct fit_job *job)
+{
+	if (job->type == FIT_JOB_HASH) {
+		job->ret = fit_image_calc_hash(list->fit, job->image_name,
+					       job->noffset, job->data,
+					       job->size, job->value,
+					       &job->value_len);
+		return;
+	}
+
+	pthread_mutex_lock(&list->sign_lock);
+	job->ret = fit_image_calc_sig(&job->info, job->image_name, job->data,
+				      job->size, &job->sig, &job->sig_len);
+	pthread_mutex_unlock(&list->sign_lock);
+}
+
+static void *fit_job_worker(void *arg)
+{
+	struct fit_job_list *list = arg;
+	int i;
+
+	for (;;) {
+		pthread_mutex_lock(&list->lock);
+		i = list->next++;
+		pthread_mutex_unlock(&list->lock);
+		if (i >= list->count)
+			break;
+		fit_job_run(list, &list->job[i]);
+	}
+
+	return NULL;
+}
+
+/*
+ * Collect the hash and signature jobs for all component images. This only
+ * reads the FIT, so all the offsets and pointers remain valid until the
+ * results are written.
+ */
+static int fit_jobs_collect(const char *keydir, void *fit,
+			    int images_noffset, int require_keys,
+			    struct fit_job_list *list)
+{
+	int image_noffset, noffset;
+
+	for (image_noffset = fdt_first_subnode(fit, images_noffset);
+	     image_noffset >= 0;
+	     image_noffset = fdt_next_subnode(fit, image_noffset)) {
+		const char *image_name;
+		const void *data;
+		size_t size;
+
+		if (fit_image_get_data(fit, image_noffset, &data, &size)) {
+			printf("Can't get image data/size\n");
 			return -1;
+		}
+		image_name = fit_get_name(fit, image_noffset, NULL);
+
+		for (noffset = fdt_first_subnode(fit, image_noffset);
+		     noffset >= 0;
+		     noffset = fdt_next_subnode(fit, noffset)) {
+			enum fit_job_type type;
+			struct fit_job *job;
+
+			type = fit_image_job_type(keydir,
+					fit_get_name(fit, noffset, NULL));
+			if (type == FIT_JOB_NONE)
+				continue;
+
+			job = realloc(list->job,
+				      (list->count + 1) * sizeof(*job));
+			if (!job) {
+				printf("Out of memory for image '%s'\n",
+				       image_name);
+				return -ENOMEM;
+			}
+			list->job = job;
+			job += list->count++;
+			memset(job, '\0', sizeof(*job));
+			job->type = type;
+			job->image_name = image_name;
+			job->noffset = noffset;
+			job->data = data;
+			job->size = size;
+			if (type == FIT_JOB_SIG &&
+			    fit_image_setup_sig(&job->info, keydir, fit,
+						image_name, noffset,
+						require_keys ? "image" : NULL))
+				return -1;
+		}
 	}
 
 	return 0;
 }
 
+/*
+ * Write the results of the jobs into the FIT. The FIT is walked in the same
+ * order as fit_jobs_collect() so that the output is identical to processing
+ * the images one at a time.
+ */
+static int fit_jobs_write(void *keydest, void *fit, int images_noffset,
+			  const char *keydir, const char *comment,
+			  struct fit_job_list *list)
+{
+	int image_noffset, noffset;
+	int i = 0;
+
+	for (image_noffset = fdt_first_subnode(fit, images_noffset);
+	     image_noffset >= 0;
+	     image_noffset = fdt_next_subnode(fit, image_noffset)) {
+		for (noffset = fdt_first_subnode(fit, image_noffset);
+		     noffset >= 0;
+		     noffset = fdt_next_subnode(fit, noffset)) {
+			const char *image_name;
+			struct fit_job *job;
+			int ret;
+
+			if (fit_image_job_type(keydir,
+				fit_get_name(fit, noffset, NULL)) ==
+			    FIT_JOB_NONE)
+				continue;
+			job = &list->job[i++];
+			image_name = fit_get_name(fit, image_noffset, NULL);
+			if (job->type == FIT_JOB_HASH) {
+				if (job->ret)
+					return -1;
+				ret = fit_image_write_hash(fit, image_name,
+						noffset, job->value,
+						job->value_len);
+			} else {
+				/* We allow keys to be missing */
+				if (job->ret == -ENOENT)
+					continue;
+				if (job->ret)
+					return -1;
+				ret = fit_image_write_sig_data(&job->info,
+						keydest, fit, image_name,
+						noffset, job->sig,
+						job->sig_len, comment);
+			}
+			if (ret)
+				return ret;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Work out the minimum space that writing the hash values will take up in
+ * the FIT. Signatures are not included, since their size is only known
+ * once they have been calculated.
+ */
+static uint fit_jobs_min_space(void *fit, struct fit_job_list *list)
+{
+	uint8_t value[FIT_MAX_HASH_LEN];
+	int len, old_len, i;
+	uint need = 0;
+	char *algo;
+
+	for (i = 0; i < list->count; i++) {
+		struct fit_job *job = &list->job[i];
+
+		/* Hashing no data is a quick way to find the hash length */
+		if (job->type != FIT_JOB_HASH ||
+		    fit_image_hash_get_algo(fit, job->noffset, &algo) ||
+		    calculate_hash(value, 0, algo, value, &len))
+			continue;
+		len = (len + FDT_TAGSIZE - 1) & ~(FDT_TAGSIZE - 1);
+		if (fdt_getprop(fit, job->noffset, FIT_VALUE_PROP, &old_len)) {
+			old_len = (old_len + FDT_TAGSIZE - 1) &
+				~(FDT_TAGSIZE - 1);
+			if (len > old_len)
+				need += len - old_len;
+		} else {
+			need += sizeof(struct fdt_property) + len;
+		}
+	}
+
+	return need;
+}
+
+/**
+ * fit_add_image_data_parallel() - Add hashes and signatures using threads
+ *
+ * This calculates the values for all hash and signature nodes of all
+ * component images using @jobs worker threads, then writes them into the
+ * FIT in order.
+ *
+ * @keydir:	Directory containing *.key and *.crt files (or NULL)
+ * @keydest:	FDT Blob to write public keys into (NULL if none)
+ * @fit:	Pointer to the FIT format image header
+ * @images_noffset: Offset of the images node
+ * @comment:	Comment to add to signature nodes
+ * @require_keys: Mark all keys as 'required'
+ * @jobs:	Number of worker threads to use
+ * @return: 0 on success, <0 on failure
+ */
+static int fit_add_image_data_parallel(const char *keydir, void *keydest,
+		void *fit, int images_noffset, const char *comment,
+		int require_keys, uint jobs)
+{
+	struct fit_job_list list;
+	pthread_t *threads;
+	int ret, i;
+
+	memset(&list, '\0', sizeof(list));
+	list.fit = fit;
+	pthread_mutex_init(&list.lock, NULL);
+	pthread_mutex_init(&list.sign_lock, NULL);
+
+	ret = fit_jobs_collect(keydir, fit, images_noffset, require_keys,
+			       &list);
+	if (ret)
+		goto done;
+
+	/*
+	 * Our caller tries again with a larger FIT if there is not enough
+	 * space. Check for that before doing any work, so that the hashes
+	 * are not calculated again on each attempt.
+	 */
+	if (fdt_totalsize(fit) - fdt_off_dt_strings(fit) -
+	    fdt_size_dt_strings(fit) < fit_jobs_min_space(fit, &list)) {
+		ret = -ENOSPC;
+		goto done;
+	}
+
+	if (jobs > (uint)list.count)
+		jobs = list.count;
+	threads = calloc(jobs, sizeof(*threads));
+	if (!threads && jobs) {
+		ret = -ENOMEM;
+		goto done;
+	}
+	for (i = 0; i < jobs; i++) {
+		if (pthread_create(&threads[i], NULL, fit_job_worker, &list))
+			break;
+	}
+	/* If no threads could be started, do the work here */
+	if (!i)
+		fit_job_worker(&list);
+	while (i--)
+		pthread_join(threads[i], NULL);
+	free(threads);
+
+	ret = fit_jobs_write(keydest, fit, images_noffset, keydir, comment,
+			     &list);
+done:
+	for (i = 0; i < list.count; i++)
+		free(list.job[i].sig);
+	free(list.job);
+	pthread_mutex_destroy(&list.lock);
+	pthread_mutex_destroy(&list.sign_lock);
+
+	return ret;
+}
+
 struct strlist {
 	int count;
 	char **strings;
@@ -653,7 +1065,7 @@ static int fit_config_add_verification_data(const char *keydir, void *keydest,
 }
 
 int fit_add_verification_data(const char *keydir, void *keydest, void *fit,
-			      const char *comment, int require_keys)
+			      const char *comment, int require_keys, int jobs)
 {
 	int images_noffset, confs_noffset;
 	int noffset;
@@ -668,17 +1080,24 @@ int fit_add_verification_data(const char *keydir, void *keydest, void *fit,
 	}
 
 	/* Process its subnodes, print out component images details */
-	for (noffset = fdt_first_subnode(fit, images_noffset);
-	     noffset >= 0;
-	     noffset = fdt_next_subnode(fit, noffset)) {
-		/*
-		 * Direct child node of the images parent node,
-		 * i.e. component image node.
-		 */
-		ret = fit_image_add_verification_data(keydir, keydest,
-				fit, noffset, comment, require_keys);
+	if (jobs > 1) {
+		ret = fit_add_image_data_parallel(keydir, keydest, fit,
+				images_noffset, comment, require_keys, jobs);
 		if (ret)
 			return ret;
+	} else {
+		for (noffset = fdt_first_subnode(fit, images_noffset);
+		     noffset >= 0;
+		     noffset = fdt_next_subnode(fit, noffset)) {
+			/*
+			 * Direct child node of the images parent node,
+			 * i.e. component image node.
+			 */
+			ret = fit_image_add_verification_data(keydir, keydest,
+					fit, noffset, comment, require_keys);
+			if (ret)
+				return ret;
+		}
 	}
 
 	/* If there are no keys, we can't sign configurations */
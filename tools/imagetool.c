@@ -9,6 +9,9 @@
 #include "imagetool.h"
 
 #include <image.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 
 struct image_type_params *imagetool_get_type(int type)
 {
@@ -93,6 +96,79 @@ int imagetool_save_subimage(
 	return 0;
 }
 
+int imagetool_copy_range(int in_fd, off_t in_off, int out_fd, off_t out_off,
+			 size_t len)
+{
+	const size_t buf_size = 1 << 20;
+	ssize_t ret;
+	char *buf;
+
+#ifdef __NR_copy_file_range
+	while (len) {
+		int64_t in_pos = in_off, out_pos = out_off;
+
+		ret = syscall(__NR_copy_file_range, in_fd, &in_pos, out_fd,
+			      &out_pos, len, 0);
+		/* Fall back to copying it ourselves if this is not supported */
+		if (ret <= 0)
+			break;
+		in_off += ret;
+		out_off += ret;
+		len -= ret;
+	}
+	if (!len)
+		return 0;
+#endif
+	buf = malloc(len < buf_size ? len : buf_size);
+	if (!buf)
+		return -EIO;
+	while (len) {
+		ret = pread(in_fd, buf, len < buf_size ? len : buf_size,
+			    in_off);
+		if (ret <= 0 || pwrite(out_fd, buf, ret, out_off) != ret) {
+			free(buf);
+			return -EIO;
+		}
+		in_off += ret;
+		out_off += ret;
+		len -= ret;
+	}
+	free(buf);
+
+	return 0;
+}
+
+int imagetool_copy_subimage(const char *file_name, const char *image_name,
+			    off_t offset, ulong len)
+{
+	int ifd, dfd;
+	int ret;
+
+	ifd = open(image_name, O_RDONLY | O_BINARY);
+	if (ifd < 0) {
+		fprintf(stderr, "Can't open \"%s\": %s\n",
+			image_name, strerror(errno));
+		return -1;
+	}
+	dfd = open(file_name, O_RDWR | O_CREAT | O_TRUNC | O_BINARY,
+		   S_IRUSR | S_IWUSR);
+	if (dfd < 0) {
+		fprintf(stderr, "Can't open \"%s\": %s\n",
+			file_name, strerror(errno));
+		close(ifd);
+		return -1;
+	}
+
+	ret = imagetool_copy_range(ifd, offset, dfd, 0, len);
+	if (ret)
+		fprintf(stderr, "Write error on \"%s\": %s\n",
+			file_name, strerror(errno));
+	close(dfd);
+	close(ifd);
+
+	return ret;
+}
+
 int imagetool_get_filesize(struct image_tool_params *params, const char *fname)
 {
 	struct stat sbuf;
@@ -75,6 +75,7 @@ struct image_tool_params {
 	bool external_data;	/* Store data outside the FIT */
 	bool quiet;		/* Don't output text in normal operation */
 	unsigned int external_offset;	/* Add padding to external data */
+	int jobs;		/* Threads to use for hashing and signing */
 };
 
 /*
@@ -194,6 +195,37 @@ int imagetool_save_subimage(
 	ulong file_data,
 	ulong file_len);
 
+/**
+ * imagetool_copy_range() - Copy part of one file into another
+ *
+ * The data is copied by the kernel where possible, so it is never read into
+ * memory. Otherwise it is copied through a small buffer.
+ *
+ * @in_fd:	File to copy from
+ * @in_off:	Offset to copy from
+ * @out_fd:	File to copy to
+ * @out_off:	Offset to copy to
+ * @len:	Number of bytes to copy
+ * @return 0 if OK, -EIO on error
+ */
+int imagetool_copy_range(int in_fd, off_t in_off, int out_fd, off_t out_off,
+			 size_t len);
+
+/**
+ * imagetool_copy_subimage() - Store part of an image file into a file
+ *
+ * This is like imagetool_save_subimage() except that the data is streamed
+ * from the image file rather than taken from memory.
+ *
+ * @file_name:	Name of the destination file
+ * @image_name:	Name of the image file
+ * @offset:	Offset of the data within the image file
+ * @len:	Number of bytes to store
+ * @return 0 if OK, -ve on error
+ */
+int imagetool_copy_subimage(const char *file_name, const char *image_name,
+			    off_t offset, ulong len);
+
 /**
  * imagetool_get_filesize() - Utility function to obtain the size of a file
  *